@@ -0,0 +1,62 @@
+#include "Arena.h"
+
+#include <algorithm>
+
+Arena::Arena(size_t blockSize)
+    : m_blockSize(blockSize)
+    , m_current(0)
+    , m_end(0)
+    , m_bytesAllocated(0)
+    , m_bytesReserved(0)
+    , m_objectCount(0)
+{
+}
+
+Arena::~Arena()
+{
+    clear();
+}
+
+void *Arena::allocate(size_t size, size_t alignment)
+{
+    size_t padding = (alignment - reinterpret_cast<size_t>(m_current) % alignment) % alignment;
+
+    if (!m_current || padding + size > static_cast<size_t>(m_end - m_current)) {
+        // oversized requests get a block of their own
+        size_t blockSize = std::max(m_blockSize, size + alignment);
+        char *block = static_cast<char *>(::operator new(blockSize));
+
+        m_blocks.push_back(block);
+        m_current = block;
+        m_end = block + blockSize;
+        m_bytesReserved += blockSize;
+
+        padding = (alignment - reinterpret_cast<size_t>(m_current) % alignment) % alignment;
+    }
+
+    void *memory = m_current + padding;
+    m_current += padding + size;
+    m_bytesAllocated += size;
+
+    return memory;
+}
+
+void Arena::clear()
+{
+    // destroy in reverse order of construction
+    for (std::vector<Destructor>::reverse_iterator i = m_destructors.rbegin(); i != m_destructors.rend(); ++i) {
+        i->destroy(i->object);
+    }
+    m_destructors.clear();
+
+    for (std::vector<char *>::iterator i = m_blocks.begin(); i != m_blocks.end(); ++i) {
+        ::operator delete(*i);
+    }
+    m_blocks.clear();
+
+    m_current = 0;
+    m_end = 0;
+    m_bytesAllocated = 0;
+    m_bytesReserved = 0;
+    m_objectCount = 0;
+}
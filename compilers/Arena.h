@@ -0,0 +1,66 @@
+#pragma once
+
+#include <boost/noncopyable.hpp>
+#include <boost/type_traits/alignment_of.hpp>
+#include <boost/type_traits/has_trivial_destructor.hpp>
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+// Bump allocator for objects that share one lifetime, such as the nodes of
+// a syntax tree. Objects are never freed one at a time; destructors run and
+// the memory is returned when the arena is cleared or destroyed.
+class Arena : private boost::noncopyable
+{
+public:
+    static const size_t kDefaultBlockSize = 64 * 1024;
+
+    // blocks are this big unless an object needs more
+    explicit Arena(size_t blockSize = kDefaultBlockSize);
+    ~Arena();
+
+    template <typename T>
+    T *create()
+    {
+        T *object = new (allocate(sizeof(T), boost::alignment_of<T>::value)) T();
+        ++m_objectCount;
+
+        if (!boost::has_trivial_destructor<T>::value) {
+            Destructor destructor = { object, &destroy<T> };
+            m_destructors.push_back(destructor);
+        }
+
+        return object;
+    }
+
+    void *allocate(size_t size, size_t alignment);
+    void clear();
+
+    size_t bytesAllocated() const { return m_bytesAllocated; }
+    size_t bytesReserved() const { return m_bytesReserved; }
+    // objects made with create() since the last clear()
+    size_t objectCount() const { return m_objectCount; }
+
+private:
+    struct Destructor
+    {
+        void *object;
+        void (*destroy)(void *);
+    };
+
+    template <typename T>
+    static void destroy(void *object)
+    {
+        static_cast<T *>(object)->~T();
+    }
+
+    size_t m_blockSize;
+    char *m_current;
+    char *m_end;
+    std::vector<char *> m_blocks;
+    std::vector<Destructor> m_destructors;
+    size_t m_bytesAllocated;
+    size_t m_bytesReserved;
+    size_t m_objectCount;
+};
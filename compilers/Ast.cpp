@@ -1,4 +1,7 @@
 #include "Ast.h"
+#include "ThreadPool.h"
+
+#include <boost/bind/bind.hpp>
 
 BasicBlock *Builder::createBeq(Value *lhs, Value *rhs, BasicBlock *True)
 {
@@ -134,11 +137,15 @@ Value *Factor::codegen(BuilderPtr builder)
         return expression->codegen(builder);
     }
 
-    Value *idValue = builder->symbolTableLookup(id);
-
     if (id->parameters) {
         ValueList paramValues = id->parameters->codegen(builder);
-        return builder->createCall(idValue, paramValues);
+        return builder->createCall(id, paramValues);
+    }
+
+    Value *idValue = builder->symbolTableLookup(id);
+
+    if (id->index && builder->checksBounds()) {
+        builder->createBoundsCheck(idValue, id->index->codegen(builder));
     }
 
     return idValue;
@@ -175,12 +182,23 @@ void Program::codegen(BuilderPtr builder)
 
     builder->setInsertBlock(mainFunction);
     mainProgram->codegen(builder);
+
+    // Where the statements end is not always the block created last: the
+    // join after an if is created before the blocks of its branches. Every
+    // other block ends in a jump, so moving it changes nothing else.
+    builder->moveToEnd(builder->getInsertBlock());
 }
 
 void AssignmentOrCallStatement::codegen(BuilderPtr builder)
 {
     if (value) {
-        builder->createAssign(builder->symbolTableLookup(id), value->codegen(builder));
+        Value *idValue = builder->symbolTableLookup(id);
+
+        if (id->index && builder->checksBounds()) {
+            builder->createBoundsCheck(idValue, id->index->codegen(builder));
+        }
+
+        builder->createAssign(idValue, value->codegen(builder));
         return;
     }
 
@@ -189,7 +207,7 @@ void AssignmentOrCallStatement::codegen(BuilderPtr builder)
         parameters = id->parameters->codegen(builder);
     }
 
-    builder->createCall(builder->symbolTableLookup(id), parameters);
+    builder->createCall(id, parameters);
 }
 
 void Statements::codegen(BuilderPtr builder)
@@ -242,12 +260,13 @@ void WhileStatement::codegen(BuilderPtr builder)
     builder->setInsertBlock(tail);
 }
 
-void SubprogramDeclaration::codegen(BuilderPtr builder)
+Function *SubprogramDeclaration::declare(BuilderPtr builder)
 {
-    BasicBlock *oldBlock = builder->getInsertBlock();
-
-    Function *function = builder->createFunction(name, arguments, returnType);
+    return builder->createFunction(name, arguments, returnType);
+}
 
+void SubprogramDeclaration::define(BuilderPtr builder, Function *function)
+{
     BasicBlock *functionBlock = builder->createBasicBlock(0, function);
     builder->setInsertBlock(functionBlock);
 
@@ -257,19 +276,42 @@ void SubprogramDeclaration::codegen(BuilderPtr builder)
 
     body->codegen(builder);
 
-    Value *returnValue;
+    Value *returnValue = 0;
     if (isFunction) {
         returnValue = builder->symbolTableLookup(name);
     }
     builder->createReturn(returnValue);
-
-    builder->setInsertBlock(oldBlock);
 }
 
 void SubprogramDeclarations::codegen(BuilderPtr builder)
 {
+    std::vector<Function *> functions;
+    std::vector<BuilderPtr> builders;
+
+    // declaring everything first leaves the bodies only reading shared state
     for (std::vector<SubprogramDeclarationPtr>::const_iterator i = list.begin(); i != list.end(); ++i) {
-        (*i)->codegen(builder);
+        Function *function = (*i)->declare(builder);
+
+        functions.push_back(function);
+        builders.push_back(builder->createFunctionBuilder(function));
+    }
+
+    ThreadPool *pool = builder->threadPool();
+
+    for (size_t i = 0; i < list.size(); ++i) {
+        if (pool) {
+            pool->submit(boost::bind(&SubprogramDeclaration::define, list[i], builders[i], functions[i]));
+        } else {
+            list[i]->define(builders[i], functions[i]);
+        }
+    }
+
+    if (pool) {
+        pool->wait();
+    }
+
+    for (std::vector<BuilderPtr>::const_iterator i = builders.begin(); i != builders.end(); ++i) {
+        builder->mergeFunctionBuilder(*i);
     }
 }
 
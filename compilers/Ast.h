@@ -13,6 +13,11 @@ class Value { public: virtual ~Value() {} };
 
 typedef std::vector<Value *> ValueList;
 
+class Builder;
+class ThreadPool;
+
+typedef boost::shared_ptr<Builder> BuilderPtr;
+
 class Builder
 {
 public:
@@ -25,6 +30,9 @@ public:
     virtual Value *constValue(float value) = 0;
 
     virtual BasicBlock *createBasicBlock(const char *name=0, Function *parent=0) = 0;
+    // Blocks are laid out in the order they are created, and the program
+    // ends by running off its last one.
+    virtual void moveToEnd(BasicBlock *bb) = 0;
 
     virtual Value *createTempVariable(BasicBlock *parent, TypePtr type) = 0;
     virtual Value *createVariable(IdentifierPtr id, TypePtr type, BasicBlock *parent=0) = 0;
@@ -32,7 +40,22 @@ public:
     virtual Function *createFunction(IdentifierPtr name, DeclarationsPtr arguments, TypePtr returnType) = 0;
     virtual Value *symbolTableLookup(IdentifierPtr id) = 0;
 
-    virtual Value *createCall(Value *target, ValueList &params) = 0;
+    // Once every subprogram is declared their bodies are independent. Each
+    // body gets a builder of its own, which may run on the thread pool, and
+    // is merged back in declaration order.
+    virtual BuilderPtr createFunctionBuilder(Function *function) = 0;
+    virtual void mergeFunctionBuilder(BuilderPtr functionBuilder) = 0;
+    virtual ThreadPool *threadPool() const = 0;
+
+    // looks name up itself, so that a name that is not a subprogram is
+    // reported where it is called
+    virtual Value *createCall(IdentifierPtr name, ValueList &params) = 0;
+
+    // Arrays are not laid out yet and an indexed name stands for the whole
+    // array, so the index is only evaluated when it is checked against the
+    // declared bounds.
+    virtual bool checksBounds() const = 0;
+    virtual void createBoundsCheck(Value *array, Value *index) = 0;
 
     virtual Value *createAdd(Value *lhs, Value *rhs) = 0;
     virtual Value *createAnd(Value *lhs, Value *rhs) = 0;
@@ -65,8 +88,6 @@ public:
     virtual BasicBlock *createBne(Value *lhs, Value *rhs, BasicBlock *True);
 };
 
-typedef boost::shared_ptr<Builder> BuilderPtr;
-
 struct Expression
 {
     ~Expression() {}
@@ -201,7 +222,8 @@ struct WhileStatement : public Statement
 
 struct SubprogramDeclaration
 {
-    void codegen(BuilderPtr builder);
+    Function *declare(BuilderPtr builder);
+    void define(BuilderPtr builder, Function *function);
 
     bool isFunction;
     IdentifierPtr name;
@@ -26,26 +26,28 @@ struct SubprogramDeclarations;
 struct Term;
 struct Type;
 
-typedef boost::shared_ptr<AddOpExpression> AddOpExpressionPtr;
-typedef boost::shared_ptr<Arguments> ArgumentsPtr;
-typedef boost::shared_ptr<CompoundStatement> CompoundStatementPtr;
-typedef boost::shared_ptr<Declaration> DeclarationPtr;
-typedef boost::shared_ptr<Declarations> DeclarationsPtr;
-typedef boost::shared_ptr<Expression> ExpressionPtr;
-typedef boost::shared_ptr<Expressions> ExpressionsPtr;
-typedef boost::shared_ptr<Factor> FactorPtr;
-typedef boost::shared_ptr<Identifier> IdentifierPtr;
-typedef boost::shared_ptr<Identifiers> IdentifiersPtr;
+// Syntax tree nodes live in the Arena of the Parser that built them and are
+// referred to by plain, non-owning pointers.
+typedef AddOpExpression *AddOpExpressionPtr;
+typedef Arguments *ArgumentsPtr;
+typedef CompoundStatement *CompoundStatementPtr;
+typedef Declaration *DeclarationPtr;
+typedef Declarations *DeclarationsPtr;
+typedef Expression *ExpressionPtr;
+typedef Expressions *ExpressionsPtr;
+typedef Factor *FactorPtr;
+typedef Identifier *IdentifierPtr;
+typedef Identifiers *IdentifiersPtr;
 typedef boost::shared_ptr<Lexer> LexerPtr;
-typedef boost::shared_ptr<Number> NumberPtr;
-typedef boost::shared_ptr<Program> ProgramPtr;
-typedef boost::shared_ptr<RelOpExpression> RelOpExpressionPtr;
-typedef boost::shared_ptr<Statement> StatementPtr;
-typedef boost::shared_ptr<Statements> StatementsPtr;
-typedef boost::shared_ptr<AssignmentOrCallStatement> AssignmentOrCallStatementPtr;
-typedef boost::shared_ptr<IfStatement> IfStatementPtr;
-typedef boost::shared_ptr<WhileStatement> WhileStatementPtr;
-typedef boost::shared_ptr<SubprogramDeclaration> SubprogramDeclarationPtr;
-typedef boost::shared_ptr<SubprogramDeclarations> SubprogramDeclarationsPtr;
-typedef boost::shared_ptr<Term> TermPtr;
-typedef boost::shared_ptr<Type> TypePtr;
+typedef Number *NumberPtr;
+typedef Program *ProgramPtr;
+typedef RelOpExpression *RelOpExpressionPtr;
+typedef Statement *StatementPtr;
+typedef Statements *StatementsPtr;
+typedef AssignmentOrCallStatement *AssignmentOrCallStatementPtr;
+typedef IfStatement *IfStatementPtr;
+typedef WhileStatement *WhileStatementPtr;
+typedef SubprogramDeclaration *SubprogramDeclarationPtr;
+typedef SubprogramDeclarations *SubprogramDeclarationsPtr;
+typedef Term *TermPtr;
+typedef Type *TypePtr;
@@ -0,0 +1,286 @@
+#include "BatchCompiler.h"
+#include "Ast.h"
+#include "Lexer.h"
+#include "Parser.h"
+#include "TacBuilder.h"
+#include "TacOptimizations.h"
+#include "TacPass.h"
+#include "X86Builder.h"
+
+#include <boost/bind/bind.hpp>
+#include <boost/filesystem.hpp>
+
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+// Part of every cache key, next to the compiler's identity. Bump it when the
+// key or the layout of an entry changes.
+static const char *kCacheVersion = "impasse-cache-4";
+
+static unsigned long long fnv1a(const std::string &data, unsigned long long hash = 14695981039346656037ULL)
+{
+    for (std::string::const_iterator i = data.begin(); i != data.end(); ++i) {
+        hash ^= static_cast<unsigned char>(*i);
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+static bool readFile(const std::string &path, std::string &contents)
+{
+    std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    std::ostringstream buffer;
+    buffer << file.rdbuf();
+    contents = buffer.str();
+
+    return true;
+}
+
+static bool writeFile(const std::string &path, const std::string &contents)
+{
+    std::ofstream file(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    file << contents;
+    file.close();
+
+    return !file.fail();
+}
+
+// Writes to a unique temporary name first, so a reader, possibly in another
+// process, never sees a partly written entry.
+static void storeInCache(const std::string &path, const std::string &contents)
+{
+    boost::system::error_code error;
+    boost::filesystem::path temporary = boost::filesystem::unique_path(path + ".%%%%-%%%%-%%%%", error);
+
+    if (error || !writeFile(temporary.string(), contents)) {
+        return;
+    }
+
+    boost::filesystem::rename(temporary, path, error);
+    if (error) {
+        boost::filesystem::remove(temporary, error);
+    }
+}
+
+// A hash of the running executable, so that entries cached by any other
+// build of the compiler are never served. Where the executable cannot be
+// read, the time this file was compiled is the nearest thing.
+static std::string compilerIdentity()
+{
+    std::string executable;
+    if (!readFile("/proc/self/exe", executable)) {
+        return __DATE__ " " __TIME__;
+    }
+
+    // a word at a time, because the executable runs to megabytes
+    unsigned long long hash = fnv1a(executable.substr(executable.size() & ~7UL));
+    for (size_t i = 0; i + 8 <= executable.size(); i += 8) {
+        unsigned long long word;
+        std::memcpy(&word, executable.data() + i, 8);
+
+        hash ^= word;
+        hash *= 1099511628211ULL;
+    }
+
+    std::ostringstream identity;
+    identity << std::hex << std::setw(16) << std::setfill('0') << hash;
+
+    return identity.str();
+}
+
+BatchCompiler::Options::Options()
+    : optimizationLevel(0)
+    , emitX86(false)
+    , boundsCheck(false)
+    , lexerKind("dfa")
+    , jobs(0)
+{
+}
+
+BatchCompiler::BatchCompiler(const Options &options)
+    : m_options(options)
+    , m_outputExtension(options.emitX86 ? ".s" : ".tac")
+    , m_compiled(0)
+    , m_cached(0)
+    , m_failed(0)
+    , m_pool(options.jobs)
+{
+}
+
+BatchCompiler::~BatchCompiler()
+{
+}
+
+bool BatchCompiler::compile(const std::vector<std::string> &files, std::ostream &log)
+{
+    if (!m_options.cacheDirectory.empty()) {
+        boost::system::error_code error;
+        boost::filesystem::create_directories(m_options.cacheDirectory, error);
+
+        if (error) {
+            log << "cannot create cache directory " << m_options.cacheDirectory << ": " << error.message() << std::endl;
+            return false;
+        }
+
+        if (m_compilerIdentity.empty()) {
+            m_compilerIdentity = compilerIdentity();
+        }
+    }
+
+    std::vector<Result> results(files.size());
+
+    for (size_t i = 0; i < files.size(); ++i) {
+        m_pool.submit(boost::bind(&BatchCompiler::compileFile, this, boost::cref(files[i]), &results[i]));
+    }
+    m_pool.wait();
+
+    m_compiled = 0;
+    m_cached = 0;
+    m_failed = 0;
+
+    for (size_t i = 0; i < files.size(); ++i) {
+        switch (results[i].status) {
+        case Result::Status::Compiled:
+            ++m_compiled;
+            break;
+        case Result::Status::Cached:
+            ++m_cached;
+            break;
+        case Result::Status::Failed:
+            ++m_failed;
+            log << files[i] << ":" << std::endl << results[i].diagnostics;
+            break;
+        }
+    }
+
+    return m_failed == 0;
+}
+
+void BatchCompiler::compileFile(const std::string &file, Result *result)
+{
+    std::string source;
+    if (!readFile(file, source)) {
+        result->diagnostics = "cannot read " + file + "\n";
+        return;
+    }
+
+    std::string outputPath = file;
+    if (outputPath.size() > 4 && outputPath.compare(outputPath.size() - 4, 4, ".pas") == 0) {
+        outputPath.erase(outputPath.size() - 4);
+    }
+    outputPath += m_outputExtension;
+
+    std::string cachePath;
+    if (!m_options.cacheDirectory.empty()) {
+        std::ostringstream options;
+        options << kCacheVersion << " " << m_compilerIdentity << " -O" << m_options.optimizationLevel << m_outputExtension
+                << (m_options.boundsCheck ? " --bounds-check" : "") << "\n";
+
+        std::ostringstream key;
+        key << std::hex << std::setw(16) << std::setfill('0') << fnv1a(source, fnv1a(options.str()));
+        cachePath = m_options.cacheDirectory + "/" + key.str() + m_outputExtension;
+
+        std::string cached;
+        if (readFile(cachePath, cached) && writeFile(outputPath, cached)) {
+            result->status = Result::Status::Cached;
+            return;
+        }
+    }
+
+    std::string output;
+    std::ostringstream diagnostics;
+
+    Context *context = acquireContext();
+    bool compiled = compileSource(*context, source, output, diagnostics);
+    releaseContext(context);
+
+    if (!compiled) {
+        result->diagnostics = diagnostics.str();
+        return;
+    }
+
+    if (!writeFile(outputPath, output)) {
+        result->diagnostics = "cannot write " + outputPath + "\n";
+        return;
+    }
+
+    if (!cachePath.empty()) {
+        storeInCache(cachePath, output);
+    }
+
+    result->status = Result::Status::Compiled;
+}
+
+// The same steps as a single compilation in main, with the output kept as
+// it would have been printed.
+bool BatchCompiler::compileSource(Context &context, const std::string &source, std::string &output, std::ostream &diagnostics)
+{
+    std::istringstream in(source);
+
+    context.lexer->reset(&in);
+    context.parser->setErrorStream(diagnostics);
+
+    ProgramPtr program = context.parser->parse(context.lexer);
+
+    if (context.parser->errorCount() > 0) {
+        diagnostics << "Number of errors: " << context.parser->errorCount() << std::endl;
+        return false;
+    }
+
+    context.builder->reset();
+    program->codegen(context.builder);
+
+    if (context.builder->errorCount() > 0) {
+        diagnostics << context.builder->diagnostics();
+        diagnostics << "Number of errors: " << context.builder->errorCount() << std::endl;
+        return false;
+    }
+
+    TacPassManager passes;
+    if (m_options.optimizationLevel >= 1) {
+        addO1Passes(passes);
+    }
+    passes.run(*context.builder->module());
+
+    output = context.builder->output() + "\n";
+
+    return true;
+}
+
+BatchCompiler::Context *BatchCompiler::acquireContext()
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    if (!m_contexts.empty()) {
+        Context *context = m_contexts.back();
+        m_contexts.pop_back();
+
+        return context;
+    }
+
+    std::istringstream empty;
+    boost::shared_ptr<Context> context(new Context);
+
+    context->lexer.reset(Lexer::create(m_options.lexerKind, &empty));
+    context->parser.reset(new Parser);
+    context->builder.reset(m_options.emitX86 ? new X86Builder : new TacBuilder);
+    context->builder->setBoundsChecking(m_options.boundsCheck);
+
+    m_allContexts.push_back(context);
+
+    return context.get();
+}
+
+void BatchCompiler::releaseContext(Context *context)
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    m_contexts.push_back(context);
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "ThreadPool.h"
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+class Lexer;
+class Parser;
+class TacBuilder;
+
+// Compiles many programs in one process. Files are spread over a thread
+// pool; every worker context keeps one lexer, parser and builder and reuses
+// them from file to file. Output is cached on disk under a hash of the
+// source, the options and the compiler itself, so unchanged inputs are not
+// compiled again.
+class BatchCompiler : private boost::noncopyable
+{
+public:
+    struct Options
+    {
+        Options();
+
+        int optimizationLevel;
+        bool emitX86;
+        // see TacBuilder::setBoundsChecking()
+        bool boundsCheck;
+        std::string lexerKind;
+        // empty disables the cache
+        std::string cacheDirectory;
+        // 0 uses every hardware thread
+        int jobs;
+    };
+
+    explicit BatchCompiler(const Options &options);
+    ~BatchCompiler();
+
+    // Writes foo.tac (or foo.s) next to each foo.pas and reports failures
+    // to log in input order. Returns false if any file failed.
+    bool compile(const std::vector<std::string> &files, std::ostream &log);
+
+    // counts from the last compile()
+    int compiledCount() const { return m_compiled; }
+    int cachedCount() const { return m_cached; }
+    int failedCount() const { return m_failed; }
+
+private:
+    struct Context
+    {
+        boost::shared_ptr<Lexer> lexer;
+        boost::shared_ptr<Parser> parser;
+        boost::shared_ptr<TacBuilder> builder;
+    };
+
+    struct Result
+    {
+        struct Status
+        {
+            enum Enum
+            {
+                Compiled,
+                Cached,
+                Failed
+            };
+        };
+
+        Result() : status(Status::Failed) {}
+
+        Status::Enum status;
+        std::string diagnostics;
+    };
+
+    void compileFile(const std::string &file, Result *result);
+    bool compileSource(Context &context, const std::string &source, std::string &output, std::ostream &diagnostics);
+
+    Context *acquireContext();
+    void releaseContext(Context *context);
+
+    Options m_options;
+    std::string m_outputExtension;
+    // part of every cache key, see compilerIdentity()
+    std::string m_compilerIdentity;
+
+    // idle contexts, at most one per worker is ever created
+    std::vector<Context *> m_contexts;
+    std::vector<boost::shared_ptr<Context> > m_allContexts;
+    boost::mutex m_mutex;
+
+    int m_compiled;
+    int m_cached;
+    int m_failed;
+
+    ThreadPool m_pool;
+};
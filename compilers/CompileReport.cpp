@@ -0,0 +1,312 @@
+#include "CompileReport.h"
+
+#include <boost/atomic.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include <sys/resource.h>
+
+#if __cplusplus >= 201103L
+#define IMPASSE_THROWS_BAD_ALLOC
+#define IMPASSE_NOTHROW noexcept
+#else
+#define IMPASSE_THROWS_BAD_ALLOC throw(std::bad_alloc)
+#define IMPASSE_NOTHROW throw()
+#endif
+
+// Set once, before there are threads to race with. Memory allocated before
+// counting started may be freed after, so the live count is kept from
+// going below zero.
+static bool s_counting = false;
+static boost::atomic<unsigned long long> s_allocations(0);
+static boost::atomic<unsigned long long> s_bytes(0);
+static boost::atomic<long long> s_liveBytes(0);
+static boost::atomic<long long> s_peakBytes(0);
+
+// What the allocator really set aside; without glibc only calls are counted.
+static size_t usableSize(void *memory)
+{
+#ifdef __GLIBC__
+    return malloc_usable_size(memory);
+#else
+    (void)memory;
+    return 0;
+#endif
+}
+
+static void *allocate(size_t size)
+{
+    void *memory = std::malloc(size ? size : 1);
+    if (!memory) {
+        throw std::bad_alloc();
+    }
+
+    if (s_counting) {
+        s_allocations.fetch_add(1, boost::memory_order_relaxed);
+        s_bytes.fetch_add(size, boost::memory_order_relaxed);
+
+        long long live = s_liveBytes.fetch_add(usableSize(memory), boost::memory_order_relaxed) + usableSize(memory);
+        long long peak = s_peakBytes.load(boost::memory_order_relaxed);
+
+        while (live > peak && !s_peakBytes.compare_exchange_weak(peak, live, boost::memory_order_relaxed)) {
+        }
+    }
+
+    return memory;
+}
+
+static void release(void *memory)
+{
+    if (memory && s_counting) {
+        long long live = s_liveBytes.fetch_sub(usableSize(memory), boost::memory_order_relaxed) - usableSize(memory);
+
+        if (live < 0) {
+            s_liveBytes.fetch_sub(live, boost::memory_order_relaxed);
+        }
+    }
+
+    std::free(memory);
+}
+
+void *operator new(size_t size) IMPASSE_THROWS_BAD_ALLOC
+{
+    return allocate(size);
+}
+
+void *operator new[](size_t size) IMPASSE_THROWS_BAD_ALLOC
+{
+    return allocate(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) IMPASSE_NOTHROW
+{
+    try {
+        return allocate(size);
+    } catch (const std::bad_alloc &) {
+        return 0;
+    }
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) IMPASSE_NOTHROW
+{
+    try {
+        return allocate(size);
+    } catch (const std::bad_alloc &) {
+        return 0;
+    }
+}
+
+void operator delete(void *memory) IMPASSE_NOTHROW
+{
+    release(memory);
+}
+
+void operator delete[](void *memory) IMPASSE_NOTHROW
+{
+    release(memory);
+}
+
+#ifdef __cpp_sized_deallocation
+void operator delete(void *memory, std::size_t) IMPASSE_NOTHROW
+{
+    release(memory);
+}
+
+void operator delete[](void *memory, std::size_t) IMPASSE_NOTHROW
+{
+    release(memory);
+}
+#endif
+
+void operator delete(void *memory, const std::nothrow_t &) IMPASSE_NOTHROW
+{
+    release(memory);
+}
+
+void operator delete[](void *memory, const std::nothrow_t &) IMPASSE_NOTHROW
+{
+    release(memory);
+}
+
+void enableHeapCounting()
+{
+    s_counting = true;
+}
+
+HeapCounters heapCounters()
+{
+    HeapCounters counters;
+    counters.allocations = s_allocations.load(boost::memory_order_relaxed);
+    counters.bytes = s_bytes.load(boost::memory_order_relaxed);
+    counters.liveBytes = s_liveBytes.load(boost::memory_order_relaxed);
+    counters.peakBytes = s_peakBytes.load(boost::memory_order_relaxed);
+
+    return counters;
+}
+
+void resetHeapPeak()
+{
+    s_peakBytes.store(s_liveBytes.load(boost::memory_order_relaxed), boost::memory_order_relaxed);
+}
+
+CompileReport::CompileReport()
+    : m_open(false)
+{
+}
+
+void CompileReport::begin(const std::string &phase)
+{
+    end();
+
+    Phase entry = { phase, 0.0, 0, 0, 0 };
+    m_phases.push_back(entry);
+    m_open = true;
+
+    resetHeapPeak();
+    m_startCounters = heapCounters();
+    m_start = boost::posix_time::microsec_clock::universal_time();
+}
+
+void CompileReport::end()
+{
+    if (!m_open) {
+        return;
+    }
+
+    boost::posix_time::time_duration elapsed = boost::posix_time::microsec_clock::universal_time() - m_start;
+    HeapCounters counters = heapCounters();
+
+    Phase &phase = m_phases.back();
+    phase.milliseconds = elapsed.total_microseconds() / 1000.0;
+    phase.allocations = counters.allocations - m_startCounters.allocations;
+    phase.bytes = counters.bytes - m_startCounters.bytes;
+    phase.peakBytes = counters.peakBytes;
+
+    m_open = false;
+}
+
+void CompileReport::setCount(const std::string &name, unsigned long long value)
+{
+    for (std::vector<std::pair<std::string, unsigned long long> >::iterator i = m_counts.begin(); i != m_counts.end(); ++i) {
+        if (i->first == name) {
+            i->second = value;
+            return;
+        }
+    }
+
+    m_counts.push_back(std::make_pair(name, value));
+}
+
+double CompileReport::milliseconds(const std::string &phase) const
+{
+    for (std::vector<Phase>::const_reverse_iterator i = m_phases.rbegin(); i != m_phases.rend(); ++i) {
+        if (i->name == phase) {
+            return i->milliseconds;
+        }
+    }
+
+    return 0.0;
+}
+
+static unsigned long long peakResidentKilobytes()
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+
+    // kilobytes on Linux
+    return usage.ru_maxrss;
+}
+
+void CompileReport::output(std::ostream &stream) const
+{
+    std::ios::fmtflags flags = stream.flags();
+    std::streamsize precision = stream.precision();
+
+    stream << std::left << std::setw(36) << "phase"
+           << std::right << std::setw(12) << "wall ms"
+           << std::setw(12) << "allocs"
+           << std::setw(12) << "alloc KB"
+           << std::setw(12) << "peak KB" << std::endl;
+
+    Phase total = { "total", 0.0, 0, 0, 0 };
+
+    for (std::vector<Phase>::const_iterator i = m_phases.begin(); i != m_phases.end(); ++i) {
+        total.milliseconds += i->milliseconds;
+        total.allocations += i->allocations;
+        total.bytes += i->bytes;
+        total.peakBytes = std::max(total.peakBytes, i->peakBytes);
+    }
+
+    std::vector<Phase> rows(m_phases);
+    rows.push_back(total);
+
+    for (std::vector<Phase>::const_iterator i = rows.begin(); i != rows.end(); ++i) {
+        stream << std::left << std::setw(36) << i->name
+               << std::right << std::setw(12) << std::fixed << std::setprecision(3) << i->milliseconds
+               << std::setw(12) << i->allocations
+               << std::setw(12) << i->bytes / 1024
+               << std::setw(12) << i->peakBytes / 1024 << std::endl;
+    }
+
+    for (std::vector<std::pair<std::string, unsigned long long> >::const_iterator i = m_counts.begin(); i != m_counts.end(); ++i) {
+        stream << std::left << std::setw(36) << i->first << std::right << std::setw(12) << i->second << std::endl;
+    }
+
+    stream << std::left << std::setw(36) << "peak_resident_kb" << std::right << std::setw(12) << peakResidentKilobytes() << std::endl;
+
+    stream.flags(flags);
+    stream.precision(precision);
+}
+
+// names are ours, so quotes and backslashes are all there is to escape
+static std::string quoted(const std::string &text)
+{
+    std::string result = "\"";
+
+    for (std::string::const_iterator i = text.begin(); i != text.end(); ++i) {
+        if (*i == '"' || *i == '\\') {
+            result += '\\';
+        }
+
+        result += *i;
+    }
+
+    return result + "\"";
+}
+
+void CompileReport::outputJson(std::ostream &stream) const
+{
+    std::ios::fmtflags flags = stream.flags();
+    std::streamsize precision = stream.precision();
+
+    stream << "{\n  \"phases\": [";
+
+    for (std::vector<Phase>::const_iterator i = m_phases.begin(); i != m_phases.end(); ++i) {
+        stream << (i == m_phases.begin() ? "\n" : ",\n")
+               << "    {\"name\": " << quoted(i->name)
+               << ", \"wall_ms\": " << std::fixed << std::setprecision(3) << i->milliseconds
+               << ", \"allocations\": " << i->allocations
+               << ", \"allocated_bytes\": " << i->bytes
+               << ", \"peak_bytes\": " << i->peakBytes << "}";
+    }
+
+    stream << "\n  ],\n  \"counts\": {";
+
+    for (std::vector<std::pair<std::string, unsigned long long> >::const_iterator i = m_counts.begin(); i != m_counts.end(); ++i) {
+        stream << "\n    " << quoted(i->first) << ": " << i->second << ",";
+    }
+
+    stream << "\n    \"peak_resident_kb\": " << peakResidentKilobytes() << "\n  }\n}" << std::endl;
+
+    stream.flags(flags);
+    stream.precision(precision);
+}
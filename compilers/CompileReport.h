@@ -0,0 +1,88 @@
+#pragma once
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Heap use as seen through the global operator new, counted only while
+// enableHeapCounting() is in effect; from all threads.
+struct HeapCounters
+{
+    HeapCounters() : allocations(0), bytes(0), liveBytes(0), peakBytes(0) {}
+
+    unsigned long long allocations;
+    unsigned long long bytes;
+    long long liveBytes;
+    long long peakBytes;
+};
+
+void enableHeapCounting();
+HeapCounters heapCounters();
+// starts a new peak from what is live now
+void resetHeapPeak();
+
+// Wall time, allocations and peak heap per compiler phase, plus counts such
+// as tokens and tree nodes, for --time-report. Phases run one after
+// another; a phase that starts while another is open closes it.
+class CompileReport : private boost::noncopyable
+{
+public:
+    CompileReport();
+
+    void begin(const std::string &phase);
+    void end();
+
+    // counts are printed in the order they are first set
+    void setCount(const std::string &name, unsigned long long value);
+
+    // the wall time of the last phase of that name, 0 if there is none
+    double milliseconds(const std::string &phase) const;
+
+    void output(std::ostream &stream) const;
+    void outputJson(std::ostream &stream) const;
+
+private:
+    struct Phase
+    {
+        std::string name;
+        double milliseconds;
+        unsigned long long allocations;
+        unsigned long long bytes;
+        // the most the heap held during the phase
+        long long peakBytes;
+    };
+
+    std::vector<Phase> m_phases;
+    std::vector<std::pair<std::string, unsigned long long> > m_counts;
+
+    bool m_open;
+    boost::posix_time::ptime m_start;
+    HeapCounters m_startCounters;
+};
+
+// Times the enclosing scope as a phase of report, if there is one.
+class ScopedPhase : private boost::noncopyable
+{
+public:
+    ScopedPhase(CompileReport *report, const std::string &phase)
+        : m_report(report)
+    {
+        if (m_report) {
+            m_report->begin(phase);
+        }
+    }
+
+    ~ScopedPhase()
+    {
+        if (m_report) {
+            m_report->end();
+        }
+    }
+
+private:
+    CompileReport *m_report;
+};
@@ -0,0 +1,150 @@
+#include "CompileServer.h"
+#include "Ast.h"
+#include "TacBuilder.h"
+#include "TacOptimizations.h"
+#include "TacPass.h"
+#include "X86Builder.h"
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <sstream>
+#include <vector>
+
+static bool readText(std::istream &in, size_t length, std::string &text)
+{
+    std::vector<char> buffer(length + 1);
+    in.read(&buffer[0], length);
+
+    if (static_cast<size_t>(in.gcount()) != length) {
+        return false;
+    }
+
+    text.assign(&buffer[0], length);
+    return true;
+}
+
+static void answerError(std::ostream &out, const std::string &message)
+{
+    out << "error bytes=" << message.size() << "\n" << message << std::flush;
+}
+
+CompileServer::Options::Options()
+    : optimizationLevel(0)
+    , emitX86(false)
+    , boundsCheck(false)
+    , lexerKind("dfa")
+    , maxErrors(100)
+{
+}
+
+CompileServer::CompileServer(const Options &options)
+    : m_options(options)
+    , m_parser(options.lexerKind)
+{
+    m_parser.setMaxReportedErrors(options.maxErrors);
+}
+
+// The same steps as a single compilation in main, on the tree the parser
+// keeps.
+bool CompileServer::compile(std::string &output)
+{
+    ProgramPtr program = m_parser.program();
+    if (!program) {
+        std::ostringstream message;
+        message << "Number of errors: " << m_parser.errorCount() << "\n";
+        output = message.str();
+        return false;
+    }
+
+    boost::shared_ptr<TacBuilder> builder(m_options.emitX86 ? new X86Builder : new TacBuilder);
+    builder->setBoundsChecking(m_options.boundsCheck);
+    program->codegen(builder);
+
+    if (builder->errorCount() > 0) {
+        // the lines in the tokens of a subprogram count from its region, so
+        // the messages come from the whole text, as the batch compiler
+        // writes them
+        builder.reset(m_options.emitX86 ? new X86Builder : new TacBuilder);
+        m_parser.wholeProgram()->codegen(builder);
+
+        std::ostringstream message;
+        message << builder->diagnostics() << "Number of errors: " << builder->errorCount() << "\n";
+        output = message.str();
+        return false;
+    }
+
+    TacPassManager passes;
+    if (m_options.optimizationLevel >= 1) {
+        addO1Passes(passes);
+    }
+    passes.run(*builder->module());
+
+    output = builder->output() + "\n";
+    return true;
+}
+
+bool CompileServer::serve(std::istream &in, std::ostream &out)
+{
+    std::string line;
+
+    while (std::getline(in, line)) {
+        std::istringstream request(line);
+        std::string command;
+        request >> command;
+
+        if (command.empty()) {
+            continue;
+        }
+        if (command == "quit") {
+            return true;
+        }
+
+        boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+        std::string payload;
+
+        if (command == "text" || command == "edit") {
+            size_t offset = 0;
+            size_t length = 0;
+            size_t bytes = 0;
+
+            if (command == "edit") {
+                request >> offset >> length;
+            }
+            if (!(request >> bytes)) {
+                answerError(out, "malformed request: " + line + "\n");
+                continue;
+            }
+
+            std::string text;
+            if (!readText(in, bytes, text)) {
+                return false;
+            }
+
+            if (command == "text") {
+                m_parser.setText(text);
+            } else if (!m_parser.edit(offset, length, text)) {
+                answerError(out, "edit out of range: " + line + "\n");
+                continue;
+            }
+
+            payload = m_parser.diagnostics();
+        } else if (command == "output") {
+            if (!compile(payload)) {
+                answerError(out, payload);
+                continue;
+            }
+        } else {
+            answerError(out, "unknown request: " + line + "\n");
+            continue;
+        }
+
+        boost::posix_time::time_duration elapsed = boost::posix_time::microsec_clock::universal_time() - start;
+
+        out << "ok errors=" << m_parser.errorCount() << " reused=" << m_parser.reusedCount()
+            << " parsed=" << m_parser.parsedCount() << " us=" << elapsed.total_microseconds()
+            << " bytes=" << payload.size() << "\n" << payload << std::flush;
+    }
+
+    return true;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "IncrementalParser.h"
+
+#include <boost/noncopyable.hpp>
+
+#include <istream>
+#include <ostream>
+#include <string>
+
+// Answers requests from an editor over a pair of streams, keeping one
+// document parsed between them. Each request is a line, followed by as many
+// bytes of text as it names:
+//
+//   text N              the whole document is the N bytes that follow
+//   edit OFFSET LENGTH N   LENGTH bytes at OFFSET become the N that follow
+//   output              the TAC (or assembly) of the document
+//   quit
+//
+// and each answer is a line, followed by as many bytes as it names:
+//
+//   ok errors=E reused=R parsed=P us=T bytes=N   then the diagnostics or
+//                                                the output
+//   error bytes=N                                then what went wrong
+//
+// reused and parsed count the regions of IncrementalParser, and us is the
+// time the request took in microseconds.
+class CompileServer : private boost::noncopyable
+{
+public:
+    struct Options
+    {
+        Options();
+
+        int optimizationLevel;
+        bool emitX86;
+        // see TacBuilder::setBoundsChecking()
+        bool boundsCheck;
+        std::string lexerKind;
+        int maxErrors;
+    };
+
+    explicit CompileServer(const Options &options);
+
+    // returns at quit or the end of in; false if in ended in mid-request
+    bool serve(std::istream &in, std::ostream &out);
+
+private:
+    bool compile(std::string &output);
+
+    Options m_options;
+    IncrementalParser m_parser;
+};
@@ -0,0 +1,264 @@
+#include "Lexer.h"
+#include "Parser.h"
+#include "ProgramGenerator.h"
+#include "TacBuilder.h"
+#include "TacOptimizations.h"
+#include "TacPass.h"
+#include "Token.h"
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Compiles generated programs of growing size and reports the time per
+// token of each stage, so that a change in throughput or in how a stage
+// scales shows up against an earlier run. Each shape grows one dimension
+// of the program, doubling it at every step:
+//
+//   subprograms  more functions and procedures
+//   statements   longer statement lists in a few bodies
+//   expressions  deeper expression nesting
+//   arrays       longer arrays, for the same number of tokens
+//
+// The scaling column is how much faster the full pipeline grew than the
+// token count since the step before; 1.00 is linear.
+
+struct Timings
+{
+    Timings() : tokens(0), lex(0), parse(0), codegen(0), passes(0), output(0) {}
+
+    // parsing pulls its own tokens, so the pipeline does not include lex
+    double full() const { return parse + codegen + passes + output; }
+
+    unsigned long long tokens;
+    double lex;
+    double parse;
+    double codegen;
+    double passes;
+    double output;
+};
+
+struct Shape
+{
+    const char *name;
+    // the option doubled at every step
+    int ProgramGenerator::Options::*grown;
+    int start;
+};
+
+static const Shape kShapes[] = {
+    { "subprograms", &ProgramGenerator::Options::subprograms, 16 },
+    { "statements", &ProgramGenerator::Options::statements, 64 },
+    { "expressions", &ProgramGenerator::Options::expressionDepth, 32 },
+    { "arrays", &ProgramGenerator::Options::arrayLength, 1000 },
+};
+
+static double secondsSince(const boost::posix_time::ptime &start)
+{
+    boost::posix_time::time_duration elapsed = boost::posix_time::microsec_clock::universal_time() - start;
+    return elapsed.total_microseconds() / 1e6;
+}
+
+static bool measure(const std::string &source, Timings &timings)
+{
+    std::istringstream in(source);
+    boost::shared_ptr<Lexer> lexer(Lexer::create("dfa", &in));
+
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    timings.tokens = 0;
+    while (lexer->nextToken().tokenType() != TokenType::Eof) {
+        ++timings.tokens;
+    }
+    timings.lex = secondsSince(start);
+
+    in.clear();
+    in.str(source);
+    lexer->reset(&in);
+
+    Parser parser;
+    start = boost::posix_time::microsec_clock::universal_time();
+    ProgramPtr program = parser.parse(lexer);
+    timings.parse = secondsSince(start);
+
+    if (parser.errorCount() > 0) {
+        std::cerr << "the generated program has " << parser.errorCount() << " errors; see --emit" << std::endl;
+        return false;
+    }
+
+    boost::shared_ptr<TacBuilder> builder(new TacBuilder);
+    start = boost::posix_time::microsec_clock::universal_time();
+    program->codegen(builder);
+    timings.codegen = secondsSince(start);
+
+    if (builder->errorCount() > 0) {
+        std::cerr << "the generated program has " << builder->errorCount() << " errors; see --emit" << std::endl;
+        return false;
+    }
+
+    TacPassManager passes;
+    addO1Passes(passes);
+    start = boost::posix_time::microsec_clock::universal_time();
+    passes.run(*builder->module());
+    timings.passes = secondsSince(start);
+
+    start = boost::posix_time::microsec_clock::universal_time();
+    std::string text = builder->output();
+    timings.output = secondsSince(start);
+
+    return !text.empty();
+}
+
+// the best of runs, stage by stage
+static bool best(const std::string &source, int runs, Timings &result)
+{
+    for (int run = 0; run < runs; ++run) {
+        Timings timings;
+        if (!measure(source, timings)) {
+            return false;
+        }
+
+        if (run == 0) {
+            result = timings;
+            continue;
+        }
+
+        result.lex = std::min(result.lex, timings.lex);
+        result.parse = std::min(result.parse, timings.parse);
+        result.codegen = std::min(result.codegen, timings.codegen);
+        result.passes = std::min(result.passes, timings.passes);
+        result.output = std::min(result.output, timings.output);
+    }
+
+    return true;
+}
+
+static double nanosecondsPerToken(double seconds, unsigned long long tokens)
+{
+    return tokens ? seconds * 1e9 / tokens : 0.0;
+}
+
+static bool benchmark(const Shape &shape, ProgramGenerator::Options options, int steps, int runs)
+{
+    if (shape.grown != &ProgramGenerator::Options::subprograms) {
+        options.subprograms = 4;
+    }
+    if (shape.grown == &ProgramGenerator::Options::expressionDepth) {
+        options.statements = 4;
+    }
+    if (shape.grown == &ProgramGenerator::Options::arrayLength && options.arrays == 0) {
+        options.arrays = 4;
+    }
+
+    std::cout << shape.name << std::endl;
+    std::cout << std::setw(10) << "size" << std::setw(12) << "tokens"
+              << std::setw(10) << "lex" << std::setw(10) << "parse" << std::setw(10) << "codegen"
+              << std::setw(10) << "passes" << std::setw(10) << "output"
+              << std::setw(12) << "full ms" << std::setw(12) << "Ktokens/s" << std::setw(10) << "scaling" << std::endl;
+
+    Timings previous;
+    options.*shape.grown = shape.start;
+
+    for (int step = 0; step < steps; ++step, options.*shape.grown *= 2) {
+        std::string source = ProgramGenerator(options).generate();
+
+        Timings timings;
+        if (!best(source, runs, timings)) {
+            return false;
+        }
+
+        std::cout << std::setw(10) << options.*shape.grown << std::setw(12) << timings.tokens
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(10) << nanosecondsPerToken(timings.lex, timings.tokens)
+                  << std::setw(10) << nanosecondsPerToken(timings.parse, timings.tokens)
+                  << std::setw(10) << nanosecondsPerToken(timings.codegen, timings.tokens)
+                  << std::setw(10) << nanosecondsPerToken(timings.passes, timings.tokens)
+                  << std::setw(10) << nanosecondsPerToken(timings.output, timings.tokens)
+                  << std::setprecision(2) << std::setw(12) << timings.full() * 1000
+                  << std::setprecision(0) << std::setw(12) << (timings.full() > 0 ? timings.tokens / timings.full() / 1000 : 0.0);
+
+        if (step > 0 && previous.full() > 0 && timings.tokens > 0) {
+            double scaling = (timings.full() / previous.full()) / (double(timings.tokens) / previous.tokens);
+            std::cout << std::setprecision(2) << std::setw(10) << scaling;
+        }
+
+        std::cout << std::endl;
+        std::cout.unsetf(std::ios::floatfield);
+        previous = timings;
+    }
+
+    std::cout << std::endl;
+    return true;
+}
+
+static int usage(const char *program)
+{
+    std::cerr << "usage: " << program << " [--shape subprograms|statements|expressions|arrays|all] [--steps N] [--runs N] [--seed N]" << std::endl;
+    std::cerr << "       " << program << " --emit [--seed N] [--subprograms N] [--statements N] [--depth N] [--nesting N] [--arrays N] [--array-length N]" << std::endl;
+    return 1;
+}
+
+int main(int argc, char const *argv[])
+{
+    ProgramGenerator::Options options;
+    std::string shape = "all";
+    int steps = 6;
+    int runs = 3;
+    bool emit = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+
+        if (arg == "--emit") {
+            emit = true;
+        } else if (arg == "--shape" && i + 1 < argc) {
+            shape = argv[++i];
+        } else if (arg == "--steps" && i + 1 < argc) {
+            steps = std::atoi(argv[++i]);
+        } else if (arg == "--runs" && i + 1 < argc) {
+            runs = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--seed" && i + 1 < argc) {
+            options.seed = std::strtoul(argv[++i], 0, 10);
+        } else if (arg == "--subprograms" && i + 1 < argc) {
+            options.subprograms = std::atoi(argv[++i]);
+        } else if (arg == "--statements" && i + 1 < argc) {
+            options.statements = std::atoi(argv[++i]);
+        } else if (arg == "--depth" && i + 1 < argc) {
+            options.expressionDepth = std::atoi(argv[++i]);
+        } else if (arg == "--nesting" && i + 1 < argc) {
+            options.statementDepth = std::atoi(argv[++i]);
+        } else if (arg == "--arrays" && i + 1 < argc) {
+            options.arrays = std::atoi(argv[++i]);
+        } else if (arg == "--array-length" && i + 1 < argc) {
+            options.arrayLength = std::max(1, std::atoi(argv[++i]));
+        } else {
+            return usage(argv[0]);
+        }
+    }
+
+    if (emit) {
+        std::cout << ProgramGenerator(options).generate();
+        return 0;
+    }
+
+    bool found = false;
+
+    for (size_t i = 0; i < sizeof(kShapes) / sizeof(kShapes[0]); ++i) {
+        if (shape != "all" && shape != kShapes[i].name) {
+            continue;
+        }
+
+        found = true;
+        if (!benchmark(kShapes[i], options, steps, runs)) {
+            return 1;
+        }
+    }
+
+    return found ? 0 : usage(argv[0]);
+}
@@ -0,0 +1,284 @@
+#include "DfaScanner.h"
+
+#include <cstring>
+
+struct CharacterClass
+{
+    enum Enum
+    {
+        Other,
+        Letter,
+        Digit
+    };
+};
+
+struct CharacterClasses
+{
+    CharacterClasses()
+    {
+        std::memset(table, CharacterClass::Other, sizeof(table));
+
+        for (int c = 'a'; c <= 'z'; ++c) {
+            table[c] = CharacterClass::Letter;
+            table[c - 'a' + 'A'] = CharacterClass::Letter;
+        }
+        for (int c = '0'; c <= '9'; ++c) {
+            table[c] = CharacterClass::Digit;
+        }
+    }
+
+    unsigned char operator[](char c) const
+    {
+        return table[static_cast<unsigned char>(c)];
+    }
+
+    unsigned char table[256];
+};
+
+static const CharacterClasses kClasses;
+
+// Reserved words, including the operators spelled as words. Lookups fold
+// case, so every name here is lower case.
+struct Keyword
+{
+    const char *name;
+    int length;
+    TokenType::Enum token;
+    OperatorType::Enum op;
+};
+
+static const Keyword kKeywords[] = {
+    { "and",       3, TokenType::MulOp,     OperatorType::And           },
+    { "array",     5, TokenType::Array,     OperatorType::Invalid       },
+    { "begin",     5, TokenType::Begin,     OperatorType::Invalid       },
+    { "div",       3, TokenType::MulOp,     OperatorType::IntegerDivide },
+    { "do",        2, TokenType::Do,        OperatorType::Invalid       },
+    { "else",      4, TokenType::Else,      OperatorType::Invalid       },
+    { "end",       3, TokenType::End,       OperatorType::Invalid       },
+    { "function",  8, TokenType::Function,  OperatorType::Invalid       },
+    { "if",        2, TokenType::If,        OperatorType::Invalid       },
+    { "integer",   7, TokenType::Integer,   OperatorType::Invalid       },
+    { "mod",       3, TokenType::MulOp,     OperatorType::Modulus       },
+    { "not",       3, TokenType::Not,       OperatorType::Invalid       },
+    { "of",        2, TokenType::Of,        OperatorType::Invalid       },
+    { "or",        2, TokenType::AddOp,     OperatorType::Or            },
+    { "procedure", 9, TokenType::Procedure, OperatorType::Invalid       },
+    { "program",   7, TokenType::Program,   OperatorType::Invalid       },
+    { "real",      4, TokenType::Real,      OperatorType::Invalid       },
+    { "then",      4, TokenType::Then,      OperatorType::Invalid       },
+    { "var",       3, TokenType::Var,       OperatorType::Invalid       },
+    { "while",     5, TokenType::While,     OperatorType::Invalid       }
+};
+
+static const int kMaxKeywordLength = 9;
+
+static const Keyword *findKeyword(const char *text, int length)
+{
+    if (length > kMaxKeywordLength) {
+        return 0;
+    }
+
+    // identifiers are ASCII letters and digits, for which setting bit 5
+    // lower-cases letters and leaves digits alone
+    char folded[kMaxKeywordLength];
+    for (int i = 0; i < length; ++i) {
+        folded[i] = text[i] | 0x20;
+    }
+
+    for (size_t i = 0; i < sizeof(kKeywords) / sizeof(kKeywords[0]); ++i) {
+        const Keyword &keyword = kKeywords[i];
+
+        if (keyword.length == length && keyword.name[0] == folded[0] && std::memcmp(keyword.name, folded, length) == 0) {
+            return &keyword;
+        }
+    }
+
+    return 0;
+}
+
+DfaScanner::DfaScanner(std::istream *in)
+    : Lexer(in)
+{
+}
+
+const Token &DfaScanner::nextToken()
+{
+    scan();
+    return m_token;
+}
+
+int DfaScanner::match(const char *begin, int length)
+{
+    m_offset = static_cast<int>(begin - m_source.data());
+    advance(length);
+    return length;
+}
+
+// The source buffer always ends in a NUL, so looking one character past
+// anything that is not the terminator is safe.
+int DfaScanner::scan()
+{
+    const char *data = m_source.data();
+    const char *end = data + m_source.size();
+    const char *p = data + m_offset;
+
+    for (;;) {
+        switch (*p) {
+        case ' ':
+        case '\t':
+        case '\r':
+        case '\f':
+        case '\v':
+            ++p;
+            continue;
+
+        case '\n':
+            m_offset = static_cast<int>(++p - data);
+            resetLine();
+            continue;
+
+        case '{':
+            for (++p; p != end && *p != '}'; ++p) {
+                if (*p == '\n') {
+                    m_offset = static_cast<int>(p + 1 - data);
+                    resetLine();
+                }
+            }
+            if (p == end) {
+                // an unterminated comment runs to the end of the input
+                m_offset = static_cast<int>(p - data);
+                return eof();
+            }
+            ++p;
+            continue;
+
+        case '\0':
+            if (p == end) {
+                m_offset = static_cast<int>(p - data);
+                return eof();
+            }
+            match(p, 1);
+            return error();
+
+        case ':':
+            if (p[1] == '=') {
+                match(p, 2);
+                return oper(TokenType::Assign);
+            }
+            match(p, 1);
+            return punctuation(TokenType::Colon);
+
+        case '.':
+            if (p[1] == '.') {
+                match(p, 2);
+                return oper(TokenType::Range);
+            }
+            match(p, 1);
+            return punctuation(TokenType::Period);
+
+        case '>':
+            if (p[1] == '=') {
+                match(p, 2);
+                return relOp(OperatorType::GreaterOrEqual);
+            }
+            match(p, 1);
+            return relOp(OperatorType::Greater);
+
+        case '<':
+            if (p[1] == '=') {
+                match(p, 2);
+                return relOp(OperatorType::LessOrEqual);
+            }
+            if (p[1] == '>') {
+                match(p, 2);
+                return relOp(OperatorType::NotEqual);
+            }
+            match(p, 1);
+            return relOp(OperatorType::Less);
+
+        case '=': match(p, 1); return relOp(OperatorType::Equal);
+        case '+': match(p, 1); return addOp(OperatorType::Add);
+        case '-': match(p, 1); return addOp(OperatorType::Subtract);
+        case '/': match(p, 1); return mulOp(OperatorType::Divide);
+        case '*': match(p, 1); return mulOp(OperatorType::Multiply);
+
+        case '[': match(p, 1); return punctuation(TokenType::LBracket);
+        case ']': match(p, 1); return punctuation(TokenType::RBracket);
+        case ',': match(p, 1); return punctuation(TokenType::Comma);
+        case '(': match(p, 1); return punctuation(TokenType::LParen);
+        case ')': match(p, 1); return punctuation(TokenType::RParen);
+        case ';': match(p, 1); return punctuation(TokenType::Semicolon);
+
+        default:
+            switch (kClasses[*p]) {
+            case CharacterClass::Letter:
+                return scanIdentifier(p);
+            case CharacterClass::Digit:
+                return scanNumber(p);
+            default:
+                match(p, 1);
+                return error();
+            }
+        }
+    }
+}
+
+int DfaScanner::scanIdentifier(const char *begin)
+{
+    const char *p = begin + 1;
+    while (kClasses[*p] != CharacterClass::Other) {
+        ++p;
+    }
+
+    int length = match(begin, static_cast<int>(p - begin));
+    const Keyword *entry = findKeyword(begin, length);
+
+    if (!entry) {
+        return identifier();
+    }
+
+    switch (entry->token) {
+    case TokenType::AddOp:
+        return addOp(entry->op);
+    case TokenType::MulOp:
+        return mulOp(entry->op);
+    case TokenType::Not:
+        return oper(TokenType::Not);
+    default:
+        return keyword(entry->token);
+    }
+}
+
+// DIGITS, then an optional fraction and an optional exponent. Either part
+// is only taken when digits follow, so "1..5" is a range and "2e" is an
+// integer followed by an identifier, as with the flex rules.
+int DfaScanner::scanNumber(const char *begin)
+{
+    const char *p = begin + 1;
+    bool real = false;
+
+    while (kClasses[*p] == CharacterClass::Digit) {
+        ++p;
+    }
+
+    if (p[0] == '.' && kClasses[p[1]] == CharacterClass::Digit) {
+        real = true;
+        for (p += 2; kClasses[*p] == CharacterClass::Digit; ++p) {
+        }
+    }
+
+    if (p[0] == 'e' || p[0] == 'E') {
+        const char *exponent = p + 1;
+        if (*exponent == '+' || *exponent == '-') {
+            ++exponent;
+        }
+        if (kClasses[*exponent] == CharacterClass::Digit) {
+            real = true;
+            for (p = exponent + 1; kClasses[*p] == CharacterClass::Digit; ++p) {
+            }
+        }
+    }
+
+    match(begin, static_cast<int>(p - begin));
+    return number(real ? NumberType::Real : NumberType::Integer);
+}
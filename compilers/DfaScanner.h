@@ -0,0 +1,22 @@
+#pragma once
+
+#include "Lexer.h"
+
+#include <istream>
+
+// Hand-written scanner for the same token set as impasse.l. It walks the
+// source buffer directly with a character class table and a switch per
+// state, so it needs neither flex nor a per-match callback.
+class DfaScanner : public Lexer
+{
+public:
+    explicit DfaScanner(std::istream *in = 0);
+
+    virtual const Token &nextToken();
+
+private:
+    int scan();
+    int scanIdentifier(const char *begin);
+    int scanNumber(const char *begin);
+    int match(const char *begin, int length);
+};
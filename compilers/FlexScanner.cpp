@@ -0,0 +1,35 @@
+#include "FlexScanner.h"
+
+FlexScanner::FlexScanner(std::istream *in, std::ostream *out)
+    : Lexer(in)
+    , yyFlexLexer(in, out)
+    , m_input(&m_source)
+{
+    // flex reads the buffered copy, so offsets into it line up with yytext
+    switch_streams(&m_input, out);
+}
+
+const Token &FlexScanner::nextToken()
+{
+    yylex();
+    return m_token;
+}
+
+void FlexScanner::reset(std::istream *in)
+{
+    Lexer::reset(in);
+
+    m_input.clear();
+    yyrestart(&m_input);
+}
+
+// Run by YY_USER_ACTION before every rule, including the ones that discard
+// their text, so m_offset always tracks the scanner's position.
+void FlexScanner::advance()
+{
+    Lexer::advance(YYLeng());
+}
+
+void FlexScanner::ignore()
+{
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "Lexer.h"
+
+#include <FlexLexer.h>
+
+#include <istream>
+
+// The flex-generated scanner from impasse.l. Only built when flex is found.
+class FlexScanner : public Lexer, public yyFlexLexer
+{
+public:
+    explicit FlexScanner(std::istream *in = 0, std::ostream *out = 0);
+
+    virtual int yylex();
+    virtual const Token &nextToken();
+    virtual void reset(std::istream *in);
+
+private:
+    void advance();
+    void ignore();
+
+    std::istream m_input;
+};
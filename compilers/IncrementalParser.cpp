@@ -0,0 +1,362 @@
+#include "IncrementalParser.h"
+#include "Lexer.h"
+#include "Parser.h"
+#include "Token.h"
+
+#include <boost/unordered_map.hpp>
+
+#include <cctype>
+#include <cstring>
+#include <sstream>
+
+// Subprogram trees are small, and there is one arena for each.
+static const size_t kRegionArenaBlockSize = 4 * 1024;
+
+static unsigned long long fnv1a(const char *data, size_t length)
+{
+    unsigned long long hash = 14695981039346656037ULL;
+
+    for (size_t i = 0; i < length; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+// No token goes on past one of these, whatever comes after it.
+static bool endsToken(char c)
+{
+    return std::isspace(static_cast<unsigned char>(c)) || c == ';' || c == ',' || c == ')' || c == ']' || c == '}';
+}
+
+// Comments do not nest and there are no strings, so this is all it takes
+// to tell whether text stops inside a '{' comment.
+static bool endsInComment(const char *begin, const char *end)
+{
+    bool comment = false;
+
+    for (; begin != end; ++begin) {
+        if (*begin == '{') {
+            comment = true;
+        } else if (*begin == '}') {
+            comment = false;
+        }
+    }
+
+    return comment;
+}
+
+static boost::shared_ptr<Lexer> createLexer(const std::string &kind, const char *text, size_t length)
+{
+    std::istringstream in(std::string(text, length));
+    return boost::shared_ptr<Lexer>(Lexer::create(kind, &in));
+}
+
+IncrementalParser::IncrementalParser(const std::string &lexerKind)
+    : m_lexerKind(lexerKind)
+    , m_programTree(0)
+    , m_program(0)
+    , m_errorCount(0)
+    , m_maxReportedErrors(100)
+    , m_reused(0)
+    , m_parsed(0)
+{
+}
+
+void IncrementalParser::setText(const std::string &text)
+{
+    if (m_regions.empty()) {
+        m_regions.push_back(Region());
+        m_regions.back().length = m_text.size();
+    }
+
+    long delta = static_cast<long>(text.size()) - static_cast<long>(m_text.size());
+    m_text = text;
+
+    // everything is cut again, but unchanged subprograms are still found
+    reparse(0, m_regions.size() - 1, delta);
+}
+
+bool IncrementalParser::edit(size_t offset, size_t length, const std::string &text)
+{
+    if (offset > m_text.size() || length > m_text.size() - offset) {
+        return false;
+    }
+
+    if (m_regions.empty()) {
+        m_regions.push_back(Region());
+        m_regions.back().length = m_text.size();
+    }
+
+    // An edit at the very start or end of a region touches its neighbour
+    // too, since it may join or split their tokens.
+    size_t first = 0;
+    while (first + 1 < m_regions.size() && m_regions[first].end() < offset) {
+        ++first;
+    }
+
+    size_t last = first;
+    while (last + 1 < m_regions.size() && m_regions[last + 1].offset <= offset + length) {
+        ++last;
+    }
+
+    m_text.replace(offset, length, text);
+    reparse(first, last, static_cast<long>(text.size()) - static_cast<long>(length));
+
+    return true;
+}
+
+// Cuts [begin, end) of the text into regions at each 'function' and
+// 'procedure'. The last subprogram ends at the token after its closing
+// 'end;', where the main block starts. kind is what the old region at
+// begin was; false if the text no longer starts that way and the span has
+// to take in the region before.
+bool IncrementalParser::cut(size_t begin, size_t end, Region::Kind::Enum kind, std::vector<Region> &pieces) const
+{
+    boost::shared_ptr<Lexer> lexer = createLexer(m_lexerKind, m_text.data() + begin, end - begin);
+
+    std::vector<size_t> cuts;
+    size_t mainBlock = end;
+    int depth = 0;
+    bool closed = false;
+    bool finished = false;
+
+    for (;;) {
+        const Token &token = lexer->nextToken();
+        TokenType::Enum type = token.tokenType();
+
+        if (type == TokenType::Eof) {
+            break;
+        }
+
+        if (type == TokenType::Function || type == TokenType::Procedure) {
+            cuts.push_back(begin + token.offset());
+            mainBlock = end;
+            depth = 0;
+            closed = false;
+            finished = false;
+        } else if (finished) {
+            // only the text up to the end takes the main block in
+            if (mainBlock == end && end == m_text.size()) {
+                mainBlock = begin + token.offset();
+            }
+        } else if (cuts.empty()) {
+            continue;
+        } else if (type == TokenType::Begin) {
+            ++depth;
+        } else if (type == TokenType::End && depth > 0) {
+            closed = --depth == 0;
+        } else {
+            finished = closed && type == TokenType::Semicolon;
+            closed = false;
+        }
+    }
+
+    if (kind == Region::Kind::Subprogram && (cuts.empty() || cuts.front() != begin)) {
+        return false;
+    }
+    if (kind == Region::Kind::Main && !cuts.empty()) {
+        return false;
+    }
+
+    if (kind != Region::Kind::Subprogram) {
+        Region piece;
+        piece.kind = kind;
+        piece.offset = begin;
+        piece.length = (cuts.empty() ? end : cuts.front()) - begin;
+        pieces.push_back(piece);
+    }
+
+    for (size_t i = 0; i < cuts.size(); ++i) {
+        Region piece;
+        piece.kind = Region::Kind::Subprogram;
+        piece.offset = cuts[i];
+        piece.length = (i + 1 < cuts.size() ? cuts[i + 1] : mainBlock) - cuts[i];
+        pieces.push_back(piece);
+    }
+
+    if (mainBlock < end) {
+        Region piece;
+        piece.kind = Region::Kind::Main;
+        piece.offset = mainBlock;
+        piece.length = end - mainBlock;
+        pieces.push_back(piece);
+    }
+
+    return true;
+}
+
+// Parses the subprograms among pieces, or takes the tree of a spare region
+// with the same text.
+void IncrementalParser::parseSubprograms(std::vector<Region> &pieces, const std::vector<Region> &spare)
+{
+    boost::unordered_map<unsigned long long, const Region *> byHash;
+    for (std::vector<Region>::const_iterator i = spare.begin(); i != spare.end(); ++i) {
+        if (i->kind == Region::Kind::Subprogram && i->subprogram) {
+            byHash[i->hash] = &*i;
+        }
+    }
+
+    for (std::vector<Region>::iterator piece = pieces.begin(); piece != pieces.end(); ++piece) {
+        if (piece->kind != Region::Kind::Subprogram) {
+            continue;
+        }
+
+        const char *text = m_text.data() + piece->offset;
+        piece->hash = fnv1a(text, piece->length);
+
+        boost::unordered_map<unsigned long long, const Region *>::const_iterator found = byHash.find(piece->hash);
+        if (found != byHash.end() && found->second->length == piece->length &&
+            std::memcmp(found->second->lexer->source().data(), text, piece->length) == 0) {
+            piece->lexer = found->second->lexer;
+            piece->parser = found->second->parser;
+            piece->subprogram = found->second->subprogram;
+            ++m_reused;
+            continue;
+        }
+
+        piece->lexer = createLexer(m_lexerKind, text, piece->length);
+        piece->parser.reset(new Parser(kRegionArenaBlockSize));
+
+        std::ostringstream discard;
+        piece->parser->setErrorStream(discard);
+        piece->subprogram = piece->parser->parseSubprogram(piece->lexer);
+        ++m_parsed;
+
+        // a region holds exactly one subprogram
+        if (piece->parser->currentToken().tokenType() != TokenType::Eof) {
+            piece->subprogram = 0;
+        }
+    }
+}
+
+// The header and main block make a program without subprograms, which is
+// parsed again only when one of them changed.
+bool IncrementalParser::parseProgram()
+{
+    const Region &header = m_regions.front();
+    const Region &mainBlock = m_regions.back();
+
+    // a line break keeps the last token of one from running into the other
+    std::string source = m_text.substr(header.offset, header.length);
+    if (mainBlock.kind == Region::Kind::Main) {
+        source += "\n" + m_text.substr(mainBlock.offset, mainBlock.length);
+    }
+
+    if (m_programTree && source == m_programSource) {
+        ++m_reused;
+    } else {
+        m_programSource = source;
+        m_programLexer = createLexer(m_lexerKind, source.data(), source.size());
+        m_programParser.reset(new Parser);
+
+        std::ostringstream discard;
+        m_programParser->setErrorStream(discard);
+        m_programTree = m_programParser->parse(m_programLexer);
+        ++m_parsed;
+
+        if (m_programParser->errorCount() > 0 || m_programTree->functions) {
+            m_programTree = 0;
+        }
+    }
+
+    return m_programTree != 0;
+}
+
+// Parses the text in one piece, for its diagnostics.
+void IncrementalParser::parseWhole()
+{
+    std::ostringstream errors;
+
+    m_wholeLexer = createLexer(m_lexerKind, m_text.data(), m_text.size());
+    m_wholeParser.reset(new Parser);
+    m_wholeParser->setErrorStream(errors);
+    m_wholeParser->setMaxReportedErrors(m_maxReportedErrors);
+
+    m_program = m_wholeParser->parse(m_wholeLexer);
+    m_errorCount = m_wholeParser->errorCount();
+    m_diagnostics = errors.str();
+
+    if (m_errorCount > 0) {
+        m_program = 0;
+    }
+}
+
+ProgramPtr IncrementalParser::wholeProgram()
+{
+    parseWhole();
+    return m_program;
+}
+
+// Replaces regions first to last, which have grown by delta, with the
+// text now in their place.
+void IncrementalParser::reparse(size_t first, size_t last, long delta)
+{
+    m_reused = 0;
+    m_parsed = 0;
+
+    std::vector<Region> pieces;
+
+    for (;;) {
+        // the last subprogram's closing 'end;' decides where the main
+        // block starts
+        if (m_regions[last].kind == Region::Kind::Subprogram && last + 1 < m_regions.size() &&
+            m_regions[last + 1].kind == Region::Kind::Main) {
+            ++last;
+        }
+
+        size_t begin = m_regions[first].offset;
+        size_t end = m_regions[last].end() + delta;
+
+        // the span is lexed on its own, so it must not end in the middle
+        // of a comment or of a token that the next region carries on
+        if (end < m_text.size() && end > begin &&
+            (endsInComment(m_text.data() + begin, m_text.data() + end) || !endsToken(m_text[end - 1]))) {
+            last = m_regions.size() - 1;
+            continue;
+        }
+
+        pieces.clear();
+        if (cut(begin, end, m_regions[first].kind, pieces)) {
+            break;
+        }
+
+        // the header always cuts, so this stops there at the latest
+        --first;
+    }
+
+    std::vector<Region> spare(m_regions.begin() + first, m_regions.begin() + last + 1);
+    parseSubprograms(pieces, spare);
+
+    for (size_t i = last + 1; i < m_regions.size(); ++i) {
+        m_regions[i].offset += delta;
+    }
+
+    m_regions.erase(m_regions.begin() + first, m_regions.begin() + last + 1);
+    m_regions.insert(m_regions.begin() + first, pieces.begin(), pieces.end());
+
+    bool succeeded = parseProgram();
+
+    // regions that failed before and were not touched still fail
+    m_functions.list.clear();
+    for (std::vector<Region>::const_iterator i = m_regions.begin(); i != m_regions.end(); ++i) {
+        if (i->kind == Region::Kind::Subprogram) {
+            succeeded = succeeded && i->subprogram;
+            m_functions.list.push_back(i->subprogram);
+        }
+    }
+
+    m_wholeLexer.reset();
+    m_wholeParser.reset();
+
+    if (!succeeded) {
+        parseWhole();
+        return;
+    }
+
+    m_programTree->functions = m_functions.list.empty() ? 0 : &m_functions;
+    m_program = m_programTree;
+    m_errorCount = 0;
+    m_diagnostics.clear();
+}
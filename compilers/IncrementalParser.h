@@ -0,0 +1,111 @@
+#pragma once
+
+#include "Ast.h"
+#include "AstPrimitives.h"
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <string>
+#include <vector>
+
+class Lexer;
+class Parser;
+
+// Keeps the syntax tree of one document across edits, for editors that
+// reparse on every keystroke. The text is cut into regions at the
+// 'function' and 'procedure' keywords: the header up to the first
+// subprogram, one region per subprogram and the main block, which starts
+// after the last subprogram's closing 'end;'. An edit
+// relexes only the regions it touches and reparses only those whose text
+// changed; the rest keep their trees, found again by hash wherever they
+// moved to. The header and the main block are parsed together as a
+// program without subprograms, and the subprograms are hung under it.
+//
+// Subprograms are parsed on their own, so the line numbers in their tokens
+// count from the start of the region. Diagnostics come from a full parse
+// and read exactly as the batch compiler writes them.
+class IncrementalParser : private boost::noncopyable
+{
+public:
+    explicit IncrementalParser(const std::string &lexerKind = "dfa");
+
+    void setText(const std::string &text);
+    // replaces length bytes at offset with text; false if out of range
+    bool edit(size_t offset, size_t length, const std::string &text);
+
+    const std::string &text() const { return m_text; }
+
+    // the tree for the current text, null while it has syntax errors
+    ProgramPtr program() const { return m_program; }
+    // the current text parsed in one piece, so that the lines in its tokens
+    // are the document's; for messages about a tree that program() gave
+    ProgramPtr wholeProgram();
+    int errorCount() const { return m_errorCount; }
+    const std::string &diagnostics() const { return m_diagnostics; }
+    // see Parser::setMaxReportedErrors()
+    void setMaxReportedErrors(int count) { m_maxReportedErrors = count; }
+
+    // regions whose tree was kept and regions parsed again by the last
+    // setText() or edit(); the header and main block count as one
+    int reusedCount() const { return m_reused; }
+    int parsedCount() const { return m_parsed; }
+
+private:
+    struct Region
+    {
+        struct Kind
+        {
+            enum Enum
+            {
+                Header,
+                Subprogram,
+                Main
+            };
+        };
+
+        Region() : kind(Kind::Header), offset(0), length(0), hash(0), subprogram(0) {}
+
+        size_t end() const { return offset + length; }
+
+        Kind::Enum kind;
+        size_t offset;
+        size_t length;
+        unsigned long long hash;
+        // a subprogram's tree lives in its parser and points into the
+        // source held by its lexer
+        boost::shared_ptr<Lexer> lexer;
+        boost::shared_ptr<Parser> parser;
+        // null if the region did not parse
+        SubprogramDeclarationPtr subprogram;
+    };
+
+    void reparse(size_t first, size_t last, long delta);
+    bool cut(size_t begin, size_t end, Region::Kind::Enum kind, std::vector<Region> &pieces) const;
+    void parseSubprograms(std::vector<Region> &pieces, const std::vector<Region> &spare);
+    bool parseProgram();
+    void parseWhole();
+
+    std::string m_lexerKind;
+    std::string m_text;
+    // tiles m_text in order
+    std::vector<Region> m_regions;
+
+    // the header and main block as last parsed
+    std::string m_programSource;
+    boost::shared_ptr<Lexer> m_programLexer;
+    boost::shared_ptr<Parser> m_programParser;
+    ProgramPtr m_programTree;
+    SubprogramDeclarations m_functions;
+
+    // the fallback when the text has errors
+    boost::shared_ptr<Lexer> m_wholeLexer;
+    boost::shared_ptr<Parser> m_wholeParser;
+
+    ProgramPtr m_program;
+    int m_errorCount;
+    std::string m_diagnostics;
+    int m_maxReportedErrors;
+    int m_reused;
+    int m_parsed;
+};
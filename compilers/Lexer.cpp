@@ -1,43 +1,82 @@
 #include "Lexer.h"
+#include "DfaScanner.h"
+#include "SymbolTable.h"
 
-static const int kLineSize = 1024;
+#ifdef IMPASSE_HAVE_FLEX
+#include "FlexScanner.h"
+#endif
 
-Lexer::Lexer(std::istream *in, std::ostream *out)
-    : yyFlexLexer(in, out)
-    , m_column(1)
-    , m_line("")
+#include <iostream>
+
+Lexer::Lexer(std::istream *in)
+    : m_source(in ? *in : std::cin)
+    , m_offset(0)
+    , m_tokenOffset(0)
+    , m_lineStart(0)
+    , m_lineNumber(1)
+{
+}
+
+Lexer::~Lexer()
 {
-    m_line.reserve(kLineSize);
 }
 
-void Lexer::ignore()
+Lexer *Lexer::create(const std::string &kind, std::istream *in)
 {
-    std::string tokenValue = rawValue();
+    if (kind == "dfa") {
+        return new DfaScanner(in);
+    }
+#ifdef IMPASSE_HAVE_FLEX
+    if (kind == "flex") {
+        return new FlexScanner(in);
+    }
+#endif
+    return 0;
+}
 
-    m_line += tokenValue;
-    m_column += YYLeng();
+std::vector<std::string> Lexer::kinds()
+{
+    std::vector<std::string> kinds;
+    kinds.push_back("dfa");
+#ifdef IMPASSE_HAVE_FLEX
+    kinds.push_back("flex");
+#endif
+    return kinds;
 }
 
-std::string Lexer::rawValue() const
+void Lexer::reset(std::istream *in)
 {
-    return std::string(YYText(), YYLeng());
+    m_source.assign(in ? *in : std::cin);
+    m_token = Token();
+    m_offset = 0;
+    m_tokenOffset = 0;
+    m_lineStart = 0;
+    m_lineNumber = 1;
 }
 
+// Marks the next length characters as the current match.
+void Lexer::advance(int length)
+{
+    m_tokenOffset = m_offset;
+    m_offset += length;
+}
+
+// Called after a newline has been matched.
 void Lexer::resetLine()
 {
-    m_column = 1;
-    m_line.clear();
+    m_lineStart = m_offset;
+    ++m_lineNumber;
 }
 
-const std::string &Lexer::line() const
+int Lexer::column() const
 {
-    return m_line;
+    return m_tokenOffset - m_lineStart + 1;
 }
 
-const Token &Lexer::nextToken()
+// The current line up to the end of the last token, for diagnostics.
+std::string Lexer::line() const
 {
-    yylex();
-    return m_token;
+    return m_source.text(m_lineStart, m_offset - m_lineStart);
 }
 
 const Token &Lexer::token() const
@@ -47,77 +86,62 @@ const Token &Lexer::token() const
 
 int Lexer::addOp(OperatorType::Enum type)
 {
-    m_token = Token(rawValue(), lineno(), m_column, TokenType::AddOp, type);
-    m_line += rawValue();
-    m_column += YYLeng();
+    m_token = Token(m_source.data(), m_tokenOffset, matchLength(), m_lineNumber, column(), TokenType::AddOp, type);
     return TokenType::AddOp;
 }
 
 int Lexer::eof()
 {
-    m_token = Token(rawValue(), lineno(), m_column, TokenType::Eof);
+    m_token = Token(m_source.data(), m_offset, 0, m_lineNumber, m_offset - m_lineStart + 1, TokenType::Eof);
     return TokenType::Eof;
 }
 
 int Lexer::error()
 {
-    m_token = Token(rawValue(), lineno(), m_column, TokenType::Error);
-    m_line += rawValue();
+    m_token = Token(m_source.data(), m_tokenOffset, matchLength(), m_lineNumber, column(), TokenType::Error);
     return TokenType::Error;
 }
 
 int Lexer::identifier()
 {
-    m_token = Token(rawValue(), lineno(), m_column);
-    m_line += rawValue();
-    m_column += YYLeng();
+    SymbolTableEntry *entry = SymbolTable::instance().intern(m_source.data() + m_tokenOffset, matchLength());
+
+    m_token = Token::identifier(m_source.data(), m_tokenOffset, matchLength(), m_lineNumber, column(), entry);
     return TokenType::Identifier;
 }
 
 int Lexer::keyword(TokenType::Enum type)
 {
-    m_token = Token(rawValue(), lineno(), m_column, type);
-    m_line += rawValue();
-    m_column += YYLeng();
+    m_token = Token(m_source.data(), m_tokenOffset, matchLength(), m_lineNumber, column(), type);
     return type;
 }
 
 int Lexer::mulOp(OperatorType::Enum type)
 {
-    m_token = Token(rawValue(), lineno(), m_column, TokenType::MulOp, type);
-    m_line += rawValue();
-    m_column += YYLeng();
+    m_token = Token(m_source.data(), m_tokenOffset, matchLength(), m_lineNumber, column(), TokenType::MulOp, type);
     return TokenType::MulOp;
 }
 
 int Lexer::number(NumberType::Enum number)
 {
-    m_token = Token(rawValue(), lineno(), m_column, number);
-    m_line += rawValue();
-    m_column += YYLeng();
+    m_token = Token::number(m_source.data(), m_tokenOffset, matchLength(), m_lineNumber, column(), number);
     return number;
 }
 
 int Lexer::oper(TokenType::Enum type)
 {
-    m_token = Token(rawValue(), lineno(), m_column, type);
-    m_line += rawValue();
-    m_column += YYLeng();
+    m_token = Token(m_source.data(), m_tokenOffset, matchLength(), m_lineNumber, column(), type);
     return type;
 }
 
 int Lexer::punctuation(TokenType::Enum type)
 {
-    m_token = Token(rawValue(), lineno(), m_column, type);
-    m_line += rawValue();
-    m_column += YYLeng();
+    m_token = Token(m_source.data(), m_tokenOffset, matchLength(), m_lineNumber, column(), type);
     return type;
 }
 
 int Lexer::relOp(OperatorType::Enum type)
 {
-    m_token = Token(rawValue(), lineno(), m_column, TokenType::RelOp, type);
-    m_line += rawValue();
-    m_column += YYLeng();
+    m_token = Token(m_source.data(), m_tokenOffset, matchLength(), m_lineNumber, column(), TokenType::RelOp, type);
     return TokenType::RelOp;
 }
@@ -1,24 +1,41 @@
 #pragma once
 
+#include "SourceBuffer.h"
 #include "Token.h"
 
-#include <FlexLexer.h>
+#include <boost/noncopyable.hpp>
 
-class Lexer : public yyFlexLexer
+#include <istream>
+#include <string>
+#include <vector>
+
+// Common base of the scanners. It owns the buffered source and the current
+// token and tracks positions; a scanner only has to find where each token
+// ends and call one of the token helpers.
+class Lexer : private boost::noncopyable
 {
 public:
-    Lexer(std::istream *in = 0, std::ostream *out = 0);
+    explicit Lexer(std::istream *in = 0);
+    virtual ~Lexer();
+
+    // "dfa" or, when built with flex, "flex"; returns 0 for anything else
+    static Lexer *create(const std::string &kind, std::istream *in = 0);
+    static std::vector<std::string> kinds();
+
+    virtual const Token &nextToken() = 0;
 
-    virtual int yylex();
+    // starts over on a new input, keeping the lexer's buffers
+    virtual void reset(std::istream *in);
 
-    const std::string &line() const;
-    const Token &nextToken();
+    std::string line() const;
     const Token &token() const;
 
-private:
-    void ignore();
-    std::string rawValue() const;
+    const SourceBuffer &source() const { return m_source; }
+
+protected:
+    void advance(int length);
     void resetLine();
+    int column() const;
 
     int addOp(OperatorType::Enum type);
     int eof();
@@ -31,7 +48,15 @@ private:
     int punctuation(TokenType::Enum type);
     int relOp(OperatorType::Enum type);
 
+    int matchLength() const { return m_offset - m_tokenOffset; }
+
+    SourceBuffer m_source;
     Token m_token;
-    int m_column;
-    std::string m_line;
+
+    // offsets into m_source: the end of the text matched so far, the start
+    // of the last match and the start of the current line
+    int m_offset;
+    int m_tokenOffset;
+    int m_lineStart;
+    int m_lineNumber;
 };
@@ -0,0 +1,174 @@
+#include "Lexer.h"
+#include "Token.h"
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Scans the same input with every available lexer and reports tokens per
+// second. The token streams are compared as well, so it doubles as a check
+// that the scanners agree.
+
+struct ScannedToken
+{
+    int type;
+    int oper;
+    int number;
+    int offset;
+    int length;
+    int line;
+    int column;
+
+    bool operator!=(const ScannedToken &other) const
+    {
+        return type != other.type || oper != other.oper || number != other.number ||
+            offset != other.offset || length != other.length || line != other.line || column != other.column;
+    }
+};
+
+// A program that exercises every token class: mixed-case keywords, word
+// operators, reals with and without exponents, ranges and comments.
+static std::string syntheticProgram(int lines)
+{
+    std::ostringstream out;
+
+    out << "PROGRAM synthetic(input, output);\n";
+    out << "var a : ARRAY [1..100] of Integer;\n";
+    out << "var x, y, total : real;\n";
+    out << "var i, j : integer;\n";
+    out << "BEGIN\n";
+
+    for (int i = 0; i < lines; ++i) {
+        switch (i % 6) {
+        case 0:
+            out << "    { iteration " << i << " }\n";
+            break;
+        case 1:
+            out << "    x := " << i << ".25e-3 * y + total / 2.5;\n";
+            break;
+        case 2:
+            out << "    If (i >= " << i << ") AND NOT (j <> 0) then i := i div 3 else j := j mod 7;\n";
+            break;
+        case 3:
+            out << "    while (i <= 10) or (j < 4) do i := i - 1;\n";
+            break;
+        case 4:
+            out << "    a[i] := a[j] + identifier" << i % 97 << " * 1E+4;\n";
+            break;
+        default:
+            out << "    total := total + x{inline}; writeln(total, i, j)\n";
+            break;
+        }
+    }
+
+    out << "    i := 0\n";
+    out << "END.\n";
+
+    return out.str();
+}
+
+static void scan(const std::string &kind, const std::string &source, std::vector<ScannedToken> &tokens, double &seconds)
+{
+    std::istringstream in(source);
+    boost::scoped_ptr<Lexer> lexer(Lexer::create(kind, &in));
+
+    tokens.clear();
+
+    // reading the input happens in the constructor and is not timed
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+
+    for (;;) {
+        const Token &token = lexer->nextToken();
+        ScannedToken scanned = {
+            token.tokenType(), token.operatorType(), token.numberType(),
+            token.offset(), token.length(), token.line(), token.column()
+        };
+        tokens.push_back(scanned);
+
+        if (token.tokenType() == TokenType::Eof) {
+            break;
+        }
+    }
+
+    boost::posix_time::time_duration elapsed = boost::posix_time::microsec_clock::universal_time() - start;
+    seconds = elapsed.total_microseconds() / 1e6;
+}
+
+int main(int argc, char const *argv[])
+{
+    int lines = 200000;
+    int runs = 5;
+    std::string source;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+
+        if (arg == "--lines" && i + 1 < argc) {
+            lines = std::atoi(argv[++i]);
+        } else if (arg == "--runs" && i + 1 < argc) {
+            runs = std::atoi(argv[++i]);
+        } else if (arg == "--input" && i + 1 < argc) {
+            std::ifstream file(argv[++i]);
+            if (!file) {
+                std::cerr << "cannot open " << argv[i] << std::endl;
+                return 1;
+            }
+            std::ostringstream contents;
+            contents << file.rdbuf();
+            source = contents.str();
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--lines N | --input program.pas] [--runs N]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (source.empty()) {
+        source = syntheticProgram(lines);
+    }
+
+    std::cout << "input: " << source.size() << " bytes, " << runs << " runs per lexer" << std::endl;
+
+    std::vector<std::string> kinds = Lexer::kinds();
+    std::vector<ScannedToken> reference;
+    bool agree = true;
+
+    for (std::vector<std::string>::const_iterator kind = kinds.begin(); kind != kinds.end(); ++kind) {
+        std::vector<ScannedToken> tokens;
+        double best = 0;
+
+        for (int run = 0; run < runs; ++run) {
+            double seconds = 0;
+            scan(*kind, source, tokens, seconds);
+            if (run == 0 || seconds < best) {
+                best = seconds;
+            }
+        }
+
+        std::cout << *kind << ": " << tokens.size() << " tokens, best " << best * 1000 << " ms, "
+            << (best > 0 ? tokens.size() / best / 1e6 : 0.0) << " M tokens/s, "
+            << (best > 0 ? source.size() / best / (1024 * 1024) : 0.0) << " MB/s" << std::endl;
+
+        if (kind == kinds.begin()) {
+            reference = tokens;
+        } else if (tokens.size() != reference.size()) {
+            std::cout << *kind << ": token count differs from " << kinds.front() << std::endl;
+            agree = false;
+        } else {
+            for (size_t i = 0; i < tokens.size(); ++i) {
+                if (tokens[i] != reference[i]) {
+                    std::cout << *kind << ": token " << i << " at line " << tokens[i].line << " differs from " << kinds.front() << std::endl;
+                    agree = false;
+                    break;
+                }
+            }
+        }
+    }
+
+    return agree ? 0 : 1;
+}
@@ -3,6 +3,7 @@
 #include "Lexer.h"
 
 #include <algorithm>
+#include <cstring>
 #include <iostream>
 
 namespace ErrorCodes
@@ -36,11 +37,35 @@ namespace ErrorCodes
     };
 };
 
-static std::string codeToMessage(int errorCode);
+static const char *codeToMessage(int errorCode);
 
-Parser::Parser()
-    : m_errorCode(ErrorCodes::NoError)
+// Each range of token types gets a run of bits, so that the sets panic()
+// synchronizes on are single words.
+static boost::uint64_t tokenBit(TokenType::Enum type)
+{
+    int index = type & 0xfff;
+
+    switch (type & 0xf000) {
+    case 0:
+        return boost::uint64_t(1) << index;
+    case TokenType::Keywords:
+        return boost::uint64_t(1) << (2 + index);
+    case TokenType::Operators:
+        return boost::uint64_t(1) << (18 + index);
+    case TokenType::Punctuation:
+        return boost::uint64_t(1) << (25 + index);
+    }
+
+    return type == TokenType::Invalid ? boost::uint64_t(1) << 63 : boost::uint64_t(1) << (34 + index);
+}
+
+Parser::Parser(size_t arenaBlockSize)
+    : m_arena(arenaBlockSize)
+    , m_errorCode(ErrorCodes::NoError)
     , m_errorCount(0)
+    , m_errors(&std::cerr)
+    , m_maxReportedErrors(100)
+    , m_openParens(0)
 {
 }
 
@@ -56,9 +81,48 @@ int Parser::errorCount() const
 
 ProgramPtr Parser::parse(boost::shared_ptr<Lexer> lexer)
 {
+    m_arena.clear();
+    m_errorCode = ErrorCodes::NoError;
+    m_errorCount = 0;
+    m_diagnostics.clear();
+    m_openParens = 0;
+
     m_lexer = lexer;
     m_curToken = m_lexer->nextToken();
-    return parseProgram();
+    ProgramPtr program = parseProgram();
+
+    outputErrors();
+    return program;
+}
+
+SubprogramDeclarationPtr Parser::parseSubprogram(boost::shared_ptr<Lexer> lexer)
+{
+    m_arena.clear();
+    m_errorCode = ErrorCodes::NoError;
+    m_errorCount = 0;
+    m_diagnostics.clear();
+    m_openParens = 0;
+
+    m_lexer = lexer;
+    m_curToken = m_lexer->nextToken();
+    SubprogramDeclarationPtr sub = parseSubprogramDeclaration();
+
+    if (m_errorCode == ErrorCodes::NoError && !match(TokenType::Semicolon)) {
+        reportError(ErrorCodes::ExpectedSemicolon);
+    }
+
+    outputErrors();
+    return m_errorCount > 0 ? SubprogramDeclarationPtr() : sub;
+}
+
+void Parser::setErrorStream(std::ostream &stream)
+{
+    m_errors = &stream;
+}
+
+void Parser::setMaxReportedErrors(int count)
+{
+    m_maxReportedErrors = count;
 }
 
 bool Parser::match(TokenType::Enum tokenType)
@@ -71,12 +135,9 @@ bool Parser::match(TokenType::Enum tokenType)
     return match;
 }
 
-void Parser::panic(const TokenType::Enum synchronizingTokens[], int numElements)
+void Parser::panic(boost::uint64_t follow)
 {
-    const TokenType::Enum *begin = synchronizingTokens;
-    const TokenType::Enum *end = synchronizingTokens + numElements;
-
-    while (std::find(begin, end, m_curToken.tokenType()) == end) {
+    while (!(follow & tokenBit(m_curToken.tokenType()))) {
         m_curToken = m_lexer->nextToken();
 
         if (m_curToken.tokenType() == TokenType::Eof) {
@@ -88,75 +149,133 @@ void Parser::panic(const TokenType::Enum synchronizingTokens[], int numElements)
     m_errorCode = ErrorCodes::Recovering;
 }
 
+// A ')' ends an expression only inside parentheses. Anywhere else it is
+// part of the error and is skipped with the rest.
+void Parser::panicInExpression(boost::uint64_t follow)
+{
+    if (m_openParens == 0) {
+        follow &= ~tokenBit(TokenType::RParen);
+    }
+
+    panic(follow);
+}
+
+// Only records the error: the text is written by outputErrors(), and not
+// at all past the cap, so files full of errors cost no more than the
+// recovery itself.
 void Parser::reportError(int errorCode)
 {
     m_errorCode = errorCode;
+    ++m_errorCount;
+
+    if (m_maxReportedErrors > 0 && m_diagnostics.size() >= static_cast<size_t>(m_maxReportedErrors)) {
+        return;
+    }
+
+    // the lexer has read up to the end of the current token
+    int lineOffset = m_curToken.offset() - (m_curToken.column() - 1);
+
+    Diagnostic diagnostic = {
+        errorCode, m_curToken.tokenType() == TokenType::Error,
+        m_curToken.line(), m_curToken.column(), m_curToken.length(),
+        lineOffset, m_curToken.offset() + m_curToken.length() - lineOffset
+    };
+    m_diagnostics.push_back(diagnostic);
+}
 
-    std::cerr << "ERROR in line " << m_curToken.line() << ": ";
-    if (m_curToken.tokenType() == TokenType::Error) {
-        std::cerr << "Illegal character";
-    } else {
-        std::cerr << codeToMessage(errorCode);
+static void writeRepeated(std::ostream &out, char c, int count)
+{
+    char buffer[64];
+    std::memset(buffer, c, sizeof(buffer));
+
+    for (; count > 0; count -= sizeof(buffer)) {
+        out.write(buffer, std::min<int>(count, sizeof(buffer)));
     }
-    std::cerr << std::endl;
-    std::cerr << "\t" << m_lexer->line() << std::endl;
+}
 
-    std::cerr << "\t";
-    for (int i = 1; i < m_curToken.column(); ++i) {
-        std::cerr << " ";
+void Parser::outputErrors()
+{
+    if (m_errorCount == 0) {
+        return;
     }
 
-    std::cerr << "^";
-    for (int i = 0; i < m_curToken.value().size() - 1; ++i) {
-        std::cerr << "~";
+    std::ostream &out = *m_errors;
+    const char *source = m_lexer->source().data();
+
+    for (std::vector<Diagnostic>::const_iterator i = m_diagnostics.begin(); i != m_diagnostics.end(); ++i) {
+        out << "ERROR in line " << i->line << ": ";
+        out << (i->illegalCharacter ? "Illegal character" : codeToMessage(i->errorCode)) << "\n";
+
+        out << "\t";
+        out.write(source + i->lineOffset, i->lineLength);
+        out << "\n";
+
+        out << "\t";
+        writeRepeated(out, ' ', i->column - 1);
+        out << "^";
+        writeRepeated(out, '~', i->length - 1);
+        out << "\n";
     }
 
-    std::cerr << std::endl;
+    if (static_cast<size_t>(m_errorCount) > m_diagnostics.size()) {
+        out << "... and " << m_errorCount - m_diagnostics.size() << " more errors" << "\n";
+    }
 
-    ++m_errorCount;
+    out.flush();
 }
 
 DeclarationsPtr Parser::parseArgumentList()
+{
+    DeclarationsPtr declarations = m_arena.create<Declarations>();
+    if (!parseArgumentGroup(declarations)) {
+        return DeclarationsPtr();
+    }
+
+    parseArgumentList_r(declarations);
+
+    return declarations;
+}
+
+void Parser::parseArgumentList_r(DeclarationsPtr declarations)
+{
+    while (match(TokenType::Semicolon)) {
+        if (!parseArgumentGroup(declarations)) {
+            return;
+        }
+    }
+}
+
+bool Parser::parseArgumentGroup(DeclarationsPtr declarations)
 {
     IdentifiersPtr identifiers = parseIdentifierList();
     if (m_errorCode > ErrorCodes::NoError) {
-        return DeclarationsPtr();
+        return false;
     }
 
     if (!match(TokenType::Colon)) {
         reportError(ErrorCodes::ExpectedColon);
-        return DeclarationsPtr();
+        return false;
     }
 
     TypePtr type = parseType();
     if (m_errorCode > ErrorCodes::NoError) {
-        return DeclarationsPtr();
+        return false;
+    }
+
+    // a list that was recovered from comes back empty
+    if (!identifiers) {
+        return true;
     }
 
-    DeclarationsPtr declarations(new Declarations);
     for (std::vector<IdentifierPtr>::const_iterator i = identifiers->list.begin(); i != identifiers->list.end(); ++i) {
-        DeclarationPtr declaration(new Declaration);
+        DeclarationPtr declaration = m_arena.create<Declaration>();
         declaration->id = *i;
         declaration->type = type;
 
         declarations->list.push_back(declaration);
     }
 
-    DeclarationsPtr rest = parseArgumentList_r();
-    if (rest) {
-        declarations->list.insert(declarations->list.end(), rest->list.begin(), rest->list.end());
-    }
-
-    return declarations;
-}
-
-DeclarationsPtr Parser::parseArgumentList_r()
-{
-    if (match(TokenType::Semicolon)) {
-        return parseArgumentList();
-    }
-
-    return DeclarationsPtr();
+    return true;
 }
 
 void Parser::parseArguments(SubprogramDeclarationPtr sub)
@@ -174,25 +293,23 @@ void Parser::parseArguments(SubprogramDeclarationPtr sub)
     }
 }
 
-static const TokenType::Enum compoundStatementFollow[] = {
-    TokenType::Eof,
-    TokenType::Period,
-    TokenType::Semicolon,
-};
-static const int compoundStatementFollowSize = 3;
+static const boost::uint64_t compoundStatementFollow =
+    tokenBit(TokenType::Eof) |
+    tokenBit(TokenType::Period) |
+    tokenBit(TokenType::Semicolon);
 
 CompoundStatementPtr Parser::parseCompoundStatement()
 {
     if (!match(TokenType::Begin)) {
         reportError(ErrorCodes::ExpectedBegin);
 
-        panic(compoundStatementFollow, compoundStatementFollowSize);
+        panic(compoundStatementFollow);
         return CompoundStatementPtr();
     }
 
     StatementsPtr statements = parseOptionalStatements();
     if (m_errorCode && m_errorCode != ErrorCodes::ExpectedStatement) {
-        panic(compoundStatementFollow, compoundStatementFollowSize);
+        panic(compoundStatementFollow);
         return CompoundStatementPtr();
     }
 
@@ -201,69 +318,71 @@ CompoundStatementPtr Parser::parseCompoundStatement()
     if (!match(TokenType::End)) {
         reportError(ErrorCodes::ExpectedEnd);
 
-        panic(compoundStatementFollow, compoundStatementFollowSize);
+        panic(compoundStatementFollow);
         return CompoundStatementPtr();
     }
 
-    CompoundStatementPtr compoundStatement(new CompoundStatement);
+    CompoundStatementPtr compoundStatement = m_arena.create<CompoundStatement>();
     compoundStatement->statements = statements;
 
     return compoundStatement;
 }
 
-static const TokenType::Enum declarationsFollow[] = {
-    TokenType::Var,
-    TokenType::Procedure,
-    TokenType::Function,
-    TokenType::Begin,
-    TokenType::Eof
-};
-static const int declarationsFollowSize = 5;
+static const boost::uint64_t declarationsFollow =
+    tokenBit(TokenType::Var) |
+    tokenBit(TokenType::Procedure) |
+    tokenBit(TokenType::Function) |
+    tokenBit(TokenType::Begin) |
+    tokenBit(TokenType::Eof);
 
 DeclarationsPtr Parser::parseDeclarations()
 {
-    if (!match(TokenType::Var)) {
-        return DeclarationsPtr();
-    }
+    // each 'var' line is appended to one list; an error keeps what was
+    // parsed before it
+    DeclarationsPtr declarations = DeclarationsPtr();
 
-    IdentifiersPtr identifiers = parseIdentifierList();
-    if (m_errorCode > ErrorCodes::NoError) {
-        panic(declarationsFollow, declarationsFollowSize);
-        return DeclarationsPtr();
-    }
+    while (match(TokenType::Var)) {
+        IdentifiersPtr identifiers = parseIdentifierList();
+        if (m_errorCode > ErrorCodes::NoError) {
+            panic(declarationsFollow);
+            return declarations;
+        }
 
-    if (!match(TokenType::Colon)) {
-        reportError(ErrorCodes::ExpectedColon);
+        if (!match(TokenType::Colon)) {
+            reportError(ErrorCodes::ExpectedColon);
 
-        panic(declarationsFollow, declarationsFollowSize);
-        return DeclarationsPtr();
-    }
+            panic(declarationsFollow);
+            return declarations;
+        }
 
-    TypePtr type = parseType();
-    if (m_errorCode > ErrorCodes::NoError) {
-        panic(declarationsFollow, declarationsFollowSize);
-        return DeclarationsPtr();
-    }
+        TypePtr type = parseType();
+        if (m_errorCode > ErrorCodes::NoError) {
+            panic(declarationsFollow);
+            return declarations;
+        }
 
-    if (!match(TokenType::Semicolon)) {
-        reportError(ErrorCodes::ExpectedSemicolon);
+        if (!match(TokenType::Semicolon)) {
+            reportError(ErrorCodes::ExpectedSemicolon);
 
-        panic(declarationsFollow, declarationsFollowSize);
-        return DeclarationsPtr();
-    }
+            panic(declarationsFollow);
+            return declarations;
+        }
 
-    DeclarationsPtr declarations(new Declarations);
-    for (std::vector<IdentifierPtr>::const_iterator i = identifiers->list.begin(); i != identifiers->list.end(); ++i) {
-        DeclarationPtr declaration(new Declaration);
-        declaration->id = *i;
-        declaration->type = type;
+        if (!declarations) {
+            declarations = m_arena.create<Declarations>();
+        }
 
-        declarations->list.push_back(declaration);
-    }
+        if (!identifiers) {
+            continue;
+        }
+
+        for (std::vector<IdentifierPtr>::const_iterator i = identifiers->list.begin(); i != identifiers->list.end(); ++i) {
+            DeclarationPtr declaration = m_arena.create<Declaration>();
+            declaration->id = *i;
+            declaration->type = type;
 
-    DeclarationsPtr rest = parseDeclarations();
-    if (rest) {
-        declarations->list.insert(declarations->list.end(), rest->list.begin(), rest->list.end());
+            declarations->list.push_back(declaration);
+        }
     }
 
     return declarations;
@@ -271,7 +390,7 @@ DeclarationsPtr Parser::parseDeclarations()
 
 ExpressionPtr Parser::parseExpression()
 {
-    RelOpExpressionPtr expr(new RelOpExpression);
+    RelOpExpressionPtr expr = m_arena.create<RelOpExpression>();
 
     expr->lhs = parseSimpleExpression();
     parseExpression_p(expr);
@@ -296,17 +415,22 @@ void Parser::parseExpression_p(RelOpExpressionPtr expr)
     return;
 }
 
+bool Parser::startsExpression() const
+{
+    return m_curToken.tokenType() == TokenType::Identifier ||
+           m_curToken.tokenType() == TokenType::AddOp ||
+           m_curToken.tokenType() == TokenType::Number ||
+           m_curToken.tokenType() == TokenType::LParen ||
+           m_curToken.tokenType() == TokenType::Not;
+}
+
 ExpressionsPtr Parser::parseExpressionList()
 {
-    if (m_curToken.tokenType() != TokenType::Identifier &&
-        m_curToken.tokenType() != TokenType::AddOp &&
-        m_curToken.tokenType() != TokenType::Number &&
-        m_curToken.tokenType() != TokenType::LParen &&
-        m_curToken.tokenType() != TokenType::Not) {
+    if (!startsExpression()) {
         return ExpressionsPtr();
     }
 
-    ExpressionsPtr expressions(new Expressions);
+    ExpressionsPtr expressions = m_arena.create<Expressions>();
 
     ExpressionPtr curExpression = parseExpression();
     if (m_errorCode > ErrorCodes::NoError) {
@@ -315,43 +439,45 @@ ExpressionsPtr Parser::parseExpressionList()
 
     expressions->list.push_back(curExpression);
 
-    ExpressionsPtr rest = parseExpressionList_r();
-    if (rest) {
-        expressions->list.insert(expressions->list.end(), rest->list.begin(), rest->list.end());
-    }
+    parseExpressionList_r(expressions);
 
     return expressions;
 }
 
-ExpressionsPtr Parser::parseExpressionList_r()
+void Parser::parseExpressionList_r(ExpressionsPtr expressions)
 {
-    if (match(TokenType::Comma)) {
-        return parseExpressionList();
-    }
+    while (match(TokenType::Comma)) {
+        if (!startsExpression()) {
+            return;
+        }
 
-    return ExpressionsPtr();
+        ExpressionPtr curExpression = parseExpression();
+        if (m_errorCode > ErrorCodes::NoError) {
+            return;
+        }
+
+        expressions->list.push_back(curExpression);
+    }
 }
 
-static const TokenType::Enum factorFollow[] = {
-    TokenType::Do,
-    TokenType::End,
-    TokenType::Eof,
-    TokenType::MulOp,
-    TokenType::Period,
-    TokenType::Semicolon,
-    TokenType::RelOp,
-    TokenType::RParen,
-};
-static const int factorFollowSize = 7;
+static const boost::uint64_t factorFollow =
+    tokenBit(TokenType::Do) |
+    tokenBit(TokenType::End) |
+    tokenBit(TokenType::Eof) |
+    tokenBit(TokenType::MulOp) |
+    tokenBit(TokenType::Period) |
+    tokenBit(TokenType::RParen) |
+    tokenBit(TokenType::Semicolon) |
+    tokenBit(TokenType::RelOp);
 
 FactorPtr Parser::parseFactor()
 {
-    FactorPtr factor(new Factor);
+    FactorPtr factor = m_arena.create<Factor>();
 
     if (m_curToken.tokenType() == TokenType::Number) {
         factor->number = parseNumber();
         if (m_errorCode > ErrorCodes::NoError) {
-            panic(factorFollow, factorFollowSize);
+            panicInExpression(factorFollow);
             return FactorPtr();
         }
 
@@ -359,16 +485,18 @@ FactorPtr Parser::parseFactor()
     } else if (m_curToken.tokenType() == TokenType::LParen) {
         match(TokenType::LParen);
 
+        ++m_openParens;
         ExpressionPtr expr = parseExpression();
+        --m_openParens;
         if (m_errorCode > ErrorCodes::NoError) {
-            panic(factorFollow, factorFollowSize);
+            panicInExpression(factorFollow);
             return FactorPtr();
         }
 
         if (!match(TokenType::RParen)) {
             reportError(ErrorCodes::ExpectedRParen);
 
-            panic(factorFollow, factorFollowSize);
+            panicInExpression(factorFollow);
             return FactorPtr();
         }
 
@@ -379,7 +507,7 @@ FactorPtr Parser::parseFactor()
 
         factor->negatedFactor = parseFactor();
         if (m_errorCode > ErrorCodes::NoError) {
-            panic(factorFollow, factorFollowSize);
+            panicInExpression(factorFollow);
             return FactorPtr();
         }
 
@@ -388,13 +516,13 @@ FactorPtr Parser::parseFactor()
 
     IdentifierPtr identifier = parseIdentifier();
     if (m_errorCode > ErrorCodes::NoError) {
-        panic(factorFollow, factorFollowSize);
+        panicInExpression(factorFollow);
         return FactorPtr();
     }
 
     parseFactor_p(identifier);
     if (m_errorCode > ErrorCodes::NoError) {
-        panic(factorFollow, factorFollowSize);
+        panicInExpression(factorFollow);
         return FactorPtr();
     }
 
@@ -408,22 +536,24 @@ void Parser::parseFactor_p(IdentifierPtr id)
         id->index = parseOptionalIndex();
         return;
     } else if (match(TokenType::LParen)) {
+        ++m_openParens;
         id->parameters = parseExpressionList();
+        --m_openParens;
         if (m_errorCode > ErrorCodes::NoError) {
-            panic(factorFollow, factorFollowSize);
+            panicInExpression(factorFollow);
             return;
         }
 
         if (!match(TokenType::RParen)) {
             reportError(ErrorCodes::ExpectedRParen);
 
-            panic(factorFollow, factorFollowSize);
+            panicInExpression(factorFollow);
             return;
         }
 
         if (!id->parameters) {
             // empty param list
-            ExpressionsPtr tmp(new Expressions);
+            ExpressionsPtr tmp = m_arena.create<Expressions>();
             id->parameters = tmp;
         }
 
@@ -441,45 +571,44 @@ IdentifierPtr Parser::parseIdentifier()
         return IdentifierPtr();
     }
 
-    IdentifierPtr id(new Identifier);
+    IdentifierPtr id = m_arena.create<Identifier>();
     id->id = curIdentifier;
 
     return id;
 }
 
-static const TokenType::Enum identifierListFollow[] = {
-    TokenType::Colon,
-    TokenType::Semicolon,
-    TokenType::RParen,
-};
-static const int identifierListFollowSize = 3;
+static const boost::uint64_t identifierListFollow =
+    tokenBit(TokenType::Colon) |
+    tokenBit(TokenType::Semicolon) |
+    tokenBit(TokenType::RParen);
 
 IdentifiersPtr Parser::parseIdentifierList()
 {
     IdentifierPtr curIdentifier = parseIdentifier();
     if (m_errorCode > ErrorCodes::NoError) {
-        panic(identifierListFollow, identifierListFollowSize);
+        panic(identifierListFollow);
         return IdentifiersPtr();
     }
 
-    IdentifiersPtr identifiers(new Identifiers);
+    IdentifiersPtr identifiers = m_arena.create<Identifiers>();
     identifiers->list.push_back(curIdentifier);
 
-    IdentifiersPtr rest = parseIdentifierList_r();
-    if (rest) {
-        identifiers->list.insert(identifiers->list.end(), rest->list.begin(), rest->list.end());
-    }
+    parseIdentifierList_r(identifiers);
 
     return identifiers;
 }
 
-IdentifiersPtr Parser::parseIdentifierList_r()
+void Parser::parseIdentifierList_r(IdentifiersPtr identifiers)
 {
-    if (match(TokenType::Comma)) {
-        return parseIdentifierList();
-    }
+    while (match(TokenType::Comma)) {
+        IdentifierPtr curIdentifier = parseIdentifier();
+        if (m_errorCode > ErrorCodes::NoError) {
+            panic(identifierListFollow);
+            return;
+        }
 
-    return IdentifiersPtr();
+        identifiers->list.push_back(curIdentifier);
+    }
 }
 
 NumberPtr Parser::parseNumber()
@@ -490,35 +619,33 @@ NumberPtr Parser::parseNumber()
         return NumberPtr();
     }
 
-    NumberPtr number(new Number);
+    NumberPtr number = m_arena.create<Number>();
     number->value = numberValue;
 
     return number;
 }
 
-static const TokenType::Enum optionalIndexFollow[] = {
-    TokenType::Assign,
-    TokenType::End,
-    TokenType::Eof,
-    TokenType::MulOp,
-    TokenType::Period,
-    TokenType::Semicolon,
-};
-static const int optionalIndexFollowSize = 6;
+static const boost::uint64_t optionalIndexFollow =
+    tokenBit(TokenType::Assign) |
+    tokenBit(TokenType::End) |
+    tokenBit(TokenType::Eof) |
+    tokenBit(TokenType::MulOp) |
+    tokenBit(TokenType::Period) |
+    tokenBit(TokenType::Semicolon);
 
 ExpressionPtr Parser::parseOptionalIndex()
 {
     if (match(TokenType::LBracket)) {
         ExpressionPtr indexExpression = parseExpression();
         if (m_errorCode > ErrorCodes::NoError) {
-            panic(optionalIndexFollow, optionalIndexFollowSize);
+            panic(optionalIndexFollow);
             return ExpressionPtr();
         }
 
         if (!match(TokenType::RBracket)) {
             reportError(ErrorCodes::ExpectedRBracket);
 
-            panic(optionalIndexFollow, optionalIndexFollowSize);
+            panic(optionalIndexFollow);
             return ExpressionPtr();
         }
 
@@ -531,7 +658,9 @@ ExpressionPtr Parser::parseOptionalIndex()
 ExpressionsPtr Parser::parseOptionalParameters()
 {
     if (match(TokenType::LParen)) {
+        ++m_openParens;
         ExpressionsPtr parameters = parseExpressionList();
+        --m_openParens;
         if (m_errorCode > ErrorCodes::NoError) {
             return ExpressionsPtr();
         }
@@ -543,7 +672,7 @@ ExpressionsPtr Parser::parseOptionalParameters()
 
         if (!parameters) {
             // empty parameter list
-            ExpressionsPtr tmp(new Expressions);
+            ExpressionsPtr tmp = m_arena.create<Expressions>();
             parameters = tmp;
         }
 
@@ -553,13 +682,11 @@ ExpressionsPtr Parser::parseOptionalParameters()
     return ExpressionsPtr();
 }
 
-static const TokenType::Enum optionalStatementsFollow[] = {
-    TokenType::End,
-    TokenType::Eof,
-    TokenType::Period,
-    TokenType::Semicolon,
-};
-static const int optionalStatementsFollowSize = 4;
+static const boost::uint64_t optionalStatementsFollow =
+    tokenBit(TokenType::End) |
+    tokenBit(TokenType::Eof) |
+    tokenBit(TokenType::Period) |
+    tokenBit(TokenType::Semicolon);
 
 StatementsPtr Parser::parseOptionalStatements()
 {
@@ -572,86 +699,84 @@ StatementsPtr Parser::parseOptionalStatements()
 
     StatementsPtr statements = parseStatementList();
     if (m_errorCode > ErrorCodes::NoError) {
-        panic(optionalStatementsFollow, optionalStatementsFollowSize);
+        panic(optionalStatementsFollow);
         return StatementsPtr();
     }
 
     return statements;
 }
 
-static const TokenType::Enum programFollow[] = {
-    TokenType::Eof,
-};
-static const int programFollowSize = 1;
+static const boost::uint64_t programFollow =
+    tokenBit(TokenType::Eof);
 
 ProgramPtr Parser::parseProgram()
 {
     if (!match(TokenType::Program)) {
         reportError(ErrorCodes::ExpectedProgram);
 
-        panic(programFollow, programFollowSize);
+        panic(programFollow);
         return ProgramPtr();
     }
 
     IdentifierPtr programName = parseIdentifier();
     if (m_errorCode > ErrorCodes::NoError) {
-        panic(programFollow, programFollowSize);
+        panic(programFollow);
         return ProgramPtr();
     }
 
     if (!match(TokenType::LParen)) {
         reportError(ErrorCodes::ExpectedLParen);
 
-        panic(programFollow, programFollowSize);
+        panic(programFollow);
         return ProgramPtr();
     }
 
     IdentifiersPtr inputOutput = parseIdentifierList();
     if (m_errorCode > ErrorCodes::NoError) {
-        panic(programFollow, programFollowSize);
+        panic(programFollow);
         return ProgramPtr();
     }
 
     if (!match(TokenType::RParen)) {
         reportError(ErrorCodes::ExpectedRParen);
 
-        panic(programFollow, programFollowSize);
+        panic(programFollow);
         return ProgramPtr();
     }
 
     if (!match(TokenType::Semicolon)) {
         reportError(ErrorCodes::ExpectedSemicolon);
 
-        panic(programFollow, programFollowSize);
+        panic(programFollow);
         return ProgramPtr();
     }
 
     DeclarationsPtr globalVariables = parseDeclarations();
     if (m_errorCode > ErrorCodes::NoError) {
-        panic(programFollow, programFollowSize);
+        panic(programFollow);
         return ProgramPtr();
     }
 
     SubprogramDeclarationsPtr functions = parseSubprogramDeclarations();
     if (m_errorCode > ErrorCodes::NoError) {
-        panic(programFollow, programFollowSize);
+        panic(programFollow);
         return ProgramPtr();
     }
 
     CompoundStatementPtr mainProgram = parseCompoundStatement();
     if (m_errorCode > ErrorCodes::NoError) {
-        panic(programFollow, programFollowSize);
+        panic(programFollow);
         return ProgramPtr();
     }
 
     if (!match(TokenType::Period)) {
         reportError(ErrorCodes::ExpectedPeriod);
 
-        panic(programFollow, programFollowSize);
+        panic(programFollow);
         return ProgramPtr();
     }
 
-    ProgramPtr program(new Program);
+    ProgramPtr program = m_arena.create<Program>();
     program->programName = programName;
     program->inputOutput = inputOutput;
     program->variables = globalVariables;
@@ -661,20 +786,18 @@ ProgramPtr Parser::parseProgram()
     return program;
 }
 
-static const TokenType::Enum simpleExpressionFollow[] = {
-    TokenType::End,
-    TokenType::Eof,
-    TokenType::Do,
-    TokenType::Period,
-    TokenType::Semicolon,
-    TokenType::RelOp,
-    TokenType::RParen,
-};
-static const int simpleExpressionFollowSize = 6;
+static const boost::uint64_t simpleExpressionFollow =
+    tokenBit(TokenType::End) |
+    tokenBit(TokenType::Eof) |
+    tokenBit(TokenType::Do) |
+    tokenBit(TokenType::Period) |
+    tokenBit(TokenType::RParen) |
+    tokenBit(TokenType::Semicolon) |
+    tokenBit(TokenType::RelOp);
 
 ExpressionPtr Parser::parseSimpleExpression()
 {
-    AddOpExpressionPtr expr(new AddOpExpression);
+    AddOpExpressionPtr expr = m_arena.create<AddOpExpression>();
 
     Token sign = m_curToken;
     if (sign.operatorType() != OperatorType::Or && match(TokenType::AddOp)) {
@@ -687,13 +810,13 @@ ExpressionPtr Parser::parseSimpleExpression()
 
     expr->lhs = parseTerm();
     if (m_errorCode > ErrorCodes::NoError) {
-        panic(simpleExpressionFollow, simpleExpressionFollowSize);
+        panicInExpression(simpleExpressionFollow);
         return ExpressionPtr();
     }
 
     parseSimpleExpression_r(expr);
     if (m_errorCode > ErrorCodes::NoError) {
-        panic(simpleExpressionFollow, simpleExpressionFollowSize);
+        panicInExpression(simpleExpressionFollow);
         return ExpressionPtr();
     }
 
@@ -706,7 +829,7 @@ void Parser::parseSimpleExpression_r(AddOpExpressionPtr expr)
     if (match(TokenType::AddOp)) {
         expr->addOp = op.operatorType();
 
-        AddOpExpressionPtr rhs(new AddOpExpression);
+        AddOpExpressionPtr rhs = m_arena.create<AddOpExpression>();
         rhs->lhs = parseTerm();
         if (m_errorCode > ErrorCodes::NoError) {
             return;
@@ -723,7 +846,7 @@ void Parser::parseSimpleExpression_r(AddOpExpressionPtr expr)
 
 TypePtr Parser::parseStandardType()
 {
-    TypePtr type(new Type);
+    TypePtr type = m_arena.create<Type>();
 
     if (m_curToken.tokenType() == TokenType::Integer) {
         match(TokenType::Integer);
@@ -743,13 +866,11 @@ TypePtr Parser::parseStandardType()
     return TypePtr();
 }
 
-static const TokenType::Enum statementFollow[] = {
-    TokenType::End,
-    TokenType::Eof,
-    TokenType::Period,
-    TokenType::Semicolon,
-};
-static const int statementFollowSize = 4;
+static const boost::uint64_t statementFollow =
+    tokenBit(TokenType::End) |
+    tokenBit(TokenType::Eof) |
+    tokenBit(TokenType::Period) |
+    tokenBit(TokenType::Semicolon);
 
 StatementPtr Parser::parseStatement()
 {
@@ -758,37 +879,37 @@ StatementPtr Parser::parseStatement()
     } else if (match(TokenType::If)) {
         ExpressionPtr expression = parseExpression();
         if (m_errorCode > ErrorCodes::NoError) {
-            panic(statementFollow, statementFollowSize);
+            panic(statementFollow);
             return StatementPtr();
         }
 
         if (!match(TokenType::Then)) {
             reportError(ErrorCodes::ExpectedThen);
 
-            panic(statementFollow, statementFollowSize);
+            panic(statementFollow);
             return StatementPtr();
         }
 
         StatementPtr thenStatement = parseStatement();
         if (m_errorCode > ErrorCodes::NoError) {
-            panic(statementFollow, statementFollowSize);
+            panic(statementFollow);
             return StatementPtr();
         }
 
         if (!match(TokenType::Else)) {
             reportError(ErrorCodes::ExpectedElse);
 
-            panic(statementFollow, statementFollowSize);
+            panic(statementFollow);
             return StatementPtr();
         }
 
         StatementPtr elseStatement = parseStatement();
         if (m_errorCode > ErrorCodes::NoError) {
-            panic(statementFollow, statementFollowSize);
+            panic(statementFollow);
             return StatementPtr();
         }
 
-        IfStatementPtr statement(new IfStatement);
+        IfStatementPtr statement = m_arena.create<IfStatement>();
         statement->expression = expression;
         statement->thenPart = thenStatement;
         statement->elsePart = elseStatement;
@@ -797,24 +918,24 @@ StatementPtr Parser::parseStatement()
     } else if (match(TokenType::While)) {
         ExpressionPtr expression = parseExpression();
         if (m_errorCode > ErrorCodes::NoError) {
-            panic(statementFollow, statementFollowSize);
+            panic(statementFollow);
             return StatementPtr();
         }
 
         if (!match(TokenType::Do)) {
             reportError(ErrorCodes::ExpectedDo);
 
-            panic(statementFollow, statementFollowSize);
+            panic(statementFollow);
             return StatementPtr();
         }
 
         StatementPtr doPart = parseStatement();
         if (m_errorCode > ErrorCodes::NoError) {
-            panic(statementFollow, statementFollowSize);
+            panic(statementFollow);
             return StatementPtr();
         }
 
-        WhileStatementPtr whileStatement(new WhileStatement);
+        WhileStatementPtr whileStatement = m_arena.create<WhileStatement>();
         whileStatement->expression = expression;
         whileStatement->doPart = doPart;
 
@@ -823,16 +944,16 @@ StatementPtr Parser::parseStatement()
 
     IdentifierPtr identifier = parseIdentifier();
     if (m_errorCode > ErrorCodes::NoError) {
-        panic(statementFollow, statementFollowSize);
+        panic(statementFollow);
         return StatementPtr();
     }
 
-    AssignmentOrCallStatementPtr statement(new AssignmentOrCallStatement);
+    AssignmentOrCallStatementPtr statement = m_arena.create<AssignmentOrCallStatement>();
     statement->id = identifier;
 
     parseStatement_p(statement);
     if (m_errorCode > ErrorCodes::NoError) {
-        panic(statementFollow, statementFollowSize);
+        panic(statementFollow);
         return StatementPtr();
     }
 
@@ -853,7 +974,7 @@ void Parser::parseStatement_p(AssignmentOrCallStatementPtr statement)
     if (match(TokenType::Assign)) {
         ExpressionPtr value = parseExpression();
         if (m_errorCode > ErrorCodes::NoError) {
-            panic(statementFollow, statementFollowSize);
+            panic(statementFollow);
             return;
         }
 
@@ -861,64 +982,62 @@ void Parser::parseStatement_p(AssignmentOrCallStatementPtr statement)
     }
 }
 
-static const TokenType::Enum statementListFollow[] = {
-    TokenType::End,
-    TokenType::Eof,
-    TokenType::Period,
-    TokenType::Semicolon,
-};
-static const int statementListFollowSize = 4;
+static const boost::uint64_t statementListFollow =
+    tokenBit(TokenType::End) |
+    tokenBit(TokenType::Eof) |
+    tokenBit(TokenType::Period) |
+    tokenBit(TokenType::Semicolon);
 
 StatementsPtr Parser::parseStatementList()
 {
     StatementPtr statement = parseStatement();
     if (m_errorCode > ErrorCodes::NoError) {
-        panic(statementListFollow, statementListFollowSize);
+        panic(statementListFollow);
         return StatementsPtr();
     }
 
-    StatementsPtr statements(new Statements);
+    StatementsPtr statements = m_arena.create<Statements>();
     statements->list.push_back(statement);
 
-    // concat this to the result
-    StatementsPtr rest = parseStatementList_r();
-    if (rest) {
-        statements->list.insert(statements->list.end(), rest->list.begin(), rest->list.end());
-    }
+    parseStatementList_r(statements);
 
     return statements;
 }
 
-StatementsPtr Parser::parseStatementList_r()
+void Parser::parseStatementList_r(StatementsPtr statements)
 {
-    if (match(TokenType::Semicolon)) {
-        return parseStatementList();
-    }
+    // append in place; copying the tail back up at every level made long
+    // statement lists quadratic
+    while (match(TokenType::Semicolon)) {
+        StatementPtr statement = parseStatement();
+        if (m_errorCode > ErrorCodes::NoError) {
+            panic(statementListFollow);
+            return;
+        }
 
-    return StatementsPtr();
+        statements->list.push_back(statement);
+    }
 }
 
-static const TokenType::Enum subprogramDeclarationFollow[] = {
-    TokenType::Begin,
-    TokenType::Eof,
-    TokenType::Period,
-    TokenType::Semicolon,
-};
-static const int subprogramDeclarationFollowSize = 4;
+static const boost::uint64_t subprogramDeclarationFollow =
+    tokenBit(TokenType::Begin) |
+    tokenBit(TokenType::Eof) |
+    tokenBit(TokenType::Period) |
+    tokenBit(TokenType::Semicolon);
 
 SubprogramDeclarationPtr Parser::parseSubprogramDeclaration()
 {
-    SubprogramDeclarationPtr sub(new SubprogramDeclaration);
+    SubprogramDeclarationPtr sub = m_arena.create<SubprogramDeclaration>();
 
     parseSubprogramHead(sub);
     if (m_errorCode > ErrorCodes::NoError) {
-        panic(subprogramDeclarationFollow, subprogramDeclarationFollowSize);
+        panic(subprogramDeclarationFollow);
         return SubprogramDeclarationPtr();
     }
 
     DeclarationsPtr declarations = parseDeclarations();
     if (m_errorCode > ErrorCodes::NoError) {
-        panic(subprogramDeclarationFollow, subprogramDeclarationFollowSize);
+        panic(subprogramDeclarationFollow);
         return SubprogramDeclarationPtr();
     }
 
@@ -926,7 +1045,7 @@ SubprogramDeclarationPtr Parser::parseSubprogramDeclaration()
 
     CompoundStatementPtr body = parseCompoundStatement();
     if (m_errorCode > ErrorCodes::NoError) {
-        panic(subprogramDeclarationFollow, subprogramDeclarationFollowSize);
+        panic(subprogramDeclarationFollow);
         return SubprogramDeclarationPtr();
     }
 
@@ -935,49 +1054,43 @@ SubprogramDeclarationPtr Parser::parseSubprogramDeclaration()
     return sub;
 }
 
-static const TokenType::Enum subprogramDeclarationsFollow[] = {
-    TokenType::Begin,
-    TokenType::Eof,
-    TokenType::Period,
-};
-static const int subprogramDeclarationsFollowSize = 3;
+static const boost::uint64_t subprogramDeclarationsFollow =
+    tokenBit(TokenType::Begin) |
+    tokenBit(TokenType::Eof) |
+    tokenBit(TokenType::Period);
 
 SubprogramDeclarationsPtr Parser::parseSubprogramDeclarations()
 {
-    if (m_curToken.tokenType() != TokenType::Function && m_curToken.tokenType() != TokenType::Procedure) {
-        return SubprogramDeclarationsPtr();
-    }
+    SubprogramDeclarationsPtr subprograms = SubprogramDeclarationsPtr();
+
+    while (m_curToken.tokenType() == TokenType::Function || m_curToken.tokenType() == TokenType::Procedure) {
+        SubprogramDeclarationPtr declaration = parseSubprogramDeclaration();
+        if (m_errorCode > ErrorCodes::NoError) {
+            return subprograms;
+        }
 
-    SubprogramDeclarationPtr declaration = parseSubprogramDeclaration();
-    if (m_errorCode <= ErrorCodes::NoError) {
         if (!match(TokenType::Semicolon)) {
             reportError(ErrorCodes::ExpectedSemicolon);
 
-            panic(subprogramDeclarationsFollow, subprogramDeclarationsFollowSize);
-            return SubprogramDeclarationsPtr();
+            panic(subprogramDeclarationsFollow);
+            return subprograms;
         }
 
-        SubprogramDeclarationsPtr subprograms(new SubprogramDeclarations);
-        subprograms->list.push_back(declaration);
-
-        SubprogramDeclarationsPtr rest = parseSubprogramDeclarations();
-        if (rest) {
-            subprograms->list.insert(subprograms->list.end(), rest->list.begin(), rest->list.end());
+        if (!subprograms) {
+            subprograms = m_arena.create<SubprogramDeclarations>();
         }
 
-        return subprograms;
+        subprograms->list.push_back(declaration);
     }
 
-    return SubprogramDeclarationsPtr();
+    return subprograms;
 }
 
-static const TokenType::Enum subprogramHeadFollow[] = {
-    TokenType::Begin,
-    TokenType::Eof,
-    TokenType::Period,
-    TokenType::Var,
-};
-static const int subprogramHeadFollowSize = 4;
+static const boost::uint64_t subprogramHeadFollow =
+    tokenBit(TokenType::Begin) |
+    tokenBit(TokenType::Eof) |
+    tokenBit(TokenType::Period) |
+    tokenBit(TokenType::Var);
 
 void Parser::parseSubprogramHead(SubprogramDeclarationPtr sub)
 {
@@ -985,13 +1098,13 @@ void Parser::parseSubprogramHead(SubprogramDeclarationPtr sub)
     if (!match(TokenType::Function) && !match(TokenType::Procedure)) {
         reportError(ErrorCodes::ExpectedSubprogramHead);
 
-        panic(subprogramHeadFollow, subprogramHeadFollowSize);
+        panic(subprogramHeadFollow);
         return;
     }
 
     IdentifierPtr name = parseIdentifier();
     if (m_errorCode > ErrorCodes::NoError) {
-        panic(subprogramHeadFollow, subprogramHeadFollowSize);
+        panic(subprogramHeadFollow);
         return;
     }
 
@@ -999,7 +1112,7 @@ void Parser::parseSubprogramHead(SubprogramDeclarationPtr sub)
 
     parseArguments(sub);
     if (m_errorCode > ErrorCodes::NoError) {
-        panic(subprogramHeadFollow, subprogramHeadFollowSize);
+        panic(subprogramHeadFollow);
         return;
     }
 
@@ -1009,13 +1122,13 @@ void Parser::parseSubprogramHead(SubprogramDeclarationPtr sub)
         if (!match(TokenType::Colon)) {
             reportError(ErrorCodes::ExpectedColon);
 
-            panic(subprogramHeadFollow, subprogramHeadFollowSize);
+            panic(subprogramHeadFollow);
             return;
         }
 
         TypePtr type = parseStandardType();
         if (m_errorCode > ErrorCodes::NoError) {
-            panic(subprogramHeadFollow, subprogramHeadFollowSize);
+            panic(subprogramHeadFollow);
             return;
         }
 
@@ -1025,29 +1138,27 @@ void Parser::parseSubprogramHead(SubprogramDeclarationPtr sub)
     if (!match(TokenType::Semicolon)) {
         reportError(ErrorCodes::ExpectedSemicolon);
 
-        panic(subprogramHeadFollow, subprogramHeadFollowSize);
+        panic(subprogramHeadFollow);
         return;
     }
 }
 
-static const TokenType::Enum termFollow[] = {
-    TokenType::End,
-    TokenType::Eof,
-    TokenType::MulOp,
-    TokenType::Period,
-    TokenType::Semicolon,
-    TokenType::RelOp,
-    TokenType::RParen,
-};
-static const int termFollowSize = 7;
+static const boost::uint64_t termFollow =
+    tokenBit(TokenType::End) |
+    tokenBit(TokenType::Eof) |
+    tokenBit(TokenType::MulOp) |
+    tokenBit(TokenType::Period) |
+    tokenBit(TokenType::Semicolon) |
+    tokenBit(TokenType::RelOp) |
+    tokenBit(TokenType::RParen);
 
 TermPtr Parser::parseTerm()
 {
-    TermPtr term(new Term);
+    TermPtr term = m_arena.create<Term>();
 
     term->lhs = parseFactor();
     if (m_errorCode > ErrorCodes::NoError) {
-        panic(termFollow, termFollowSize);
+        panicInExpression(termFollow);
         return TermPtr();
     }
 
@@ -1066,14 +1177,12 @@ void Parser::parseTerm_r(TermPtr term)
     }
 }
 
-static const TokenType::Enum typeFollow[] = {
-    TokenType::Begin,
-    TokenType::Function,
-    TokenType::Eof,
-    TokenType::Procedure,
-    TokenType::Semicolon,
-};
-static const int typeFollowSize = 5;
+static const boost::uint64_t typeFollow =
+    tokenBit(TokenType::Begin) |
+    tokenBit(TokenType::Function) |
+    tokenBit(TokenType::Eof) |
+    tokenBit(TokenType::Procedure) |
+    tokenBit(TokenType::Semicolon);
 
 TypePtr Parser::parseType()
 {
@@ -1081,50 +1190,50 @@ TypePtr Parser::parseType()
         if (!match(TokenType::LBracket)) {
             reportError(ErrorCodes::ExpectedLBracket);
 
-            panic(typeFollow, typeFollowSize);
+            panic(typeFollow);
             return TypePtr();
         }
 
         NumberPtr from = parseNumber();
         if (m_errorCode > ErrorCodes::NoError) {
-            panic(typeFollow, typeFollowSize);
+            panic(typeFollow);
             return TypePtr();
         }
 
         if (!match(TokenType::Range)) {
             reportError(ErrorCodes::ExpectedRange);
 
-            panic(typeFollow, typeFollowSize);
+            panic(typeFollow);
             return TypePtr();
         }
 
         NumberPtr to = parseNumber();
         if (m_errorCode > ErrorCodes::NoError) {
-            panic(typeFollow, typeFollowSize);
+            panic(typeFollow);
             return TypePtr();
         }
 
         if (!match(TokenType::RBracket)) {
             reportError(ErrorCodes::ExpectedRBracket);
 
-            panic(typeFollow, typeFollowSize);
+            panic(typeFollow);
             return TypePtr();
         }
 
         if (!match(TokenType::Of)) {
             reportError(ErrorCodes::ExpectedOf);
 
-            panic(typeFollow, typeFollowSize);
+            panic(typeFollow);
             return TypePtr();
         }
 
         TypePtr type = parseStandardType();
         if (m_errorCode > ErrorCodes::NoError) {
-            panic(typeFollow, typeFollowSize);
+            panic(typeFollow);
             return TypePtr();
         }
 
-        TypePtr arrayType(new Type);
+        TypePtr arrayType = m_arena.create<Type>();
         arrayType->isArray = true;
         arrayType->startsAt = from;
         arrayType->endsAt = to;
@@ -1136,7 +1245,7 @@ TypePtr Parser::parseType()
     return parseStandardType();
 }
 
-static std::string codeToMessage(int errorCode)
+static const char *codeToMessage(int errorCode)
 {
     switch (errorCode) {
     case ErrorCodes::NoError:
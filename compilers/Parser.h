@@ -1,39 +1,83 @@
 #pragma once
 
+#include "Arena.h"
 #include "AstPrimitives.h"
 #include "Token.h"
 
+#include <boost/cstdint.hpp>
 #include <boost/shared_ptr.hpp>
 
+#include <ostream>
+#include <vector>
+
 class Parser
 {
 public:
-    Parser();
+    // the tree's arena grows by arenaBlockSize at a time
+    explicit Parser(size_t arenaBlockSize = Arena::kDefaultBlockSize);
 
     bool error() const;
     int errorCount() const;
 
+    // The tree is allocated in the parser's arena and stays valid until the
+    // parser is destroyed or parses again.
     ProgramPtr parse(boost::shared_ptr<Lexer> lexer);
 
+    // Parses a single subprogram_declaration and the ';' after it, leaving
+    // currentToken() on whatever follows. IncrementalParser parses a file
+    // one subprogram at a time with this.
+    SubprogramDeclarationPtr parseSubprogram(boost::shared_ptr<Lexer> lexer);
+    const Token &currentToken() const { return m_curToken; }
+
+    // where syntax errors are reported; std::cerr by default
+    void setErrorStream(std::ostream &stream);
+
+    // Errors are written once parsing is done, at most this many of them
+    // and then a line counting the rest; 0 writes them all. errorCount()
+    // counts every error either way. 100 by default.
+    void setMaxReportedErrors(int count);
+
+    const Arena &arena() const { return m_arena; }
+
 private:
+    // token types as bits, see tokenBit() in Parser.cpp
+    typedef boost::uint64_t TokenSet;
+
+    // what is needed to write an error out later
+    struct Diagnostic
+    {
+        int errorCode;
+        bool illegalCharacter;
+        int line;
+        int column;
+        int length;
+        // the source line up to the end of the offending token
+        int lineOffset;
+        int lineLength;
+    };
+
     bool match(TokenType::Enum tokenType);
-    void panic(const TokenType::Enum synchronizingTokens[], int numElements);
+    void panic(TokenSet follow);
+    void panicInExpression(TokenSet follow);
     void reportError(int errorCode);
+    void outputErrors();
+    bool startsExpression() const;
 
+    bool parseArgumentGroup(DeclarationsPtr declarations);
     DeclarationsPtr parseArgumentList();
-    DeclarationsPtr parseArgumentList_r();
+    void parseArgumentList_r(DeclarationsPtr declarations);
     void parseArguments(SubprogramDeclarationPtr sub);
     CompoundStatementPtr parseCompoundStatement();
     DeclarationsPtr parseDeclarations();
     ExpressionPtr parseExpression();
     void parseExpression_p(RelOpExpressionPtr expr);
     ExpressionsPtr parseExpressionList();
-    ExpressionsPtr parseExpressionList_r();
+    void parseExpressionList_r(ExpressionsPtr expressions);
     FactorPtr parseFactor();
     void parseFactor_p(IdentifierPtr id);
     IdentifierPtr parseIdentifier();
     IdentifiersPtr parseIdentifierList();
-    IdentifiersPtr parseIdentifierList_r();
+    void parseIdentifierList_r(IdentifiersPtr identifiers);
     NumberPtr parseNumber();
     ExpressionPtr parseOptionalIndex();
     ExpressionsPtr parseOptionalParameters();
@@ -45,7 +89,7 @@ private:
     StatementPtr parseStatement();
     void parseStatement_p(AssignmentOrCallStatementPtr statement);
     StatementsPtr parseStatementList();
-    StatementsPtr parseStatementList_r();
+    void parseStatementList_r(StatementsPtr statements);
     SubprogramDeclarationPtr parseSubprogramDeclaration();
     SubprogramDeclarationsPtr parseSubprogramDeclarations();
     void parseSubprogramHead(SubprogramDeclarationPtr sub);
@@ -53,8 +97,14 @@ private:
     void parseTerm_r(TermPtr term);
     TypePtr parseType();
 
+    Arena m_arena;
     boost::shared_ptr<Lexer> m_lexer;
     int m_errorCode;
     int m_errorCount;
     Token m_curToken;
+    std::ostream *m_errors;
+    int m_maxReportedErrors;
+    std::vector<Diagnostic> m_diagnostics;
+    // parentheses open around the expression being parsed
+    int m_openParens;
 };
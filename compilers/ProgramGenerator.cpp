@@ -0,0 +1,381 @@
+#include "ProgramGenerator.h"
+
+#include <boost/random/uniform_int_distribution.hpp>
+
+// Every integer assignment is reduced modulo this, so that no expression
+// the generator writes can overflow.
+static const int kModulus = 9973;
+static const int kMaxLoopBound = 4;
+static const char *kRelationalOperators[] = { "=", "<>", "<", "<=", ">", ">=" };
+
+static std::string indentation(int indent)
+{
+    return std::string(4 * indent, ' ');
+}
+
+static std::string number(int value)
+{
+    std::ostringstream ss;
+    ss << value;
+
+    return ss.str();
+}
+
+ProgramGenerator::Options::Options()
+    : seed(1)
+    , subprograms(16)
+    , statements(16)
+    , expressionDepth(4)
+    , statementDepth(2)
+    , arrays(0)
+    , arrayLength(100)
+{
+}
+
+ProgramGenerator::ProgramGenerator(const Options &options)
+    : m_options(options)
+{
+}
+
+int ProgramGenerator::random(int low, int high)
+{
+    return boost::random::uniform_int_distribution<int>(low, high)(m_random);
+}
+
+bool ProgramGenerator::chance(int percent)
+{
+    return random(0, 99) < percent;
+}
+
+template <typename T>
+const T &ProgramGenerator::pick(const std::vector<T> &items)
+{
+    return items[random(0, items.size() - 1)];
+}
+
+std::string ProgramGenerator::name(int index)
+{
+    return (isFunction(index) ? "f" : "p") + number(index);
+}
+
+std::string ProgramGenerator::generate()
+{
+    m_out.str("");
+    m_random.seed(m_options.seed);
+
+    m_counters.clear();
+    for (int i = 0; i < m_options.statementDepth; ++i) {
+        m_counters += (i ? ", k" : "var k") + number(i);
+    }
+    if (!m_counters.empty()) {
+        m_counters += " : integer;\n";
+    }
+
+    m_out << "program generated(input, output);\n";
+    m_out << "var g0, g1, g2, g3 : integer;\n";
+    m_out << "var r0, r1 : real;\n";
+    m_out << m_counters;
+
+    for (int i = 0; i < m_options.arrays; ++i) {
+        m_out << "var a" << i << " : array [1.." << m_options.arrayLength << "] of integer;\n";
+    }
+
+    m_out << "\n";
+
+    for (int i = 0; i < m_options.subprograms; ++i) {
+        subprogram(i);
+    }
+
+    Scope scope;
+    for (int i = 0; i < 4; ++i) {
+        scope.integers.push_back("g" + number(i));
+    }
+    scope.targets = scope.integers;
+    scope.reals.push_back("r0");
+    scope.reals.push_back("r1");
+
+    for (int i = 0; i < m_options.subprograms; ++i) {
+        (isFunction(i) ? scope.functions : scope.procedures).push_back(i);
+    }
+
+    body(scope, "", "writeln(g0, g1, g2, g3)");
+    m_out << ".\n";
+
+    return m_out.str();
+}
+
+void ProgramGenerator::subprogram(int index)
+{
+    Scope scope;
+    scope.integers.push_back("x");
+
+    if (isFunction(index)) {
+        m_out << "function " << name(index) << "(x, y : integer) : integer;\n";
+        scope.integers.push_back("y");
+    } else {
+        m_out << "procedure " << name(index) << "(x : integer; z : real);\n";
+        scope.reals.push_back("z");
+    }
+
+    m_out << "var l0, l1 : integer;\n";
+    m_out << m_counters;
+
+    scope.integers.push_back("l0");
+    scope.integers.push_back("l1");
+    scope.targets.push_back("l0");
+    scope.targets.push_back("l1");
+
+    for (int i = 0; i < 4; ++i) {
+        scope.integers.push_back("g" + number(i));
+        scope.targets.push_back("g" + number(i));
+    }
+    scope.reals.push_back("r0");
+    scope.reals.push_back("r1");
+
+    // leaves call nothing and the rest only call leaves, so no call chain
+    // is more than two deep and none recurses
+    if (!isLeaf(index)) {
+        for (int i = 0; i < index; ++i) {
+            if (isLeaf(i)) {
+                (isFunction(i) ? scope.functions : scope.procedures).push_back(i);
+            }
+        }
+    }
+
+    if (isFunction(index)) {
+        body(scope, name(index) + " := x", name(index) + " := " + expression(scope, 1) + " mod " + number(kModulus));
+    } else {
+        body(scope, "", "");
+    }
+
+    m_out << ";\n\n";
+}
+
+void ProgramGenerator::body(Scope &scope, const std::string &first, const std::string &last)
+{
+    m_out << "begin\n";
+
+    bool separate = false;
+    if (!first.empty()) {
+        m_out << indentation(1) << first;
+        separate = true;
+    }
+
+    for (int i = 0; i < m_options.statements; ++i) {
+        m_out << (separate ? ";\n" : "") << indentation(1);
+        separate = true;
+
+        if (i == 0 && m_options.expressionDepth > 0) {
+            m_out << pick(scope.targets) << " := " << deepExpression(scope, m_options.expressionDepth) << " mod " << kModulus;
+        } else {
+            statement(scope, m_options.statementDepth, 1);
+        }
+    }
+
+    if (!last.empty()) {
+        m_out << (separate ? ";\n" : "") << indentation(1) << last;
+        separate = true;
+    }
+
+    m_out << (separate ? "\n" : "") << "end";
+}
+
+void ProgramGenerator::statement(Scope &scope, int depth, int indent)
+{
+    int kind = random(0, 99);
+
+    if (depth > 0 && kind < 15) {
+        m_out << "if " << condition(scope, 1) << " then\n" << indentation(indent + 1);
+        block(scope, depth - 1, indent + 1, "");
+        m_out << "\n" << indentation(indent) << "else\n" << indentation(indent + 1);
+        block(scope, depth - 1, indent + 1, "");
+        return;
+    }
+
+    // each loop nested in another takes the next counter
+    if (depth > 0 && kind < 25 && scope.counters.size() < static_cast<size_t>(m_options.statementDepth)) {
+        std::string counter = "k" + number(scope.counters.size());
+
+        m_out << counter << " := 0;\n" << indentation(indent)
+              << "while " << counter << " < " << random(2, kMaxLoopBound) << " do\n" << indentation(indent + 1);
+
+        scope.counters.push_back(counter);
+        block(scope, depth - 1, indent + 1, counter + " := " + counter + " + 1");
+        scope.counters.pop_back();
+        return;
+    }
+
+    if (kind < 35 && !scope.procedures.empty()) {
+        m_out << call(scope, pick(scope.procedures));
+        return;
+    }
+
+    assignment(scope);
+}
+
+void ProgramGenerator::block(Scope &scope, int depth, int indent, const std::string &last)
+{
+    m_out << "begin\n";
+
+    for (int i = random(1, 2); i > 0; --i) {
+        m_out << indentation(indent + 1);
+        statement(scope, depth, indent + 1);
+        m_out << (i > 1 || !last.empty() ? ";\n" : "\n");
+    }
+
+    if (!last.empty()) {
+        m_out << indentation(indent + 1) << last << "\n";
+    }
+
+    m_out << indentation(indent) << "end";
+}
+
+void ProgramGenerator::assignment(Scope &scope)
+{
+    int kind = random(0, 99);
+
+    if (m_options.arrays > 0 && kind < 33) {
+        m_out << arrayElement(scope) << " := " << expression(scope, 2) << " mod " << kModulus;
+    } else if (kind < 45) {
+        m_out << pick(scope.reals) << " := " << realExpression(scope, 2);
+    } else {
+        m_out << pick(scope.targets) << " := " << expression(scope, random(0, 3)) << " mod " << kModulus;
+    }
+}
+
+// Integer atoms are all within kModulus of zero: variables and array
+// elements only ever hold a remainder, and so do function results.
+std::string ProgramGenerator::atom(Scope &scope)
+{
+    int kind = random(0, 99);
+
+    if (kind < 10 && !scope.functions.empty()) {
+        return call(scope, pick(scope.functions));
+    }
+    if (kind < 25 && m_options.arrays > 0) {
+        return arrayElement(scope);
+    }
+    if (kind < 35 && !scope.counters.empty()) {
+        return pick(scope.counters);
+    }
+    if (kind < 70) {
+        return pick(scope.integers);
+    }
+
+    return number(random(0, 99));
+}
+
+std::string ProgramGenerator::arrayElement(Scope &scope)
+{
+    std::string element = "a" + number(random(0, m_options.arrays - 1)) + "[";
+
+    // a counter is below kMaxLoopBound, so the sum stays in range
+    if (!scope.counters.empty() && m_options.arrayLength > kMaxLoopBound && chance(50)) {
+        return element + pick(scope.counters) + " + " + number(random(1, m_options.arrayLength - kMaxLoopBound)) + "]";
+    }
+
+    return element + number(random(1, m_options.arrayLength)) + "]";
+}
+
+// Arguments are plain variables and constants so that calls do not nest.
+std::string ProgramGenerator::call(Scope &scope, int index)
+{
+    std::string first = chance(50) ? pick(scope.integers) : number(random(0, 99));
+
+    if (isFunction(index)) {
+        std::string second = chance(50) ? pick(scope.integers) : number(random(0, 99));
+        return name(index) + "(" + first + ", " + second + ")";
+    }
+
+    std::string second = chance(50) ? pick(scope.reals) : number(random(0, 99)) + ".5";
+    return name(index) + "(" + first + ", " + second + ")";
+}
+
+// At most three levels deep where it is used, and each level at most
+// multiplies by 9 or adds two operands, which keeps well inside 32 bits.
+std::string ProgramGenerator::expression(Scope &scope, int depth)
+{
+    if (depth == 0) {
+        return atom(scope);
+    }
+
+    int kind = random(0, 99);
+
+    if (kind < 50) {
+        return "(" + expression(scope, depth - 1) + (chance(50) ? " + " : " - ") + expression(scope, depth - 1) + ")";
+    }
+    if (kind < 65) {
+        return "(" + expression(scope, depth - 1) + " * " + number(random(2, 9)) + ")";
+    }
+    if (kind < 80) {
+        return "(" + expression(scope, depth - 1) + (chance(50) ? " div " : " mod ") + number(random(2, 97)) + ")";
+    }
+    if (kind < 90) {
+        return "(-" + expression(scope, depth - 1) + ")";
+    }
+
+    return expression(scope, depth - 1);
+}
+
+// A chain of additions and divisions nested depth deep, built without
+// recursion so that the depth is not bounded by our own stack. Each level
+// adds at most one atom, so the value stays below depth * kModulus.
+std::string ProgramGenerator::deepExpression(Scope &scope, int depth)
+{
+    std::string result = atom(scope);
+
+    for (int i = 0; i < depth; ++i) {
+        int kind = random(0, 99);
+
+        if (kind < 20) {
+            result = "(" + result + " div " + number(random(2, 9)) + ")";
+        } else if (kind < 60) {
+            result = "(" + result + (chance(50) ? " + " : " - ") + atom(scope) + ")";
+        } else {
+            result = "(" + atom(scope) + (chance(50) ? " + " : " - ") + result + ")";
+        }
+    }
+
+    return result;
+}
+
+std::string ProgramGenerator::realExpression(Scope &scope, int depth)
+{
+    int kind = random(0, 99);
+
+    if (depth == 0) {
+        if (kind < 50) {
+            return pick(scope.reals);
+        }
+        if (kind < 75) {
+            return pick(scope.integers);
+        }
+        return number(random(0, 99)) + "." + number(random(0, 9));
+    }
+
+    if (kind < 60) {
+        return "(" + realExpression(scope, depth - 1) + (chance(50) ? " + " : " - ") + realExpression(scope, depth - 1) + ")";
+    }
+    if (kind < 80) {
+        return "(" + realExpression(scope, depth - 1) + " * 0.5)";
+    }
+
+    return "(" + realExpression(scope, depth - 1) + " / " + number(random(2, 9)) + ".0)";
+}
+
+std::string ProgramGenerator::condition(Scope &scope, int depth)
+{
+    int kind = random(0, 99);
+
+    if (depth > 0 && kind < 10) {
+        return "(" + condition(scope, depth - 1) + ") and (" + condition(scope, depth - 1) + ")";
+    }
+    if (depth > 0 && kind < 20) {
+        return "(" + condition(scope, depth - 1) + ") or (" + condition(scope, depth - 1) + ")";
+    }
+    if (depth > 0 && kind < 25) {
+        return "not (" + condition(scope, depth - 1) + ")";
+    }
+
+    return expression(scope, 1) + " " + kRelationalOperators[random(0, 5)] + " " + expression(scope, 1);
+}
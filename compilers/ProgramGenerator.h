@@ -0,0 +1,82 @@
+#pragma once
+
+#include <boost/random/mersenne_twister.hpp>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Writes random programs in the language of grammar.txt that also compile
+// and run to completion: names are declared before use, calls match the
+// arguments of their subprogram, loops count up to a small bound, divisors
+// and array indices are constants in range and integers are kept small
+// enough not to overflow. The same options always give the same program.
+class ProgramGenerator
+{
+public:
+    struct Options
+    {
+        Options();
+
+        unsigned int seed;
+        // functions and procedures, each callable from those after it
+        int subprograms;
+        // statements in each body, not counting the nested ones
+        int statements;
+        // nesting of the one deep expression in each body
+        int expressionDepth;
+        // nesting of if and while statements
+        int statementDepth;
+        // integer arrays of arrayLength elements, read and written by
+        // about a third of the assignments; 0 declares none
+        int arrays;
+        int arrayLength;
+    };
+
+    explicit ProgramGenerator(const Options &options);
+
+    std::string generate();
+
+private:
+    // what a body may read, write and call
+    struct Scope
+    {
+        std::vector<std::string> integers;
+        std::vector<std::string> targets;
+        std::vector<std::string> reals;
+        std::vector<int> functions;
+        std::vector<int> procedures;
+        // counters of the enclosing loops, innermost last
+        std::vector<std::string> counters;
+    };
+
+    int random(int low, int high);
+    bool chance(int percent);
+    template <typename T>
+    const T &pick(const std::vector<T> &items);
+
+    void subprogram(int index);
+    // first and last, if not empty, are written around the statements
+    void body(Scope &scope, const std::string &first, const std::string &last);
+    void statement(Scope &scope, int depth, int indent);
+    void block(Scope &scope, int depth, int indent, const std::string &last);
+    void assignment(Scope &scope);
+
+    std::string atom(Scope &scope);
+    std::string arrayElement(Scope &scope);
+    std::string call(Scope &scope, int index);
+    std::string expression(Scope &scope, int depth);
+    std::string deepExpression(Scope &scope, int depth);
+    std::string realExpression(Scope &scope, int depth);
+    std::string condition(Scope &scope, int depth);
+
+    static std::string name(int index);
+    static bool isFunction(int index) { return index % 3 != 2; }
+    static bool isLeaf(int index) { return index % 4 == 0; }
+
+    Options m_options;
+    boost::random::mt19937 m_random;
+    std::ostringstream m_out;
+    // the declaration of the loop counters, global and in each subprogram
+    std::string m_counters;
+};
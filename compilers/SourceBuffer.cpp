@@ -0,0 +1,32 @@
+#include "SourceBuffer.h"
+
+static const size_t kChunkSize = 64 * 1024;
+
+SourceBuffer::SourceBuffer(std::istream &in)
+{
+    assign(in);
+}
+
+void SourceBuffer::assign(std::istream &in)
+{
+    m_data.clear();
+
+    // read in large blocks rather than a character at a time
+    size_t length = 0;
+    while (in) {
+        m_data.resize(length + kChunkSize);
+        in.read(&m_data[length], kChunkSize);
+        length += static_cast<size_t>(in.gcount());
+    }
+
+    m_data.resize(length);
+    m_data.push_back('\0');
+
+    char *begin = &m_data[0];
+    setg(begin, begin, begin + size());
+}
+
+std::string SourceBuffer::text(size_t offset, size_t length) const
+{
+    return std::string(data() + offset, length);
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <istream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+// The whole input held in memory. Tokens refer to their text by offset into
+// it rather than copying it, and it can be read back as a stream.
+class SourceBuffer : public std::streambuf
+{
+public:
+    explicit SourceBuffer(std::istream &in);
+
+    // replaces the contents with everything left in the stream
+    void assign(std::istream &in);
+
+    const char *data() const { return &m_data[0]; }
+    size_t size() const { return m_data.size() - 1; }
+
+    std::string text(size_t offset, size_t length) const;
+
+private:
+    SourceBuffer(const SourceBuffer &);
+    SourceBuffer &operator=(const SourceBuffer &);
+
+    // always ends in a NUL that is not part of the source
+    std::vector<char> m_data;
+};
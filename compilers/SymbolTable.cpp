@@ -0,0 +1,58 @@
+#include "SymbolTable.h"
+#include "Token.h"
+
+#include <boost/thread/tss.hpp>
+
+#include <cctype>
+
+SymbolTable &SymbolTable::instance()
+{
+    static boost::thread_specific_ptr<SymbolTable> tables;
+
+    SymbolTable *table = tables.get();
+    if (!table) {
+        table = new SymbolTable;
+        tables.reset(table);
+    }
+
+    return *table;
+}
+
+SymbolTableEntry *SymbolTable::intern(const std::string &name)
+{
+    boost::unordered_map<std::string, SymbolTableEntry *>::const_iterator i = m_index.find(name);
+    if (i != m_index.end()) {
+        return i->second;
+    }
+
+    boost::shared_ptr<SymbolTableEntry> entry(new SymbolTableEntry(name, m_entries.size()));
+    m_entries.push_back(entry);
+    m_index[name] = entry.get();
+
+    return entry.get();
+}
+
+SymbolTableEntry *SymbolTable::intern(const char *text, size_t length)
+{
+    m_key.assign(text, length);
+    for (std::string::iterator i = m_key.begin(); i != m_key.end(); ++i) {
+        *i = std::tolower(static_cast<unsigned char>(*i));
+    }
+
+    return intern(m_key);
+}
+
+SymbolTableEntry *SymbolTable::intern(Token &token)
+{
+    // the entry is cached on the token so the name is only folded once
+    if (!token.symbolTableEntry()) {
+        token.setSymbolTableEntry(intern(token.value()));
+    }
+
+    return token.symbolTableEntry();
+}
+
+int SymbolTable::size() const
+{
+    return m_entries.size();
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <string>
+#include <vector>
+
+class Token;
+
+// An interned identifier. Two identifiers spelled the same way (ignoring
+// case) share one entry, so entries can be compared and hashed by address.
+class SymbolTableEntry
+{
+public:
+    SymbolTableEntry(const std::string &name, int uid) : m_name(name), m_uid(uid) {}
+
+    const std::string &name() const { return m_name; }
+    int uid() const { return m_uid; }
+
+private:
+    std::string m_name;
+    int m_uid;
+};
+
+// Each thread interns into a table of its own, so separate compilations can
+// run side by side. An entry belongs to the thread that interned it; other
+// threads may use entries already cached on tokens but must not intern.
+class SymbolTable
+{
+public:
+    static SymbolTable &instance();
+
+    SymbolTableEntry *intern(const std::string &name);
+    // folds case; looking up a name that is already interned does not allocate
+    SymbolTableEntry *intern(const char *text, size_t length);
+    SymbolTableEntry *intern(Token &token);
+
+    int size() const;
+
+private:
+    SymbolTable() {}
+
+    boost::unordered_map<std::string, SymbolTableEntry *> m_index;
+    std::string m_key;
+    std::vector<boost::shared_ptr<SymbolTableEntry> > m_entries;
+};
@@ -0,0 +1,603 @@
+#include "Tac.h"
+
+#include <algorithm>
+#include <sstream>
+
+static bool isRealType(TypePtr type)
+{
+    return type && type->standardType == NumberType::Real;
+}
+
+static const char *kBlockLabelPrefix = "__block__label__";
+static const char *kTemporaryPrefix = "__temp__";
+static const char *kTemporaryLabelPrefix = "__temp__label__";
+
+static std::string uniqueName(const char *prefix, int uid)
+{
+    std::stringstream ss;
+    ss << prefix << uid;
+
+    return ss.str();
+}
+
+std::string generatedTemporaryName(int uid)
+{
+    return uniqueName(kTemporaryPrefix, uid);
+}
+
+std::string generatedLabelName(int uid, bool isBlock)
+{
+    return uniqueName(isBlock ? kBlockLabelPrefix : kTemporaryLabelPrefix, uid);
+}
+
+int TacInstruction::numUses() const
+{
+    if (isBinary() || isBranch()) {
+        return 2;
+    }
+
+    if (opcode == TacOpcode::Check) {
+        return 3;
+    }
+
+    if (isUnary() || opcode == TacOpcode::Param) {
+        return 1;
+    }
+
+    return 0;
+}
+
+int TacInstruction::definition() const
+{
+    if (isBinary()) {
+        return operands[2];
+    }
+
+    if (isUnary()) {
+        return operands[1];
+    }
+
+    if (opcode == TacOpcode::Call) {
+        // the function value doubles as the return slot
+        return operands[0];
+    }
+
+    return kNoOperand;
+}
+
+int TacInstruction::label() const
+{
+    if (isBranch()) {
+        return operands[2];
+    }
+
+    if (opcode == TacOpcode::Goto || opcode == TacOpcode::Label) {
+        return operands[0];
+    }
+
+    return kNoOperand;
+}
+
+int *TacInstruction::labelOperand()
+{
+    if (isBranch()) {
+        return &operands[2];
+    }
+
+    if (opcode == TacOpcode::Goto || opcode == TacOpcode::Label) {
+        return &operands[0];
+    }
+
+    return 0;
+}
+
+std::string ConstIntTacValue::value() const
+{
+    std::stringstream ss;
+    ss << intValue;
+
+    return ss.str();
+}
+
+std::string ConstRealTacValue::value() const
+{
+    std::stringstream ss;
+    ss << realValue;
+
+    return ss.str();
+}
+
+FunctionTacValue::FunctionTacValue(TacFunctionPtr f)
+    : function(f)
+{
+    isFunction = true;
+
+    IdentifierPtr fid = f->module->arena.create<Identifier>();
+    fid->id = Token(f->name, -1, -1);
+
+    id = fid;
+}
+
+TacBasicBlock::TacBasicBlock(const std::string &n, TacFunction *o)
+    : name(n)
+    , label(kNoOperand)
+    , owner(o)
+{
+    int uid = 0;
+
+    // fragments name generated labels when they are merged
+    if (n.empty()) {
+        uid = owner->module->nextUid();
+        if (!owner->module->parent) {
+            name = generatedLabelName(uid, true);
+        }
+    }
+
+    label = owner->module->addLabel(name, this, uid);
+}
+
+TacBasicBlock::TacBasicBlock(const std::string &n, TacFunction *o, int l)
+    : name(n)
+    , label(l)
+    , owner(o)
+{
+    owner->module->labels[label].block = this;
+}
+
+void TacFunction::addSymbol(TacValue *value)
+{
+    symbols.push_back(value);
+
+    // the first declaration of a name wins, as with the old linear scan
+    symbolIndex.insert(std::make_pair(value->symbol, value));
+}
+
+TacBasicBlock *TacFunction::createBasicBlock(const std::string &name)
+{
+    TacBasicBlockPtr block(new TacBasicBlock(name, this));
+
+    blocks.push_back(block);
+
+    return block.get();
+}
+
+TacFunction *TacFunction::createFunction(IdentifierPtr name, DeclarationsPtr arguments, TypePtr returnType)
+{
+    TacFunctionPtr func(new TacFunction(module, name->id.value(), arguments, returnType));
+    TacValuePtr funcValue(new FunctionTacValue(func));
+
+    func->parent = this;
+
+    if (arguments) {
+        for (std::vector<DeclarationPtr>::iterator i = arguments->list.begin(); i != arguments->list.end(); ++i) {
+            TacValue *parameter = func->createVariable((*i)->id, (*i)->type);
+            parameter->isParameter = true;
+
+            func->parameters.push_back(parameter);
+        }
+    }
+
+    funcValue->symbol = SymbolTable::instance().intern(funcValue->id->id);
+
+    children.push_back(func);
+    module->addValue(funcValue);
+    addSymbol(funcValue.get());
+
+    return func.get();
+}
+
+TacValue *TacFunction::createVariable(IdentifierPtr id, TypePtr type)
+{
+    TacValuePtr symbol(new TacValue);
+    symbol->isConstant = false;
+    symbol->id = id;
+    symbol->type = type;
+    symbol->symbol = SymbolTable::instance().intern(id->id);
+
+    module->addValue(symbol);
+    addSymbol(symbol.get());
+
+    return symbol.get();
+}
+
+// Temporaries are never looked up by name, so they stay out of the symbol
+// index. A fragment leaves them unnamed until it is merged, because naming
+// interns into the shared symbol table and the final number is not known.
+TacValue *TacFunction::createTemporary(TypePtr type)
+{
+    TacValuePtr temporary(new TacValue);
+    temporary->type = type;
+    temporary->uid = module->nextUid();
+    temporary->isTemporary = true;
+
+    module->addValue(temporary);
+    symbols.push_back(temporary.get());
+
+    if (!module->parent) {
+        module->nameTemporary(temporary.get());
+    }
+
+    return temporary.get();
+}
+
+TacValue *TacFunction::lookupSymbol(IdentifierPtr id)
+{
+    SymbolTableEntry *entry = SymbolTable::instance().intern(id->id);
+
+    ++module->statistics.symbolLookups;
+
+    for (TacFunction *scope = this; scope; scope = scope->parent) {
+        ++module->statistics.symbolProbes;
+
+        TacSymbolIndex::const_iterator i = scope->symbolIndex.find(entry);
+        if (i != scope->symbolIndex.end()) {
+            return i->second;
+        }
+    }
+
+    return 0;
+}
+
+void TacFunction::removeSymbol(TacValue *value)
+{
+    symbols.erase(std::remove(symbols.begin(), symbols.end(), value), symbols.end());
+
+    TacSymbolIndex::iterator i = symbolIndex.find(value->symbol);
+    if (i != symbolIndex.end() && i->second == value) {
+        symbolIndex.erase(i);
+    }
+}
+
+void TacFunction::output(std::ostream &ss) const
+{
+    if (!name.empty()) {
+        ss << name << ":";
+    }
+
+    if (arguments) {
+        for (std::vector<DeclarationPtr>::iterator i = arguments->list.begin(); i != arguments->list.end(); ++i) {
+            ss << "\t\t" << "FPARAM" << "\t" << (*i)->id->id.value() << "\n";
+        }
+    }
+
+    for (std::vector<TacValue *>::const_iterator i = symbols.begin(); i != symbols.end(); ++i) {
+        if ((*i)->isConstant || (*i)->isFunction || (*i)->isParameter) {
+            continue;
+        }
+
+        ss << "\t\t" << "VAR" << "\t" << (*i)->value() << "\n";
+    }
+
+    // redundant
+    ss << "\t\t" << "GOTO" << "\t" << blocks.front()->name << "\n";
+
+    for (std::vector<TacFunctionPtr>::const_iterator i = children.begin(); i != children.end(); ++i)
+    {
+        (*i)->output(ss);
+    }
+
+    for (std::vector<TacBasicBlockPtr>::const_iterator i = blocks.begin(); i != blocks.end(); ++i) {
+        if (!(*i)->name.empty()) {
+            ss << (*i)->name << ":";
+        }
+
+        for (TacInstructions::const_iterator j = (*i)->code.begin(); j != (*i)->code.end(); ++j) {
+            module->output(ss, *j);
+        }
+
+        ss << "\n";
+    }
+}
+
+TacModule::TacModule(const TacModule *p)
+    : parent(p)
+    , program(new TacFunction(this, "", DeclarationsPtr(), TypePtr()))
+    , uidCount(0)
+{
+}
+
+int TacModule::addValue(TacValuePtr value)
+{
+    value->index = values.size();
+    values.push_back(value);
+
+    return value->index;
+}
+
+int TacModule::addLabel(const std::string &name, TacBasicBlock *block, int uid)
+{
+    labels.push_back(TacLabel(name, block, uid));
+
+    return labels.size() - 1;
+}
+
+int TacModule::createLabel()
+{
+    int uid = nextUid();
+
+    return addLabel(parent ? std::string() : generatedLabelName(uid, false), 0, uid);
+}
+
+int TacModule::constant(int value)
+{
+    return addValue(TacValuePtr(new ConstIntTacValue(value)));
+}
+
+int TacModule::constant(float value)
+{
+    return addValue(TacValuePtr(new ConstRealTacValue(value)));
+}
+
+// The operand index of a value. In a fragment, values that belong to the
+// parent are given an index here on first use.
+int TacModule::indexOf(TacValue *value)
+{
+    if (!parent) {
+        return value->index;
+    }
+
+    size_t index = value->index;
+    if (index < values.size() && values[index].get() == value) {
+        return value->index;
+    }
+
+    boost::unordered_map<const TacValue *, int>::const_iterator i = imports.find(value);
+    if (i != imports.end()) {
+        return i->second;
+    }
+
+    int local = values.size();
+    values.push_back(parent->values[value->index]);
+    imports.insert(std::make_pair(value, local));
+
+    return local;
+}
+
+void TacModule::nameTemporary(TacValue *value)
+{
+    IdentifierPtr id = arena.create<Identifier>();
+    id->id = Token(generatedTemporaryName(value->uid), -1, -1);
+
+    value->id = id;
+    value->symbol = SymbolTable::instance().intern(id->id);
+}
+
+// Appends a fragment's values and labels in the fragment's order and offsets
+// its numbering by what has been used here so far. Merging fragments in
+// declaration order therefore gives the same module as generating each
+// function here directly, however the fragments were scheduled.
+void TacModule::merge(TacModule &fragment, TacFunction *function)
+{
+    int labelBase = labels.size();
+    int uidBase = uidCount;
+
+    std::vector<int> remap(fragment.values.size());
+    for (size_t i = 0; i < fragment.values.size(); ++i) {
+        TacValuePtr value = fragment.values[i];
+
+        if (fragment.imports.count(value.get())) {
+            remap[i] = value->index;
+            continue;
+        }
+
+        remap[i] = addValue(value);
+
+        if (value->isTemporary) {
+            value->uid += uidBase;
+            nameTemporary(value.get());
+        }
+    }
+
+    for (std::vector<TacLabel>::const_iterator i = fragment.labels.begin(); i != fragment.labels.end(); ++i) {
+        TacLabel label = *i;
+
+        if (label.uid) {
+            label.uid += uidBase;
+            label.name = generatedLabelName(label.uid, label.block != 0);
+        }
+
+        labels.push_back(label);
+    }
+
+    for (std::vector<TacBasicBlockPtr>::const_iterator i = function->blocks.begin(); i != function->blocks.end(); ++i) {
+        TacBasicBlock *block = i->get();
+
+        block->label += labelBase;
+        block->name = labels[block->label].name;
+
+        for (TacInstructions::iterator j = block->code.begin(); j != block->code.end(); ++j) {
+            int *label = j->labelOperand();
+
+            for (int k = 0; k < 3; ++k) {
+                if (&j->operands[k] == label) {
+                    *label += labelBase;
+                } else if (j->operands[k] != kNoOperand) {
+                    j->operands[k] = remap[j->operands[k]];
+                }
+            }
+        }
+    }
+
+    function->module = this;
+    uidCount += fragment.uidCount;
+    statistics.symbolLookups += fragment.statistics.symbolLookups;
+    statistics.symbolProbes += fragment.statistics.symbolProbes;
+}
+
+static void collectFunctions(TacFunction *function, std::vector<TacFunction *> &functions)
+{
+    functions.push_back(function);
+
+    for (std::vector<TacFunctionPtr>::const_iterator i = function->children.begin(); i != function->children.end(); ++i) {
+        collectFunctions(i->get(), functions);
+    }
+}
+
+void TacModule::collectFunctions(std::vector<TacFunction *> &functions) const
+{
+    ::collectFunctions(program.get(), functions);
+}
+
+std::string TacModule::output() const
+{
+    std::stringstream ss;
+
+    program->output(ss);
+
+    return ss.str();
+}
+
+const char *opcodeToString(TacOpcode::Enum opcode)
+{
+    switch (opcode) {
+    case TacOpcode::Add:
+        return "ADD";
+    case TacOpcode::And:
+        return "AND";
+    case TacOpcode::Divide:
+        return "DIVIDE";
+    case TacOpcode::IntegerDivide:
+        return "DIV";
+    case TacOpcode::Modulus:
+        return "MOD";
+    case TacOpcode::Multiply:
+        return "MULT";
+    case TacOpcode::Or:
+        return "OR";
+    case TacOpcode::Subtract:
+        return "SUB";
+    case TacOpcode::Assign:
+        return "ASSIGN";
+    case TacOpcode::Negate:
+        return "UMINUS";
+    case TacOpcode::Not:
+        return "NOT";
+    case TacOpcode::BranchEq:
+        return "EQ";
+    case TacOpcode::BranchGe:
+        return "GE";
+    case TacOpcode::BranchGt:
+        return "GT";
+    case TacOpcode::BranchLe:
+        return "LE";
+    case TacOpcode::BranchLt:
+        return "LT";
+    case TacOpcode::BranchNe:
+        return "NE";
+    case TacOpcode::Goto:
+        return "GOTO";
+    case TacOpcode::Param:
+        return "APARAM";
+    case TacOpcode::Call:
+        return "CALL";
+    case TacOpcode::Return:
+        return "RETURN";
+    case TacOpcode::Check:
+        return "CHECK";
+    default:
+        return "<<<INVALID OPCODE>>>";
+    }
+}
+
+void TacModule::output(std::ostream &ss, const TacInstruction &instruction) const
+{
+    const int *operands = instruction.operands;
+
+    switch (instruction.opcode) {
+    case TacOpcode::Label:
+        ss << labelName(operands[0]) << ":";
+        return;
+
+    case TacOpcode::Goto:
+        ss << "\t\t" << "GOTO" << "\t" << labelName(operands[0]) << "\n";
+        return;
+
+    case TacOpcode::BranchEq:
+    case TacOpcode::BranchGe:
+    case TacOpcode::BranchGt:
+    case TacOpcode::BranchLe:
+    case TacOpcode::BranchLt:
+    case TacOpcode::BranchNe:
+        ss << "\t\t" << opcodeToString(instruction.opcode)
+           << "\t" << value(operands[0])->value()
+           << "\t" << value(operands[1])->value()
+           << "\t" << labelName(operands[2]) << "\n";
+        return;
+
+    case TacOpcode::Not:
+        // the operand is repeated to keep the three-address layout
+        ss << "\t\t" << "NOT"
+           << "\t" << value(operands[0])->value()
+           << "\t" << value(operands[0])->value()
+           << "\t" << value(operands[1])->value() << "\n";
+        return;
+
+    default:
+        break;
+    }
+
+    ss << "\t\t" << opcodeToString(instruction.opcode);
+    for (int i = 0; i < 3 && operands[i] != kNoOperand; ++i) {
+        ss << "\t" << value(operands[i])->value();
+    }
+    ss << "\n";
+}
+
+void inferRealValues(const TacModule &module, const std::vector<TacFunction *> &functions, std::vector<char> &isReal)
+{
+    isReal.assign(module.values.size(), false);
+
+    for (std::vector<TacValuePtr>::const_iterator i = module.values.begin(); i != module.values.end(); ++i) {
+        TacValue *value = i->get();
+
+        if (dynamic_cast<ConstRealTacValue *>(value)) {
+            isReal[value->index] = true;
+        } else if (FunctionTacValue *function = dynamic_cast<FunctionTacValue *>(value)) {
+            isReal[value->index] = isRealType(function->function->returnType);
+        } else if (!value->isTemporary || value->type) {
+            isReal[value->index] = isRealType(value->type);
+        }
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+
+        for (std::vector<TacFunction *>::const_iterator i = functions.begin(); i != functions.end(); ++i) {
+            TacFunction *function = *i;
+
+            for (std::vector<TacBasicBlockPtr>::iterator j = function->blocks.begin(); j != function->blocks.end(); ++j) {
+                for (TacInstructions::iterator k = (*j)->code.begin(); k != (*j)->code.end(); ++k) {
+                    int definition = k->definition();
+                    TacValue *defined = definition == kNoOperand ? 0 : module.value(definition);
+                    if (!defined || !defined->isTemporary || defined->type || isReal[definition]) {
+                        continue;
+                    }
+
+                    bool real = false;
+                    switch (k->opcode) {
+                    case TacOpcode::Add:
+                    case TacOpcode::Multiply:
+                    case TacOpcode::Subtract:
+                        real = isReal[k->operands[0]] || isReal[k->operands[1]];
+                        break;
+                    case TacOpcode::Divide:
+                        real = true;
+                        break;
+                    case TacOpcode::Assign:
+                    case TacOpcode::Negate:
+                        real = isReal[k->operands[0]];
+                        break;
+                    default:
+                        break;
+                    }
+
+                    if (real) {
+                        isReal[definition] = true;
+                        changed = true;
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,268 @@
+#pragma once
+
+#include "Arena.h"
+#include "Ast.h"
+#include "SymbolTable.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+class TacBasicBlock;
+class TacFunction;
+class TacModule;
+class TacValue;
+
+typedef boost::shared_ptr<TacBasicBlock> TacBasicBlockPtr;
+typedef boost::shared_ptr<TacFunction> TacFunctionPtr;
+typedef boost::shared_ptr<TacModule> TacModulePtr;
+typedef boost::shared_ptr<TacValue> TacValuePtr;
+
+struct TacOpcode
+{
+    enum Enum
+    {
+        // dest = lhs op rhs
+        Add,
+        And,
+        Divide,
+        IntegerDivide,
+        Modulus,
+        Multiply,
+        Or,
+        Subtract,
+
+        // dest = op value
+        Assign,
+        Negate,
+        Not,
+
+        // if (lhs relop rhs) goto label
+        BranchEq,
+        BranchGe,
+        BranchGt,
+        BranchLe,
+        BranchLt,
+        BranchNe,
+
+        Goto,
+        Label,
+
+        Param,
+        Call,
+        Return,
+
+        // stop with an error unless lo <= value <= hi: CHECK value lo hi
+        Check,
+
+        Invalid = 0xff
+    };
+};
+
+static const int kNoOperand = -1;
+
+// Operands are indices into the module value table, except for the label
+// operand of branches, Goto and Label which index the module label table.
+struct TacInstruction
+{
+    TacInstruction(TacOpcode::Enum op, int a = kNoOperand, int b = kNoOperand, int c = kNoOperand)
+        : opcode(op)
+    {
+        operands[0] = a;
+        operands[1] = b;
+        operands[2] = c;
+    }
+
+    bool isBinary() const { return opcode <= TacOpcode::Subtract; }
+    bool isUnary() const { return opcode >= TacOpcode::Assign && opcode <= TacOpcode::Not; }
+    bool isBranch() const { return opcode >= TacOpcode::BranchEq && opcode <= TacOpcode::BranchNe; }
+    bool isJump() const { return isBranch() || opcode == TacOpcode::Goto; }
+    bool isTerminator() const { return opcode == TacOpcode::Goto || opcode == TacOpcode::Return; }
+
+    int numUses() const;
+    int definition() const;
+    int label() const;
+    int *labelOperand();
+
+    TacOpcode::Enum opcode;
+    int operands[3];
+};
+
+typedef std::vector<TacInstruction> TacInstructions;
+
+struct TacLabel
+{
+    TacLabel(const std::string &n, TacBasicBlock *b, int u = 0) : name(n), block(b), uid(u) {}
+
+    std::string name;
+    TacBasicBlock *block;
+    // the number in a generated name, 0 for names from the source
+    int uid;
+};
+
+class TacValue : public Value
+{
+public:
+    TacValue() : id(), type(), symbol(0), index(kNoOperand), uid(0), isConstant(false), isFunction(false), isTemporary(false), isParameter(false) {}
+
+    virtual std::string value() const
+    {
+        return symbol ? symbol->name() : id->id.value();
+    }
+
+    IdentifierPtr id;
+    TypePtr type;
+    SymbolTableEntry *symbol;
+    int index;
+    // the number in a temporary's name
+    int uid;
+    bool isConstant;
+    bool isFunction;
+    bool isTemporary;
+    bool isParameter;
+};
+
+class ConstIntTacValue : public TacValue
+{
+public:
+    ConstIntTacValue(int v) : intValue(v) { isConstant = true; }
+
+    virtual std::string value() const;
+
+    int intValue;
+};
+
+class ConstRealTacValue : public TacValue
+{
+public:
+    ConstRealTacValue(float v) : realValue(v) { isConstant = true; }
+
+    virtual std::string value() const;
+
+    float realValue;
+};
+
+class FunctionTacValue : public TacValue
+{
+public:
+    FunctionTacValue(TacFunctionPtr f);
+
+    TacFunctionPtr function;
+};
+
+class TacBasicBlock : public BasicBlock
+{
+public:
+    TacBasicBlock(const std::string &n, TacFunction *o);
+    // for a loader: takes over a label the module already has
+    TacBasicBlock(const std::string &n, TacFunction *o, int l);
+
+    void append(TacOpcode::Enum op, int a = kNoOperand, int b = kNoOperand, int c = kNoOperand)
+    {
+        code.push_back(TacInstruction(op, a, b, c));
+    }
+
+    std::string name;
+    int label;
+    TacFunction *owner;
+    TacInstructions code;
+};
+
+typedef boost::unordered_map<SymbolTableEntry *, TacValue *> TacSymbolIndex;
+
+class TacFunction : public Function
+{
+public:
+    TacFunction(TacModule *m, const std::string &n, DeclarationsPtr a, TypePtr r)
+        : module(m), name(n), arguments(a), returnType(r), parent(0) {}
+
+    void addSymbol(TacValue *value);
+    TacBasicBlock *createBasicBlock(const std::string &name);
+    TacFunction *createFunction(IdentifierPtr name, DeclarationsPtr arguments, TypePtr returnType);
+    TacValue *createVariable(IdentifierPtr id, TypePtr type);
+    TacValue *createTemporary(TypePtr type);
+    TacValue *lookupSymbol(IdentifierPtr id);
+    void removeSymbol(TacValue *value);
+    void output(std::ostream &stream) const;
+
+    TacModule *module;
+    std::string name;
+    DeclarationsPtr arguments;
+    TypePtr returnType;
+    TacFunction *parent;
+    std::vector<TacFunctionPtr> children;
+    std::vector<TacBasicBlockPtr> blocks;
+    std::vector<TacValue *> parameters;
+    std::vector<TacValue *> symbols;
+    TacSymbolIndex symbolIndex;
+};
+
+class TacModule
+{
+public:
+    // A module with a parent is a fragment: it holds the body of one of the
+    // parent's functions while that is generated apart from the rest, and
+    // is folded back in with merge().
+    explicit TacModule(const TacModule *parent = 0);
+
+    struct Statistics
+    {
+        Statistics() : symbolLookups(0), symbolProbes(0) {}
+
+        unsigned long symbolLookups;
+        unsigned long symbolProbes;
+    };
+
+    int addValue(TacValuePtr value);
+    int addLabel(const std::string &name, TacBasicBlock *block = 0, int uid = 0);
+    int createLabel();
+    int constant(int value);
+    int constant(float value);
+    int nextUid() { return ++uidCount; }
+
+    int indexOf(TacValue *value);
+    void nameTemporary(TacValue *value);
+    void merge(TacModule &fragment, TacFunction *function);
+
+    void collectFunctions(std::vector<TacFunction *> &functions) const;
+
+    TacValue *value(int index) const { return values[index].get(); }
+    const std::string &labelName(int index) const { return labels[index].name; }
+
+    std::string output() const;
+    void output(std::ostream &stream, const TacInstruction &instruction) const;
+
+    // identifiers made up by codegen, such as temporaries; the rest point
+    // into the parser's tree
+    Arena arena;
+    const TacModule *parent;
+    TacFunctionPtr program;
+    std::vector<TacValuePtr> values;
+    std::vector<TacLabel> labels;
+    Statistics statistics;
+
+    // numbers generated names; a fragment counts from zero and is offset
+    // when merged, so the names do not depend on which thread made them
+    int uidCount;
+
+    // parent values used by a fragment, and their index in the fragment
+    boost::unordered_map<const TacValue *, int> imports;
+};
+
+// The mnemonic TacModule::output() prints for an opcode.
+const char *opcodeToString(TacOpcode::Enum opcode);
+
+// The names codegen makes up from a uid, for temporaries and for the labels
+// of blocks and of jumps inside blocks.
+std::string generatedTemporaryName(int uid);
+std::string generatedLabelName(int uid, bool isBlock);
+
+// Values are statically typed: variables by their declaration, function
+// values by their return type and temporaries by the instruction that
+// defines them, unless they were created with a type, as the inliner does
+// for the variables it copies into a caller. Fills isReal, indexed by value,
+// for the module's values and the temporaries of the given functions.
+void inferRealValues(const TacModule &module, const std::vector<TacFunction *> &functions, std::vector<char> &isReal);
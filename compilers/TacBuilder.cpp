@@ -2,697 +2,412 @@
 
 #include <sstream>
 
-static int g_labelUid = 0;
-
-class TacBasicBlock : public BasicBlock
-{
-public:
-    TacBasicBlock(const std::string &n, TacFunction *o);
-
-    std::string name;
-    TacFunction *owner;
-    std::stringstream code;
-};
-
-class TacFunction : public Function
+TacBuilder::TacBuilder()
+    : m_insertBlock(0)
+    , m_function(0)
+    , m_checksBounds(false)
+    , m_errorCount(0)
 {
-public:
-    TacFunction(const std::string &n, DeclarationsPtr a, TypePtr r)
-        : name(n), arguments(a) {}
-
-    TacBasicBlockPtr createBasicBlock(const std::string &name);
-    TacFunctionPtr createFunction(IdentifierPtr name, DeclarationsPtr arguments, TypePtr returnType);
-    TacValuePtr createVariable(IdentifierPtr id, TypePtr type);
-    TacValuePtr createTemporary(TypePtr type);
-    TacBasicBlockPtr findBasicBlock(TacBasicBlock *bb);
-    TacFunctionPtr findFunction(TacFunction *func);
-    TacValuePtr lookupSymbol(IdentifierPtr id);
-    std::string output();
-
-    std::string name;
-    DeclarationsPtr arguments;
-    TacFunction *parent;
-    std::vector<TacFunctionPtr> children;
-    std::vector<TacBasicBlockPtr> blocks;
-    std::vector<TacValuePtr> symbols;
-};
+    reset();
+}
 
-class TacValue : public Value
+void TacBuilder::reset()
 {
-public:
-    TacValue() : id(), type(), isConstant(false), isFunction(false) {}
-
-    virtual std::string value() const
-    {
-        return id->id.value();
-    }
-
-    IdentifierPtr id;
-    TypePtr type;
-    bool isConstant;
-    bool isFunction;
-};
+    m_module.reset(new TacModule);
+    m_insertBlock = 0;
+    m_errorCount = 0;
+    m_diagnostics.clear();
 
-class ConstIntTacValue : public TacValue
-{
-public:
-    ConstIntTacValue(int v) : intValue(v) { isConstant = true; }
+    TacValuePtr writelnPtr(new TacValue);
 
-    virtual std::string value() const
-    {
-        std::stringstream ss;
-        ss << intValue;
+    IdentifierPtr writelnIdPtr = m_module->arena.create<Identifier>();
+    writelnIdPtr->id = Token("writeln", -1, -1);
 
-        return ss.str();
-    }
+    writelnPtr->id = writelnIdPtr;
+    writelnPtr->isConstant = true;
+    writelnPtr->isFunction = true;
+    writelnPtr->symbol = SymbolTable::instance().intern(writelnIdPtr->id);
 
-    int intValue;
-};
+    m_module->addValue(writelnPtr);
+    m_module->program->addSymbol(writelnPtr.get());
+}
 
-class ConstRealTacValue : public TacValue
+// A builder for one function body. Until it is merged, the body's blocks,
+// labels and values go to a fragment module of its own.
+TacBuilder::TacBuilder(TacModulePtr parent, TacFunction *function)
+    : m_module(new TacModule(parent.get()))
+    , m_insertBlock(0)
+    , m_function(function)
+    , m_checksBounds(false)
+    , m_errorCount(0)
 {
-public:
-    ConstRealTacValue(float v) : realValue(v) { isConstant = true; }
-
-    virtual std::string value() const
-    {
-        std::stringstream ss;
-        ss << realValue;
-
-        return ss.str();
-    }
-
-    float realValue;
-};
+    function->module = m_module.get();
+}
 
-class FunctionTacValue : public TacValue
+std::string TacBuilder::output()
 {
-public:
-    FunctionTacValue(TacFunctionPtr f) : function(f)
-    {
-        isFunction = true;
-
-        IdentifierPtr fid(new Identifier);
-        fid->id = Token(f->name, -1, -1);
-
-        id = fid;
-    }
-
-    TacFunctionPtr function;
-};
+    return m_module->output();
+}
 
-TacBasicBlock::TacBasicBlock(const std::string &n, TacFunction *o)
-    : name(n)
-    , owner(o)
+TacModulePtr TacBuilder::module() const
 {
-    if (n.empty()) {
-        std::stringstream ss;
-
-        ss << "__block__label__" << (++g_labelUid);
-        name = ss.str();
-    }
+    return m_module;
 }
 
-TacBasicBlockPtr TacFunction::createBasicBlock(const std::string &name)
+BasicBlock *TacBuilder::getInsertBlock()
 {
-    TacBasicBlockPtr block(new TacBasicBlock(name, this));
-
-    blocks.push_back(block);
-
-    return block;
+    return m_insertBlock;
 }
 
-TacFunctionPtr TacFunction::createFunction(IdentifierPtr name, DeclarationsPtr arguments, TypePtr returnType)
+void TacBuilder::setInsertBlock(BasicBlock *bb)
 {
-    TacFunctionPtr func(new TacFunction(name->id.value(), arguments, returnType));
-    TacValuePtr funcValue(new FunctionTacValue(func));
-
-    func->parent = this;
-
-    children.push_back(func);
-    symbols.push_back(funcValue);
-
-    return func;
+    m_insertBlock = (TacBasicBlock *)bb;
 }
 
-TacValuePtr TacFunction::createVariable(IdentifierPtr id, TypePtr type)
+Value *TacBuilder::constValue(int value)
 {
-    TacValuePtr symbol(new TacValue);
-    symbol->isConstant = false;
-    symbol->id = id;
-    symbol->type = type;
-
-    symbols.push_back(symbol);
-
-    return symbol;
+    return m_module->value(m_module->constant(value));
 }
 
-TacValuePtr TacFunction::createTemporary(TypePtr type)
+Value *TacBuilder::constValue(float value)
 {
-    std::stringstream name;
-    name << "__temp__" << (++g_labelUid);
-
-    IdentifierPtr id(new Identifier);
-    id->id = Token(name.str(), -1, -1);
-
-    return createVariable(id, type);
+    return m_module->value(m_module->constant(value));
 }
 
-TacBasicBlockPtr TacFunction::findBasicBlock(TacBasicBlock *bb)
+BasicBlock *TacBuilder::createBasicBlock(const char *name, Function *parent)
 {
-    for (std::vector<TacBasicBlockPtr>::iterator i = blocks.begin(); i != blocks.end(); ++i) {
-        if (i->get() == bb) {
-            return *i;
-        }
+    if (!m_insertBlock && !parent) {
+        m_insertBlock = m_module->program->createBasicBlock(name);
+        return m_insertBlock;
     }
 
-    for (std::vector<TacFunctionPtr>::iterator i = children.begin(); i != children.end(); ++i) {
-        TacBasicBlockPtr ptr = (*i)->findBasicBlock(bb);
-        if (ptr) {
-            return ptr;
-        }
+    if (parent == 0) {
+        parent = m_insertBlock->owner;
+    }
+
+    if (name == 0) {
+        name = "";
     }
 
-    return TacBasicBlockPtr();
+    return ((TacFunction *)parent)->createBasicBlock(name);
 }
 
-TacFunctionPtr TacFunction::findFunction(TacFunction *func)
+void TacBuilder::moveToEnd(BasicBlock *bb)
 {
-    for (std::vector<TacFunctionPtr>::iterator i = children.begin(); i != children.end(); ++i) {
-        if (func == i->get()) {
-            return *i;
-        }
+    TacBasicBlock *block = (TacBasicBlock *)bb;
+    std::vector<TacBasicBlockPtr> &blocks = block->owner->blocks;
 
-        TacFunctionPtr ptr = (*i)->findFunction(func);
-        if (ptr) {
-            return ptr;
+    for (std::vector<TacBasicBlockPtr>::iterator i = blocks.begin(); i != blocks.end(); ++i) {
+        if (i->get() == block) {
+            TacBasicBlockPtr moved = *i;
+            blocks.erase(i);
+            blocks.push_back(moved);
+            return;
         }
     }
-
-    return TacFunctionPtr();
 }
 
-TacValuePtr TacFunction::lookupSymbol(IdentifierPtr id)
+Value *TacBuilder::createTempVariable(BasicBlock *parent, TypePtr type)
 {
-    for (std::vector<TacValuePtr>::iterator i = symbols.begin(); i != symbols.end(); ++i)
-    {
-        if ((*i)->value() == id->id.value()) {
-            return (*i);
-        }
-    }
-
-    if (parent) {
-        return parent->lookupSymbol(id);
+    if (parent == 0) {
+        parent = m_insertBlock;
     }
 
-    return TacValuePtr();
+    return ((TacBasicBlock *)parent)->owner->createTemporary(type);
 }
 
-std::string TacFunction::output()
+Value *TacBuilder::createVariable(IdentifierPtr id, TypePtr type, BasicBlock *parent)
 {
-    std::stringstream ss;
-
-    if (!name.empty()) {
-        ss << name << ":";
-    }
-
-    if (arguments) {
-        for (std::vector<DeclarationPtr>::iterator i = arguments->list.begin(); i != arguments->list.end(); ++i) {
-            ss << "\t\t" << "FPARAM" << "\t" << (*i)->id->id.value() << std::endl;
-        }
+    if (parent == 0) {
+        parent = m_insertBlock;
     }
 
-    for (std::vector<TacValuePtr>::iterator i = symbols.begin(); i != symbols.end(); ++i) {
-        if ((*i)->isConstant || (*i)->isFunction) {
-            continue;
-        }
+    return ((TacBasicBlock *)parent)->owner->createVariable(id, type);
+}
 
-        ss << "\t\t" << "VAR" << "\t" << (*i)->value() << std::endl;
+Function *TacBuilder::createFunction(IdentifierPtr name, DeclarationsPtr arguments, TypePtr returnType)
+{
+    if (!m_insertBlock) {
+        return m_module->program->createFunction(name, arguments, returnType);
     }
 
-    // redundant
-    ss << "\t\t" << "GOTO" << "\t" << blocks.front()->name << std::endl;
-
-    for (std::vector<TacFunctionPtr>::iterator i = children.begin(); i != children.end(); ++i)
-    {
-        ss << (*i)->output();
-    }
+    return m_insertBlock->owner->createFunction(name, arguments, returnType);
+}
 
-    for (std::vector<TacBasicBlockPtr>::iterator i = blocks.begin(); i != blocks.end(); ++i) {
-        if (!(*i)->name.empty()) {
-            ss << (*i)->name << ":";
-        }
+// A name that is not declared is declared where it is missed, without a type,
+// so that it is reported once per subprogram and the rest of the body still
+// generates.
+Value *TacBuilder::symbolTableLookup(IdentifierPtr id)
+{
+    TacValue *symbol = m_insertBlock->owner->lookupSymbol(id);
 
-        ss << (*i)->code.str() << std::endl;
+    if (!symbol) {
+        error(id->id, "Undeclared identifier '" + id->id.value() + "'");
+        symbol = m_insertBlock->owner->createVariable(id, TypePtr());
     }
 
-    return ss.str();
+    return symbol;
 }
 
-TacBuilder::TacBuilder()
-    : m_programFunction(new TacFunction("", DeclarationsPtr(), TypePtr()))
-    , m_insertBlock()
+BuilderPtr TacBuilder::createFunctionBuilder(Function *function)
 {
-    TacValuePtr writelnPtr(new TacValue);
-
-    IdentifierPtr writelnIdPtr(new Identifier);
-    writelnIdPtr->id = Token("writeln", -1, -1);
-
-    writelnPtr->id = writelnIdPtr;
-    writelnPtr->isConstant = true;
-    writelnPtr->isFunction = true;
+    TacBuilder *builder = new TacBuilder(m_module, (TacFunction *)function);
+    builder->m_checksBounds = m_checksBounds;
 
-    m_programFunction->symbols.push_back(writelnPtr);
+    return BuilderPtr(builder);
 }
 
-std::string TacBuilder::output()
+void TacBuilder::mergeFunctionBuilder(BuilderPtr functionBuilder)
 {
-    return m_programFunction->output();
-}
+    TacBuilder *fragment = (TacBuilder *)functionBuilder.get();
 
-BasicBlock *TacBuilder::getInsertBlock()
-{
-    return m_insertBlock.get();
-}
+    m_module->merge(*fragment->m_module, fragment->m_function);
 
-void TacBuilder::setInsertBlock(BasicBlock *bb)
-{
-    m_insertBlock = m_programFunction->findBasicBlock((TacBasicBlock *)bb);
+    m_errorCount += fragment->m_errorCount;
+    m_diagnostics += fragment->m_diagnostics;
 }
 
-Value *TacBuilder::constValue(int value)
+ThreadPool *TacBuilder::threadPool() const
 {
-    TacValuePtr constValue(new ConstIntTacValue(value));
-    m_constValues.push_back(constValue);
-
-    return constValue.get();
+    return m_threadPool.get();
 }
 
-Value *TacBuilder::constValue(float value)
+void TacBuilder::setThreadPool(boost::shared_ptr<ThreadPool> pool)
 {
-    TacValuePtr constValue(new ConstRealTacValue(value));
-    m_constValues.push_back(constValue);
-
-    return constValue.get();
+    m_threadPool = pool;
 }
 
-BasicBlock *TacBuilder::createBasicBlock(const char *name, Function *parent)
+Value *TacBuilder::createCall(IdentifierPtr name, ValueList &params)
 {
-    if (!m_insertBlock) {
-        m_insertBlock = m_programFunction->createBasicBlock(name);
-        return m_insertBlock.get();
-    }
-
-    if (parent == 0) {
-        parent = m_insertBlock->owner;
-    }
+    TacValue *symbol = (TacValue *)symbolTableLookup(name);
 
-    if (name == 0) {
-        name = "";
+    for (ValueList::iterator i = params.begin(); i != params.end(); ++i) {
+        m_insertBlock->append(TacOpcode::Param, index(*i));
     }
 
-    TacFunctionPtr owner = findFunction((TacFunction *)parent);
-
-    return owner->createBasicBlock(name).get();
-}
+    m_insertBlock->append(TacOpcode::Call, index(symbol));
 
-Value *TacBuilder::createTempVariable(BasicBlock *parent, TypePtr type)
-{
-    if (parent == 0) {
-        parent = m_insertBlock.get();
+    if (symbol->isFunction) {
+        return symbol;
     }
 
-    TacFunction *owner = m_programFunction->findBasicBlock((TacBasicBlock *)parent)->owner;
-    return owner->createTemporary(type).get();
-}
-
-Value *TacBuilder::createVariable(IdentifierPtr id, TypePtr type, BasicBlock *parent)
-{
-    if (parent == 0) {
-        parent = m_insertBlock.get();
+    // a name without a type was declared where it was missed, and reported
+    if (symbol->type) {
+        error(name->id, "'" + name->id.value() + "' is not a function or procedure");
     }
-
-    TacFunction *owner = m_programFunction->findBasicBlock((TacBasicBlock *)parent)->owner;
-
-    return owner->createVariable(id, type).get();
+    return createTempVariable(m_insertBlock, symbol->type);
 }
 
-Function *TacBuilder::createFunction(IdentifierPtr name, DeclarationsPtr arguments, TypePtr returnType)
+bool TacBuilder::checksBounds() const
 {
-    if (!m_insertBlock) {
-        return m_programFunction->createFunction(name, arguments, returnType).get() ;
-    }
-
-    return m_insertBlock->owner->createFunction(name, arguments, returnType).get();
+    return m_checksBounds;
 }
 
-Value *TacBuilder::symbolTableLookup(IdentifierPtr id)
+void TacBuilder::setBoundsChecking(bool enabled)
 {
-    return m_insertBlock->owner->lookupSymbol(id).get();
+    m_checksBounds = enabled;
 }
 
-Value *TacBuilder::createCall(Value *target, ValueList &params)
+void TacBuilder::createBoundsCheck(Value *array, Value *subscript)
 {
-    TacValuePtr symbol = m_insertBlock->owner->lookupSymbol(((TacValue *)target)->id);
+    TacValue *symbol = (TacValue *)array;
 
-    for (ValueList::iterator i = params.begin(); i != params.end(); ++i) {
-        m_insertBlock->code << "\t\t" << "APARAM" << "\t" << ((TacValue *)(*i))->value() << std::endl;
+    if (!symbol || !symbol->type || !symbol->type->isArray) {
+        return;
     }
 
-    m_insertBlock->code << "\t\t" << "CALL" << "\t" << symbol->value() << std::endl;
-
-    if (symbol->isFunction) {
-        return symbol.get();
-    }
+    int lo = m_module->constant(symbol->type->startsAt->value.valueAsInt());
+    int hi = m_module->constant(symbol->type->endsAt->value.valueAsInt());
 
-    return 0;
+    m_insertBlock->append(TacOpcode::Check, index(subscript), lo, hi);
 }
 
 Value *TacBuilder::createAdd(Value *lhs, Value *rhs)
 {
-    TacValuePtr result = m_insertBlock->owner->createTemporary(TypePtr());
-
-    TacValue *lhsValue = (TacValue *)lhs;
-    TacValue *rhsValue = (TacValue *)rhs;
-    m_insertBlock->code << "\t\t" << "ADD" << "\t" << lhsValue->value() << "\t" << rhsValue->value() << "\t" << result->value() << std::endl;
-
-    return result.get();
+    return createBinary(TacOpcode::Add, lhs, rhs);
 }
 
 Value *TacBuilder::createAnd(Value *lhs, Value *rhs)
 {
-    TacValuePtr result = m_insertBlock->owner->createTemporary(TypePtr());
-
-    TacValue *lhsValue = (TacValue *)lhs;
-    TacValue *rhsValue = (TacValue *)rhs;
-    m_insertBlock->code << "\t\t" << "AND" << "\t" << lhsValue->value() << "\t" << rhsValue->value() << "\t" << result->value() << std::endl;
-
-    return result.get();
+    return createBinary(TacOpcode::And, lhs, rhs);
 }
 
 void TacBuilder::createAssign(Value *dest, Value *value)
 {
-    TacValue *destValue = (TacValue *)dest;
-    TacValue *valueValue = (TacValue *)value;
-    m_insertBlock->code << "\t\t" << "ASSIGN" << "\t" << valueValue->value() << "\t" << destValue->value() << std::endl;
+    m_insertBlock->append(TacOpcode::Assign, index(value), index(dest));
 }
 
 Value *TacBuilder::createDiv(Value *lhs, Value *rhs)
 {
-    TacValuePtr result = m_insertBlock->owner->createTemporary(TypePtr());
-
-    TacValue *lhsValue = (TacValue *)lhs;
-    TacValue *rhsValue = (TacValue *)rhs;
-    m_insertBlock->code << "\t\t" << "DIVIDE" << "\t" << lhsValue->value() << "\t" << rhsValue->value() << "\t" << result->value() << std::endl;
-
-    return result.get();
+    return createBinary(TacOpcode::Divide, lhs, rhs);
 }
 
 Value *TacBuilder::createIDiv(Value *lhs, Value *rhs)
 {
-    TacValuePtr result = m_insertBlock->owner->createTemporary(TypePtr());
-
-    TacValue *lhsValue = (TacValue *)lhs;
-    TacValue *rhsValue = (TacValue *)rhs;
-    m_insertBlock->code << "\t\t" << "DIV" << "\t" << lhsValue->value() << "\t" << rhsValue->value() << "\t" << result->value() << std::endl;
-
-    return result.get();
+    return createBinary(TacOpcode::IntegerDivide, lhs, rhs);
 }
 
 Value *TacBuilder::createMod(Value *lhs, Value *rhs)
 {
-    TacValuePtr result = m_insertBlock->owner->createTemporary(TypePtr());
-
-    TacValue *lhsValue = (TacValue *)lhs;
-    TacValue *rhsValue = (TacValue *)rhs;
-    m_insertBlock->code << "\t\t" << "MOD" << "\t" << lhsValue->value() << "\t" << rhsValue->value() << "\t" << result->value() << std::endl;
-
-    return result.get();
+    return createBinary(TacOpcode::Modulus, lhs, rhs);
 }
 
 Value *TacBuilder::createMul(Value *lhs, Value *rhs)
 {
-    TacValuePtr result = m_insertBlock->owner->createTemporary(TypePtr());
-
-    TacValue *lhsValue = (TacValue *)lhs;
-    TacValue *rhsValue = (TacValue *)rhs;
-    m_insertBlock->code << "\t\t" << "MULT" << "\t" << lhsValue->value() << "\t" << rhsValue->value() << "\t" << result->value() << std::endl;
-
-    return result.get();
+    return createBinary(TacOpcode::Multiply, lhs, rhs);
 }
 
 Value *TacBuilder::createNeg(Value *value)
 {
-    TacValuePtr result = m_insertBlock->owner->createTemporary(TypePtr());
+    TacValue *result = m_insertBlock->owner->createTemporary(TypePtr());
 
-    TacValue *valueValue = (TacValue *)value;
-    m_insertBlock->code << "\t\t" << "UMINUS" << "\t" << valueValue->value() << "\t" << result->value() << std::endl;
+    m_insertBlock->append(TacOpcode::Negate, index(value), index(result));
 
-    return result.get();
+    return result;
 }
 
 Value *TacBuilder::createNot(Value *value)
 {
-    TacValuePtr result = m_insertBlock->owner->createTemporary(TypePtr());
+    TacValue *result = m_insertBlock->owner->createTemporary(TypePtr());
 
-    TacValue *valueValue = (TacValue *)value;
-    m_insertBlock->code << "\t\t" << "NOT" << "\t" << valueValue->value() << "\t" << valueValue->value() << "\t" << result->value() << std::endl;
+    m_insertBlock->append(TacOpcode::Not, index(value), index(result));
 
-    return result.get();
+    return result;
 }
 
 Value *TacBuilder::createOr(Value *lhs, Value *rhs)
 {
-    TacValuePtr result = m_insertBlock->owner->createTemporary(TypePtr());
-
-    TacValue *lhsValue = (TacValue *)lhs;
-    TacValue *rhsValue = (TacValue *)rhs;
-    m_insertBlock->code << "\t\t" << "OR" << "\t" << lhsValue->value() << "\t" << rhsValue->value() << "\t" << result->value() << std::endl;
-
-    return result.get();
+    return createBinary(TacOpcode::Or, lhs, rhs);
 }
 
 Value *TacBuilder::createSub(Value *lhs, Value *rhs)
 {
-    TacValuePtr result = m_insertBlock->owner->createTemporary(TypePtr());
-
-    TacValue *lhsValue = (TacValue *)lhs;
-    TacValue *rhsValue = (TacValue *)rhs;
-    m_insertBlock->code << "\t\t" << "SUB" << "\t" << lhsValue->value() << "\t" << rhsValue->value() << "\t" << result->value() << std::endl;
-
-    return result.get();
+    return createBinary(TacOpcode::Subtract, lhs, rhs);
 }
 
 Value *TacBuilder::createCmpEq(Value *lhs, Value *rhs)
 {
-    TacValuePtr result = m_insertBlock->owner->createTemporary(TypePtr());
-    std::string trueLabel = createLabel();
-    std::string doneLabel = createLabel();
-
-    TacValue *lhsValue = (TacValue *)lhs;
-    TacValue *rhsValue = (TacValue *)rhs;
-    m_insertBlock->code << "\t\t" << "EQ" << "\t" << lhsValue->value() << "\t" << rhsValue->value() << "\t" << trueLabel << std::endl;
-    m_insertBlock->code << "\t\t" << "ASSIGN" << "\t" << "0" << "\t" << result->value() << std::endl;
-    m_insertBlock->code << "\t\t" << "GOTO" << "\t" << doneLabel << std::endl;
-    m_insertBlock->code << trueLabel << ":";
-    m_insertBlock->code << "\t\t" << "ASSIGN" << "\t" << "1" << "\t" << result->value() << std::endl;
-    m_insertBlock->code << doneLabel << ":";
-
-    return result.get();
+    return createCompare(TacOpcode::BranchEq, lhs, rhs);
 }
 
 Value *TacBuilder::createCmpGe(Value *lhs, Value *rhs)
 {
-    TacValuePtr result = m_insertBlock->owner->createTemporary(TypePtr());
-    std::string trueLabel = createLabel();
-    std::string doneLabel = createLabel();
-
-    TacValue *lhsValue = (TacValue *)lhs;
-    TacValue *rhsValue = (TacValue *)rhs;
-    m_insertBlock->code << "\t\t" << "GE" << "\t" << lhsValue->value() << "\t" << rhsValue->value() << "\t" << trueLabel << std::endl;
-    m_insertBlock->code << "\t\t" << "ASSIGN" << "\t" << "0" << "\t" << result->value() << std::endl;
-    m_insertBlock->code << "\t\t" << "GOTO" << "\t" << doneLabel << std::endl;
-    m_insertBlock->code << trueLabel << ":";
-    m_insertBlock->code << "\t\t" << "ASSIGN" << "\t" << "1" << "\t" << result->value() << std::endl;
-    m_insertBlock->code << doneLabel << ":";
-
-    return result.get();
+    return createCompare(TacOpcode::BranchGe, lhs, rhs);
 }
 
 Value *TacBuilder::createCmpGt(Value *lhs, Value *rhs)
 {
-    TacValuePtr result = m_insertBlock->owner->createTemporary(TypePtr());
-    std::string trueLabel = createLabel();
-    std::string doneLabel = createLabel();
-
-    TacValue *lhsValue = (TacValue *)lhs;
-    TacValue *rhsValue = (TacValue *)rhs;
-    m_insertBlock->code << "\t\t" << "GT" << "\t" << lhsValue->value() << "\t" << rhsValue->value() << "\t" << trueLabel << std::endl;
-    m_insertBlock->code << "\t\t" << "ASSIGN" << "\t" << "0" << "\t" << result->value() << std::endl;
-    m_insertBlock->code << "\t\t" << "GOTO" << "\t" << doneLabel << std::endl;
-    m_insertBlock->code << trueLabel << ":";
-    m_insertBlock->code << "\t\t" << "ASSIGN" << "\t" << "1" << "\t" << result->value() << std::endl;
-    m_insertBlock->code << doneLabel << ":";
-
-    return result.get();
+    return createCompare(TacOpcode::BranchGt, lhs, rhs);
 }
 
 Value *TacBuilder::createCmpLe(Value *lhs, Value *rhs)
 {
-    TacValuePtr result = m_insertBlock->owner->createTemporary(TypePtr());
-    std::string trueLabel = createLabel();
-    std::string doneLabel = createLabel();
-
-    TacValue *lhsValue = (TacValue *)lhs;
-    TacValue *rhsValue = (TacValue *)rhs;
-    m_insertBlock->code << "\t\t" << "LE" << "\t" << lhsValue->value() << "\t" << rhsValue->value() << "\t" << trueLabel << std::endl;
-    m_insertBlock->code << "\t\t" << "ASSIGN" << "\t" << "0" << "\t" << result->value() << std::endl;
-    m_insertBlock->code << "\t\t" << "GOTO" << "\t" << doneLabel << std::endl;
-    m_insertBlock->code << trueLabel << ":";
-    m_insertBlock->code << "\t\t" << "ASSIGN" << "\t" << "1" << "\t" << result->value() << std::endl;
-    m_insertBlock->code << doneLabel << ":";
-
-    return result.get();
+    return createCompare(TacOpcode::BranchLe, lhs, rhs);
 }
 
 Value *TacBuilder::createCmpLt(Value *lhs, Value *rhs)
 {
-    TacValuePtr result = m_insertBlock->owner->createTemporary(TypePtr());
-    std::string trueLabel = createLabel();
-    std::string doneLabel = createLabel();
-
-    TacValue *lhsValue = (TacValue *)lhs;
-    TacValue *rhsValue = (TacValue *)rhs;
-    m_insertBlock->code << "\t\t" << "LT" << "\t" << lhsValue->value() << "\t" << rhsValue->value() << "\t" << trueLabel << std::endl;
-    m_insertBlock->code << "\t\t" << "ASSIGN" << "\t" << "0" << "\t" << result->value() << std::endl;
-    m_insertBlock->code << "\t\t" << "GOTO" << "\t" << doneLabel << std::endl;
-    m_insertBlock->code << trueLabel << ":";
-    m_insertBlock->code << "\t\t" << "ASSIGN" << "\t" << "1" << "\t" << result->value() << std::endl;
-    m_insertBlock->code << doneLabel << ":";
-
-    return result.get();
+    return createCompare(TacOpcode::BranchLt, lhs, rhs);
 }
 
 Value *TacBuilder::createCmpNe(Value *lhs, Value *rhs)
 {
-    TacValuePtr result = m_insertBlock->owner->createTemporary(TypePtr());
-    std::string trueLabel = createLabel();
-    std::string doneLabel = createLabel();
-
-    TacValue *lhsValue = (TacValue *)lhs;
-    TacValue *rhsValue = (TacValue *)rhs;
-    m_insertBlock->code << "\t\t" << "NE" << "\t" << lhsValue->value() << "\t" << rhsValue->value() << "\t" << trueLabel << std::endl;
-    m_insertBlock->code << "\t\t" << "ASSIGN" << "\t" << "0" << "\t" << result->value() << std::endl;
-    m_insertBlock->code << "\t\t" << "GOTO" << "\t" << doneLabel << std::endl;
-    m_insertBlock->code << trueLabel << ":";
-    m_insertBlock->code << "\t\t" << "ASSIGN" << "\t" << "1" << "\t" << result->value() << std::endl;
-    m_insertBlock->code << doneLabel << ":";
-
-    return result.get();
+    return createCompare(TacOpcode::BranchNe, lhs, rhs);
 }
 
 void TacBuilder::createBr(BasicBlock *dest)
 {
-    m_insertBlock->code << "\t\t" << "GOTO" << "\t" << ((TacBasicBlock *)dest)->name << std::endl;
+    m_insertBlock->append(TacOpcode::Goto, ((TacBasicBlock *)dest)->label);
 }
 
 void TacBuilder::createBrCond(Value *cond, BasicBlock *True, BasicBlock *False)
 {
-    m_insertBlock->code << "\t\t" << "EQ" << "\t" << "1" << "\t" << ((TacValue *)cond)->value() << ((TacBasicBlock *)True)->name << std::endl;
-    m_insertBlock->code << "\t\t" << "GOTO" << "\t" << ((TacBasicBlock *)False)->name << std::endl;
+    m_insertBlock->append(TacOpcode::BranchEq, index(constValue(1)), index(cond), ((TacBasicBlock *)True)->label);
+    m_insertBlock->append(TacOpcode::Goto, ((TacBasicBlock *)False)->label);
 }
 
 void TacBuilder::createReturn(Value *value)
 {
-    m_insertBlock->code << "\t\t" << "RETURN" << std::endl;
+    m_insertBlock->append(TacOpcode::Return);
 }
 
 BasicBlock *TacBuilder::createBeq(Value *lhs, Value *rhs, BasicBlock *True)
 {
-    TacBasicBlock *falseBlock = (TacBasicBlock *)createBasicBlock();
-
-    TacValue *lhsValue = (TacValue *)lhs;
-    TacValue *rhsValue = (TacValue *)rhs;
-    m_insertBlock->code << "\t\t" << "EQ" << "\t" << lhsValue->value() << "\t" << rhsValue->value() << "\t" << ((TacBasicBlock *)True)->name << std::endl;
-    m_insertBlock->code << "\t\t" << "GOTO" << "\t" << falseBlock->name << std::endl;
-
-    return falseBlock;
+    return createBranch(TacOpcode::BranchEq, lhs, rhs, True);
 }
 
 BasicBlock *TacBuilder::createBge(Value *lhs, Value *rhs, BasicBlock *True)
 {
-    TacBasicBlock *falseBlock = (TacBasicBlock *)createBasicBlock();
-
-    TacValue *lhsValue = (TacValue *)lhs;
-    TacValue *rhsValue = (TacValue *)rhs;
-    m_insertBlock->code << "\t\t" << "GE" << "\t" << lhsValue->value() << "\t" << rhsValue->value() << "\t" << ((TacBasicBlock *)True)->name << std::endl;
-    m_insertBlock->code << "\t\t" << "GOTO" << "\t" << falseBlock->name << std::endl;
-
-    return falseBlock;
+    return createBranch(TacOpcode::BranchGe, lhs, rhs, True);
 }
 
 BasicBlock *TacBuilder::createBgt(Value *lhs, Value *rhs, BasicBlock *True)
 {
-    TacBasicBlock *falseBlock = (TacBasicBlock *)createBasicBlock();
+    return createBranch(TacOpcode::BranchGt, lhs, rhs, True);
+}
 
-    TacValue *lhsValue = (TacValue *)lhs;
-    TacValue *rhsValue = (TacValue *)rhs;
-    m_insertBlock->code << "\t\t" << "GT" << "\t" << lhsValue->value() << "\t" << rhsValue->value() << "\t" << ((TacBasicBlock *)True)->name << std::endl;
-    m_insertBlock->code << "\t\t" << "GOTO" << "\t" << falseBlock->name << std::endl;
+BasicBlock *TacBuilder::createBle(Value *lhs, Value *rhs, BasicBlock *True)
+{
+    return createBranch(TacOpcode::BranchLe, lhs, rhs, True);
+}
 
-    return falseBlock;
+BasicBlock *TacBuilder::createBlt(Value *lhs, Value *rhs, BasicBlock *True)
+{
+    return createBranch(TacOpcode::BranchLt, lhs, rhs, True);
 }
 
-BasicBlock *TacBuilder::createBle(Value *lhs, Value *rhs, BasicBlock *True)
+BasicBlock *TacBuilder::createBne(Value *lhs, Value *rhs, BasicBlock *True)
 {
-    TacBasicBlock *falseBlock = (TacBasicBlock *)createBasicBlock();
+    return createBranch(TacOpcode::BranchNe, lhs, rhs, True);
+}
+
+Value *TacBuilder::createBinary(TacOpcode::Enum opcode, Value *lhs, Value *rhs)
+{
+    TacValue *result = m_insertBlock->owner->createTemporary(TypePtr());
 
-    TacValue *lhsValue = (TacValue *)lhs;
-    TacValue *rhsValue = (TacValue *)rhs;
-    m_insertBlock->code << "\t\t" << "LE" << "\t" << lhsValue->value() << "\t" << rhsValue->value() << "\t" << ((TacBasicBlock *)True)->name << std::endl;
-    m_insertBlock->code << "\t\t" << "GOTO" << "\t" << falseBlock->name << std::endl;
+    m_insertBlock->append(opcode, index(lhs), index(rhs), index(result));
 
-    return falseBlock;
+    return result;
 }
 
-BasicBlock *TacBuilder::createBlt(Value *lhs, Value *rhs, BasicBlock *True)
+Value *TacBuilder::createCompare(TacOpcode::Enum opcode, Value *lhs, Value *rhs)
 {
-    TacBasicBlock *falseBlock = (TacBasicBlock *)createBasicBlock();
+    TacValue *result = m_insertBlock->owner->createTemporary(TypePtr());
+    int trueLabel = m_module->createLabel();
+    int doneLabel = m_module->createLabel();
 
-    TacValue *lhsValue = (TacValue *)lhs;
-    TacValue *rhsValue = (TacValue *)rhs;
-    m_insertBlock->code << "\t\t" << "LT" << "\t" << lhsValue->value() << "\t" << rhsValue->value() << "\t" << ((TacBasicBlock *)True)->name << std::endl;
-    m_insertBlock->code << "\t\t" << "GOTO" << "\t" << falseBlock->name << std::endl;
+    m_insertBlock->append(opcode, index(lhs), index(rhs), trueLabel);
+    m_insertBlock->append(TacOpcode::Assign, index(constValue(0)), index(result));
+    m_insertBlock->append(TacOpcode::Goto, doneLabel);
+    m_insertBlock->append(TacOpcode::Label, trueLabel);
+    m_insertBlock->append(TacOpcode::Assign, index(constValue(1)), index(result));
+    m_insertBlock->append(TacOpcode::Label, doneLabel);
 
-    return falseBlock;
+    return result;
 }
 
-BasicBlock *TacBuilder::createBne(Value *lhs, Value *rhs, BasicBlock *True)
+BasicBlock *TacBuilder::createBranch(TacOpcode::Enum opcode, Value *lhs, Value *rhs, BasicBlock *True)
 {
     TacBasicBlock *falseBlock = (TacBasicBlock *)createBasicBlock();
 
-    TacValue *lhsValue = (TacValue *)lhs;
-    TacValue *rhsValue = (TacValue *)rhs;
-    m_insertBlock->code << "\t\t" << "NE" << "\t" << lhsValue->value() << "\t" << rhsValue->value() << "\t" << ((TacBasicBlock *)True)->name << std::endl;
-    m_insertBlock->code << "\t\t" << "GOTO" << "\t" << falseBlock->name << std::endl;
+    m_insertBlock->append(opcode, index(lhs), index(rhs), ((TacBasicBlock *)True)->label);
+    m_insertBlock->append(TacOpcode::Goto, falseBlock->label);
 
     return falseBlock;
 }
 
-std::string TacBuilder::createLabel()
+int TacBuilder::index(Value *value)
 {
-    std::stringstream ss;
-
-    ss << "__temp__label__" << (++g_labelUid);
-
-    return ss.str();
+    return m_module->indexOf((TacValue *)value);
 }
 
-TacFunctionPtr TacBuilder::findFunction(TacFunction *function)
+// in the words of Parser::outputErrors(), without the source line, which
+// the builder does not have
+void TacBuilder::error(const Token &token, const std::string &message)
 {
-    if (function == m_programFunction.get()) {
-        return m_programFunction;
-    }
+    std::ostringstream out;
+    out << "ERROR in line " << token.line() << ": " << message << "\n";
 
-    return m_programFunction->findFunction(function);
+    ++m_errorCount;
+    m_diagnostics += out.str();
 }
@@ -1,25 +1,21 @@
 #pragma once
 
 #include "Ast.h"
+#include "Tac.h"
+#include "ThreadPool.h"
 
 #include <boost/shared_ptr.hpp>
 
-#include <vector>
-
-class TacBasicBlock;
-class TacFunction;
-class TacValue;
-
-typedef boost::shared_ptr<TacBasicBlock> TacBasicBlockPtr;
-typedef boost::shared_ptr<TacFunction> TacFunctionPtr;
-typedef boost::shared_ptr<TacValue> TacValuePtr;
-
 class TacBuilder : public Builder
 {
 public:
     TacBuilder();
 
-    std::string output();
+    // drops the module built so far and starts an empty one
+    void reset();
+
+    virtual std::string output();
+    TacModulePtr module() const;
 
     virtual BasicBlock *getInsertBlock();
     virtual void setInsertBlock(BasicBlock *bb);
@@ -28,6 +24,7 @@ public:
     virtual Value *constValue(float value);
 
     virtual BasicBlock *createBasicBlock(const char *name=0, Function *parent=0);
+    virtual void moveToEnd(BasicBlock *bb);
 
     virtual Value *createTempVariable(BasicBlock *parent, TypePtr type);
     virtual Value *createVariable(IdentifierPtr id, TypePtr type, BasicBlock *parent=0);
@@ -35,7 +32,26 @@ public:
     virtual Function *createFunction(IdentifierPtr name, DeclarationsPtr arguments, TypePtr returnType);
     virtual Value *symbolTableLookup(IdentifierPtr id);
 
-    virtual Value *createCall(Value *target, ValueList &params);
+    virtual BuilderPtr createFunctionBuilder(Function *function);
+    virtual void mergeFunctionBuilder(BuilderPtr functionBuilder);
+    virtual ThreadPool *threadPool() const;
+
+    // subprogram bodies are generated on the pool when one is set
+    void setThreadPool(boost::shared_ptr<ThreadPool> pool);
+
+    virtual Value *createCall(IdentifierPtr name, ValueList &params);
+
+    virtual bool checksBounds() const;
+    virtual void createBoundsCheck(Value *array, Value *index);
+
+    // array indices are checked against the declared bounds when set
+    void setBoundsChecking(bool enabled);
+
+    // Names that resolve to nothing, and calls of what is not a subprogram,
+    // are reported here instead of in the parser; when errorCount() is not 0
+    // the module is not worth running.
+    int errorCount() const { return m_errorCount; }
+    const std::string &diagnostics() const { return m_diagnostics; }
 
     virtual Value *createAdd(Value *lhs, Value *rhs);
     virtual Value *createAnd(Value *lhs, Value *rhs);
@@ -68,11 +84,22 @@ public:
     virtual BasicBlock *createBne(Value *lhs, Value *rhs, BasicBlock *True);
 
 private:
-    std::string createLabel();
-    TacFunctionPtr findFunction(TacFunction *function);
+    TacBuilder(TacModulePtr parent, TacFunction *function);
+
+    Value *createBinary(TacOpcode::Enum opcode, Value *lhs, Value *rhs);
+    Value *createCompare(TacOpcode::Enum opcode, Value *lhs, Value *rhs);
+    BasicBlock *createBranch(TacOpcode::Enum opcode, Value *lhs, Value *rhs, BasicBlock *True);
+    int index(Value *value);
+    void error(const Token &token, const std::string &message);
+
+    TacModulePtr m_module;
+    TacBasicBlock *m_insertBlock;
+    boost::shared_ptr<ThreadPool> m_threadPool;
 
-    TacFunctionPtr m_programFunction;
-    TacBasicBlockPtr m_insertBlock;
+    // the function whose body a fragment builder generates
+    TacFunction *m_function;
+    bool m_checksBounds;
 
-    std::vector<TacValuePtr> m_constValues;
+    int m_errorCount;
+    std::string m_diagnostics;
 };
@@ -0,0 +1,331 @@
+#include "TacCfg.h"
+
+#include <algorithm>
+
+static void addUnique(std::vector<int> &list, int value)
+{
+    if (std::find(list.begin(), list.end(), value) == list.end()) {
+        list.push_back(value);
+    }
+}
+
+TacCfg::TacCfg(TacFunction &function)
+    : m_function(&function)
+{
+    split();
+    connect();
+    order();
+    computeDominators();
+    computeFrontiers();
+    numberDominatorTree();
+}
+
+// A node ends after every jump or return and before every label. Each
+// TacBasicBlock gets at least one node, so its label always has a target.
+void TacCfg::split()
+{
+    for (std::vector<TacBasicBlockPtr>::iterator i = m_function->blocks.begin(); i != m_function->blocks.end(); ++i) {
+        TacBasicBlock *block = i->get();
+        const TacInstructions &code = block->code;
+        size_t first = m_nodes.size();
+        size_t start = 0;
+
+        for (size_t j = 0; j < code.size(); ++j) {
+            bool endsBefore = code[j].opcode == TacOpcode::Label && j > start;
+            bool endsAfter = code[j].isJump() || code[j].opcode == TacOpcode::Return;
+
+            if (endsBefore) {
+                m_nodes.push_back(Node(block, start, j));
+                start = j;
+            }
+
+            if (endsAfter) {
+                m_nodes.push_back(Node(block, start, j + 1));
+                start = j + 1;
+            }
+        }
+
+        if (start < code.size() || m_nodes.size() == first) {
+            m_nodes.push_back(Node(block, start, code.size()));
+        }
+
+        if (block->label >= 0) {
+            m_labelNodes[block->label] = first;
+        }
+
+        for (size_t j = first; j < m_nodes.size(); ++j) {
+            const Node &node = m_nodes[j];
+            if (node.begin < node.end && code[node.begin].opcode == TacOpcode::Label) {
+                m_labelNodes[code[node.begin].operands[0]] = j;
+            }
+        }
+    }
+}
+
+// Control falls from a node into the next one in layout order unless it
+// ends in a GOTO or a return; falling off the last node leaves the function.
+void TacCfg::connect()
+{
+    for (size_t i = 0; i < m_nodes.size(); ++i) {
+        Node &node = m_nodes[i];
+        bool fallsThrough = true;
+
+        if (node.begin < node.end) {
+            const TacInstruction &last = node.block->code[node.end - 1];
+
+            if (last.isJump()) {
+                int target = nodeOfLabel(last.label());
+                if (target >= 0) {
+                    addUnique(node.successors, target);
+                }
+            }
+
+            fallsThrough = !last.isTerminator();
+        }
+
+        if (fallsThrough && i + 1 < m_nodes.size()) {
+            addUnique(node.successors, i + 1);
+        }
+
+        for (std::vector<int>::iterator j = node.successors.begin(); j != node.successors.end(); ++j) {
+            m_nodes[*j].predecessors.push_back(i);
+        }
+    }
+}
+
+void TacCfg::order()
+{
+    m_rpoNumber.assign(m_nodes.size(), -1);
+    if (m_nodes.empty()) {
+        return;
+    }
+
+    // iterative depth-first search; the second member is the next successor
+    std::vector<std::pair<int, size_t> > stack;
+    std::vector<bool> visited(m_nodes.size(), false);
+
+    stack.push_back(std::make_pair(0, 0));
+    visited[0] = true;
+
+    while (!stack.empty()) {
+        std::pair<int, size_t> &top = stack.back();
+        const std::vector<int> &successors = m_nodes[top.first].successors;
+
+        if (top.second < successors.size()) {
+            int next = successors[top.second++];
+            if (!visited[next]) {
+                visited[next] = true;
+                stack.push_back(std::make_pair(next, 0));
+            }
+        } else {
+            m_order.push_back(top.first);
+            stack.pop_back();
+        }
+    }
+
+    std::reverse(m_order.begin(), m_order.end());
+
+    for (size_t i = 0; i < m_order.size(); ++i) {
+        m_rpoNumber[m_order[i]] = i;
+    }
+}
+
+int TacCfg::intersect(int a, int b) const
+{
+    while (a != b) {
+        while (m_rpoNumber[a] > m_rpoNumber[b]) {
+            a = m_nodes[a].idom;
+        }
+        while (m_rpoNumber[b] > m_rpoNumber[a]) {
+            b = m_nodes[b].idom;
+        }
+    }
+
+    return a;
+}
+
+// Cooper, Harvey and Kennedy, "A Simple, Fast Dominance Algorithm".
+void TacCfg::computeDominators()
+{
+    for (std::vector<Node>::iterator i = m_nodes.begin(); i != m_nodes.end(); ++i) {
+        i->idom = -1;
+    }
+
+    if (m_order.empty()) {
+        return;
+    }
+
+    int entry = m_order.front();
+    m_nodes[entry].idom = entry;
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+
+        for (size_t i = 1; i < m_order.size(); ++i) {
+            Node &node = m_nodes[m_order[i]];
+            int idom = -1;
+
+            for (std::vector<int>::iterator j = node.predecessors.begin(); j != node.predecessors.end(); ++j) {
+                if (m_nodes[*j].idom < 0) {
+                    continue;
+                }
+
+                idom = idom < 0 ? *j : intersect(*j, idom);
+            }
+
+            if (node.idom != idom) {
+                node.idom = idom;
+                changed = true;
+            }
+        }
+    }
+
+    m_nodes[entry].idom = -1;
+
+    for (size_t i = 1; i < m_order.size(); ++i) {
+        m_nodes[m_nodes[m_order[i]].idom].dominated.push_back(m_order[i]);
+    }
+}
+
+void TacCfg::computeFrontiers()
+{
+    for (std::vector<int>::iterator i = m_order.begin(); i != m_order.end(); ++i) {
+        const Node &node = m_nodes[*i];
+        if (node.predecessors.size() < 2) {
+            continue;
+        }
+
+        for (std::vector<int>::const_iterator j = node.predecessors.begin(); j != node.predecessors.end(); ++j) {
+            int runner = *j;
+            if (!isReachable(runner)) {
+                continue;
+            }
+
+            while (runner >= 0 && runner != node.idom) {
+                addUnique(m_nodes[runner].frontier, *i);
+                runner = m_nodes[runner].idom;
+            }
+        }
+    }
+}
+
+void TacCfg::numberDominatorTree()
+{
+    m_treeEnter.assign(m_nodes.size(), -1);
+    m_treeLeave.assign(m_nodes.size(), -1);
+
+    if (m_order.empty()) {
+        return;
+    }
+
+    std::vector<std::pair<int, size_t> > stack;
+    int clock = 0;
+
+    stack.push_back(std::make_pair(m_order.front(), 0));
+    m_treeEnter[m_order.front()] = clock++;
+
+    while (!stack.empty()) {
+        std::pair<int, size_t> &top = stack.back();
+        const std::vector<int> &dominated = m_nodes[top.first].dominated;
+
+        if (top.second < dominated.size()) {
+            int next = dominated[top.second++];
+            m_treeEnter[next] = clock++;
+            stack.push_back(std::make_pair(next, 0));
+        } else {
+            m_treeLeave[top.first] = clock++;
+            stack.pop_back();
+        }
+    }
+}
+
+bool TacCfg::dominates(int a, int b) const
+{
+    if (!isReachable(a) || !isReachable(b)) {
+        return false;
+    }
+
+    return m_treeEnter[a] <= m_treeEnter[b] && m_treeLeave[b] <= m_treeLeave[a];
+}
+
+int TacCfg::nodeOfLabel(int label) const
+{
+    boost::unordered_map<int, int>::const_iterator i = m_labelNodes.find(label);
+
+    return i == m_labelNodes.end() ? -1 : i->second;
+}
+
+int TacCfg::predecessorIndex(int node, int predecessor) const
+{
+    const std::vector<int> &predecessors = m_nodes[node].predecessors;
+
+    return std::find(predecessors.begin(), predecessors.end(), predecessor) - predecessors.begin();
+}
+
+void TacCfg::insert(const std::vector<TacInstructions> &heads, const std::vector<TacInstructions> &tails) const
+{
+    size_t index = 0;
+
+    for (std::vector<TacBasicBlockPtr>::iterator i = m_function->blocks.begin(); i != m_function->blocks.end(); ++i) {
+        TacInstructions &code = (*i)->code;
+        TacInstructions rewritten;
+        rewritten.reserve(code.size());
+
+        for (; index < m_nodes.size() && m_nodes[index].block == i->get(); ++index) {
+            const Node &node = m_nodes[index];
+            size_t head = node.begin;
+            size_t tail = node.end;
+
+            if (head < tail && code[head].opcode == TacOpcode::Label) {
+                ++head;
+            }
+            if (head < tail && (code[tail - 1].isJump() || code[tail - 1].opcode == TacOpcode::Return)) {
+                --tail;
+            }
+
+            rewritten.insert(rewritten.end(), code.begin() + node.begin, code.begin() + head);
+            rewritten.insert(rewritten.end(), heads[index].begin(), heads[index].end());
+            rewritten.insert(rewritten.end(), code.begin() + head, code.begin() + tail);
+            rewritten.insert(rewritten.end(), tails[index].begin(), tails[index].end());
+            rewritten.insert(rewritten.end(), code.begin() + tail, code.begin() + node.end);
+        }
+
+        code.swap(rewritten);
+    }
+}
+
+static void outputList(std::ostream &stream, const char *name, const std::vector<int> &list)
+{
+    if (list.empty()) {
+        return;
+    }
+
+    stream << "\t" << name;
+    for (std::vector<int>::const_iterator i = list.begin(); i != list.end(); ++i) {
+        stream << " " << *i;
+    }
+}
+
+void TacCfg::output(std::ostream &stream) const
+{
+    for (size_t i = 0; i < m_nodes.size(); ++i) {
+        const Node &node = m_nodes[i];
+
+        stream << i << "\t" << node.block->name << " [" << node.begin << ", " << node.end << ")";
+
+        if (!isReachable(i)) {
+            stream << "\tunreachable\n";
+            continue;
+        }
+
+        if (node.idom >= 0) {
+            stream << "\tidom " << node.idom;
+        }
+
+        outputList(stream, "preds", node.predecessors);
+        outputList(stream, "succs", node.successors);
+        outputList(stream, "frontier", node.frontier);
+        stream << "\n";
+    }
+}
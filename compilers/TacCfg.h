@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Tac.h"
+
+#include <boost/unordered_map.hpp>
+
+#include <ostream>
+#include <vector>
+
+// The control-flow graph of one function. A TacBasicBlock is not always a
+// basic block: the code for relational operators puts labels and branches
+// in the middle of one. The nodes here are the real basic blocks, each a
+// range of instructions in a TacBasicBlock, in layout order.
+//
+// The graph is a snapshot; it has to be rebuilt after a pass adds, removes
+// or moves instructions.
+class TacCfg
+{
+public:
+    struct Node
+    {
+        Node(TacBasicBlock *b, size_t first, size_t last) : block(b), begin(first), end(last), idom(-1) {}
+
+        TacBasicBlock *block;
+        // instructions [begin, end) of block->code
+        size_t begin;
+        size_t end;
+
+        std::vector<int> predecessors;
+        std::vector<int> successors;
+
+        // immediate dominator; -1 for the entry and for unreachable nodes
+        int idom;
+        std::vector<int> dominated;
+        std::vector<int> frontier;
+    };
+
+    explicit TacCfg(TacFunction &function);
+
+    TacFunction &function() const { return *m_function; }
+    const std::vector<Node> &nodes() const { return m_nodes; }
+    const Node &node(int index) const { return m_nodes[index]; }
+    int size() const { return m_nodes.size(); }
+
+    // reachable nodes only, entry first
+    const std::vector<int> &reversePostorder() const { return m_order; }
+
+    bool isReachable(int node) const { return m_rpoNumber[node] >= 0; }
+    bool dominates(int a, int b) const;
+
+    // the node that starts at a label, or -1
+    int nodeOfLabel(int label) const;
+    // where the edge from a node to one of its successors comes in
+    int predecessorIndex(int node, int predecessor) const;
+
+    // Adds instructions at the start of nodes, after a leading label, and at
+    // their end, ahead of a closing jump; both indexed by node. The graph
+    // no longer matches the code afterwards.
+    void insert(const std::vector<TacInstructions> &heads, const std::vector<TacInstructions> &tails) const;
+
+    void output(std::ostream &stream) const;
+
+private:
+    void split();
+    void connect();
+    void order();
+    void computeDominators();
+    void computeFrontiers();
+    void numberDominatorTree();
+
+    int intersect(int a, int b) const;
+
+    TacFunction *m_function;
+    std::vector<Node> m_nodes;
+    std::vector<int> m_order;
+    std::vector<int> m_rpoNumber;
+    // preorder interval of every node in the dominator tree
+    std::vector<int> m_treeEnter;
+    std::vector<int> m_treeLeave;
+    boost::unordered_map<int, int> m_labelNodes;
+};
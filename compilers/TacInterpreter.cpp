@@ -0,0 +1,549 @@
+#include "TacInterpreter.h"
+
+#include <boost/unordered_map.hpp>
+
+#include <algorithm>
+#include <sstream>
+
+#if defined(__GNUC__)
+// labels as values give us direct-threaded dispatch
+#define TAC_DIRECT_THREADING 1
+#endif
+
+static const int kStackSize = 1 << 20;
+static const size_t kMaxCallDepth = 1 << 16;
+
+namespace InterpreterOpcodes
+{
+    enum Enum
+    {
+        Add,
+        Subtract,
+        Multiply,
+        Divide,
+        IntegerDivide,
+        Modulus,
+        And,
+        Or,
+        Assign,
+        Negate,
+        Not,
+        BranchEq,
+        BranchGe,
+        BranchGt,
+        BranchLe,
+        BranchLt,
+        BranchNe,
+        Goto,
+        Param,
+        Call,
+        Writeln,
+        Return,
+        Check,
+        Halt,
+    };
+};
+
+static int translateOpcode(TacOpcode::Enum opcode)
+{
+    switch (opcode) {
+    case TacOpcode::Add:
+        return InterpreterOpcodes::Add;
+    case TacOpcode::And:
+        return InterpreterOpcodes::And;
+    case TacOpcode::Divide:
+        return InterpreterOpcodes::Divide;
+    case TacOpcode::IntegerDivide:
+        return InterpreterOpcodes::IntegerDivide;
+    case TacOpcode::Modulus:
+        return InterpreterOpcodes::Modulus;
+    case TacOpcode::Multiply:
+        return InterpreterOpcodes::Multiply;
+    case TacOpcode::Or:
+        return InterpreterOpcodes::Or;
+    case TacOpcode::Subtract:
+        return InterpreterOpcodes::Subtract;
+    case TacOpcode::Assign:
+        return InterpreterOpcodes::Assign;
+    case TacOpcode::Negate:
+        return InterpreterOpcodes::Negate;
+    case TacOpcode::Not:
+        return InterpreterOpcodes::Not;
+    case TacOpcode::BranchEq:
+        return InterpreterOpcodes::BranchEq;
+    case TacOpcode::BranchGe:
+        return InterpreterOpcodes::BranchGe;
+    case TacOpcode::BranchGt:
+        return InterpreterOpcodes::BranchGt;
+    case TacOpcode::BranchLe:
+        return InterpreterOpcodes::BranchLe;
+    case TacOpcode::BranchLt:
+        return InterpreterOpcodes::BranchLt;
+    case TacOpcode::BranchNe:
+        return InterpreterOpcodes::BranchNe;
+    case TacOpcode::Goto:
+        return InterpreterOpcodes::Goto;
+    case TacOpcode::Param:
+        return InterpreterOpcodes::Param;
+    case TacOpcode::Call:
+        return InterpreterOpcodes::Call;
+    case TacOpcode::Return:
+        return InterpreterOpcodes::Return;
+    case TacOpcode::Check:
+        return InterpreterOpcodes::Check;
+    default:
+        return -1;
+    }
+}
+
+static inline float asReal(const TacCell *cell)
+{
+    return cell->isReal ? cell->realValue : (float)cell->intValue;
+}
+
+static inline int asInt(const TacCell *cell)
+{
+    return cell->isReal ? (int)cell->realValue : cell->intValue;
+}
+
+static inline bool isTrue(const TacCell *cell)
+{
+    return cell->isReal ? cell->realValue != 0 : cell->intValue != 0;
+}
+
+static inline void setInt(TacCell *cell, int value)
+{
+    cell->isReal = false;
+    cell->intValue = value;
+}
+
+static inline void setReal(TacCell *cell, float value)
+{
+    cell->isReal = true;
+    cell->realValue = value;
+}
+
+static TacCell zeroCell()
+{
+    TacCell cell;
+    setInt(&cell, 0);
+    return cell;
+}
+
+TacInterpreter::TacInterpreter(TacModulePtr module)
+    : m_module(module)
+    , m_compiled(false)
+    , m_maxLevel(0)
+    , m_instructionsExecuted(0)
+{
+}
+
+bool TacInterpreter::resolve(int valueIndex, Operand &operand)
+{
+    if (valueIndex == kNoOperand) {
+        operand.level = 0;
+        operand.slot = 0;
+        return true;
+    }
+
+    operand = m_locations[valueIndex];
+    if (operand.level < 0) {
+        m_error = "unresolved value '" + m_module->value(valueIndex)->value() + "'";
+        return false;
+    }
+
+    return true;
+}
+
+bool TacInterpreter::compile()
+{
+    std::vector<TacFunction *> functions;
+    m_module->collectFunctions(functions);
+
+    boost::unordered_map<TacFunction *, int> indices;
+    Operand unresolved = { -1, -1 };
+    m_locations.assign(m_module->values.size(), unresolved);
+
+    // every symbol lives in the frame of the function that declares it
+    for (size_t i = 0; i < functions.size(); ++i) {
+        TacFunction *function = functions[i];
+
+        FunctionInfo info;
+        info.function = function;
+        info.level = function->parent ? m_functions[indices[function->parent]].level + 1 : 0;
+        info.frameSize = 0;
+        info.entry = -1;
+
+        for (std::vector<TacValue *>::iterator j = function->symbols.begin(); j != function->symbols.end(); ++j) {
+            Operand location = { info.level, info.frameSize++ };
+            m_locations[(*j)->index] = location;
+        }
+
+        for (std::vector<TacValue *>::iterator j = function->parameters.begin(); j != function->parameters.end(); ++j) {
+            info.parameterSlots.push_back(m_locations[(*j)->index].slot);
+        }
+
+        m_maxLevel = std::max(m_maxLevel, info.level);
+        indices[function] = m_functions.size();
+        m_functions.push_back(info);
+    }
+
+    // constants are appended to the static frame of the program
+    for (std::vector<TacValuePtr>::iterator i = m_module->values.begin(); i != m_module->values.end(); ++i) {
+        TacCell cell;
+
+        if (ConstIntTacValue *intValue = dynamic_cast<ConstIntTacValue *>(i->get())) {
+            setInt(&cell, intValue->intValue);
+        } else if (ConstRealTacValue *realValue = dynamic_cast<ConstRealTacValue *>(i->get())) {
+            setReal(&cell, realValue->realValue);
+        } else {
+            continue;
+        }
+
+        Operand location = { 0, m_functions[0].frameSize++ };
+        m_locations[(*i)->index] = location;
+        m_constants.push_back(cell);
+        m_constantSlots.push_back(location.slot);
+    }
+
+    std::vector<int> labels(m_module->labels.size(), -1);
+    std::vector<int> jumps;
+
+    for (size_t i = 0; i < m_functions.size(); ++i) {
+        FunctionInfo &info = m_functions[i];
+        info.entry = m_code.size();
+
+        for (std::vector<TacBasicBlockPtr>::iterator j = info.function->blocks.begin(); j != info.function->blocks.end(); ++j) {
+            labels[(*j)->label] = m_code.size();
+
+            for (TacInstructions::iterator k = (*j)->code.begin(); k != (*j)->code.end(); ++k) {
+                if (k->opcode == TacOpcode::Label) {
+                    labels[k->operands[0]] = m_code.size();
+                    continue;
+                }
+
+                if (k->opcode == TacOpcode::Invalid) {
+                    continue;
+                }
+
+                Instruction instruction;
+                instruction.handler = 0;
+                instruction.opcode = translateOpcode(k->opcode);
+                instruction.target = -1;
+
+                if (instruction.opcode < 0) {
+                    m_error = "cannot interpret instruction";
+                    return false;
+                }
+
+                if (k->opcode == TacOpcode::Call) {
+                    TacValue *target = m_module->value(k->operands[0]);
+                    FunctionTacValue *callee = dynamic_cast<FunctionTacValue *>(target);
+
+                    if (callee) {
+                        instruction.target = indices[callee->function.get()];
+                    } else if (target->value() == "writeln") {
+                        instruction.opcode = InterpreterOpcodes::Writeln;
+                    } else {
+                        m_error = "call to unknown function '" + target->value() + "'";
+                        return false;
+                    }
+
+                    m_code.push_back(instruction);
+                    continue;
+                }
+
+                int numOperands = k->isJump() ? k->numUses() : 3;
+                for (int operand = 0; operand < 3; ++operand) {
+                    int value = operand < numOperands ? k->operands[operand] : kNoOperand;
+                    if (!resolve(value, instruction.operands[operand])) {
+                        return false;
+                    }
+                }
+
+                if (k->isJump()) {
+                    instruction.target = k->label();
+                    jumps.push_back(m_code.size());
+                }
+
+                m_code.push_back(instruction);
+            }
+        }
+
+        // falling off the end returns to the caller, or ends the program
+        Instruction end;
+        end.handler = 0;
+        end.opcode = i == 0 ? InterpreterOpcodes::Halt : InterpreterOpcodes::Return;
+        end.target = -1;
+        m_code.push_back(end);
+    }
+
+    for (std::vector<int>::iterator i = jumps.begin(); i != jumps.end(); ++i) {
+        Instruction &instruction = m_code[*i];
+
+        if (labels[instruction.target] < 0) {
+            m_error = "jump to undefined label '" + m_module->labelName(instruction.target) + "'";
+            return false;
+        }
+
+        instruction.target = labels[instruction.target];
+    }
+
+    m_compiled = true;
+    return true;
+}
+
+#define CELL(n) (display[pc->operands[n].level] + pc->operands[n].slot)
+
+#ifdef TAC_DIRECT_THREADING
+#define OPCODE(name) op_##name:
+#define DISPATCH() goto *pc->handler
+#else
+#define OPCODE(name) case InterpreterOpcodes::name:
+#define DISPATCH() goto dispatch
+#endif
+
+#define NEXT() do { ++executed; ++pc; DISPATCH(); } while (0)
+#define JUMP(target) do { ++executed; pc = code + (target); DISPATCH(); } while (0)
+
+#define ARITHMETIC(name, op) \
+    OPCODE(name) { \
+        TacCell *lhs = CELL(0); \
+        TacCell *rhs = CELL(1); \
+        if (lhs->isReal || rhs->isReal) { \
+            setReal(CELL(2), asReal(lhs) op asReal(rhs)); \
+        } else { \
+            setInt(CELL(2), lhs->intValue op rhs->intValue); \
+        } \
+        NEXT(); \
+    }
+
+#define BRANCH(name, op) \
+    OPCODE(name) { \
+        TacCell *lhs = CELL(0); \
+        TacCell *rhs = CELL(1); \
+        bool taken = (lhs->isReal || rhs->isReal) ? asReal(lhs) op asReal(rhs) : lhs->intValue op rhs->intValue; \
+        if (taken) { \
+            JUMP(pc->target); \
+        } \
+        NEXT(); \
+    }
+
+bool TacInterpreter::run(std::ostream &output)
+{
+    m_error.clear();
+    m_instructionsExecuted = 0;
+
+    if (!m_compiled && !compile()) {
+        return false;
+    }
+
+#ifdef TAC_DIRECT_THREADING
+    static const void *handlers[] = {
+        &&op_Add, &&op_Subtract, &&op_Multiply, &&op_Divide, &&op_IntegerDivide, &&op_Modulus,
+        &&op_And, &&op_Or, &&op_Assign, &&op_Negate, &&op_Not,
+        &&op_BranchEq, &&op_BranchGe, &&op_BranchGt, &&op_BranchLe, &&op_BranchLt, &&op_BranchNe,
+        &&op_Goto, &&op_Param, &&op_Call, &&op_Writeln, &&op_Return, &&op_Check, &&op_Halt,
+    };
+
+    if (!m_code.front().handler) {
+        for (std::vector<Instruction>::iterator i = m_code.begin(); i != m_code.end(); ++i) {
+            i->handler = handlers[i->opcode];
+        }
+    }
+#endif
+
+    const FunctionInfo &program = m_functions.front();
+
+    m_stack.resize(kStackSize);
+    m_calls.clear();
+    m_parameters.clear();
+
+    std::fill(m_stack.begin(), m_stack.begin() + program.frameSize, zeroCell());
+    for (size_t i = 0; i < m_constants.size(); ++i) {
+        m_stack[m_constantSlots[i]] = m_constants[i];
+    }
+
+    std::vector<TacCell *> displayStorage(m_maxLevel + 1, (TacCell *)0);
+    TacCell **display = &displayStorage[0];
+    display[0] = &m_stack[0];
+
+    int stackTop = program.frameSize;
+    unsigned long long executed = 0;
+
+    const Instruction *code = &m_code[0];
+    const Instruction *pc = code + program.entry;
+
+    DISPATCH();
+
+#ifndef TAC_DIRECT_THREADING
+dispatch:
+    switch (pc->opcode) {
+#endif
+
+    ARITHMETIC(Add, +)
+    ARITHMETIC(Subtract, -)
+    ARITHMETIC(Multiply, *)
+
+    OPCODE(Divide) {
+        float divisor = asReal(CELL(1));
+        if (divisor == 0) {
+            m_error = "division by zero";
+            goto fail;
+        }
+        setReal(CELL(2), asReal(CELL(0)) / divisor);
+        NEXT();
+    }
+
+    OPCODE(IntegerDivide) {
+        int divisor = asInt(CELL(1));
+        if (divisor == 0) {
+            m_error = "division by zero";
+            goto fail;
+        }
+        setInt(CELL(2), asInt(CELL(0)) / divisor);
+        NEXT();
+    }
+
+    OPCODE(Modulus) {
+        int divisor = asInt(CELL(1));
+        if (divisor == 0) {
+            m_error = "division by zero";
+            goto fail;
+        }
+        setInt(CELL(2), asInt(CELL(0)) % divisor);
+        NEXT();
+    }
+
+    OPCODE(And) {
+        setInt(CELL(2), isTrue(CELL(0)) && isTrue(CELL(1)));
+        NEXT();
+    }
+
+    OPCODE(Or) {
+        setInt(CELL(2), isTrue(CELL(0)) || isTrue(CELL(1)));
+        NEXT();
+    }
+
+    OPCODE(Assign) {
+        *CELL(1) = *CELL(0);
+        NEXT();
+    }
+
+    OPCODE(Negate) {
+        TacCell *value = CELL(0);
+        if (value->isReal) {
+            setReal(CELL(1), -value->realValue);
+        } else {
+            setInt(CELL(1), -value->intValue);
+        }
+        NEXT();
+    }
+
+    OPCODE(Not) {
+        setInt(CELL(1), !isTrue(CELL(0)));
+        NEXT();
+    }
+
+    BRANCH(BranchEq, ==)
+    BRANCH(BranchGe, >=)
+    BRANCH(BranchGt, >)
+    BRANCH(BranchLe, <=)
+    BRANCH(BranchLt, <)
+    BRANCH(BranchNe, !=)
+
+    OPCODE(Goto) {
+        JUMP(pc->target);
+    }
+
+    OPCODE(Param) {
+        m_parameters.push_back(*CELL(0));
+        NEXT();
+    }
+
+    OPCODE(Call) {
+        const FunctionInfo &callee = m_functions[pc->target];
+
+        if (m_calls.size() >= kMaxCallDepth || stackTop + callee.frameSize > kStackSize) {
+            m_error = "stack overflow";
+            goto fail;
+        }
+
+        CallRecord record = { pc + 1, display[callee.level], callee.level, stackTop };
+        m_calls.push_back(record);
+
+        TacCell *frame = &m_stack[stackTop];
+        std::fill(frame, frame + callee.frameSize, zeroCell());
+        stackTop += callee.frameSize;
+
+        size_t numParameters = std::min(callee.parameterSlots.size(), m_parameters.size());
+        for (size_t i = 0; i < numParameters; ++i) {
+            frame[callee.parameterSlots[i]] = m_parameters[i];
+        }
+        m_parameters.clear();
+
+        display[callee.level] = frame;
+        JUMP(callee.entry);
+    }
+
+    OPCODE(Writeln) {
+        for (size_t i = 0; i < m_parameters.size(); ++i) {
+            if (i > 0) {
+                output << " ";
+            }
+
+            if (m_parameters[i].isReal) {
+                output << m_parameters[i].realValue;
+            } else {
+                output << m_parameters[i].intValue;
+            }
+        }
+        output << "\n";
+
+        m_parameters.clear();
+        NEXT();
+    }
+
+    OPCODE(Return) {
+        if (m_calls.empty()) {
+            ++executed;
+            goto done;
+        }
+
+        const CallRecord &record = m_calls.back();
+        display[record.level] = record.savedFrame;
+        stackTop = record.stackTop;
+        pc = record.returnAddress;
+        m_calls.pop_back();
+
+        ++executed;
+        DISPATCH();
+    }
+
+    OPCODE(Check) {
+        int index = asInt(CELL(0));
+        if (index < asInt(CELL(1)) || index > asInt(CELL(2))) {
+            std::ostringstream ss;
+            ss << "index " << index << " out of range " << asInt(CELL(1)) << ".." << asInt(CELL(2));
+            m_error = ss.str();
+            goto fail;
+        }
+        NEXT();
+    }
+
+    OPCODE(Halt) {
+        goto done;
+    }
+
+#ifndef TAC_DIRECT_THREADING
+    }
+#endif
+
+done:
+    m_instructionsExecuted = executed;
+    return true;
+
+fail:
+    m_instructionsExecuted = executed;
+    return false;
+}
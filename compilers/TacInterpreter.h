@@ -0,0 +1,83 @@
+#pragma once
+
+#include "Tac.h"
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct TacCell
+{
+    bool isReal;
+    union
+    {
+        int intValue;
+        float realValue;
+    };
+};
+
+// Executes a TacModule directly. Every value is resolved up front to a
+// (lexical level, frame slot) pair; the display holds the active frame of
+// each level, so nested functions see the variables of their parents.
+class TacInterpreter
+{
+public:
+    TacInterpreter(TacModulePtr module);
+
+    bool run(std::ostream &output);
+
+    unsigned long long instructionsExecuted() const { return m_instructionsExecuted; }
+    const std::string &error() const { return m_error; }
+
+private:
+    struct Operand
+    {
+        int level;
+        int slot;
+    };
+
+    struct Instruction
+    {
+        const void *handler;
+        int opcode;
+        Operand operands[3];
+        int target;
+    };
+
+    struct FunctionInfo
+    {
+        TacFunction *function;
+        int level;
+        int frameSize;
+        int entry;
+        std::vector<int> parameterSlots;
+    };
+
+    struct CallRecord
+    {
+        const Instruction *returnAddress;
+        TacCell *savedFrame;
+        int level;
+        int stackTop;
+    };
+
+    bool compile();
+    bool resolve(int valueIndex, Operand &operand);
+
+    TacModulePtr m_module;
+    bool m_compiled;
+    std::string m_error;
+
+    std::vector<FunctionInfo> m_functions;
+    std::vector<Instruction> m_code;
+    std::vector<Operand> m_locations;
+    std::vector<TacCell> m_constants;
+    std::vector<int> m_constantSlots;
+    int m_maxLevel;
+
+    std::vector<TacCell> m_stack;
+    std::vector<TacCell> m_parameters;
+    std::vector<CallRecord> m_calls;
+
+    unsigned long long m_instructionsExecuted;
+};
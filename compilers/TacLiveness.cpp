@@ -0,0 +1,130 @@
+#include "TacLiveness.h"
+
+TacLiveness::TacLiveness(const TacCfg &cfg)
+    : m_cfg(&cfg)
+    , m_callsReadShared(!cfg.function().children.empty())
+{
+    TacFunction &function = cfg.function();
+    m_slots.reserve(function.symbols.size());
+
+    for (std::vector<TacValue *>::iterator i = function.symbols.begin(); i != function.symbols.end(); ++i) {
+        if ((*i)->isConstant || (*i)->isFunction) {
+            continue;
+        }
+
+        m_slots[(*i)->index] = m_values.size();
+        m_values.push_back((*i)->index);
+    }
+
+    m_shared.resize(m_values.size());
+    if (m_callsReadShared) {
+        for (size_t i = 0; i < m_values.size(); ++i) {
+            m_shared[i] = !function.module->value(m_values[i])->isTemporary;
+        }
+    }
+
+    int count = cfg.size();
+    m_liveIn.assign(count, Set(m_values.size()));
+    m_liveOut.assign(count, Set(m_values.size()));
+
+    // upward exposed uses and definitions of every node
+    std::vector<Set> uses(count, Set(m_values.size()));
+    std::vector<Set> definitions(count, Set(m_values.size()));
+
+    for (int i = 0; i < count; ++i) {
+        const TacCfg::Node &node = cfg.node(i);
+
+        for (size_t j = node.end; j > node.begin; --j) {
+            const TacInstruction &instruction = node.block->code[j - 1];
+
+            int defined = slot(instruction.definition());
+            if (defined >= 0) {
+                definitions[i].set(defined);
+            }
+
+            transfer(instruction, uses[i]);
+        }
+    }
+
+    // backwards, so most nodes see their successors' final sets first
+    const std::vector<int> &order = cfg.reversePostorder();
+    bool changed = true;
+
+    // reused across visits, since this loop is hot and the sets are small
+    Set out(m_values.size());
+    Set in(m_values.size());
+
+    while (changed) {
+        changed = false;
+
+        for (std::vector<int>::const_reverse_iterator i = order.rbegin(); i != order.rend(); ++i) {
+            const TacCfg::Node &node = cfg.node(*i);
+            out.reset();
+
+            for (std::vector<int>::const_iterator j = node.successors.begin(); j != node.successors.end(); ++j) {
+                out |= m_liveIn[*j];
+            }
+
+            in = out;
+            in -= definitions[*i];
+            in |= uses[*i];
+
+            m_liveOut[*i] = out;
+
+            if (in != m_liveIn[*i]) {
+                m_liveIn[*i] = in;
+                changed = true;
+            }
+        }
+    }
+}
+
+int TacLiveness::slot(int value) const
+{
+    boost::unordered_map<int, int>::const_iterator i = m_slots.find(value);
+
+    return i == m_slots.end() ? -1 : i->second;
+}
+
+void TacLiveness::transfer(const TacInstruction &instruction, Set &live) const
+{
+    int defined = slot(instruction.definition());
+    if (defined >= 0) {
+        live.reset(defined);
+    }
+
+    for (int i = 0; i < instruction.numUses(); ++i) {
+        int used = slot(instruction.operands[i]);
+        if (used >= 0) {
+            live.set(used);
+        }
+    }
+
+    if (instruction.opcode == TacOpcode::Call && m_callsReadShared) {
+        live |= m_shared;
+    }
+}
+
+void TacLiveness::outputSet(std::ostream &stream, const Set &set) const
+{
+    TacModule &module = *m_cfg->function().module;
+
+    for (Set::size_type i = set.find_first(); i != Set::npos; i = set.find_next(i)) {
+        stream << " " << module.value(m_values[i])->value();
+    }
+}
+
+void TacLiveness::output(std::ostream &stream) const
+{
+    for (int i = 0; i < m_cfg->size(); ++i) {
+        if (!m_cfg->isReachable(i)) {
+            continue;
+        }
+
+        stream << i << "\tin";
+        outputSet(stream, m_liveIn[i]);
+        stream << "\n\tout";
+        outputSet(stream, m_liveOut[i]);
+        stream << "\n";
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "TacCfg.h"
+
+#include <boost/dynamic_bitset.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <ostream>
+#include <vector>
+
+// Live variables over a TacCfg, as one bit vector per node. Only the
+// function's own variables, parameters and temporaries are tracked; values
+// of other functions and constants are taken to be live everywhere.
+//
+// A call may read any variable of the function that calls it, when that
+// function has nested subprograms, so calls count as uses of those.
+class TacLiveness
+{
+public:
+    typedef boost::dynamic_bitset<> Set;
+
+    explicit TacLiveness(const TacCfg &cfg);
+
+    const TacCfg &cfg() const { return *m_cfg; }
+
+    // tracked values are numbered densely from 0; -1 if not tracked
+    int slot(int value) const;
+    int value(int slot) const { return m_values[slot]; }
+    int size() const { return m_values.size(); }
+
+    // visible to nested subprograms, so never renamed or kept in registers
+    bool isShared(int slot) const { return m_shared[slot]; }
+
+    const Set &liveIn(int node) const { return m_liveIn[node]; }
+    const Set &liveOut(int node) const { return m_liveOut[node]; }
+
+    // Steps a live set from after the instruction to before it.
+    void transfer(const TacInstruction &instruction, Set &live) const;
+
+    void output(std::ostream &stream) const;
+
+private:
+    void outputSet(std::ostream &stream, const Set &set) const;
+
+    const TacCfg *m_cfg;
+    boost::unordered_map<int, int> m_slots;
+    std::vector<int> m_values;
+    Set m_shared;
+    bool m_callsReadShared;
+    std::vector<Set> m_liveIn;
+    std::vector<Set> m_liveOut;
+};
@@ -0,0 +1,133 @@
+#include "TacLoops.h"
+
+#include <algorithm>
+
+static bool hasFewerNodes(const TacLoops::Loop &a, const TacLoops::Loop &b)
+{
+    return a.nodes.size() < b.nodes.size();
+}
+
+TacLoops::TacLoops(const TacCfg &cfg)
+    : m_cfg(&cfg)
+{
+    const std::vector<int> &order = cfg.reversePostorder();
+
+    for (std::vector<int>::const_iterator i = order.begin(); i != order.end(); ++i) {
+        const TacCfg::Node &header = cfg.node(*i);
+
+        Loop loop;
+        for (std::vector<int>::const_iterator j = header.predecessors.begin(); j != header.predecessors.end(); ++j) {
+            if (cfg.dominates(*i, *j)) {
+                loop.latches.push_back(*j);
+            }
+        }
+
+        if (loop.latches.empty()) {
+            continue;
+        }
+
+        loop.header = *i;
+        loop.parent = -1;
+        loop.members.resize(cfg.size());
+        loop.members.set(*i);
+
+        // everything that reaches a latch without passing the header
+        std::vector<int> worklist;
+        for (std::vector<int>::const_iterator j = loop.latches.begin(); j != loop.latches.end(); ++j) {
+            if (!loop.members.test(*j)) {
+                loop.members.set(*j);
+                worklist.push_back(*j);
+            }
+        }
+
+        while (!worklist.empty()) {
+            int node = worklist.back();
+            worklist.pop_back();
+
+            const std::vector<int> &predecessors = cfg.node(node).predecessors;
+            for (std::vector<int>::const_iterator j = predecessors.begin(); j != predecessors.end(); ++j) {
+                if (cfg.isReachable(*j) && !loop.members.test(*j)) {
+                    loop.members.set(*j);
+                    worklist.push_back(*j);
+                }
+            }
+        }
+
+        for (std::vector<int>::const_iterator j = i; j != order.end(); ++j) {
+            if (loop.members.test(*j)) {
+                loop.nodes.push_back(*j);
+            }
+        }
+
+        m_loops.push_back(loop);
+    }
+
+    // Loops nest or are disjoint, so the smallest loop holding a header is
+    // the innermost one around it.
+    std::stable_sort(m_loops.begin(), m_loops.end(), hasFewerNodes);
+
+    for (size_t i = 0; i < m_loops.size(); ++i) {
+        for (size_t j = i + 1; j < m_loops.size(); ++j) {
+            if (contains(m_loops[j], m_loops[i].header)) {
+                m_loops[i].parent = j;
+                break;
+            }
+        }
+    }
+}
+
+int TacLoops::preheader(const Loop &loop) const
+{
+    int preheader = -1;
+    const std::vector<int> &predecessors = m_cfg->node(loop.header).predecessors;
+
+    for (std::vector<int>::const_iterator i = predecessors.begin(); i != predecessors.end(); ++i) {
+        if (contains(loop, *i)) {
+            continue;
+        }
+
+        if (preheader >= 0 || m_cfg->node(*i).successors.size() != 1) {
+            return -1;
+        }
+
+        preheader = *i;
+    }
+
+    return preheader;
+}
+
+std::vector<int> TacLoops::exitingNodes(const Loop &loop) const
+{
+    std::vector<int> exiting;
+
+    for (std::vector<int>::const_iterator i = loop.nodes.begin(); i != loop.nodes.end(); ++i) {
+        const std::vector<int> &successors = m_cfg->node(*i).successors;
+
+        for (std::vector<int>::const_iterator j = successors.begin(); j != successors.end(); ++j) {
+            if (!contains(loop, *j)) {
+                exiting.push_back(*i);
+                break;
+            }
+        }
+    }
+
+    return exiting;
+}
+
+void TacLoops::output(std::ostream &stream) const
+{
+    for (size_t i = 0; i < m_loops.size(); ++i) {
+        const Loop &loop = m_loops[i];
+
+        stream << "loop " << i << "\theader " << loop.header;
+        if (loop.parent >= 0) {
+            stream << "\tparent " << loop.parent;
+        }
+
+        stream << "\tnodes";
+        for (std::vector<int>::const_iterator j = loop.nodes.begin(); j != loop.nodes.end(); ++j) {
+            stream << " " << *j;
+        }
+        stream << "\n";
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "TacCfg.h"
+
+#include <boost/dynamic_bitset.hpp>
+
+#include <ostream>
+#include <vector>
+
+// The natural loops of a TacCfg. An edge is a back edge when its target
+// dominates its source; the loops of all back edges into one header are
+// merged into a single loop.
+class TacLoops
+{
+public:
+    struct Loop
+    {
+        int header;
+        // sources of the back edges
+        std::vector<int> latches;
+        // members in reverse postorder, header first
+        std::vector<int> nodes;
+        boost::dynamic_bitset<> members;
+        // the innermost enclosing loop, or -1
+        int parent;
+    };
+
+    explicit TacLoops(const TacCfg &cfg);
+
+    // inner loops come before the loops around them
+    const std::vector<Loop> &loops() const { return m_loops; }
+
+    bool contains(const Loop &loop, int node) const { return loop.members.test(node); }
+
+    // The only predecessor from outside the loop, if it leads nowhere but
+    // the header, so code put at its end runs once before the loop; or -1.
+    int preheader(const Loop &loop) const;
+
+    // loop nodes with a successor outside the loop
+    std::vector<int> exitingNodes(const Loop &loop) const;
+
+    void output(std::ostream &stream) const;
+
+private:
+    const TacCfg *m_cfg;
+    std::vector<Loop> m_loops;
+};
@@ -0,0 +1,702 @@
+#include "TacObject.h"
+#include "SymbolTable.h"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+// Names are stored once, however many records use them.
+class TacObjectStrings
+{
+public:
+    boost::uint32_t add(const std::string &name)
+    {
+        boost::unordered_map<std::string, boost::uint32_t>::iterator i = m_offsets.find(name);
+        if (i != m_offsets.end()) {
+            return i->second;
+        }
+
+        boost::uint32_t offset = m_data.size();
+        m_data.append(name);
+        m_data.push_back('\0');
+        m_offsets[name] = offset;
+
+        return offset;
+    }
+
+    const std::string &data() const { return m_data; }
+
+private:
+    std::string m_data;
+    boost::unordered_map<std::string, boost::uint32_t> m_offsets;
+};
+
+static size_t padding(size_t size)
+{
+    return (4 - size % 4) % 4;
+}
+
+template <typename T>
+static void writeTable(std::ostream &stream, const std::vector<T> &table)
+{
+    if (!table.empty()) {
+        stream.write(reinterpret_cast<const char *>(&table[0]), table.size() * sizeof(T));
+    }
+}
+
+template <typename T>
+static TacObjectSection section(size_t &offset, size_t count)
+{
+    TacObjectSection result = { (boost::uint32_t)offset, (boost::uint32_t)count };
+    offset += count * sizeof(T);
+
+    return result;
+}
+
+// Lays out the tables of a module's image. Values and labels get a record
+// when something first refers to them.
+class TacObjectWriter
+{
+public:
+    explicit TacObjectWriter(const TacModule &module);
+
+    bool write(std::ostream &stream);
+
+private:
+    boost::uint32_t addType(TypePtr type);
+    boost::uint32_t addValue(int index);
+    boost::uint32_t addLabel(int index);
+
+    const TacModule &m_module;
+    TacObjectStrings m_strings;
+
+    std::vector<TacObjectType> m_types;
+    std::vector<TacObjectValue> m_values;
+    std::vector<TacObjectLabel> m_labels;
+    std::vector<TacObjectFunction> m_functions;
+    std::vector<boost::uint32_t> m_symbols;
+    std::vector<TacObjectBlock> m_blocks;
+    std::vector<TacObjectInstruction> m_instructions;
+
+    // per module value and label, its record or kTacObjectNone
+    std::vector<boost::uint32_t> m_valueRecords;
+    std::vector<boost::uint32_t> m_labelRecords;
+    // per label record, the module label
+    std::vector<int> m_labelOrigins;
+    // per flags, type and bits, the record of a constant
+    boost::unordered_map<std::pair<boost::uint64_t, boost::uint32_t>, boost::uint32_t> m_constants;
+    boost::unordered_map<const TacFunction *, boost::uint32_t> m_functionIndices;
+};
+
+TacObjectWriter::TacObjectWriter(const TacModule &module)
+    : m_module(module)
+    , m_valueRecords(module.values.size(), kTacObjectNone)
+    , m_labelRecords(module.labels.size(), kTacObjectNone)
+{
+}
+
+boost::uint32_t TacObjectWriter::addType(TypePtr type)
+{
+    if (!type) {
+        return kTacObjectNone;
+    }
+
+    for (size_t i = 0; i < m_types.size(); ++i) {
+        if (m_types[i].standardType == (boost::uint32_t)type->standardType && m_types[i].isArray == (boost::uint32_t)type->isArray) {
+            return i;
+        }
+    }
+
+    TacObjectType record = { (boost::uint32_t)type->standardType, (boost::uint32_t)type->isArray };
+    m_types.push_back(record);
+
+    return m_types.size() - 1;
+}
+
+boost::uint32_t TacObjectWriter::addValue(int index)
+{
+    if (m_valueRecords[index] != kTacObjectNone) {
+        return m_valueRecords[index];
+    }
+
+    TacValue *value = m_module.value(index);
+
+    TacObjectValue record;
+    record.flags = 0;
+    record.name = kTacObjectNone;
+    record.type = addType(value->type);
+    record.uid = value->uid;
+    record.constant = 0;
+    record.function = kTacObjectNone;
+
+    bool isNumber = false;
+
+    if (ConstIntTacValue *intValue = dynamic_cast<ConstIntTacValue *>(value)) {
+        std::memcpy(&record.constant, &intValue->intValue, sizeof(record.constant));
+        isNumber = true;
+    } else if (ConstRealTacValue *realValue = dynamic_cast<ConstRealTacValue *>(value)) {
+        std::memcpy(&record.constant, &realValue->realValue, sizeof(record.constant));
+        record.flags |= TacObjectValueFlags::Real;
+        isNumber = true;
+    } else if (value->isTemporary && value->value() == generatedTemporaryName(value->uid)) {
+        record.name = kTacObjectTemporaryName;
+    } else {
+        record.name = m_strings.add(value->value());
+    }
+
+    if (FunctionTacValue *functionValue = dynamic_cast<FunctionTacValue *>(value)) {
+        boost::unordered_map<const TacFunction *, boost::uint32_t>::iterator function = m_functionIndices.find(functionValue->function.get());
+        if (function != m_functionIndices.end()) {
+            record.function = function->second;
+        }
+    }
+
+    record.flags |= value->isConstant ? TacObjectValueFlags::Constant : 0;
+    record.flags |= value->isFunction ? TacObjectValueFlags::Function : 0;
+    record.flags |= value->isTemporary ? TacObjectValueFlags::Temporary : 0;
+    record.flags |= value->isParameter ? TacObjectValueFlags::Parameter : 0;
+
+    // nothing writes to a constant, so its uses may share it
+    if (isNumber) {
+        std::pair<boost::uint64_t, boost::uint32_t> key((boost::uint64_t)record.flags << 32 | record.type, record.constant);
+
+        boost::unordered_map<std::pair<boost::uint64_t, boost::uint32_t>, boost::uint32_t>::iterator i = m_constants.find(key);
+        if (i != m_constants.end()) {
+            return m_valueRecords[index] = i->second;
+        }
+
+        m_constants[key] = m_values.size();
+    }
+
+    m_values.push_back(record);
+
+    return m_valueRecords[index] = m_values.size() - 1;
+}
+
+boost::uint32_t TacObjectWriter::addLabel(int index)
+{
+    if (m_labelRecords[index] != kTacObjectNone) {
+        return m_labelRecords[index];
+    }
+
+    const TacLabel &label = m_module.labels[index];
+
+    TacObjectLabel record = { 0, kTacObjectNone, (boost::uint32_t)label.uid };
+    if (label.name == generatedLabelName(label.uid, true)) {
+        record.name = kTacObjectBlockLabelName;
+    } else if (label.name == generatedLabelName(label.uid, false)) {
+        record.name = kTacObjectJumpLabelName;
+    } else {
+        record.name = m_strings.add(label.name);
+    }
+
+    m_labels.push_back(record);
+    m_labelOrigins.push_back(index);
+
+    return m_labelRecords[index] = m_labels.size() - 1;
+}
+
+bool TacObjectWriter::write(std::ostream &stream)
+{
+    std::vector<TacFunction *> functions;
+    m_module.collectFunctions(functions);
+
+    for (size_t i = 0; i < functions.size(); ++i) {
+        m_functionIndices[functions[i]] = i;
+    }
+
+    boost::unordered_map<const TacBasicBlock *, boost::uint32_t> blockIndices;
+
+    for (std::vector<TacFunction *>::iterator i = functions.begin(); i != functions.end(); ++i) {
+        TacFunction *function = *i;
+
+        TacObjectFunction record;
+        record.name = m_strings.add(function->name);
+        record.parent = function->parent ? m_functionIndices[function->parent] : kTacObjectNone;
+        record.returnType = addType(function->returnType);
+        record.firstSymbol = m_symbols.size();
+        record.symbolCount = function->symbols.size();
+        record.parameterCount = function->parameters.size();
+        record.firstBlock = m_blocks.size();
+        record.blockCount = function->blocks.size();
+        m_functions.push_back(record);
+
+        for (std::vector<TacValue *>::iterator j = function->symbols.begin(); j != function->symbols.end(); ++j) {
+            m_symbols.push_back(addValue((*j)->index));
+        }
+
+        for (std::vector<TacValue *>::iterator j = function->parameters.begin(); j != function->parameters.end(); ++j) {
+            m_symbols.push_back(addValue((*j)->index));
+        }
+
+        for (std::vector<TacBasicBlockPtr>::iterator j = function->blocks.begin(); j != function->blocks.end(); ++j) {
+            TacObjectBlock block = { addLabel((*j)->label), (boost::uint32_t)m_instructions.size(), (boost::uint32_t)(*j)->code.size() };
+            blockIndices[j->get()] = m_blocks.size();
+            m_blocks.push_back(block);
+
+            for (TacInstructions::iterator k = (*j)->code.begin(); k != (*j)->code.end(); ++k) {
+                TacObjectInstruction instruction = { (boost::uint32_t)k->opcode, { kNoOperand, kNoOperand, kNoOperand } };
+                int *label = k->labelOperand();
+
+                for (int l = 0; l < 3; ++l) {
+                    if (&k->operands[l] == label) {
+                        instruction.operands[l] = addLabel(*label);
+                    } else if (k->operands[l] != kNoOperand) {
+                        instruction.operands[l] = addValue(k->operands[l]);
+                    }
+                }
+
+                m_instructions.push_back(instruction);
+            }
+        }
+    }
+
+    // a label names a block only if the block is still in its function
+    for (size_t i = 0; i < m_labels.size(); ++i) {
+        boost::unordered_map<const TacBasicBlock *, boost::uint32_t>::iterator block = blockIndices.find(m_module.labels[m_labelOrigins[i]].block);
+        if (block != blockIndices.end()) {
+            m_labels[i].block = block->second;
+        }
+    }
+
+    TacObjectHeader header;
+    std::memcpy(header.magic, kTacObjectMagic, sizeof(header.magic));
+    header.version = kTacObjectVersion;
+    header.byteOrder = kTacObjectByteOrder;
+    header.uidCount = m_module.uidCount;
+
+    const std::string &strings = m_strings.data();
+
+    size_t offset = sizeof(header);
+    header.strings = section<char>(offset, strings.size());
+    offset += padding(strings.size());
+    header.types = section<TacObjectType>(offset, m_types.size());
+    header.values = section<TacObjectValue>(offset, m_values.size());
+    header.labels = section<TacObjectLabel>(offset, m_labels.size());
+    header.functions = section<TacObjectFunction>(offset, m_functions.size());
+    header.symbols = section<boost::uint32_t>(offset, m_symbols.size());
+    header.blocks = section<TacObjectBlock>(offset, m_blocks.size());
+    header.instructions = section<TacObjectInstruction>(offset, m_instructions.size());
+
+    static const char zeros[4] = { 0, 0, 0, 0 };
+
+    stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    stream.write(strings.data(), strings.size());
+    stream.write(zeros, padding(strings.size()));
+    writeTable(stream, m_types);
+    writeTable(stream, m_values);
+    writeTable(stream, m_labels);
+    writeTable(stream, m_functions);
+    writeTable(stream, m_symbols);
+    writeTable(stream, m_blocks);
+    writeTable(stream, m_instructions);
+
+    return stream.good();
+}
+
+bool writeTacObject(const TacModule &module, std::ostream &stream)
+{
+    return TacObjectWriter(module).write(stream);
+}
+
+// Reads the tables of an image in place, once the sections are known to
+// lie inside it.
+class TacObjectReader
+{
+public:
+    TacObjectReader(const char *data, size_t size, std::string &error)
+        : m_data(data), m_size(size), m_header(0), m_error(&error) {}
+
+    TacModulePtr load();
+
+private:
+    template <typename T>
+    const T *table(const TacObjectSection &section) const
+    {
+        return reinterpret_cast<const T *>(m_data + section.offset);
+    }
+
+    template <typename T>
+    bool checkSection(const TacObjectSection &section, const char *name)
+    {
+        if (section.offset % 4 != 0 || section.offset > m_size || section.count > (m_size - section.offset) / sizeof(T)) {
+            return fail(std::string("the ") + name + " table lies outside the file");
+        }
+
+        return true;
+    }
+
+    bool checkRange(boost::uint32_t first, boost::uint32_t count, boost::uint32_t size, const char *name);
+    bool checkInstruction(const TacObjectInstruction &instruction);
+    bool name(boost::uint32_t offset, std::string &result);
+    bool type(boost::uint32_t index, const std::vector<TypePtr> &types, TypePtr &result);
+    bool fail(const std::string &message);
+
+    const char *m_data;
+    size_t m_size;
+    const TacObjectHeader *m_header;
+    std::string *m_error;
+};
+
+bool TacObjectReader::fail(const std::string &message)
+{
+    *m_error = message;
+    return false;
+}
+
+bool TacObjectReader::checkRange(boost::uint32_t first, boost::uint32_t count, boost::uint32_t size, const char *name)
+{
+    if (first > size || count > size - first) {
+        return fail(std::string("a range of ") + name + " runs past its table");
+    }
+
+    return true;
+}
+
+bool TacObjectReader::name(boost::uint32_t offset, std::string &result)
+{
+    if (offset == kTacObjectNone) {
+        result.clear();
+        return true;
+    }
+
+    // the table ends in a NUL, so every name in it does
+    if (offset >= m_header->strings.count) {
+        return fail("a name lies outside the string table");
+    }
+
+    result = m_data + m_header->strings.offset + offset;
+    return true;
+}
+
+bool TacObjectReader::type(boost::uint32_t index, const std::vector<TypePtr> &types, TypePtr &result)
+{
+    if (index == kTacObjectNone) {
+        result = TypePtr();
+        return true;
+    }
+
+    if (index >= types.size()) {
+        return fail("a type that does not exist");
+    }
+
+    result = types[index];
+    return true;
+}
+
+bool TacObjectReader::checkInstruction(const TacObjectInstruction &instruction)
+{
+    if (instruction.opcode > TacOpcode::Check && instruction.opcode != TacOpcode::Invalid) {
+        return fail("unknown opcode");
+    }
+
+    TacInstruction decoded((TacOpcode::Enum)instruction.opcode, instruction.operands[0], instruction.operands[1], instruction.operands[2]);
+    if (decoded.opcode == TacOpcode::Invalid) {
+        return true;
+    }
+
+    int *label = decoded.labelOperand();
+
+    // what the passes and backends read must be there; the rest may be
+    // kNoOperand
+    int required = decoded.numUses();
+    if (decoded.isBinary() || decoded.isUnary() || decoded.opcode == TacOpcode::Call) {
+        ++required;
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        int operand = decoded.operands[i];
+
+        if (&decoded.operands[i] == label) {
+            if (operand < 0 || (boost::uint32_t)operand >= m_header->labels.count) {
+                return fail("a jump to a label that does not exist");
+            }
+        } else if (operand == kNoOperand ? i < required : operand < 0 || (boost::uint32_t)operand >= m_header->values.count) {
+            return fail("an operand that is not a value");
+        }
+    }
+
+    return true;
+}
+
+TacModulePtr TacObjectReader::load()
+{
+    if (m_size < sizeof(TacObjectHeader)) {
+        fail("too short for a TAC object");
+        return TacModulePtr();
+    }
+
+    m_header = reinterpret_cast<const TacObjectHeader *>(m_data);
+
+    if (std::memcmp(m_header->magic, kTacObjectMagic, sizeof(m_header->magic)) != 0) {
+        fail("not a TAC object");
+        return TacModulePtr();
+    }
+
+    if (m_header->byteOrder != kTacObjectByteOrder) {
+        fail("written with the other byte order");
+        return TacModulePtr();
+    }
+
+    if (m_header->version != kTacObjectVersion) {
+        std::stringstream ss;
+        ss << "version " << m_header->version << ", but this reads version " << kTacObjectVersion;
+        fail(ss.str());
+        return TacModulePtr();
+    }
+
+    if (!checkSection<char>(m_header->strings, "string")
+            || !checkSection<TacObjectType>(m_header->types, "type")
+            || !checkSection<TacObjectValue>(m_header->values, "value")
+            || !checkSection<TacObjectLabel>(m_header->labels, "label")
+            || !checkSection<TacObjectFunction>(m_header->functions, "function")
+            || !checkSection<boost::uint32_t>(m_header->symbols, "symbol")
+            || !checkSection<TacObjectBlock>(m_header->blocks, "block")
+            || !checkSection<TacObjectInstruction>(m_header->instructions, "instruction")) {
+        return TacModulePtr();
+    }
+
+    if (m_header->strings.count > 0 && m_data[m_header->strings.offset + m_header->strings.count - 1] != '\0') {
+        fail("the string table is not terminated");
+        return TacModulePtr();
+    }
+
+    if (m_header->functions.count == 0) {
+        fail("there is no program");
+        return TacModulePtr();
+    }
+
+    TacModulePtr module(new TacModule);
+    module->uidCount = m_header->uidCount;
+
+    const TacObjectType *typeRecords = table<TacObjectType>(m_header->types);
+    std::vector<TypePtr> types;
+
+    for (boost::uint32_t i = 0; i < m_header->types.count; ++i) {
+        if (typeRecords[i].standardType > NumberType::Real) {
+            fail("unknown standard type");
+            return TacModulePtr();
+        }
+
+        TypePtr type = module->arena.create<Type>();
+        type->standardType = (NumberType::Enum)typeRecords[i].standardType;
+        type->isArray = typeRecords[i].isArray != 0;
+        types.push_back(type);
+    }
+
+    const TacObjectFunction *functionRecords = table<TacObjectFunction>(m_header->functions);
+    std::vector<TacFunctionPtr> functions;
+    std::string text;
+
+    for (boost::uint32_t i = 0; i < m_header->functions.count; ++i) {
+        const TacObjectFunction &record = functionRecords[i];
+
+        if ((i == 0) != (record.parent == kTacObjectNone) || (i > 0 && record.parent >= i)) {
+            fail("functions are not listed parents first");
+            return TacModulePtr();
+        }
+
+        TypePtr returnType;
+        if (!type(record.returnType, types, returnType) || !name(record.name, text)) {
+            return TacModulePtr();
+        }
+
+        TacFunctionPtr function = i == 0 ? module->program : TacFunctionPtr(new TacFunction(module.get(), text, DeclarationsPtr(), returnType));
+        function->name = text;
+        function->returnType = returnType;
+
+        if (i > 0) {
+            function->parent = functions[record.parent].get();
+            function->parent->children.push_back(function);
+        }
+
+        functions.push_back(function);
+    }
+
+    const TacObjectValue *valueRecords = table<TacObjectValue>(m_header->values);
+
+    for (boost::uint32_t i = 0; i < m_header->values.count; ++i) {
+        const TacObjectValue &record = valueRecords[i];
+        TacValuePtr value;
+
+        TypePtr valueType;
+        if (!type(record.type, types, valueType) || (record.name != kTacObjectTemporaryName && !name(record.name, text))) {
+            return TacModulePtr();
+        }
+
+        // output() prints every value but a constant by name
+        bool isNumber = (record.flags & TacObjectValueFlags::Constant) && !(record.flags & TacObjectValueFlags::Function);
+        if (record.name == kTacObjectNone && !isNumber) {
+            fail("a value with no name");
+            return TacModulePtr();
+        }
+
+        if (record.function != kTacObjectNone) {
+            if (record.function >= functions.size()) {
+                fail("a function value for a function that does not exist");
+                return TacModulePtr();
+            }
+
+            value.reset(new FunctionTacValue(functions[record.function]));
+        } else if (isNumber) {
+            if (record.flags & TacObjectValueFlags::Real) {
+                float realValue;
+                std::memcpy(&realValue, &record.constant, sizeof(realValue));
+                value.reset(new ConstRealTacValue(realValue));
+            } else {
+                int intValue;
+                std::memcpy(&intValue, &record.constant, sizeof(intValue));
+                value.reset(new ConstIntTacValue(intValue));
+            }
+        } else {
+            value.reset(new TacValue);
+        }
+
+        value->type = valueType;
+        value->uid = record.uid;
+        value->isConstant = (record.flags & TacObjectValueFlags::Constant) != 0;
+        value->isFunction = (record.flags & TacObjectValueFlags::Function) != 0;
+        value->isTemporary = (record.flags & TacObjectValueFlags::Temporary) != 0;
+        value->isParameter = (record.flags & TacObjectValueFlags::Parameter) != 0;
+
+        if (record.name == kTacObjectTemporaryName) {
+            module->nameTemporary(value.get());
+        } else if (record.name != kTacObjectNone) {
+            IdentifierPtr id = module->arena.create<Identifier>();
+            id->id = Token(text, -1, -1);
+
+            value->id = id;
+            value->symbol = SymbolTable::instance().intern(id->id);
+        }
+
+        module->addValue(value);
+    }
+
+    const TacObjectLabel *labelRecords = table<TacObjectLabel>(m_header->labels);
+
+    for (boost::uint32_t i = 0; i < m_header->labels.count; ++i) {
+        const TacObjectLabel &record = labelRecords[i];
+
+        if (record.name == kTacObjectBlockLabelName || record.name == kTacObjectJumpLabelName) {
+            text = generatedLabelName(record.uid, record.name == kTacObjectBlockLabelName);
+        } else if (!name(record.name, text)) {
+            return TacModulePtr();
+        }
+
+        module->addLabel(text, 0, record.uid);
+    }
+
+    const boost::uint32_t *symbols = table<boost::uint32_t>(m_header->symbols);
+    const TacObjectBlock *blockRecords = table<TacObjectBlock>(m_header->blocks);
+    const TacObjectInstruction *instructions = table<TacObjectInstruction>(m_header->instructions);
+
+    for (boost::uint32_t i = 0; i < m_header->functions.count; ++i) {
+        const TacObjectFunction &record = functionRecords[i];
+        TacFunction *function = functions[i].get();
+
+        if (!checkRange(record.firstSymbol, record.symbolCount, m_header->symbols.count, "symbols")
+                || !checkRange(record.firstSymbol + record.symbolCount, record.parameterCount, m_header->symbols.count, "parameters")
+                || !checkRange(record.firstBlock, record.blockCount, m_header->blocks.count, "blocks")) {
+            return TacModulePtr();
+        }
+
+        // the entry is the first block
+        if (record.blockCount == 0) {
+            fail("a function with no code");
+            return TacModulePtr();
+        }
+
+        for (boost::uint32_t j = record.firstSymbol; j < record.firstSymbol + record.symbolCount + record.parameterCount; ++j) {
+            if (symbols[j] >= m_header->values.count) {
+                fail("a symbol that is not a value");
+                return TacModulePtr();
+            }
+        }
+
+        // temporaries are never looked up by name, as in createTemporary()
+        for (boost::uint32_t j = 0; j < record.symbolCount; ++j) {
+            TacValue *value = module->value(symbols[record.firstSymbol + j]);
+
+            if (value->isTemporary) {
+                function->symbols.push_back(value);
+            } else {
+                function->addSymbol(value);
+            }
+        }
+
+        if (record.parameterCount > 0) {
+            function->arguments = module->arena.create<Declarations>();
+        }
+
+        for (boost::uint32_t j = 0; j < record.parameterCount; ++j) {
+            TacValue *parameter = module->value(symbols[record.firstSymbol + record.symbolCount + j]);
+
+            DeclarationPtr declaration = module->arena.create<Declaration>();
+            declaration->id = parameter->id;
+            declaration->type = parameter->type;
+
+            function->parameters.push_back(parameter);
+            function->arguments->list.push_back(declaration);
+        }
+
+        for (boost::uint32_t j = record.firstBlock; j < record.firstBlock + record.blockCount; ++j) {
+            const TacObjectBlock &block = blockRecords[j];
+
+            if (block.label >= m_header->labels.count || labelRecords[block.label].block != j) {
+                fail("the block and label tables disagree");
+                return TacModulePtr();
+            }
+
+            if (!checkRange(block.firstInstruction, block.instructionCount, m_header->instructions.count, "instructions")) {
+                return TacModulePtr();
+            }
+
+            TacBasicBlockPtr basicBlock(new TacBasicBlock(module->labels[block.label].name, function, block.label));
+            basicBlock->code.reserve(block.instructionCount);
+
+            for (boost::uint32_t k = block.firstInstruction; k < block.firstInstruction + block.instructionCount; ++k) {
+                const TacObjectInstruction &instruction = instructions[k];
+
+                if (!checkInstruction(instruction)) {
+                    return TacModulePtr();
+                }
+
+                basicBlock->append((TacOpcode::Enum)instruction.opcode, instruction.operands[0], instruction.operands[1], instruction.operands[2]);
+            }
+
+            function->blocks.push_back(basicBlock);
+        }
+    }
+
+    return module;
+}
+
+TacModulePtr loadTacObject(const char *data, size_t size, std::string &error)
+{
+    // the tables are read in place, which needs them aligned
+    if (reinterpret_cast<size_t>(data) % 4 != 0) {
+        std::vector<boost::uint32_t> aligned(size / 4 + 1);
+        std::memcpy(&aligned[0], data, size);
+
+        return loadTacObject(reinterpret_cast<const char *>(&aligned[0]), size, error);
+    }
+
+    return TacObjectReader(data, size, error).load();
+}
+
+TacModulePtr loadTacObjectFile(const std::string &path, std::string &error)
+{
+    try {
+        boost::interprocess::file_mapping file(path.c_str(), boost::interprocess::read_only);
+        boost::interprocess::mapped_region region(file, boost::interprocess::read_only);
+
+        return loadTacObject(static_cast<const char *>(region.get_address()), region.get_size(), error);
+    } catch (const boost::interprocess::interprocess_exception &e) {
+        error = e.what();
+        return TacModulePtr();
+    }
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "Tac.h"
+
+#include <boost/cstdint.hpp>
+
+#include <ostream>
+#include <string>
+
+// A binary image of a TacModule that loads by indexing instead of parsing.
+// The file is a header followed by tables of fixed-width records; records
+// refer to each other by table index and to names by their offset in the
+// string table. Everything is 4-byte aligned and in the byte order of the
+// machine that wrote it, so a mapped file is read in place.
+//
+//   header        TacObjectHeader
+//   strings       NUL-terminated names, padded to 4 bytes
+//   types         TacObjectType, one per distinct declared type
+//   values        TacObjectValue, in the order the tables below first use them
+//   labels        TacObjectLabel, likewise
+//   functions     TacObjectFunction, parents before children
+//   symbols       value indices: each function's symbols, then parameters
+//   blocks        TacObjectBlock, each function's blocks in turn
+//   instructions  TacObjectInstruction, each block's code in turn
+//
+// Only the values and labels something refers to are written, equal
+// constants share a record, and names made up from a uid are not stored.
+// The loaded module therefore numbers values and labels its own way, but
+// prints the same text.
+
+static const char kTacObjectMagic[4] = { 'I', 'T', 'A', 'C' };
+static const boost::uint32_t kTacObjectVersion = 1;
+static const boost::uint32_t kTacObjectByteOrder = 0x01020304;
+static const boost::uint32_t kTacObjectNone = 0xffffffff;
+
+// names for the uid to make up: generatedTemporaryName() and
+// generatedLabelName()
+static const boost::uint32_t kTacObjectTemporaryName = 0xfffffffe;
+static const boost::uint32_t kTacObjectBlockLabelName = 0xfffffffd;
+static const boost::uint32_t kTacObjectJumpLabelName = 0xfffffffc;
+
+struct TacObjectValueFlags
+{
+    enum Enum
+    {
+        Constant = 1 << 0,
+        Real = 1 << 1,
+        Function = 1 << 2,
+        Temporary = 1 << 3,
+        Parameter = 1 << 4
+    };
+};
+
+struct TacObjectSection
+{
+    boost::uint32_t offset;
+    boost::uint32_t count;
+};
+
+struct TacObjectHeader
+{
+    char magic[4];
+    boost::uint32_t version;
+    boost::uint32_t byteOrder;
+    // TacModule::uidCount, so names made after loading stay unique
+    boost::uint32_t uidCount;
+
+    // strings counts bytes, the others records
+    TacObjectSection strings;
+    TacObjectSection types;
+    TacObjectSection values;
+    TacObjectSection labels;
+    TacObjectSection functions;
+    TacObjectSection symbols;
+    TacObjectSection blocks;
+    TacObjectSection instructions;
+};
+
+// Array bounds are not kept; nothing after codegen reads them.
+struct TacObjectType
+{
+    boost::uint32_t standardType;
+    boost::uint32_t isArray;
+};
+
+struct TacObjectValue
+{
+    // TacObjectValueFlags
+    boost::uint32_t flags;
+    // kTacObjectNone for constants
+    boost::uint32_t name;
+    boost::uint32_t type;
+    boost::uint32_t uid;
+    // the bits of an int or float constant
+    boost::uint32_t constant;
+    // the function a function value stands for, or kTacObjectNone
+    boost::uint32_t function;
+};
+
+struct TacObjectLabel
+{
+    boost::uint32_t name;
+    // the block the label names, or kTacObjectNone for a label inside a block
+    boost::uint32_t block;
+    boost::uint32_t uid;
+};
+
+struct TacObjectFunction
+{
+    boost::uint32_t name;
+    // kTacObjectNone for the program, which is always the first function
+    boost::uint32_t parent;
+    boost::uint32_t returnType;
+    boost::uint32_t firstSymbol;
+    boost::uint32_t symbolCount;
+    boost::uint32_t parameterCount;
+    boost::uint32_t firstBlock;
+    boost::uint32_t blockCount;
+};
+
+struct TacObjectBlock
+{
+    boost::uint32_t label;
+    boost::uint32_t firstInstruction;
+    boost::uint32_t instructionCount;
+};
+
+struct TacObjectInstruction
+{
+    boost::uint32_t opcode;
+    boost::int32_t operands[3];
+};
+
+// Writes the module's image. Returns false if the stream fails.
+bool writeTacObject(const TacModule &module, std::ostream &stream);
+
+// Rebuilds a module from an image in memory, checking every index against
+// the table it points into. Returns an empty pointer and sets error if the
+// image is not one this version reads.
+TacModulePtr loadTacObject(const char *data, size_t size, std::string &error);
+
+// Maps the file and loads it.
+TacModulePtr loadTacObjectFile(const std::string &path, std::string &error);
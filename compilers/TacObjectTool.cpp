@@ -0,0 +1,117 @@
+#include "TacInterpreter.h"
+#include "TacObject.h"
+#include "TacReader.h"
+
+#include <fstream>
+#include <iostream>
+#include <string>
+
+// Converts between TAC objects and the text impasse prints, and runs
+// objects on the interpreter.
+
+static int usage(const char *program)
+{
+    std::cerr << "usage: " << program << " --to-text in.tobj [out.tac]" << std::endl;
+    std::cerr << "       " << program << " --to-object in.tac out.tobj" << std::endl;
+    std::cerr << "       " << program << " --run in.tobj" << std::endl;
+    return 1;
+}
+
+static TacModulePtr loadObject(const std::string &path)
+{
+    std::string error;
+    TacModulePtr module = loadTacObjectFile(path, error);
+
+    if (!module) {
+        std::cerr << path << ": " << error << std::endl;
+    }
+
+    return module;
+}
+
+static bool toText(const std::string &in, const std::string &out)
+{
+    TacModulePtr module = loadObject(in);
+    if (!module) {
+        return false;
+    }
+
+    // as impasse prints it
+    if (out.empty()) {
+        std::cout << module->output() << std::endl;
+        return true;
+    }
+
+    std::ofstream stream(out.c_str());
+    stream << module->output() << std::endl;
+
+    if (!stream) {
+        std::cerr << "cannot write " << out << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+static bool toObject(const std::string &in, const std::string &out)
+{
+    std::ifstream text(in.c_str());
+    if (!text) {
+        std::cerr << "cannot open " << in << std::endl;
+        return false;
+    }
+
+    std::string error;
+    TacModulePtr module = readTacText(text, error);
+    if (!module) {
+        std::cerr << in << ": " << error << std::endl;
+        return false;
+    }
+
+    std::ofstream stream(out.c_str(), std::ios::binary);
+    if (!stream || !writeTacObject(*module, stream)) {
+        std::cerr << "cannot write " << out << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+static bool run(const std::string &in)
+{
+    TacModulePtr module = loadObject(in);
+    if (!module) {
+        return false;
+    }
+
+    TacInterpreter interpreter(module);
+    if (!interpreter.run(std::cout)) {
+        std::cerr << "Runtime error: " << interpreter.error() << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char const *argv[])
+{
+    if (argc < 3) {
+        return usage(argv[0]);
+    }
+
+    std::string mode = argv[1];
+
+    if (mode == "--to-text" && argc <= 4) {
+        return toText(argv[2], argc == 4 ? argv[3] : "") ? 0 : 1;
+    }
+
+    if (mode == "--to-object" && argc == 4) {
+        return toObject(argv[2], argv[3]) ? 0 : 1;
+    }
+
+    if (mode == "--run" && argc == 3) {
+        return run(argv[2]) ? 0 : 1;
+    }
+
+    return usage(argv[0]);
+}
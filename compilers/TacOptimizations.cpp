@@ -0,0 +1,2256 @@
+#include "TacOptimizations.h"
+#include "TacLiveness.h"
+#include "TacLoops.h"
+
+#include <boost/unordered_map.hpp>
+
+#include <algorithm>
+#include <climits>
+#include <iomanip>
+#include <map>
+#include <set>
+
+typedef boost::unordered_map<int, int> CountMap;
+
+static int count(const CountMap &counts, int key)
+{
+    CountMap::const_iterator i = counts.find(key);
+    return i == counts.end() ? 0 : i->second;
+}
+
+static void countUses(const TacFunction &function, CountMap &uses, CountMap &definitions)
+{
+    for (std::vector<TacBasicBlockPtr>::const_iterator i = function.blocks.begin(); i != function.blocks.end(); ++i) {
+        for (TacInstructions::const_iterator j = (*i)->code.begin(); j != (*i)->code.end(); ++j) {
+            for (int k = 0; k < j->numUses(); ++k) {
+                ++uses[j->operands[k]];
+            }
+
+            if (j->definition() != kNoOperand) {
+                ++definitions[j->definition()];
+            }
+        }
+    }
+}
+
+static void countLabelReferences(const TacFunction &function, CountMap &references)
+{
+    for (std::vector<TacBasicBlockPtr>::const_iterator i = function.blocks.begin(); i != function.blocks.end(); ++i) {
+        for (TacInstructions::const_iterator j = (*i)->code.begin(); j != (*i)->code.end(); ++j) {
+            if (j->isJump()) {
+                ++references[j->label()];
+            }
+        }
+    }
+}
+
+static bool isTemporary(const TacModule &module, int index)
+{
+    return module.value(index)->isTemporary;
+}
+
+static bool constantOf(const TacModule &module, int index, double &value, bool &isReal)
+{
+    TacValue *tacValue = module.value(index);
+
+    if (ConstIntTacValue *intValue = dynamic_cast<ConstIntTacValue *>(tacValue)) {
+        value = intValue->intValue;
+        isReal = false;
+        return true;
+    }
+
+    if (ConstRealTacValue *realValue = dynamic_cast<ConstRealTacValue *>(tacValue)) {
+        value = realValue->realValue;
+        isReal = true;
+        return true;
+    }
+
+    return false;
+}
+
+static bool isIntConstant(const TacModule &module, int index, int value)
+{
+    ConstIntTacValue *intValue = dynamic_cast<ConstIntTacValue *>(module.value(index));
+    return intValue && intValue->intValue == value;
+}
+
+TacOpcode::Enum invertBranch(TacOpcode::Enum opcode)
+{
+    switch (opcode) {
+    case TacOpcode::BranchEq:
+        return TacOpcode::BranchNe;
+    case TacOpcode::BranchGe:
+        return TacOpcode::BranchLt;
+    case TacOpcode::BranchGt:
+        return TacOpcode::BranchLe;
+    case TacOpcode::BranchLe:
+        return TacOpcode::BranchGt;
+    case TacOpcode::BranchLt:
+        return TacOpcode::BranchGe;
+    case TacOpcode::BranchNe:
+        return TacOpcode::BranchEq;
+    default:
+        return TacOpcode::Invalid;
+    }
+}
+
+static bool foldBinary(TacOpcode::Enum opcode, double lhs, double rhs, bool isReal, double &result)
+{
+    if (isReal) {
+        switch (opcode) {
+        case TacOpcode::Add:
+            result = (float)lhs + (float)rhs;
+            return true;
+        case TacOpcode::Subtract:
+            result = (float)lhs - (float)rhs;
+            return true;
+        case TacOpcode::Multiply:
+            result = (float)lhs * (float)rhs;
+            return true;
+        case TacOpcode::Divide:
+            if (rhs == 0) {
+                return false;
+            }
+            result = (float)lhs / (float)rhs;
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    long long a = (long long)lhs;
+    long long b = (long long)rhs;
+
+    switch (opcode) {
+    case TacOpcode::Add:
+        result = (int)(a + b);
+        return true;
+    case TacOpcode::Subtract:
+        result = (int)(a - b);
+        return true;
+    case TacOpcode::Multiply:
+        result = (int)(a * b);
+        return true;
+    case TacOpcode::IntegerDivide:
+        if (b == 0) {
+            return false;
+        }
+        result = (int)(a / b);
+        return true;
+    case TacOpcode::Modulus:
+        if (b == 0) {
+            return false;
+        }
+        result = (int)(a % b);
+        return true;
+    case TacOpcode::And:
+        result = (a != 0 && b != 0) ? 1 : 0;
+        return true;
+    case TacOpcode::Or:
+        result = (a != 0 || b != 0) ? 1 : 0;
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool foldBranch(TacOpcode::Enum opcode, double lhs, double rhs)
+{
+    switch (opcode) {
+    case TacOpcode::BranchEq:
+        return lhs == rhs;
+    case TacOpcode::BranchGe:
+        return lhs >= rhs;
+    case TacOpcode::BranchGt:
+        return lhs > rhs;
+    case TacOpcode::BranchLe:
+        return lhs <= rhs;
+    case TacOpcode::BranchLt:
+        return lhs < rhs;
+    case TacOpcode::BranchNe:
+        return lhs != rhs;
+    default:
+        return false;
+    }
+}
+
+bool ConstantFoldingPass::runOnFunction(TacFunction &function)
+{
+    TacModule &module = *function.module;
+    bool changed = false;
+
+    for (std::vector<TacBasicBlockPtr>::iterator i = function.blocks.begin(); i != function.blocks.end(); ++i) {
+        for (TacInstructions::iterator j = (*i)->code.begin(); j != (*i)->code.end(); ++j) {
+            double lhs, rhs;
+            bool lhsReal, rhsReal;
+
+            if (j->isBinary() || j->isBranch()) {
+                if (!constantOf(module, j->operands[0], lhs, lhsReal) || !constantOf(module, j->operands[1], rhs, rhsReal)) {
+                    continue;
+                }
+
+                if (j->isBranch()) {
+                    if (foldBranch(j->opcode, lhs, rhs)) {
+                        *j = TacInstruction(TacOpcode::Goto, j->operands[2]);
+                    } else {
+                        j->opcode = TacOpcode::Invalid;
+                    }
+
+                    changed = true;
+                    continue;
+                }
+
+                bool isReal = lhsReal || rhsReal || j->opcode == TacOpcode::Divide;
+                double result;
+                if (!foldBinary(j->opcode, lhs, rhs, isReal, result)) {
+                    continue;
+                }
+
+                int folded = isReal ? module.constant((float)result) : module.constant((int)result);
+                *j = TacInstruction(TacOpcode::Assign, folded, j->operands[2]);
+                changed = true;
+            } else if (j->opcode == TacOpcode::Negate || j->opcode == TacOpcode::Not) {
+                if (!constantOf(module, j->operands[0], lhs, lhsReal)) {
+                    continue;
+                }
+
+                int folded;
+                if (j->opcode == TacOpcode::Not) {
+                    if (lhsReal) {
+                        continue;
+                    }
+                    folded = module.constant(lhs == 0 ? 1 : 0);
+                } else {
+                    folded = lhsReal ? module.constant((float)-lhs) : module.constant((int)-lhs);
+                }
+
+                *j = TacInstruction(TacOpcode::Assign, folded, j->operands[1]);
+                changed = true;
+            }
+        }
+
+        compactBasicBlock(**i);
+    }
+
+    return changed;
+}
+
+bool BranchFusionPass::runOnFunction(TacFunction &function)
+{
+    TacModule &module = *function.module;
+    bool changed = false;
+
+    CountMap uses, definitions, references;
+    countUses(function, uses, definitions);
+    countLabelReferences(function, references);
+
+    for (std::vector<TacBasicBlockPtr>::iterator i = function.blocks.begin(); i != function.blocks.end(); ++i) {
+        TacInstructions &code = (*i)->code;
+
+        for (size_t j = 0; j + 6 < code.size(); ++j) {
+            // BRxx a b Lt; ASSIGN 0 t; GOTO Ld; Lt: ASSIGN 1 t; Ld: BRNE t 0 L
+            TacInstruction *seq = &code[j];
+            if (!seq[0].isBranch() ||
+                seq[1].opcode != TacOpcode::Assign ||
+                seq[2].opcode != TacOpcode::Goto ||
+                seq[3].opcode != TacOpcode::Label ||
+                seq[4].opcode != TacOpcode::Assign ||
+                seq[5].opcode != TacOpcode::Label ||
+                !seq[6].isBranch()) {
+                continue;
+            }
+
+            int trueLabel = seq[0].operands[2];
+            int doneLabel = seq[2].operands[0];
+            int result = seq[1].operands[1];
+
+            if (seq[3].operands[0] != trueLabel || seq[5].operands[0] != doneLabel ||
+                seq[4].operands[1] != result || !isTemporary(module, result) ||
+                !isIntConstant(module, seq[1].operands[0], 0) || !isIntConstant(module, seq[4].operands[0], 1) ||
+                count(references, trueLabel) != 1 || count(references, doneLabel) != 1 ||
+                count(uses, result) != 1) {
+                continue;
+            }
+
+            TacOpcode::Enum test = seq[6].opcode;
+            if (test != TacOpcode::BranchNe && test != TacOpcode::BranchEq) {
+                continue;
+            }
+
+            bool comparesResultToZero =
+                (seq[6].operands[0] == result && isIntConstant(module, seq[6].operands[1], 0)) ||
+                (seq[6].operands[1] == result && isIntConstant(module, seq[6].operands[0], 0));
+            if (!comparesResultToZero) {
+                continue;
+            }
+
+            seq[0].operands[2] = seq[6].operands[2];
+            if (test == TacOpcode::BranchEq) {
+                seq[0].opcode = invertBranch(seq[0].opcode);
+            }
+
+            for (int k = 1; k <= 6; ++k) {
+                seq[k].opcode = TacOpcode::Invalid;
+            }
+
+            changed = true;
+            j += 6;
+        }
+
+        compactBasicBlock(**i);
+    }
+
+    return changed;
+}
+
+static void forgetCopiesOf(CountMap &copies, int value)
+{
+    copies.erase(value);
+
+    for (CountMap::iterator i = copies.begin(); i != copies.end();) {
+        if (i->second == value) {
+            i = copies.erase(i);
+        } else {
+            ++i;
+        }
+    }
+}
+
+bool CopyPropagationPass::runOnFunction(TacFunction &function)
+{
+    TacModule &module = *function.module;
+    bool changed = false;
+
+    // forward copies into temporaries within straight-line code
+    for (std::vector<TacBasicBlockPtr>::iterator i = function.blocks.begin(); i != function.blocks.end(); ++i) {
+        CountMap copies;
+
+        for (TacInstructions::iterator j = (*i)->code.begin(); j != (*i)->code.end(); ++j) {
+            if (j->opcode == TacOpcode::Label) {
+                copies.clear();
+                continue;
+            }
+
+            for (int k = 0; k < j->numUses(); ++k) {
+                CountMap::const_iterator copy = copies.find(j->operands[k]);
+                if (copy != copies.end()) {
+                    j->operands[k] = copy->second;
+                    changed = true;
+                }
+            }
+
+            if (j->opcode == TacOpcode::Call) {
+                // the callee may write any variable that is not a temporary
+                for (CountMap::iterator k = copies.begin(); k != copies.end();) {
+                    if (!module.value(k->second)->isConstant && !isTemporary(module, k->second)) {
+                        k = copies.erase(k);
+                    } else {
+                        ++k;
+                    }
+                }
+            }
+
+            int definition = j->definition();
+            if (definition != kNoOperand) {
+                forgetCopiesOf(copies, definition);
+            }
+
+            if (j->opcode == TacOpcode::Assign && isTemporary(module, j->operands[1]) &&
+                j->operands[0] != j->operands[1]) {
+                copies[j->operands[1]] = j->operands[0];
+            }
+        }
+    }
+
+    // fold "op ... t; ASSIGN t x" into "op ... x"
+    CountMap uses, definitions;
+    countUses(function, uses, definitions);
+
+    for (std::vector<TacBasicBlockPtr>::iterator i = function.blocks.begin(); i != function.blocks.end(); ++i) {
+        TacInstructions &code = (*i)->code;
+
+        for (size_t j = 0; j + 1 < code.size(); ++j) {
+            TacInstruction &producer = code[j];
+            TacInstruction &copy = code[j + 1];
+
+            if (!(producer.isBinary() || producer.isUnary()) || copy.opcode != TacOpcode::Assign) {
+                continue;
+            }
+
+            int temporary = producer.definition();
+            if (copy.operands[0] != temporary || !isTemporary(module, temporary) ||
+                count(uses, temporary) != 1 || count(definitions, temporary) != 1) {
+                continue;
+            }
+
+            if (producer.isBinary()) {
+                producer.operands[2] = copy.operands[1];
+            } else {
+                producer.operands[1] = copy.operands[1];
+            }
+
+            copy.opcode = TacOpcode::Invalid;
+            changed = true;
+            ++j;
+        }
+
+        compactBasicBlock(**i);
+    }
+
+    return changed;
+}
+
+bool DeadTemporaryEliminationPass::runOnFunction(TacFunction &function)
+{
+    TacModule &module = *function.module;
+    bool changed = false;
+    bool removed = true;
+
+    while (removed) {
+        removed = false;
+
+        CountMap uses, definitions;
+        countUses(function, uses, definitions);
+
+        for (std::vector<TacBasicBlockPtr>::iterator i = function.blocks.begin(); i != function.blocks.end(); ++i) {
+            for (TacInstructions::iterator j = (*i)->code.begin(); j != (*i)->code.end(); ++j) {
+                if (!(j->isBinary() || j->isUnary())) {
+                    continue;
+                }
+
+                int definition = j->definition();
+                if (isTemporary(module, definition) && count(uses, definition) == 0) {
+                    j->opcode = TacOpcode::Invalid;
+                    removed = true;
+                }
+            }
+
+            compactBasicBlock(**i);
+        }
+
+        changed |= removed;
+    }
+
+    CountMap uses, definitions;
+    countUses(function, uses, definitions);
+
+    std::vector<TacValue *> unused;
+    for (std::vector<TacValue *>::iterator i = function.symbols.begin(); i != function.symbols.end(); ++i) {
+        if ((*i)->isTemporary && count(uses, (*i)->index) == 0 && count(definitions, (*i)->index) == 0) {
+            unused.push_back(*i);
+        }
+    }
+
+    for (std::vector<TacValue *>::iterator i = unused.begin(); i != unused.end(); ++i) {
+        function.removeSymbol(*i);
+        changed = true;
+    }
+
+    return changed;
+}
+
+struct CodePosition
+{
+    CodePosition(size_t b = 0, size_t i = 0) : block(b), instruction(i) {}
+
+    bool operator==(const CodePosition &other) const
+    {
+        return block == other.block && instruction == other.instruction;
+    }
+
+    size_t block;
+    size_t instruction;
+};
+
+typedef boost::unordered_map<int, CodePosition> LabelPositions;
+
+// Skips labels and removed instructions, falling through empty blocks.
+static CodePosition normalize(const TacFunction &function, CodePosition position)
+{
+    while (position.block < function.blocks.size()) {
+        const TacInstructions &code = function.blocks[position.block]->code;
+
+        if (position.instruction >= code.size()) {
+            position = CodePosition(position.block + 1, 0);
+            continue;
+        }
+
+        TacOpcode::Enum opcode = code[position.instruction].opcode;
+        if (opcode != TacOpcode::Label && opcode != TacOpcode::Invalid) {
+            return position;
+        }
+
+        ++position.instruction;
+    }
+
+    return CodePosition(function.blocks.size(), 0);
+}
+
+static void findLabels(const TacFunction &function, LabelPositions &positions)
+{
+    for (size_t i = 0; i < function.blocks.size(); ++i) {
+        const TacBasicBlock &block = *function.blocks[i];
+
+        positions[block.label] = CodePosition(i, 0);
+
+        for (size_t j = 0; j < block.code.size(); ++j) {
+            if (block.code[j].opcode == TacOpcode::Label) {
+                positions[block.code[j].operands[0]] = CodePosition(i, j + 1);
+            }
+        }
+    }
+}
+
+static const TacInstruction *instructionAt(const TacFunction &function, const CodePosition &position)
+{
+    if (position.block >= function.blocks.size()) {
+        return 0;
+    }
+
+    return &function.blocks[position.block]->code[position.instruction];
+}
+
+static int resolveLabel(const TacFunction &function, const LabelPositions &positions, int label)
+{
+    // bounded so that GOTO cycles terminate
+    for (size_t hops = 0; hops <= positions.size(); ++hops) {
+        LabelPositions::const_iterator position = positions.find(label);
+        if (position == positions.end()) {
+            break;
+        }
+
+        const TacInstruction *target = instructionAt(function, normalize(function, position->second));
+        if (!target || target->opcode != TacOpcode::Goto || target->operands[0] == label) {
+            break;
+        }
+
+        label = target->operands[0];
+    }
+
+    return label;
+}
+
+static bool threadJumps(TacFunction &function)
+{
+    bool changed = false;
+
+    LabelPositions positions;
+    findLabels(function, positions);
+
+    for (size_t i = 0; i < function.blocks.size(); ++i) {
+        TacInstructions &code = function.blocks[i]->code;
+
+        for (size_t j = 0; j < code.size(); ++j) {
+            if (!code[j].isJump()) {
+                continue;
+            }
+
+            int *label = code[j].labelOperand();
+            int resolved = resolveLabel(function, positions, *label);
+            if (resolved != *label) {
+                *label = resolved;
+                changed = true;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < function.blocks.size(); ++i) {
+        TacInstructions &code = function.blocks[i]->code;
+
+        for (size_t j = 0; j < code.size(); ++j) {
+            if (!code[j].isJump()) {
+                continue;
+            }
+
+            CodePosition target = normalize(function, positions[code[j].label()]);
+            CodePosition next = normalize(function, CodePosition(i, j + 1));
+
+            if (target == next) {
+                code[j].opcode = TacOpcode::Invalid;
+                changed = true;
+                continue;
+            }
+
+            // BRxx a b L1; GOTO L2; L1: becomes BR!xx a b L2; L1:
+            if (code[j].isBranch() && next.block == i && code[next.instruction].opcode == TacOpcode::Goto) {
+                CodePosition afterGoto = normalize(function, CodePosition(i, next.instruction + 1));
+
+                if (target == afterGoto) {
+                    code[j].opcode = invertBranch(code[j].opcode);
+                    code[j].operands[2] = code[next.instruction].operands[0];
+                    code[next.instruction].opcode = TacOpcode::Invalid;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < function.blocks.size(); ++i) {
+        compactBasicBlock(*function.blocks[i]);
+    }
+
+    return changed;
+}
+
+static bool fallsThrough(const TacBasicBlock &block)
+{
+    return block.code.empty() || !block.code.back().isTerminator();
+}
+
+static bool removeUnreachable(TacFunction &function)
+{
+    TacModule &module = *function.module;
+    bool changed = false;
+
+    CountMap references;
+    countLabelReferences(function, references);
+
+    // drop labels nobody jumps to, then the code after a GOTO or RETURN
+    // that no label leads to any more
+    for (std::vector<TacBasicBlockPtr>::iterator i = function.blocks.begin(); i != function.blocks.end(); ++i) {
+        bool dead = false;
+
+        for (TacInstructions::iterator j = (*i)->code.begin(); j != (*i)->code.end(); ++j) {
+            if (j->opcode == TacOpcode::Label && count(references, j->operands[0]) == 0) {
+                j->opcode = TacOpcode::Invalid;
+                changed = true;
+            }
+
+            if (j->opcode == TacOpcode::Label) {
+                dead = false;
+            } else if (dead && j->opcode != TacOpcode::Invalid) {
+                if (j->isJump()) {
+                    --references[j->label()];
+                }
+
+                j->opcode = TacOpcode::Invalid;
+                changed = true;
+            } else {
+                dead = j->isTerminator();
+            }
+        }
+
+        compactBasicBlock(**i);
+    }
+
+    // the first block is the function entry and always stays
+    for (size_t i = 1; i < function.blocks.size();) {
+        TacBasicBlock &block = *function.blocks[i];
+
+        bool referenced = count(references, block.label) > 0;
+        for (TacInstructions::iterator j = block.code.begin(); j != block.code.end(); ++j) {
+            if (j->opcode == TacOpcode::Label) {
+                referenced = true;
+            }
+        }
+
+        bool reachable = fallsThrough(*function.blocks[i - 1]) && !block.code.empty();
+        if (referenced || reachable) {
+            ++i;
+            continue;
+        }
+
+        for (TacInstructions::iterator j = block.code.begin(); j != block.code.end(); ++j) {
+            if (j->isJump()) {
+                --references[j->label()];
+            }
+        }
+
+        module.labels[block.label].block = 0;
+        function.blocks.erase(function.blocks.begin() + i);
+        changed = true;
+    }
+
+    return changed;
+}
+
+bool JumpThreadingPass::runOnFunction(TacFunction &function)
+{
+    bool changed = false;
+
+    for (;;) {
+        bool threaded = threadJumps(function);
+        bool removed = removeUnreachable(function);
+
+        if (!threaded && !removed) {
+            break;
+        }
+
+        changed = true;
+    }
+
+    return changed;
+}
+
+// Bodies up to this many instructions are copied into their callers, and a
+// caller stops taking them in once it has grown to the second limit.
+static const int kMaxInlinedSize = 16;
+static const int kMaxCallerSize = 512;
+
+static TacFunction *calledFunction(const TacModule &module, const TacInstruction &instruction)
+{
+    if (instruction.opcode != TacOpcode::Call) {
+        return 0;
+    }
+
+    FunctionTacValue *target = dynamic_cast<FunctionTacValue *>(module.value(instruction.operands[0]));
+    return target ? target->function.get() : 0;
+}
+
+static int functionSize(const TacFunction &function)
+{
+    int size = 0;
+
+    for (std::vector<TacBasicBlockPtr>::const_iterator i = function.blocks.begin(); i != function.blocks.end(); ++i) {
+        for (TacInstructions::const_iterator j = (*i)->code.begin(); j != (*i)->code.end(); ++j) {
+            if (j->opcode != TacOpcode::Label && j->opcode != TacOpcode::Invalid) {
+                ++size;
+            }
+        }
+    }
+
+    return size;
+}
+
+// Tarjan's strongly connected components over the call graph, without
+// recursion since call chains can be long. Components complete callees
+// first, which is the order the inliner wants. A function is recursive when
+// its component has other members or it calls itself.
+static void orderCallGraph(const std::vector<std::vector<int> > &calls, std::vector<int> &order, std::vector<bool> &recursive)
+{
+    int size = calls.size();
+    std::vector<int> number(size, -1);
+    std::vector<int> lowest(size, 0);
+    std::vector<bool> onStack(size, false);
+    std::vector<int> stack;
+    int count = 0;
+
+    recursive.assign(size, false);
+
+    for (int root = 0; root < size; ++root) {
+        if (number[root] >= 0) {
+            continue;
+        }
+
+        // the second member is the next call to follow
+        std::vector<std::pair<int, size_t> > work;
+        work.push_back(std::make_pair(root, 0));
+        number[root] = lowest[root] = count++;
+        stack.push_back(root);
+        onStack[root] = true;
+
+        while (!work.empty()) {
+            int function = work.back().first;
+
+            if (work.back().second < calls[function].size()) {
+                int callee = calls[function][work.back().second++];
+
+                if (callee == function) {
+                    recursive[function] = true;
+                }
+
+                if (number[callee] < 0) {
+                    number[callee] = lowest[callee] = count++;
+                    stack.push_back(callee);
+                    onStack[callee] = true;
+                    work.push_back(std::make_pair(callee, 0));
+                } else if (onStack[callee]) {
+                    lowest[function] = std::min(lowest[function], number[callee]);
+                }
+
+                continue;
+            }
+
+            work.pop_back();
+            if (!work.empty()) {
+                int caller = work.back().first;
+                lowest[caller] = std::min(lowest[caller], lowest[function]);
+            }
+
+            if (lowest[function] != number[function]) {
+                continue;
+            }
+
+            std::vector<int>::iterator first = stack.end();
+            do {
+                --first;
+            } while (*first != function);
+
+            bool cycle = stack.end() - first > 1;
+            for (std::vector<int>::iterator i = first; i != stack.end(); ++i) {
+                onStack[*i] = false;
+                recursive[*i] = recursive[*i] || cycle;
+                order.push_back(*i);
+            }
+
+            stack.erase(first, stack.end());
+        }
+    }
+}
+
+// Appends the callee's body to code, as it runs for a call with the given
+// arguments: its values become fresh temporaries of the caller, its labels
+// fresh labels, and a RETURN jumps past the end of the copy.
+static void copyBody(TacFunction &caller, const TacFunction &callee, const std::vector<int> &arguments,
+                     const std::vector<int> &cleared, TacInstructions &code)
+{
+    TacModule &module = *caller.module;
+
+    CountMap values;
+    for (std::vector<TacValue *>::const_iterator i = callee.symbols.begin(); i != callee.symbols.end(); ++i) {
+        if (!(*i)->isConstant && !(*i)->isFunction) {
+            values[(*i)->index] = caller.createTemporary((*i)->type)->index;
+        }
+    }
+
+    for (size_t i = 0; i < arguments.size(); ++i) {
+        code.push_back(TacInstruction(TacOpcode::Assign, arguments[i], values[callee.parameters[i]->index]));
+    }
+
+    if (!cleared.empty()) {
+        int zero = module.constant(0);
+
+        for (std::vector<int>::const_iterator i = cleared.begin(); i != cleared.end(); ++i) {
+            code.push_back(TacInstruction(TacOpcode::Assign, zero, values[*i]));
+        }
+    }
+
+    CountMap references;
+    countLabelReferences(callee, references);
+
+    CountMap labels;
+    for (CountMap::iterator i = references.begin(); i != references.end(); ++i) {
+        labels[i->first] = module.createLabel();
+    }
+
+    // a RETURN at the very end just falls through
+    const TacInstruction *last = 0;
+    for (std::vector<TacBasicBlockPtr>::const_iterator i = callee.blocks.begin(); i != callee.blocks.end(); ++i) {
+        for (TacInstructions::const_iterator j = (*i)->code.begin(); j != (*i)->code.end(); ++j) {
+            if (j->opcode != TacOpcode::Label && j->opcode != TacOpcode::Invalid) {
+                last = &*j;
+            }
+        }
+    }
+
+    int end = kNoOperand;
+
+    for (std::vector<TacBasicBlockPtr>::const_iterator i = callee.blocks.begin(); i != callee.blocks.end(); ++i) {
+        if (labels.count((*i)->label)) {
+            code.push_back(TacInstruction(TacOpcode::Label, labels[(*i)->label]));
+        }
+
+        for (TacInstructions::const_iterator j = (*i)->code.begin(); j != (*i)->code.end(); ++j) {
+            if (j->opcode == TacOpcode::Label) {
+                if (labels.count(j->operands[0])) {
+                    code.push_back(TacInstruction(TacOpcode::Label, labels[j->operands[0]]));
+                }
+                continue;
+            }
+
+            if (j->opcode == TacOpcode::Invalid || (j->opcode == TacOpcode::Return && &*j == last)) {
+                continue;
+            }
+
+            if (j->opcode == TacOpcode::Return) {
+                if (end == kNoOperand) {
+                    end = module.createLabel();
+                }
+
+                code.push_back(TacInstruction(TacOpcode::Goto, end));
+                continue;
+            }
+
+            TacInstruction copy = *j;
+            int *label = copy.isJump() ? copy.labelOperand() : 0;
+
+            for (int k = 0; k < 3; ++k) {
+                if (&copy.operands[k] == label) {
+                    *label = labels[*label];
+                    continue;
+                }
+
+                CountMap::const_iterator value = values.find(copy.operands[k]);
+                if (value != values.end()) {
+                    copy.operands[k] = value->second;
+                }
+            }
+
+            code.push_back(copy);
+        }
+    }
+
+    if (end != kNoOperand) {
+        code.push_back(TacInstruction(TacOpcode::Label, end));
+    }
+}
+
+bool InliningPass::run(TacModule &module)
+{
+    std::vector<TacFunction *> functions;
+    module.collectFunctions(functions);
+
+    boost::unordered_map<const TacFunction *, int> indices;
+    for (size_t i = 0; i < functions.size(); ++i) {
+        indices[functions[i]] = i;
+    }
+
+    std::vector<std::vector<int> > calls(functions.size());
+    for (size_t i = 0; i < functions.size(); ++i) {
+        for (std::vector<TacBasicBlockPtr>::iterator j = functions[i]->blocks.begin(); j != functions[i]->blocks.end(); ++j) {
+            for (TacInstructions::iterator k = (*j)->code.begin(); k != (*j)->code.end(); ++k) {
+                TacFunction *callee = calledFunction(module, *k);
+                if (callee) {
+                    calls[i].push_back(indices[callee]);
+                }
+            }
+        }
+    }
+
+    std::vector<int> order;
+    std::vector<bool> recursive;
+    orderCallGraph(calls, order, recursive);
+
+    m_recursive.clear();
+    m_readBeforeWritten.clear();
+    m_sites.clear();
+
+    for (size_t i = 0; i < functions.size(); ++i) {
+        if (recursive[i]) {
+            m_recursive[functions[i]] = true;
+        }
+    }
+
+    bool changed = false;
+    for (std::vector<int>::iterator i = order.begin(); i != order.end(); ++i) {
+        changed |= runOnFunction(*functions[*i]);
+    }
+
+    return changed;
+}
+
+// The callee's variables that are live on entry, which a call would find
+// cleared in the new frame.
+const std::vector<int> &InliningPass::readBeforeWritten(TacFunction &callee)
+{
+    boost::unordered_map<const TacFunction *, std::vector<int> >::iterator cached = m_readBeforeWritten.find(&callee);
+    if (cached != m_readBeforeWritten.end()) {
+        return cached->second;
+    }
+
+    std::vector<int> &values = m_readBeforeWritten[&callee];
+    TacCfg cfg(callee);
+
+    if (cfg.size() > 0) {
+        TacLiveness liveness(cfg);
+        const TacLiveness::Set &live = liveness.liveIn(0);
+
+        for (TacLiveness::Set::size_type i = live.find_first(); i != TacLiveness::Set::npos; i = live.find_next(i)) {
+            int value = liveness.value(i);
+            if (!callee.module->value(value)->isParameter) {
+                values.push_back(value);
+            }
+        }
+    }
+
+    return values;
+}
+
+bool InliningPass::runOnFunction(TacFunction &function)
+{
+    TacModule &module = *function.module;
+    int size = functionSize(function);
+    bool changed = false;
+
+    // index into m_sites of this caller's record for each callee
+    boost::unordered_map<const TacFunction *, size_t> sites;
+
+    for (std::vector<TacBasicBlockPtr>::iterator i = function.blocks.begin(); i != function.blocks.end(); ++i) {
+        TacInstructions &code = (*i)->code;
+        TacInstructions inlined;
+        bool blockChanged = false;
+
+        for (size_t j = 0; j < code.size(); ++j) {
+            TacFunction *callee = calledFunction(module, code[j]);
+
+            if (!callee || callee == &function || m_recursive.count(callee) || !callee->children.empty()) {
+                inlined.push_back(code[j]);
+                continue;
+            }
+
+            // the call's APARAMs come right before it; any more, or fewer,
+            // than the callee takes and the call is left as it is
+            size_t numArguments = 0;
+            while (numArguments < j && code[j - numArguments - 1].opcode == TacOpcode::Param) {
+                ++numArguments;
+            }
+
+            int calleeSize = functionSize(*callee);
+            if (numArguments != callee->parameters.size() || calleeSize > kMaxInlinedSize || size + calleeSize > kMaxCallerSize) {
+                inlined.push_back(code[j]);
+                continue;
+            }
+
+            std::vector<int> arguments;
+            for (size_t k = inlined.size() - numArguments; k < inlined.size(); ++k) {
+                arguments.push_back(inlined[k].operands[0]);
+            }
+            inlined.erase(inlined.end() - numArguments, inlined.end());
+
+            copyBody(function, *callee, arguments, readBeforeWritten(*callee), inlined);
+            size += calleeSize;
+            blockChanged = true;
+
+            boost::unordered_map<const TacFunction *, size_t>::iterator site = sites.find(callee);
+            if (site == sites.end()) {
+                Site record = { function.name.empty() ? "<program>" : function.name, callee->name, 0, calleeSize };
+                site = sites.insert(std::make_pair(callee, m_sites.size())).first;
+                m_sites.push_back(record);
+            }
+            ++m_sites[site->second].count;
+        }
+
+        if (blockChanged) {
+            code.swap(inlined);
+            changed = true;
+        }
+    }
+
+    return changed;
+}
+
+void InliningPass::report(std::ostream &stream) const
+{
+    stream << std::left << std::setw(28) << "inlined calls"
+           << std::right << std::setw(14) << "sites"
+           << std::setw(12) << "size" << std::endl;
+
+    int sites = 0;
+
+    for (std::vector<Site>::const_iterator i = m_sites.begin(); i != m_sites.end(); ++i) {
+        stream << std::left << std::setw(28) << (i->callee + " in " + i->caller)
+               << std::right << std::setw(14) << i->count
+               << std::setw(12) << i->instructions << std::endl;
+
+        sites += i->count;
+    }
+
+    stream << std::left << std::setw(28) << "total"
+           << std::right << std::setw(14) << sites << std::endl;
+}
+
+// Definitions of each value inside a loop, and whether the loop calls
+// anything, since a call can read or change values other functions can
+// see. Without a call, those shared values are as good as local.
+static void collectLoopDefinitions(const TacCfg &cfg, const TacLoops::Loop &loop, CountMap &definitions, bool &hasCall)
+{
+    hasCall = false;
+
+    for (std::vector<int>::const_iterator i = loop.nodes.begin(); i != loop.nodes.end(); ++i) {
+        const TacCfg::Node &node = cfg.node(*i);
+
+        for (size_t j = node.begin; j < node.end; ++j) {
+            const TacInstruction &instruction = node.block->code[j];
+
+            if (instruction.definition() != kNoOperand) {
+                ++definitions[instruction.definition()];
+            }
+
+            hasCall |= instruction.opcode == TacOpcode::Call;
+        }
+    }
+}
+
+static bool isLoopInvariant(const TacModule &module, const TacLiveness &liveness, const CountMap &definitions, bool hasCall, int value)
+{
+    if (module.value(value)->isConstant) {
+        return true;
+    }
+
+    if (count(definitions, value) > 0) {
+        return false;
+    }
+
+    int slot = liveness.slot(value);
+    if (slot >= 0 && !liveness.isShared(slot)) {
+        return true;
+    }
+
+    return !hasCall;
+}
+
+// Where code can go at the end of a node: ahead of a closing jump.
+static size_t tailPosition(const TacCfg::Node &node)
+{
+    if (node.begin < node.end) {
+        const TacInstruction &last = node.block->code[node.end - 1];
+
+        if (last.isJump() || last.opcode == TacOpcode::Return) {
+            return node.end - 1;
+        }
+    }
+
+    return node.end;
+}
+
+// Marks the loops around a changed loop, whose code it no longer matches.
+// Returns true if there are any, so the caller knows to look again.
+static bool markEnclosingLoops(const TacLoops &loops, int loop, std::vector<bool> &changed)
+{
+    bool enclosed = false;
+
+    for (int i = loops.loops()[loop].parent; i >= 0; i = loops.loops()[i].parent) {
+        changed[i] = true;
+        enclosed = true;
+    }
+
+    return enclosed;
+}
+
+// Works on every loop that nothing has changed inside of yet; sets again
+// when an enclosing loop had to be skipped.
+static bool hoistInvariants(TacFunction &function, bool &again)
+{
+    TacCfg cfg(function);
+    TacLoops loops(cfg);
+    if (loops.loops().empty()) {
+        return false;
+    }
+
+    TacLiveness liveness(cfg);
+    TacModule &module = *function.module;
+
+    std::vector<TacInstructions> heads(cfg.size());
+    std::vector<TacInstructions> tails(cfg.size());
+    std::vector<bool> changed(loops.loops().size(), false);
+    bool hoistedAny = false;
+
+    for (size_t i = 0; i < loops.loops().size(); ++i) {
+        const TacLoops::Loop &loop = loops.loops()[i];
+
+        int preheader = loops.preheader(loop);
+        if (changed[i] || preheader < 0) {
+            continue;
+        }
+
+        CountMap definitions;
+        bool hasCall;
+        collectLoopDefinitions(cfg, loop, definitions, hasCall);
+
+        std::vector<int> exiting = loops.exitingNodes(loop);
+        TacLiveness::Set liveAfter(liveness.size());
+
+        for (std::vector<int>::iterator j = exiting.begin(); j != exiting.end(); ++j) {
+            const std::vector<int> &successors = cfg.node(*j).successors;
+
+            for (std::vector<int>::const_iterator k = successors.begin(); k != successors.end(); ++k) {
+                if (!loops.contains(loop, *k)) {
+                    liveAfter |= liveness.liveIn(*k);
+                }
+            }
+        }
+
+        CountMap hoisted;
+
+        // hoisting one instruction can make the ones that read it invariant
+        bool found = true;
+        while (found) {
+            found = false;
+
+            for (std::vector<int>::const_iterator j = loop.nodes.begin(); j != loop.nodes.end(); ++j) {
+                const TacCfg::Node &node = cfg.node(*j);
+
+                for (size_t k = node.begin; k < node.end; ++k) {
+                    TacInstruction &instruction = node.block->code[k];
+
+                    if (!(instruction.isBinary() || instruction.isUnary())) {
+                        continue;
+                    }
+
+                    if (instruction.opcode == TacOpcode::Divide || instruction.opcode == TacOpcode::IntegerDivide
+                            || instruction.opcode == TacOpcode::Modulus) {
+                        continue;
+                    }
+
+                    int definition = instruction.definition();
+                    int slot = liveness.slot(definition);
+
+                    if (slot < 0 || (liveness.isShared(slot) && hasCall) || count(definitions, definition) != 1
+                            || liveness.liveIn(loop.header).test(slot)) {
+                        continue;
+                    }
+
+                    if (liveAfter.test(slot)) {
+                        bool dominatesExits = true;
+                        for (std::vector<int>::iterator l = exiting.begin(); l != exiting.end(); ++l) {
+                            dominatesExits &= cfg.dominates(*j, *l);
+                        }
+
+                        if (!dominatesExits) {
+                            continue;
+                        }
+                    }
+
+                    bool invariant = true;
+                    for (int l = 0; l < instruction.numUses(); ++l) {
+                        int operand = instruction.operands[l];
+                        invariant &= count(hoisted, operand) > 0 || isLoopInvariant(module, liveness, definitions, hasCall, operand);
+                    }
+
+                    if (invariant) {
+                        tails[preheader].push_back(instruction);
+                        hoisted[definition] = 1;
+                        instruction.opcode = TacOpcode::Invalid;
+                        found = true;
+                    }
+                }
+            }
+        }
+
+        if (!hoisted.empty()) {
+            changed[i] = true;
+            again |= markEnclosingLoops(loops, i, changed);
+            hoistedAny = true;
+        }
+    }
+
+    if (hoistedAny) {
+        cfg.insert(heads, tails);
+
+        for (std::vector<TacBasicBlockPtr>::iterator i = function.blocks.begin(); i != function.blocks.end(); ++i) {
+            compactBasicBlock(**i);
+        }
+    }
+
+    return hoistedAny;
+}
+
+// Code hoisted out of an inner loop can then leave the outer one too.
+bool LoopInvariantCodeMotionPass::runOnFunction(TacFunction &function)
+{
+    bool changed = false;
+    bool again = true;
+
+    while (again) {
+        again = false;
+        changed |= hoistInvariants(function, again);
+    }
+
+    return changed;
+}
+
+struct Insertion
+{
+    TacBasicBlock *block;
+    // the new code goes in front of this instruction
+    size_t position;
+    TacInstructions code;
+};
+
+static bool isLater(const Insertion &a, const Insertion &b)
+{
+    return a.block != b.block ? a.block < b.block : a.position > b.position;
+}
+
+// Later positions first, so the earlier ones in the same block still hold.
+static void applyInsertions(std::vector<Insertion> &insertions)
+{
+    std::stable_sort(insertions.begin(), insertions.end(), isLater);
+
+    for (std::vector<Insertion>::iterator i = insertions.begin(); i != insertions.end(); ++i) {
+        TacInstructions &code = i->block->code;
+        code.insert(code.begin() + i->position, i->code.begin(), i->code.end());
+    }
+}
+
+static int intConstant(const TacModule &module, int index, bool &found)
+{
+    ConstIntTacValue *value = dynamic_cast<ConstIntTacValue *>(module.value(index));
+
+    found = value != 0;
+    return value ? value->intValue : 0;
+}
+
+static bool reduceStrength(TacFunction &function, std::vector<char> &isReal, bool &again)
+{
+    TacCfg cfg(function);
+    TacLoops loops(cfg);
+    if (loops.loops().empty()) {
+        return false;
+    }
+
+    TacLiveness liveness(cfg);
+    TacModule &module = *function.module;
+
+    std::vector<Insertion> insertions;
+    std::vector<bool> changed(loops.loops().size(), false);
+
+    for (size_t i = 0; i < loops.loops().size(); ++i) {
+        const TacLoops::Loop &loop = loops.loops()[i];
+
+        int preheader = loops.preheader(loop);
+        if (changed[i] || preheader < 0) {
+            continue;
+        }
+
+        CountMap definitions;
+        bool hasCall;
+        collectLoopDefinitions(cfg, loop, definitions, hasCall);
+
+        // Basic induction variables: integers whose one definition in the
+        // loop is "ADD i c i" or "SUB i c i" for a constant c. Maps each to
+        // its step and the place of that definition.
+        CountMap steps;
+        boost::unordered_map<int, std::pair<TacBasicBlock *, size_t> > updates;
+
+        for (std::vector<int>::const_iterator j = loop.nodes.begin(); j != loop.nodes.end(); ++j) {
+            const TacCfg::Node &node = cfg.node(*j);
+
+            for (size_t k = node.begin; k < node.end; ++k) {
+                const TacInstruction &instruction = node.block->code[k];
+                int variable = instruction.definition();
+                int slot = liveness.slot(variable);
+
+                if ((instruction.opcode != TacOpcode::Add && instruction.opcode != TacOpcode::Subtract)
+                        || slot < 0 || (liveness.isShared(slot) && hasCall) || isReal[variable] || count(definitions, variable) != 1) {
+                    continue;
+                }
+
+                int other = kNoOperand;
+                if (instruction.operands[0] == variable) {
+                    other = instruction.operands[1];
+                } else if (instruction.opcode == TacOpcode::Add && instruction.operands[1] == variable) {
+                    other = instruction.operands[0];
+                }
+
+                bool found;
+                int step = other == kNoOperand ? 0 : intConstant(module, other, found);
+                if (other == kNoOperand || !found) {
+                    continue;
+                }
+
+                steps[variable] = instruction.opcode == TacOpcode::Add ? step : -step;
+                updates[variable] = std::make_pair(node.block, k);
+            }
+        }
+
+        if (steps.empty()) {
+            continue;
+        }
+
+        size_t inserted = insertions.size();
+        // the temporary that follows i * k, keyed by i and k
+        std::map<std::pair<int, int>, int> reduced;
+
+        for (std::vector<int>::const_iterator j = loop.nodes.begin(); j != loop.nodes.end(); ++j) {
+            const TacCfg::Node &node = cfg.node(*j);
+
+            for (size_t k = node.begin; k < node.end; ++k) {
+                TacInstruction &instruction = node.block->code[k];
+                if (instruction.opcode != TacOpcode::Multiply) {
+                    continue;
+                }
+
+                int variable = instruction.operands[0];
+                int factor = instruction.operands[1];
+                if (!steps.count(variable)) {
+                    std::swap(variable, factor);
+                }
+
+                bool found;
+                int multiplier = intConstant(module, factor, found);
+                if (!steps.count(variable) || !found) {
+                    continue;
+                }
+
+                std::pair<int, int> key(variable, multiplier);
+                std::map<std::pair<int, int>, int>::iterator existing = reduced.find(key);
+                int temporary;
+
+                if (existing != reduced.end()) {
+                    temporary = existing->second;
+                } else {
+                    temporary = function.createTemporary(TypePtr())->index;
+                    reduced[key] = temporary;
+
+                    Insertion start = { cfg.node(preheader).block, tailPosition(cfg.node(preheader)), TacInstructions() };
+                    start.code.push_back(TacInstruction(TacOpcode::Multiply, variable, factor, temporary));
+                    insertions.push_back(start);
+
+                    // step the temporary just before the variable, so the two
+                    // agree everywhere but between these instructions
+                    int delta = module.constant(steps[variable] * multiplier);
+                    Insertion step = { updates[variable].first, updates[variable].second, TacInstructions() };
+                    step.code.push_back(TacInstruction(TacOpcode::Add, temporary, delta, temporary));
+                    insertions.push_back(step);
+                }
+
+                instruction = TacInstruction(TacOpcode::Assign, temporary, instruction.operands[2]);
+            }
+        }
+
+        if (insertions.size() > inserted) {
+            changed[i] = true;
+            again |= markEnclosingLoops(loops, i, changed);
+        }
+    }
+
+    if (insertions.empty()) {
+        return false;
+    }
+
+    applyInsertions(insertions);
+
+    // the new temporaries and constants are all integers
+    isReal.resize(module.values.size(), false);
+
+    return true;
+}
+
+bool StrengthReductionPass::run(TacModule &module)
+{
+    std::vector<TacFunction *> functions;
+    module.collectFunctions(functions);
+
+    inferRealValues(module, functions, m_isReal);
+
+    return TacPass::run(module);
+}
+
+bool StrengthReductionPass::runOnFunction(TacFunction &function)
+{
+    bool changed = false;
+    bool again = true;
+
+    while (again) {
+        again = false;
+        changed |= reduceStrength(function, m_isReal, again);
+    }
+
+    return changed;
+}
+
+// The label that starts a node, or -1 if control can only fall into it.
+static int labelOf(const TacCfg::Node &node)
+{
+    if (node.begin == 0) {
+        return node.block->label;
+    }
+
+    if (node.block->code[node.begin].opcode == TacOpcode::Label) {
+        return node.block->code[node.begin].operands[0];
+    }
+
+    return -1;
+}
+
+// a copy of the header's test is only worth it while the test is short
+static const size_t kMaxRotatedTest = 8;
+
+bool LoopRotationPass::runOnFunction(TacFunction &function)
+{
+    TacCfg cfg(function);
+    TacLoops loops(cfg);
+    std::vector<Insertion> insertions;
+
+    for (std::vector<TacLoops::Loop>::const_iterator i = loops.loops().begin(); i != loops.loops().end(); ++i) {
+        const TacLoops::Loop &loop = *i;
+        const TacCfg::Node &header = cfg.node(loop.header);
+
+        if (loop.latches.size() != 1 || header.begin == header.end || header.end - header.begin > kMaxRotatedTest) {
+            continue;
+        }
+
+        const TacInstruction &test = header.block->code[header.end - 1];
+        int exit = cfg.nodeOfLabel(test.label());
+        int body = loop.header + 1;
+
+        if (!test.isBranch() || exit < 0 || loops.contains(loop, exit) || body >= cfg.size() || !loops.contains(loop, body)) {
+            continue;
+        }
+
+        int bodyLabel = labelOf(cfg.node(body));
+        if (bodyLabel < 0) {
+            continue;
+        }
+
+        int latch = loop.latches.front();
+        const TacCfg::Node &back = cfg.node(latch);
+        if (back.begin == back.end || back.block->code[back.end - 1].opcode != TacOpcode::Goto) {
+            continue;
+        }
+
+        size_t first = header.begin;
+        if (header.block->code[first].opcode == TacOpcode::Label) {
+            ++first;
+        }
+
+        bool hasCall = false;
+        TacInstructions rotated;
+        for (size_t j = first; j + 1 < header.end; ++j) {
+            rotated.push_back(header.block->code[j]);
+            hasCall |= rotated.back().opcode == TacOpcode::Call;
+        }
+
+        if (hasCall) {
+            continue;
+        }
+
+        rotated.push_back(TacInstruction(invertBranch(test.opcode), test.operands[0], test.operands[1], bodyLabel));
+        if (latch + 1 != exit) {
+            rotated.push_back(TacInstruction(TacOpcode::Goto, test.label()));
+        }
+
+        // the rotated test takes the place of the GOTO
+        Insertion insertion = { back.block, back.end - 1, rotated };
+        insertions.push_back(insertion);
+        back.block->code[back.end - 1].opcode = TacOpcode::Invalid;
+    }
+
+    if (insertions.empty()) {
+        return false;
+    }
+
+    applyInsertions(insertions);
+
+    for (std::vector<TacBasicBlockPtr>::iterator i = function.blocks.begin(); i != function.blocks.end(); ++i) {
+        compactBasicBlock(**i);
+    }
+
+    return true;
+}
+
+bool TemporaryCoalescingPass::run(TacModule &module)
+{
+    std::vector<TacFunction *> functions;
+    module.collectFunctions(functions);
+
+    inferRealValues(module, functions, m_isReal);
+    m_slots.clear();
+
+    return TacPass::run(module);
+}
+
+bool TemporaryCoalescingPass::runOnFunction(TacFunction &function)
+{
+    TacCfg cfg(function);
+    TacLiveness liveness(cfg);
+    TacModule &module = *function.module;
+
+    int size = liveness.size();
+    std::vector<std::vector<int> > interference(size);
+
+    // A temporary interferes with every other one live where it is defined,
+    // except the source of a copy into it.
+    for (std::vector<int>::const_iterator i = cfg.reversePostorder().begin(); i != cfg.reversePostorder().end(); ++i) {
+        const TacCfg::Node &node = cfg.node(*i);
+        TacLiveness::Set live = liveness.liveOut(*i);
+
+        for (size_t j = node.end; j > node.begin; --j) {
+            const TacInstruction &instruction = node.block->code[j - 1];
+            int defined = liveness.slot(instruction.definition());
+
+            if (defined >= 0 && isTemporary(module, instruction.definition())) {
+                int source = instruction.opcode == TacOpcode::Assign ? liveness.slot(instruction.operands[0]) : -1;
+
+                for (TacLiveness::Set::size_type k = live.find_first(); k != TacLiveness::Set::npos; k = live.find_next(k)) {
+                    if ((int)k != defined && (int)k != source && isTemporary(module, liveness.value(k))) {
+                        interference[defined].push_back(k);
+                        interference[k].push_back(defined);
+                    }
+                }
+            }
+
+            liveness.transfer(instruction, live);
+        }
+    }
+
+    // Temporaries in code order. One that is live on entry is read before
+    // anything writes it, so it keeps a slot of its own.
+    std::vector<int> order;
+    std::vector<bool> seen(size, false);
+    const TacLiveness::Set *entry = cfg.size() > 0 ? &liveness.liveIn(0) : 0;
+
+    for (std::vector<TacBasicBlockPtr>::iterator i = function.blocks.begin(); i != function.blocks.end(); ++i) {
+        for (TacInstructions::iterator j = (*i)->code.begin(); j != (*i)->code.end(); ++j) {
+            int operands[4];
+            int count = 0;
+            for (int k = 0; k < j->numUses(); ++k) {
+                operands[count++] = j->operands[k];
+            }
+            operands[count++] = j->definition();
+
+            for (int k = 0; k < count; ++k) {
+                int slot = liveness.slot(operands[k]);
+                if (slot >= 0 && !seen[slot] && isTemporary(module, operands[k]) && !(entry && entry->test(slot))) {
+                    seen[slot] = true;
+                    order.push_back(slot);
+                }
+            }
+        }
+    }
+
+    // the first temporary given each colour names the slot
+    std::vector<int> colours(size, -1);
+    std::vector<int> slots[2];
+    boost::unordered_map<int, int> renames;
+
+    for (std::vector<int>::iterator i = order.begin(); i != order.end(); ++i) {
+        int value = liveness.value(*i);
+        std::vector<int> &names = slots[m_isReal[value] ? 1 : 0];
+        std::vector<bool> taken(names.size(), false);
+
+        for (std::vector<int>::iterator j = interference[*i].begin(); j != interference[*i].end(); ++j) {
+            int colour = colours[*j];
+            if (colour >= 0 && m_isReal[liveness.value(*j)] == m_isReal[value]) {
+                taken[colour] = true;
+            }
+        }
+
+        int colour = std::find(taken.begin(), taken.end(), false) - taken.begin();
+        colours[*i] = colour;
+
+        if (colour == (int)names.size()) {
+            names.push_back(value);
+        } else {
+            renames[value] = names[colour];
+        }
+    }
+
+    int temporaries = 0;
+    for (std::vector<TacValue *>::iterator i = function.symbols.begin(); i != function.symbols.end(); ++i) {
+        temporaries += (*i)->isTemporary;
+    }
+
+    if (temporaries > 0) {
+        Slots record = { function.name.empty() ? "<program>" : function.name, temporaries, temporaries - (int)renames.size() };
+        m_slots.push_back(record);
+    }
+
+    if (renames.empty()) {
+        return false;
+    }
+
+    for (std::vector<TacBasicBlockPtr>::iterator i = function.blocks.begin(); i != function.blocks.end(); ++i) {
+        for (TacInstructions::iterator j = (*i)->code.begin(); j != (*i)->code.end(); ++j) {
+            int *defined = 0;
+            if (j->isBinary()) {
+                defined = &j->operands[2];
+            } else if (j->isUnary()) {
+                defined = &j->operands[1];
+            }
+
+            for (int k = 0; k < j->numUses(); ++k) {
+                CountMap::iterator rename = renames.find(j->operands[k]);
+                if (rename != renames.end()) {
+                    j->operands[k] = rename->second;
+                }
+            }
+
+            if (defined) {
+                CountMap::iterator rename = renames.find(*defined);
+                if (rename != renames.end()) {
+                    *defined = rename->second;
+                }
+            }
+
+            if (j->opcode == TacOpcode::Assign && j->operands[0] == j->operands[1]) {
+                j->opcode = TacOpcode::Invalid;
+            }
+        }
+
+        compactBasicBlock(**i);
+    }
+
+    std::vector<TacValue *> symbols;
+    for (std::vector<TacValue *>::iterator i = function.symbols.begin(); i != function.symbols.end(); ++i) {
+        if (!renames.count((*i)->index)) {
+            symbols.push_back(*i);
+        }
+    }
+    function.symbols.swap(symbols);
+
+    return true;
+}
+
+void TemporaryCoalescingPass::report(std::ostream &stream) const
+{
+    stream << std::left << std::setw(28) << "temporary slots"
+           << std::right << std::setw(14) << "before"
+           << std::setw(12) << "after" << std::endl;
+
+    int before = 0;
+    int after = 0;
+
+    for (std::vector<Slots>::const_iterator i = m_slots.begin(); i != m_slots.end(); ++i) {
+        stream << std::left << std::setw(28) << i->function
+               << std::right << std::setw(14) << i->temporaries
+               << std::setw(12) << i->slots << std::endl;
+
+        before += i->temporaries;
+        after += i->slots;
+    }
+
+    stream << std::left << std::setw(28) << "total"
+           << std::right << std::setw(14) << before
+           << std::setw(12) << after << std::endl;
+}
+
+// An interval of int values; the ends are kept wider than int so that
+// arithmetic on them cannot overflow before it is checked.
+struct Range
+{
+    long long lo;
+    long long hi;
+};
+
+typedef std::vector<Range> Ranges;
+
+static Range makeRange(long long lo, long long hi)
+{
+    // a result that may wrap around could be anything
+    if (lo < INT_MIN || hi > INT_MAX) {
+        lo = INT_MIN;
+        hi = INT_MAX;
+    }
+
+    Range range = { lo, hi };
+    return range;
+}
+
+static Range anyInt()
+{
+    return makeRange(INT_MIN, INT_MAX);
+}
+
+static Range hull(const Range &a, const Range &b)
+{
+    return makeRange(std::min(a.lo, b.lo), std::max(a.hi, b.hi));
+}
+
+static bool operator==(const Range &a, const Range &b)
+{
+    return a.lo == b.lo && a.hi == b.hi;
+}
+
+// The ranges of one function. Its own variables, parameters and
+// temporaries are tracked; constants have their value and everything else
+// may be anything.
+class RangeAnalysis
+{
+public:
+    RangeAnalysis(const TacCfg &cfg, const std::vector<char> &isReal,
+                  const boost::unordered_map<const TacFunction *, std::vector<int> > &modified);
+
+    void run();
+
+    bool isReached(int node) const { return m_reached[node]; }
+    const Ranges &in(int node) const { return m_in[node]; }
+
+    // Steps ranges over one instruction. True for a CHECK the ranges before
+    // it already satisfy.
+    bool transfer(const TacInstruction &instruction, Ranges &ranges) const;
+
+private:
+    Range rangeOf(const Ranges &ranges, int value) const;
+    void set(Ranges &ranges, int value, const Range &range) const;
+    bool isReal(int value) const { return (*m_isReal)[value]; }
+
+    bool refine(TacOpcode::Enum opcode, int lhs, int rhs, Ranges &ranges) const;
+    bool edge(int node, int successor, Ranges &ranges) const;
+    bool sweep(bool widen);
+
+    const TacCfg *m_cfg;
+    const TacModule *m_module;
+    const std::vector<char> *m_isReal;
+    const boost::unordered_map<const TacFunction *, std::vector<int> > *m_modified;
+
+    boost::unordered_map<int, int> m_slots;
+    std::vector<char> m_isHeader;
+    std::vector<int> m_updates;
+    std::vector<char> m_reached;
+    std::vector<Ranges> m_in;
+    std::vector<Ranges> m_out;
+};
+
+RangeAnalysis::RangeAnalysis(const TacCfg &cfg, const std::vector<char> &isReal,
+                             const boost::unordered_map<const TacFunction *, std::vector<int> > &modified)
+    : m_cfg(&cfg)
+    , m_module(cfg.function().module)
+    , m_isReal(&isReal)
+    , m_modified(&modified)
+{
+    const TacFunction &function = cfg.function();
+
+    for (std::vector<TacValue *>::const_iterator i = function.symbols.begin(); i != function.symbols.end(); ++i) {
+        if (!(*i)->isConstant && !(*i)->isFunction) {
+            int slot = m_slots.size();
+            m_slots[(*i)->index] = slot;
+        }
+    }
+
+    TacLoops loops(cfg);
+    m_isHeader.assign(cfg.size(), false);
+    for (std::vector<TacLoops::Loop>::const_iterator i = loops.loops().begin(); i != loops.loops().end(); ++i) {
+        m_isHeader[i->header] = true;
+    }
+
+    m_updates.assign(cfg.size(), 0);
+    m_reached.assign(cfg.size(), false);
+    m_in.assign(cfg.size(), Ranges());
+    m_out.assign(cfg.size(), Ranges());
+}
+
+Range RangeAnalysis::rangeOf(const Ranges &ranges, int value) const
+{
+    if (ConstIntTacValue *constant = dynamic_cast<ConstIntTacValue *>(m_module->value(value))) {
+        return makeRange(constant->intValue, constant->intValue);
+    }
+
+    boost::unordered_map<int, int>::const_iterator slot = m_slots.find(value);
+    if (slot == m_slots.end() || isReal(value)) {
+        return anyInt();
+    }
+
+    return ranges[slot->second];
+}
+
+void RangeAnalysis::set(Ranges &ranges, int value, const Range &range) const
+{
+    boost::unordered_map<int, int>::const_iterator slot = m_slots.find(value);
+    if (slot != m_slots.end()) {
+        ranges[slot->second] = range;
+    }
+}
+
+bool RangeAnalysis::transfer(const TacInstruction &instruction, Ranges &ranges) const
+{
+    const int *operands = instruction.operands;
+
+    if (instruction.isBinary() || instruction.isUnary()) {
+        int definition = instruction.definition();
+        bool real = isReal(definition) || isReal(operands[0]) || (instruction.isBinary() && isReal(operands[1]));
+
+        Range x = rangeOf(ranges, operands[0]);
+        Range y = instruction.isBinary() ? rangeOf(ranges, operands[1]) : x;
+        Range result = anyInt();
+
+        switch (instruction.opcode) {
+        case TacOpcode::Add:
+            result = makeRange(x.lo + y.lo, x.hi + y.hi);
+            break;
+
+        case TacOpcode::Subtract:
+            result = makeRange(x.lo - y.hi, x.hi - y.lo);
+            break;
+
+        case TacOpcode::Multiply: {
+            long long corners[4] = { x.lo * y.lo, x.lo * y.hi, x.hi * y.lo, x.hi * y.hi };
+            result = makeRange(*std::min_element(corners, corners + 4), *std::max_element(corners, corners + 4));
+            break;
+        }
+
+        case TacOpcode::IntegerDivide:
+            // division truncates, which is monotone for a positive divisor
+            if (y.lo > 0) {
+                long long corners[4] = { x.lo / y.lo, x.lo / y.hi, x.hi / y.lo, x.hi / y.hi };
+                result = makeRange(*std::min_element(corners, corners + 4), *std::max_element(corners, corners + 4));
+            }
+            break;
+
+        case TacOpcode::Modulus:
+            // the remainder takes the sign of the dividend
+            if (y.lo > 0) {
+                long long bound = y.hi - 1;
+                result = makeRange(x.lo >= 0 ? 0 : std::max(x.lo, -bound), x.hi <= 0 ? 0 : std::min(x.hi, bound));
+            }
+            break;
+
+        case TacOpcode::And:
+        case TacOpcode::Or:
+        case TacOpcode::Not:
+            result = makeRange(0, 1);
+            real = false;
+            break;
+
+        case TacOpcode::Assign:
+            result = x;
+            break;
+
+        case TacOpcode::Negate:
+            result = makeRange(-x.hi, -x.lo);
+            break;
+
+        default:
+            break;
+        }
+
+        set(ranges, definition, real ? anyInt() : result);
+        return false;
+    }
+
+    if (instruction.opcode == TacOpcode::Call) {
+        set(ranges, operands[0], anyInt());
+
+        if (FunctionTacValue *callee = dynamic_cast<FunctionTacValue *>(m_module->value(operands[0]))) {
+            boost::unordered_map<const TacFunction *, std::vector<int> >::const_iterator modified = m_modified->find(callee->function.get());
+
+            if (modified != m_modified->end()) {
+                for (std::vector<int>::const_iterator i = modified->second.begin(); i != modified->second.end(); ++i) {
+                    set(ranges, *i, anyInt());
+                }
+            }
+        }
+        return false;
+    }
+
+    if (instruction.opcode == TacOpcode::Check && !isReal(operands[0])) {
+        Range x = rangeOf(ranges, operands[0]);
+        Range lo = rangeOf(ranges, operands[1]);
+        Range hi = rangeOf(ranges, operands[2]);
+
+        if (x.lo >= lo.hi && x.hi <= hi.lo) {
+            return true;
+        }
+
+        // past the check the index is in bounds, unless it never is
+        Range checked = makeRange(std::max(x.lo, lo.lo), std::min(x.hi, hi.hi));
+        if (checked.lo <= checked.hi) {
+            set(ranges, operands[0], checked);
+        }
+    }
+
+    return false;
+}
+
+// Narrows the operands of a comparison to where "lhs opcode rhs" holds;
+// false if it never does.
+bool RangeAnalysis::refine(TacOpcode::Enum opcode, int lhs, int rhs, Ranges &ranges) const
+{
+    if (isReal(lhs) || isReal(rhs)) {
+        return true;
+    }
+
+    Range x = rangeOf(ranges, lhs);
+    Range y = rangeOf(ranges, rhs);
+    Range a = x;
+    Range b = y;
+
+    switch (opcode) {
+    case TacOpcode::BranchLt:
+        a.hi = std::min(x.hi, y.hi - 1);
+        b.lo = std::max(y.lo, x.lo + 1);
+        break;
+
+    case TacOpcode::BranchLe:
+        a.hi = std::min(x.hi, y.hi);
+        b.lo = std::max(y.lo, x.lo);
+        break;
+
+    case TacOpcode::BranchGt:
+        a.lo = std::max(x.lo, y.lo + 1);
+        b.hi = std::min(y.hi, x.hi - 1);
+        break;
+
+    case TacOpcode::BranchGe:
+        a.lo = std::max(x.lo, y.lo);
+        b.hi = std::min(y.hi, x.hi);
+        break;
+
+    case TacOpcode::BranchEq:
+        a.lo = b.lo = std::max(x.lo, y.lo);
+        a.hi = b.hi = std::min(x.hi, y.hi);
+        break;
+
+    case TacOpcode::BranchNe:
+        // only an end that equals the other side's one value can go
+        if (y.lo == y.hi) {
+            a.lo += x.lo == y.lo;
+            a.hi -= x.hi == y.lo;
+        }
+        if (x.lo == x.hi) {
+            b.lo += y.lo == x.lo;
+            b.hi -= y.hi == x.lo;
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    if (a.lo > a.hi || b.lo > b.hi) {
+        return false;
+    }
+
+    set(ranges, lhs, a);
+    set(ranges, rhs, b);
+    return true;
+}
+
+// Steps the ranges at the end of node along its edge to successor; false
+// if the branch there never takes that edge.
+bool RangeAnalysis::edge(int node, int successor, Ranges &ranges) const
+{
+    const TacCfg::Node &from = m_cfg->node(node);
+    if (from.end == from.begin || from.successors.size() < 2) {
+        return true;
+    }
+
+    const TacInstruction &last = from.block->code[from.end - 1];
+    if (!last.isBranch()) {
+        return true;
+    }
+
+    bool taken = m_cfg->nodeOfLabel(last.label()) == successor;
+    return refine(taken ? last.opcode : invertBranch(last.opcode), last.operands[0], last.operands[1], ranges);
+}
+
+// One pass over the nodes in reverse postorder, each taking the join of
+// what its predecessors hand on; back edges bring the last pass's ranges.
+// While widening, the solution only grows, and the ends still moving at a
+// loop header go to the ends of int so that it stops growing. Sweeps
+// without widening that start from such a solution can only narrow it.
+bool RangeAnalysis::sweep(bool widen)
+{
+    const std::vector<int> &order = m_cfg->reversePostorder();
+    bool changed = false;
+
+    for (std::vector<int>::const_iterator i = order.begin(); i != order.end(); ++i) {
+        int node = *i;
+        bool reached = i == order.begin();
+        Ranges in(m_slots.size(), anyInt());
+
+        const std::vector<int> &predecessors = m_cfg->node(node).predecessors;
+        for (std::vector<int>::const_iterator j = predecessors.begin(); j != predecessors.end() && node != order.front(); ++j) {
+            if (!m_reached[*j]) {
+                continue;
+            }
+
+            Ranges ranges = m_out[*j];
+            if (!edge(*j, node, ranges)) {
+                continue;
+            }
+
+            if (!reached) {
+                in = ranges;
+                reached = true;
+            } else {
+                for (size_t k = 0; k < in.size(); ++k) {
+                    in[k] = hull(in[k], ranges[k]);
+                }
+            }
+        }
+
+        if (widen && m_reached[node] && reached) {
+            // headers after a few rounds; any node after many, in case the
+            // graph has a cycle without one
+            bool widening = ++m_updates[node] > (m_isHeader[node] ? 2 : 16);
+
+            for (size_t k = 0; k < in.size(); ++k) {
+                const Range &old = m_in[node][k];
+
+                if (in[k].lo < old.lo) {
+                    in[k].lo = widening ? INT_MIN : in[k].lo;
+                }
+                if (in[k].hi > old.hi) {
+                    in[k].hi = widening ? INT_MAX : in[k].hi;
+                }
+                in[k] = hull(in[k], old);
+            }
+        }
+
+        if (reached == (bool)m_reached[node] && (!reached || in == m_in[node])) {
+            continue;
+        }
+
+        changed = true;
+        m_reached[node] = reached;
+        m_in[node] = in;
+        m_out[node] = in;
+
+        if (reached) {
+            const TacCfg::Node &current = m_cfg->node(node);
+            for (size_t j = current.begin; j < current.end; ++j) {
+                transfer(current.block->code[j], m_out[node]);
+            }
+        }
+    }
+
+    return changed;
+}
+
+void RangeAnalysis::run()
+{
+    if (m_cfg->reversePostorder().empty()) {
+        return;
+    }
+
+    while (sweep(true)) {
+    }
+
+    for (int i = 0; i < 2 && sweep(false); ++i) {
+    }
+}
+
+bool BoundsCheckEliminationPass::run(TacModule &module)
+{
+    std::vector<TacFunction *> functions;
+    module.collectFunctions(functions);
+
+    inferRealValues(module, functions, m_isReal);
+    m_checks.clear();
+    m_modified.clear();
+
+    boost::unordered_map<int, const TacFunction *> owners;
+    for (std::vector<TacFunction *>::iterator i = functions.begin(); i != functions.end(); ++i) {
+        for (std::vector<TacValue *>::iterator j = (*i)->symbols.begin(); j != (*i)->symbols.end(); ++j) {
+            owners[(*j)->index] = *i;
+        }
+    }
+
+    // what each function writes of other functions, then what the ones it
+    // calls write, until nothing more turns up
+    std::vector<std::set<int> > modified(functions.size());
+    std::vector<std::vector<int> > callees(functions.size());
+    boost::unordered_map<const TacFunction *, int> indices;
+
+    for (size_t i = 0; i < functions.size(); ++i) {
+        indices[functions[i]] = i;
+    }
+
+    for (size_t i = 0; i < functions.size(); ++i) {
+        for (std::vector<TacBasicBlockPtr>::iterator j = functions[i]->blocks.begin(); j != functions[i]->blocks.end(); ++j) {
+            for (TacInstructions::iterator k = (*j)->code.begin(); k != (*j)->code.end(); ++k) {
+                int definition = k->definition();
+
+                if (definition != kNoOperand && owners.count(definition) && owners[definition] != functions[i]) {
+                    modified[i].insert(definition);
+                }
+
+                if (k->opcode == TacOpcode::Call) {
+                    if (FunctionTacValue *callee = dynamic_cast<FunctionTacValue *>(module.value(k->operands[0]))) {
+                        callees[i].push_back(indices[callee->function.get()]);
+                    }
+                }
+            }
+        }
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+
+        for (size_t i = 0; i < functions.size(); ++i) {
+            for (std::vector<int>::iterator j = callees[i].begin(); j != callees[i].end(); ++j) {
+                for (std::set<int>::iterator k = modified[*j].begin(); k != modified[*j].end(); ++k) {
+                    // a call gets a frame of its own, so the caller's
+                    // variables only change if a nested function writes them
+                    if (owners[*k] != functions[i] && modified[i].insert(*k).second) {
+                        changed = true;
+                    }
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < functions.size(); ++i) {
+        m_modified[functions[i]].assign(modified[i].begin(), modified[i].end());
+    }
+
+    return TacPass::run(module);
+}
+
+bool BoundsCheckEliminationPass::runOnFunction(TacFunction &function)
+{
+    int before = 0;
+    for (std::vector<TacBasicBlockPtr>::iterator i = function.blocks.begin(); i != function.blocks.end(); ++i) {
+        for (TacInstructions::iterator j = (*i)->code.begin(); j != (*i)->code.end(); ++j) {
+            before += j->opcode == TacOpcode::Check;
+        }
+    }
+
+    if (before == 0) {
+        return false;
+    }
+
+    TacCfg cfg(function);
+    RangeAnalysis ranges(cfg, m_isReal, m_modified);
+    ranges.run();
+
+    int removed = 0;
+
+    for (int i = 0; i < cfg.size(); ++i) {
+        if (!ranges.isReached(i)) {
+            continue;
+        }
+
+        const TacCfg::Node &node = cfg.node(i);
+        Ranges current = ranges.in(i);
+
+        for (size_t j = node.begin; j < node.end; ++j) {
+            TacInstruction &instruction = node.block->code[j];
+
+            if (ranges.transfer(instruction, current)) {
+                instruction.opcode = TacOpcode::Invalid;
+                ++removed;
+            }
+        }
+    }
+
+    Checks record = { function.name.empty() ? "<program>" : function.name, before, before - removed };
+    m_checks.push_back(record);
+
+    if (removed == 0) {
+        return false;
+    }
+
+    for (std::vector<TacBasicBlockPtr>::iterator i = function.blocks.begin(); i != function.blocks.end(); ++i) {
+        compactBasicBlock(**i);
+    }
+
+    return true;
+}
+
+void BoundsCheckEliminationPass::report(std::ostream &stream) const
+{
+    stream << std::left << std::setw(28) << "bounds checks"
+           << std::right << std::setw(14) << "before"
+           << std::setw(12) << "after" << std::endl;
+
+    int before = 0;
+    int after = 0;
+
+    for (std::vector<Checks>::const_iterator i = m_checks.begin(); i != m_checks.end(); ++i) {
+        stream << std::left << std::setw(28) << i->function
+               << std::right << std::setw(14) << i->before
+               << std::setw(12) << i->after << std::endl;
+
+        before += i->before;
+        after += i->after;
+    }
+
+    stream << std::left << std::setw(28) << "total"
+           << std::right << std::setw(14) << before
+           << std::setw(12) << after << std::endl;
+}
+
+void addO1Passes(TacPassManager &manager)
+{
+    manager.add(TacPassPtr(new ConstantFoldingPass));
+    manager.add(TacPassPtr(new BranchFusionPass));
+    manager.add(TacPassPtr(new CopyPropagationPass));
+    manager.add(TacPassPtr(new DeadTemporaryEliminationPass));
+    manager.add(TacPassPtr(new JumpThreadingPass));
+    manager.add(TacPassPtr(new InliningPass));
+    manager.add(TacPassPtr(new CopyPropagationPass));
+    manager.add(TacPassPtr(new ConstantFoldingPass));
+    manager.add(TacPassPtr(new DeadTemporaryEliminationPass));
+    manager.add(TacPassPtr(new JumpThreadingPass));
+    manager.add(TacPassPtr(new BoundsCheckEliminationPass));
+    manager.add(TacPassPtr(new LoopInvariantCodeMotionPass));
+    manager.add(TacPassPtr(new StrengthReductionPass));
+    manager.add(TacPassPtr(new LoopRotationPass));
+    manager.add(TacPassPtr(new CopyPropagationPass));
+    manager.add(TacPassPtr(new DeadTemporaryEliminationPass));
+    manager.add(TacPassPtr(new TemporaryCoalescingPass));
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include "TacPass.h"
+
+// Folds arithmetic and branches whose operands are all constants.
+class ConstantFoldingPass : public TacPass
+{
+public:
+    virtual const char *name() const { return "constant-folding"; }
+    virtual bool runOnFunction(TacFunction &function);
+};
+
+// Rewrites the compare-into-temporary sequence emitted for relational
+// operators into a single conditional branch when the temporary only feeds
+// the branch that follows it.
+class BranchFusionPass : public TacPass
+{
+public:
+    virtual const char *name() const { return "branch-fusion"; }
+    virtual bool runOnFunction(TacFunction &function);
+};
+
+// Forwards copies into temporaries to their uses and folds
+// "op ... t; ASSIGN t x" into "op ... x" for single-use temporaries.
+class CopyPropagationPass : public TacPass
+{
+public:
+    virtual const char *name() const { return "copy-propagation"; }
+    virtual bool runOnFunction(TacFunction &function);
+};
+
+// Removes instructions that only define unused temporaries and drops the
+// temporaries from the function's VAR list.
+class DeadTemporaryEliminationPass : public TacPass
+{
+public:
+    virtual const char *name() const { return "dead-temporary-elimination"; }
+    virtual bool runOnFunction(TacFunction &function);
+};
+
+// Retargets jumps to GOTOs, removes jumps to the next instruction and
+// deletes blocks that can no longer be reached.
+class JumpThreadingPass : public TacPass
+{
+public:
+    virtual const char *name() const { return "jump-threading"; }
+    virtual bool runOnFunction(TacFunction &function);
+};
+
+// Replaces calls to small functions with a copy of their body. Callees are
+// handled before their callers, so a caller inlines the already inlined
+// body; functions on a call cycle and functions with nested functions of
+// their own are never inlined. Parameters and variables of the callee become
+// temporaries of the caller, and the ones read before they are written are
+// cleared, as a fresh frame would be.
+class InliningPass : public TacPass
+{
+public:
+    virtual const char *name() const { return "inlining"; }
+    virtual bool run(TacModule &module);
+    virtual bool runOnFunction(TacFunction &function);
+
+    // inlined call sites, per caller and callee
+    virtual void report(std::ostream &stream) const;
+
+private:
+    struct Site
+    {
+        std::string caller;
+        std::string callee;
+        int count;
+        int instructions;
+    };
+
+    const std::vector<int> &readBeforeWritten(TacFunction &callee);
+
+    // functions on a call cycle
+    boost::unordered_map<const TacFunction *, bool> m_recursive;
+    // per callee, the values its body reads before writing them
+    boost::unordered_map<const TacFunction *, std::vector<int> > m_readBeforeWritten;
+    std::vector<Site> m_sites;
+};
+
+// Moves computations whose operands do not change inside a loop to the end
+// of the loop's preheader. Only values the loop defines once, that are not
+// read before that definition, and that are dead after the loop (or defined
+// on every way out) are moved; divisions stay, since they can trap.
+class LoopInvariantCodeMotionPass : public TacPass
+{
+public:
+    virtual const char *name() const { return "loop-invariant-code-motion"; }
+    virtual bool runOnFunction(TacFunction &function);
+};
+
+// Replaces "MULT i k t", for an integer induction variable i stepped by a
+// constant and a constant k, with a copy from a temporary that starts at
+// i * k in the preheader and moves by step * k next to each step of i.
+// This is the multiply that indexing by a loop counter turns into.
+class StrengthReductionPass : public TacPass
+{
+public:
+    virtual const char *name() const { return "strength-reduction"; }
+    virtual bool run(TacModule &module);
+    virtual bool runOnFunction(TacFunction &function);
+
+private:
+    std::vector<char> m_isReal;
+};
+
+// Turns a loop that tests at the top and jumps back with a GOTO into one
+// that tests at the bottom: the latch gets a copy of the header's test,
+// inverted, and the header is left as a guard run once on the way in.
+class LoopRotationPass : public TacPass
+{
+public:
+    virtual const char *name() const { return "loop-rotation"; }
+    virtual bool runOnFunction(TacFunction &function);
+};
+
+// Packs each function's temporaries into as few slots as their live ranges
+// allow, by greedy colouring of the interference graph in code order. A
+// slot only holds temporaries of one type, since the x86 backend gives every
+// value a single type.
+class TemporaryCoalescingPass : public TacPass
+{
+public:
+    virtual const char *name() const { return "temporary-coalescing"; }
+    virtual bool run(TacModule &module);
+    virtual bool runOnFunction(TacFunction &function);
+
+    // temporaries before and slots after, per function
+    virtual void report(std::ostream &stream) const;
+
+private:
+    struct Slots
+    {
+        std::string function;
+        int temporaries;
+        int slots;
+    };
+
+    std::vector<char> m_isReal;
+    std::vector<Slots> m_slots;
+};
+
+// Removes CHECKs whose index is known to be in bounds. A forward range
+// analysis gives each integer variable and temporary of the function an
+// interval on entry to every node, narrowed along the branches that lead
+// there and by the checks already passed. Loop headers are widened so the
+// analysis ends, then narrowed again. A call forgets the values the callee
+// or anything it calls may write.
+class BoundsCheckEliminationPass : public TacPass
+{
+public:
+    virtual const char *name() const { return "bounds-check-elimination"; }
+    virtual bool run(TacModule &module);
+    virtual bool runOnFunction(TacFunction &function);
+
+    // checks before and after, per function
+    virtual void report(std::ostream &stream) const;
+
+private:
+    struct Checks
+    {
+        std::string function;
+        int before;
+        int after;
+    };
+
+    std::vector<char> m_isReal;
+    // per function, the values of other functions it may write, itself or
+    // through the functions it calls
+    boost::unordered_map<const TacFunction *, std::vector<int> > m_modified;
+    std::vector<Checks> m_checks;
+};
+
+TacOpcode::Enum invertBranch(TacOpcode::Enum opcode);
+
+void addO1Passes(TacPassManager &manager);
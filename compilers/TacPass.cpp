@@ -0,0 +1,111 @@
+#include "TacPass.h"
+#include "CompileReport.h"
+
+#include <algorithm>
+#include <iomanip>
+
+bool TacPass::run(TacModule &module)
+{
+    std::vector<TacFunction *> functions;
+    module.collectFunctions(functions);
+
+    bool changed = false;
+    for (std::vector<TacFunction *>::iterator i = functions.begin(); i != functions.end(); ++i) {
+        changed |= runOnFunction(**i);
+    }
+
+    return changed;
+}
+
+void TacPassManager::add(TacPassPtr pass)
+{
+    m_passes.push_back(pass);
+}
+
+void TacPassManager::run(TacModule &module)
+{
+    m_results.clear();
+    record("codegen", module);
+
+    for (std::vector<TacPassPtr>::iterator i = m_passes.begin(); i != m_passes.end(); ++i) {
+        {
+            ScopedPhase phase(m_report, std::string("pass ") + (*i)->name());
+            (*i)->run(module);
+        }
+
+        record((*i)->name(), module);
+    }
+}
+
+void TacPassManager::report(std::ostream &stream) const
+{
+    stream << std::left << std::setw(28) << "pass"
+           << std::right << std::setw(14) << "instructions"
+           << std::setw(12) << "variables" << std::endl;
+
+    for (std::vector<TacPassResult>::const_iterator i = m_results.begin(); i != m_results.end(); ++i) {
+        stream << std::left << std::setw(28) << i->name
+               << std::right << std::setw(14) << i->instructions
+               << std::setw(12) << i->variables << std::endl;
+    }
+
+    for (std::vector<TacPassPtr>::const_iterator i = m_passes.begin(); i != m_passes.end(); ++i) {
+        (*i)->report(stream);
+    }
+}
+
+int TacPassManager::countInstructions(const TacModule &module)
+{
+    std::vector<TacFunction *> functions;
+    module.collectFunctions(functions);
+
+    int count = 0;
+    for (std::vector<TacFunction *>::iterator i = functions.begin(); i != functions.end(); ++i) {
+        for (std::vector<TacBasicBlockPtr>::iterator j = (*i)->blocks.begin(); j != (*i)->blocks.end(); ++j) {
+            for (TacInstructions::iterator k = (*j)->code.begin(); k != (*j)->code.end(); ++k) {
+                if (k->opcode != TacOpcode::Label) {
+                    ++count;
+                }
+            }
+        }
+    }
+
+    return count;
+}
+
+int TacPassManager::countVariables(const TacModule &module)
+{
+    std::vector<TacFunction *> functions;
+    module.collectFunctions(functions);
+
+    int count = 0;
+    for (std::vector<TacFunction *>::iterator i = functions.begin(); i != functions.end(); ++i) {
+        for (std::vector<TacValue *>::iterator j = (*i)->symbols.begin(); j != (*i)->symbols.end(); ++j) {
+            if (!(*j)->isConstant && !(*j)->isFunction && !(*j)->isParameter) {
+                ++count;
+            }
+        }
+    }
+
+    return count;
+}
+
+void TacPassManager::record(const std::string &name, const TacModule &module)
+{
+    TacPassResult result;
+    result.name = name;
+    result.instructions = countInstructions(module);
+    result.variables = countVariables(module);
+
+    m_results.push_back(result);
+}
+
+static bool isInvalid(const TacInstruction &instruction)
+{
+    return instruction.opcode == TacOpcode::Invalid;
+}
+
+void compactBasicBlock(TacBasicBlock &block)
+{
+    block.code.erase(std::remove_if(block.code.begin(), block.code.end(), isInvalid), block.code.end());
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Tac.h"
+
+class CompileReport;
+
+#include <boost/shared_ptr.hpp>
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+class TacPass
+{
+public:
+    virtual ~TacPass() {}
+
+    virtual const char *name() const = 0;
+
+    // Runs the pass over a single function. Returns true if the code changed.
+    virtual bool runOnFunction(TacFunction &function) = 0;
+
+    // Runs the pass over every function in the module.
+    virtual bool run(TacModule &module);
+
+    // Prints anything the pass recorded beyond the pass manager's counts.
+    virtual void report(std::ostream & /*stream*/) const {}
+};
+
+typedef boost::shared_ptr<TacPass> TacPassPtr;
+
+struct TacPassResult
+{
+    std::string name;
+    int instructions;
+    int variables;
+};
+
+class TacPassManager
+{
+public:
+    TacPassManager() : m_report(0) {}
+
+    void add(TacPassPtr pass);
+    // times each pass as a phase of report
+    void setReport(CompileReport *report) { m_report = report; }
+    void run(TacModule &module);
+
+    // Prints the instruction and variable counts recorded after each pass,
+    // then each pass's own report.
+    void report(std::ostream &stream) const;
+
+    static int countInstructions(const TacModule &module);
+    static int countVariables(const TacModule &module);
+
+private:
+    void record(const std::string &name, const TacModule &module);
+
+    std::vector<TacPassPtr> m_passes;
+    std::vector<TacPassResult> m_results;
+    CompileReport *m_report;
+};
+
+// Removes instructions that passes have marked TacOpcode::Invalid.
+void compactBasicBlock(TacBasicBlock &block);
@@ -0,0 +1,554 @@
+#include "TacReader.h"
+#include "SymbolTable.h"
+
+#include <boost/unordered_map.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <sstream>
+#include <vector>
+
+// The uid a name was made up from, or 0 if it is not a made-up name.
+static int generatedUid(const std::string &name, bool isTemporary)
+{
+    std::string::size_type digits = name.find_last_not_of("0123456789") + 1;
+    if (digits == 0 || digits == name.size()) {
+        return 0;
+    }
+
+    int uid = std::atoi(name.c_str() + digits);
+
+    if (isTemporary) {
+        return name == generatedTemporaryName(uid) ? uid : 0;
+    }
+
+    return name == generatedLabelName(uid, true) || name == generatedLabelName(uid, false) ? uid : 0;
+}
+
+static bool isNumber(const std::string &name)
+{
+    return !name.empty() && ((name[0] >= '0' && name[0] <= '9') || name[0] == '-' || name[0] == '.');
+}
+
+class TacTextReader
+{
+public:
+    TacTextReader(std::istream &stream, std::string &error);
+
+    TacModulePtr read();
+
+private:
+    // "a:b:\t\tOP\tx\ty" is labels a and b, then an instruction; a line may
+    // hold only labels, or be blank
+    struct Line
+    {
+        int number;
+        std::vector<std::string> labels;
+        std::string opcode;
+        std::vector<std::string> operands;
+    };
+
+    // an instruction whose value operands wait for every function to be
+    // declared, since a body may call a function declared after it
+    struct Pending
+    {
+        TacBasicBlock *block;
+        size_t instruction;
+        int line;
+        std::string operands[3];
+    };
+
+    struct Header
+    {
+        std::string name;
+        std::vector<std::string> parameters;
+        std::vector<std::string> variables;
+        std::string entry;
+    };
+
+    bool blank(size_t i) const { return m_lines[i].labels.empty() && m_lines[i].opcode.empty(); }
+    bool startsHeader(size_t i, const std::vector<std::string> &entries) const;
+    bool readHeader(Header &header, bool named);
+    bool declare(TacFunction *function, const Header &header);
+    bool readFunction(TacFunction *function, std::vector<std::string> &entries);
+    bool readBlock(TacFunction *function);
+    bool readInstruction(TacBasicBlock *block, const Line &line);
+    bool resolve(Pending &pending);
+    int label(const std::string &name);
+    bool define(int label, int line);
+    bool fail(int line, const std::string &message);
+
+    std::istream &m_stream;
+    std::string *m_error;
+    std::vector<Line> m_lines;
+    size_t m_next;
+
+    TacModulePtr m_module;
+    boost::unordered_map<std::string, TacOpcode::Enum> m_opcodes;
+    boost::unordered_map<std::string, int> m_labels;
+    std::vector<char> m_defined;
+    boost::unordered_map<std::string, TacValue *> m_temporaries;
+    std::vector<Pending> m_pending;
+};
+
+TacTextReader::TacTextReader(std::istream &stream, std::string &error)
+    : m_stream(stream)
+    , m_error(&error)
+    , m_next(0)
+{
+    for (int i = TacOpcode::Add; i <= TacOpcode::Check; ++i) {
+        if (i != TacOpcode::Label) {
+            m_opcodes[opcodeToString((TacOpcode::Enum)i)] = (TacOpcode::Enum)i;
+        }
+    }
+}
+
+bool TacTextReader::fail(int line, const std::string &message)
+{
+    std::stringstream ss;
+    ss << "line " << line << ": " << message;
+    *m_error = ss.str();
+
+    return false;
+}
+
+// A labelled line opens a function if it declares something, or if it is
+// the entry GOTO and the function's first child or entry block follows; a
+// block that is only a GOTO is followed by the blank line that ends it.
+// Labels and functions may share names, so a GOTO line labelled with the
+// entry of an enclosing function is that function's block.
+bool TacTextReader::startsHeader(size_t i, const std::vector<std::string> &entries) const
+{
+    const Line &line = m_lines[i];
+
+    if (line.labels.size() != 1) {
+        return false;
+    }
+
+    if (line.opcode == "FPARAM" || line.opcode == "VAR") {
+        return true;
+    }
+
+    if (std::find(entries.begin(), entries.end(), line.labels[0]) != entries.end()) {
+        return false;
+    }
+
+    if (line.opcode != "GOTO" || line.operands.size() != 1 || i + 1 == m_lines.size()) {
+        return false;
+    }
+
+    const Line &next = m_lines[i + 1];
+
+    return !next.labels.empty() && (next.labels[0] == line.operands[0] || startsHeader(i + 1, entries));
+}
+
+bool TacTextReader::readHeader(Header &header, bool named)
+{
+    const Line &first = m_lines[m_next];
+
+    if (named) {
+        header.name = first.labels[0];
+    } else if (!first.labels.empty()) {
+        return fail(first.number, "the program has no name");
+    }
+
+    for (; m_next < m_lines.size(); ++m_next) {
+        const Line &line = m_lines[m_next];
+
+        if (&line != &first && !line.labels.empty()) {
+            return fail(line.number, "a label inside a declaration list");
+        }
+
+        if (line.opcode == "GOTO" && line.operands.size() == 1) {
+            header.entry = line.operands[0];
+            ++m_next;
+            return true;
+        }
+
+        if (line.operands.size() != 1) {
+            return fail(line.number, "expected a declaration");
+        }
+
+        if (line.opcode == "FPARAM" && header.variables.empty()) {
+            header.parameters.push_back(line.operands[0]);
+        } else if (line.opcode == "VAR") {
+            header.variables.push_back(line.operands[0]);
+        } else {
+            return fail(line.number, "expected a declaration");
+        }
+    }
+
+    return fail(m_lines.empty() ? 1 : m_lines.back().number, "no GOTO to the entry block");
+}
+
+bool TacTextReader::declare(TacFunction *function, const Header &header)
+{
+    for (std::vector<std::string>::const_iterator i = header.variables.begin(); i != header.variables.end(); ++i) {
+        IdentifierPtr id = m_module->arena.create<Identifier>();
+        id->id = Token(*i, -1, -1);
+
+        if (generatedUid(*i, true) == 0) {
+            function->createVariable(id, TypePtr());
+            continue;
+        }
+
+        if (m_temporaries.count(*i)) {
+            return fail(m_lines[m_next - 1].number, "temporary " + *i + " is declared twice");
+        }
+
+        TacValuePtr temporary(new TacValue);
+        temporary->uid = generatedUid(*i, true);
+        temporary->isTemporary = true;
+        temporary->id = id;
+        temporary->symbol = SymbolTable::instance().intern(id->id);
+
+        m_module->addValue(temporary);
+        function->symbols.push_back(temporary.get());
+        m_temporaries[*i] = temporary.get();
+
+        m_module->uidCount = std::max(m_module->uidCount, temporary->uid);
+    }
+
+    return true;
+}
+
+// entries holds the entry labels of the enclosing functions; the line that
+// opens one of those blocks ends this function.
+bool TacTextReader::readFunction(TacFunction *function, std::vector<std::string> &entries)
+{
+    while (m_next < m_lines.size() && startsHeader(m_next, entries)) {
+        Header header;
+        if (!readHeader(header, true)) {
+            return false;
+        }
+
+        DeclarationsPtr arguments = m_module->arena.create<Declarations>();
+        for (std::vector<std::string>::iterator i = header.parameters.begin(); i != header.parameters.end(); ++i) {
+            DeclarationPtr declaration = m_module->arena.create<Declaration>();
+            declaration->id = m_module->arena.create<Identifier>();
+            declaration->id->id = Token(*i, -1, -1);
+            declaration->type = TypePtr();
+
+            arguments->list.push_back(declaration);
+        }
+
+        IdentifierPtr name = m_module->arena.create<Identifier>();
+        name->id = Token(header.name, -1, -1);
+
+        TacFunction *child = function->createFunction(name, arguments, TypePtr());
+        if (!declare(child, header)) {
+            return false;
+        }
+
+        entries.push_back(header.entry);
+        bool succeeded = readFunction(child, entries);
+        entries.pop_back();
+
+        if (!succeeded) {
+            return false;
+        }
+    }
+
+    while (m_next < m_lines.size()) {
+        const Line &line = m_lines[m_next];
+
+        if (blank(m_next)) {
+            ++m_next;
+            continue;
+        }
+
+        // a sibling, or the code of an enclosing function
+        if (entries.size() > 1 && startsHeader(m_next, entries)) {
+            break;
+        }
+
+        if (!line.labels.empty() && std::find(entries.begin(), entries.end() - 1, line.labels[0]) != entries.end() - 1) {
+            break;
+        }
+
+        if (!readBlock(function)) {
+            return false;
+        }
+    }
+
+    if (function->blocks.empty() || function->blocks.front()->name != entries.back()) {
+        return fail(m_next < m_lines.size() ? m_lines[m_next].number : m_lines.back().number,
+                    "the code of " + (function->name.empty() ? std::string("the program") : function->name) + " does not start at " + entries.back());
+    }
+
+    return true;
+}
+
+// A block is its first line's first label and runs to a blank line or to a
+// line of labels only, which TacFunction::output() ends every block with.
+bool TacTextReader::readBlock(TacFunction *function)
+{
+    const Line &first = m_lines[m_next];
+
+    std::string name = first.labels.empty() ? std::string() : first.labels[0];
+    int blockLabel = label(name);
+    if (!define(blockLabel, first.number)) {
+        return false;
+    }
+
+    TacBasicBlockPtr block(new TacBasicBlock(name, function, blockLabel));
+    function->blocks.push_back(block);
+
+    for (size_t i = 1; ; i = 0) {
+        const Line &line = m_lines[m_next++];
+
+        if (&line != &first && blank(m_next - 1)) {
+            return true;
+        }
+
+        for (; i < line.labels.size(); ++i) {
+            int instructionLabel = label(line.labels[i]);
+            if (!define(instructionLabel, line.number)) {
+                return false;
+            }
+
+            block->append(TacOpcode::Label, instructionLabel);
+        }
+
+        if (line.opcode.empty()) {
+            return true;
+        }
+
+        if (!readInstruction(block.get(), line)) {
+            return false;
+        }
+
+        if (m_next == m_lines.size()) {
+            return true;
+        }
+    }
+}
+
+bool TacTextReader::readInstruction(TacBasicBlock *block, const Line &line)
+{
+    boost::unordered_map<std::string, TacOpcode::Enum>::iterator opcode = m_opcodes.find(line.opcode);
+    if (opcode == m_opcodes.end()) {
+        return fail(line.number, "unknown opcode " + line.opcode);
+    }
+
+    TacInstruction instruction(opcode->second);
+
+    size_t operands = 0;
+    if (instruction.isBinary() || instruction.isBranch() || instruction.opcode == TacOpcode::Not || instruction.opcode == TacOpcode::Check) {
+        operands = 3;
+    } else if (instruction.isUnary()) {
+        operands = 2;
+    } else if (instruction.opcode != TacOpcode::Return) {
+        operands = 1;
+    }
+
+    if (line.operands.size() != operands) {
+        return fail(line.number, "wrong number of operands for " + line.opcode);
+    }
+
+    Pending pending;
+    pending.block = block;
+    pending.instruction = block->code.size();
+    pending.line = line.number;
+
+    for (size_t i = 0; i < operands; ++i) {
+        pending.operands[i] = line.operands[i];
+    }
+
+    // NOT prints its operand twice
+    if (instruction.opcode == TacOpcode::Not) {
+        if (line.operands[0] != line.operands[1]) {
+            return fail(line.number, "NOT with two different operands");
+        }
+
+        pending.operands[1] = line.operands[2];
+        pending.operands[2].clear();
+    }
+
+    if (int *labelOperand = instruction.labelOperand()) {
+        std::string &name = pending.operands[labelOperand - instruction.operands];
+
+        *labelOperand = label(name);
+        name.clear();
+    }
+
+    block->code.push_back(instruction);
+    m_pending.push_back(pending);
+
+    return true;
+}
+
+bool TacTextReader::resolve(Pending &pending)
+{
+    TacInstruction &instruction = pending.block->code[pending.instruction];
+
+    for (int i = 0; i < 3; ++i) {
+        const std::string &name = pending.operands[i];
+
+        if (name.empty()) {
+            continue;
+        }
+
+        if (isNumber(name)) {
+            const char *begin = name.c_str();
+            char *end = 0;
+            errno = 0;
+
+            if (name.find_first_of(".eEin") == std::string::npos) {
+                long value = std::strtol(begin, &end, 10);
+                instruction.operands[i] = m_module->constant((int)value);
+            } else {
+                float value = std::strtod(begin, &end);
+                instruction.operands[i] = m_module->constant(value);
+            }
+
+            if (*end != '\0' || errno != 0) {
+                return fail(pending.line, "bad constant " + name);
+            }
+
+            continue;
+        }
+
+        boost::unordered_map<std::string, TacValue *>::iterator temporary = m_temporaries.find(name);
+        if (temporary != m_temporaries.end()) {
+            instruction.operands[i] = temporary->second->index;
+            continue;
+        }
+
+        IdentifierPtr id = m_module->arena.create<Identifier>();
+        id->id = Token(name, -1, -1);
+
+        TacValue *value = pending.block->owner->lookupSymbol(id);
+        if (!value) {
+            return fail(pending.line, "undeclared " + name);
+        }
+
+        instruction.operands[i] = value->index;
+    }
+
+    return true;
+}
+
+int TacTextReader::label(const std::string &name)
+{
+    boost::unordered_map<std::string, int>::iterator i = m_labels.find(name);
+    if (i != m_labels.end() && !name.empty()) {
+        return i->second;
+    }
+
+    int uid = generatedUid(name, false);
+
+    m_module->uidCount = std::max(m_module->uidCount, uid);
+
+    int index = m_module->addLabel(name, 0, uid);
+    m_labels[name] = index;
+    m_defined.push_back(false);
+
+    return index;
+}
+
+bool TacTextReader::define(int label, int line)
+{
+    if (m_defined[label]) {
+        return fail(line, "label " + m_module->labelName(label) + " is defined twice");
+    }
+
+    m_defined[label] = true;
+
+    return true;
+}
+
+TacModulePtr TacTextReader::read()
+{
+    std::string text;
+
+    for (int number = 1; std::getline(m_stream, text); ++number) {
+        Line line;
+        line.number = number;
+
+        std::string::size_type tab = text.find('\t');
+        std::string labels = text.substr(0, tab);
+
+        for (std::string::size_type start = 0; start < labels.size(); ) {
+            std::string::size_type colon = labels.find(':', start);
+            if (colon == std::string::npos) {
+                fail(number, "expected a label");
+                return TacModulePtr();
+            }
+
+            line.labels.push_back(labels.substr(start, colon - start));
+            start = colon + 1;
+        }
+
+        if (tab != std::string::npos) {
+            if (text.compare(tab, 2, "\t\t") != 0) {
+                fail(number, "expected an instruction");
+                return TacModulePtr();
+            }
+
+            std::stringstream fields(text.substr(tab + 2));
+            std::getline(fields, line.opcode, '\t');
+
+            std::string operand;
+            while (std::getline(fields, operand, '\t')) {
+                line.operands.push_back(operand);
+            }
+        }
+
+        m_lines.push_back(line);
+    }
+
+    if (m_lines.empty()) {
+        fail(1, "no program");
+        return TacModulePtr();
+    }
+
+    m_module.reset(new TacModule);
+
+    // the builtin, as TacBuilder declares it
+    TacValuePtr writeln(new TacValue);
+    writeln->id = m_module->arena.create<Identifier>();
+    writeln->id->id = Token("writeln", -1, -1);
+    writeln->isConstant = true;
+    writeln->isFunction = true;
+    writeln->symbol = SymbolTable::instance().intern(writeln->id->id);
+
+    m_module->addValue(writeln);
+    m_module->program->addSymbol(writeln.get());
+
+    Header header;
+    if (!readHeader(header, false) || !declare(m_module->program.get(), header)) {
+        return TacModulePtr();
+    }
+
+    std::vector<std::string> entries(1, header.entry);
+    if (!readFunction(m_module->program.get(), entries)) {
+        return TacModulePtr();
+    }
+
+    if (m_next < m_lines.size()) {
+        fail(m_lines[m_next].number, "text after the program");
+        return TacModulePtr();
+    }
+
+    for (std::vector<Pending>::iterator i = m_pending.begin(); i != m_pending.end(); ++i) {
+        if (!resolve(*i)) {
+            return TacModulePtr();
+        }
+    }
+
+    for (size_t i = 0; i < m_defined.size(); ++i) {
+        if (!m_defined[i]) {
+            fail(m_lines.back().number, "jump to undefined label " + m_module->labelName(i));
+            return TacModulePtr();
+        }
+    }
+
+    return m_module;
+}
+
+TacModulePtr readTacText(std::istream &stream, std::string &error)
+{
+    return TacTextReader(stream, error).read();
+}
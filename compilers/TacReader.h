@@ -0,0 +1,14 @@
+#pragma once
+
+#include "Tac.h"
+
+#include <istream>
+#include <string>
+
+// Reads back the text TacModule::output() prints. The text names no types,
+// so values come back untyped, and a real constant with no fraction comes
+// back as an integer: a module read from text runs on the interpreter as
+// the original did, but is not fit for the x86 backend. Returns an empty
+// pointer and sets error, with a line number, on text output() would not
+// have printed.
+TacModulePtr readTacText(std::istream &stream, std::string &error);
@@ -0,0 +1,390 @@
+#include "TacSsa.h"
+#include "TacLiveness.h"
+
+#include <algorithm>
+#include <sstream>
+
+// Label operands index the label table, so they must not be mistaken for
+// values when operands are renamed.
+static bool isValueOperand(const TacInstruction &instruction, int operand)
+{
+    if (instruction.operands[operand] == kNoOperand) {
+        return false;
+    }
+
+    if (instruction.isBranch()) {
+        return operand != 2;
+    }
+
+    return instruction.opcode != TacOpcode::Goto && instruction.opcode != TacOpcode::Label;
+}
+
+static int *definitionOperand(TacInstruction &instruction)
+{
+    if (instruction.isBinary()) {
+        return &instruction.operands[2];
+    }
+
+    if (instruction.isUnary()) {
+        return &instruction.operands[1];
+    }
+
+    return 0;
+}
+
+TacSsa::TacSsa(TacFunction &function)
+    : m_function(&function)
+{
+}
+
+TacSsa::~TacSsa()
+{
+}
+
+int TacSsa::original(int value) const
+{
+    boost::unordered_map<int, int>::const_iterator i = m_originals.find(value);
+
+    return i == m_originals.end() ? value : i->second;
+}
+
+// Like TacFunction::createTemporary, but unnamed: most versions are folded
+// away again, and interning a name for each would cost more than the rest
+// of the round trip. destroy() names the ones that stay.
+int TacSsa::createVersion(int value)
+{
+    TacModule &module = *m_function->module;
+
+    TacValuePtr version(new TacValue);
+    version->type = module.value(value)->type;
+    version->uid = module.nextUid();
+    version->isTemporary = true;
+
+    module.addValue(version);
+    m_function->symbols.push_back(version.get());
+    m_originals[version->index] = value;
+
+    return version->index;
+}
+
+static std::string versionName(const TacValue *value)
+{
+    if (value->symbol) {
+        return value->value();
+    }
+
+    std::ostringstream name;
+    name << "%" << value->uid;
+
+    return name.str();
+}
+
+// Cytron et al., with phis pruned by liveness and renaming done over the
+// dominator tree.
+void TacSsa::construct()
+{
+    m_cfg.reset(new TacCfg(*m_function));
+    m_phis.assign(m_cfg->size(), std::vector<Phi>());
+    m_originals.clear();
+
+    // A jump back to the entry would need a phi on the way in from the
+    // caller as well; leave such functions as they are.
+    if (m_cfg->size() == 0 || !m_cfg->node(0).predecessors.empty()) {
+        return;
+    }
+
+    TacLiveness liveness(*m_cfg);
+    int slots = liveness.size();
+
+    std::vector<std::vector<int> > definitions(slots);
+    const std::vector<int> &order = m_cfg->reversePostorder();
+
+    for (std::vector<int>::const_iterator i = order.begin(); i != order.end(); ++i) {
+        const TacCfg::Node &node = m_cfg->node(*i);
+
+        for (size_t j = node.begin; j < node.end; ++j) {
+            const TacInstruction &instruction = node.block->code[j];
+            int slot = liveness.slot(instruction.definition());
+
+            if (slot >= 0 && !liveness.isShared(slot) && (definitions[slot].empty() || definitions[slot].back() != *i)) {
+                definitions[slot].push_back(*i);
+            }
+        }
+    }
+
+    // the last slot that placed a phi in, or queued, each node
+    std::vector<int> placed(m_cfg->size(), -1);
+    std::vector<int> queued(m_cfg->size(), -1);
+
+    for (int slot = 0; slot < slots; ++slot) {
+        std::vector<int> worklist(definitions[slot]);
+        for (std::vector<int>::iterator i = worklist.begin(); i != worklist.end(); ++i) {
+            queued[*i] = slot;
+        }
+
+        while (!worklist.empty()) {
+            int node = worklist.back();
+            worklist.pop_back();
+
+            const std::vector<int> &frontier = m_cfg->node(node).frontier;
+            for (std::vector<int>::const_iterator i = frontier.begin(); i != frontier.end(); ++i) {
+                if (placed[*i] == slot) {
+                    continue;
+                }
+                placed[*i] = slot;
+
+                if (liveness.liveIn(*i).test(slot)) {
+                    Phi phi;
+                    phi.variable = liveness.value(slot);
+                    phi.result = kNoOperand;
+                    phi.arguments.assign(m_cfg->node(*i).predecessors.size(), phi.variable);
+                    m_phis[*i].push_back(phi);
+                }
+
+                if (queued[*i] != slot) {
+                    queued[*i] = slot;
+                    worklist.push_back(*i);
+                }
+            }
+        }
+    }
+
+    // Every value starts out as its own version, which is what a use sees
+    // before any definition.
+    std::vector<std::vector<int> > versions(slots);
+    for (int slot = 0; slot < slots; ++slot) {
+        versions[slot].push_back(liveness.value(slot));
+    }
+
+    std::vector<int> pushed;
+    std::vector<std::pair<int, size_t> > stack;
+    std::vector<size_t> marks;
+
+    stack.push_back(std::make_pair(order.front(), 0));
+
+    while (!stack.empty()) {
+        int current = stack.back().first;
+        size_t child = stack.back().second;
+
+        if (child == 0) {
+            marks.push_back(pushed.size());
+
+            for (std::vector<Phi>::iterator i = m_phis[current].begin(); i != m_phis[current].end(); ++i) {
+                int slot = liveness.slot(i->variable);
+                i->result = createVersion(i->variable);
+                versions[slot].push_back(i->result);
+                pushed.push_back(slot);
+            }
+
+            const TacCfg::Node &node = m_cfg->node(current);
+            for (size_t j = node.begin; j < node.end; ++j) {
+                TacInstruction &instruction = node.block->code[j];
+
+                for (int k = 0; k < instruction.numUses(); ++k) {
+                    int slot = liveness.slot(instruction.operands[k]);
+                    if (slot >= 0 && !liveness.isShared(slot)) {
+                        instruction.operands[k] = versions[slot].back();
+                    }
+                }
+
+                int *definition = definitionOperand(instruction);
+                int slot = definition ? liveness.slot(*definition) : -1;
+                if (slot >= 0 && !liveness.isShared(slot)) {
+                    *definition = createVersion(*definition);
+                    versions[slot].push_back(*definition);
+                    pushed.push_back(slot);
+                }
+            }
+
+            for (std::vector<int>::const_iterator i = node.successors.begin(); i != node.successors.end(); ++i) {
+                int index = m_cfg->predecessorIndex(*i, current);
+
+                for (std::vector<Phi>::iterator j = m_phis[*i].begin(); j != m_phis[*i].end(); ++j) {
+                    j->arguments[index] = versions[liveness.slot(j->variable)].back();
+                }
+            }
+        }
+
+        const std::vector<int> &dominated = m_cfg->node(current).dominated;
+        if (child < dominated.size()) {
+            ++stack.back().second;
+            stack.push_back(std::make_pair(dominated[child], 0));
+            continue;
+        }
+
+        for (size_t i = marks.back(); i < pushed.size(); ++i) {
+            versions[pushed[i]].pop_back();
+        }
+        pushed.resize(marks.back());
+        marks.pop_back();
+        stack.pop_back();
+    }
+}
+
+bool TacSsa::destroy()
+{
+    if (m_originals.empty()) {
+        m_phis.clear();
+        m_cfg.reset();
+        return false;
+    }
+
+    std::vector<TacInstructions> heads(m_cfg->size());
+    std::vector<TacInstructions> tails(m_cfg->size());
+
+    for (int i = 0; i < m_cfg->size(); ++i) {
+        const std::vector<int> &predecessors = m_cfg->node(i).predecessors;
+
+        for (std::vector<Phi>::iterator j = m_phis[i].begin(); j != m_phis[i].end(); ++j) {
+            int copy = createVersion(j->variable);
+
+            for (size_t k = 0; k < predecessors.size(); ++k) {
+                tails[predecessors[k]].push_back(TacInstruction(TacOpcode::Assign, j->arguments[k], copy));
+            }
+            heads[i].push_back(TacInstruction(TacOpcode::Assign, copy, j->result));
+        }
+    }
+
+    // A copy into a fresh temporary is harmless on the paths that do not
+    // lead to the phi, so no edges need splitting.
+    m_cfg->insert(heads, tails);
+
+    m_phis.clear();
+    m_cfg.reset();
+
+    boost::unordered_map<int, int> renames;
+    coalesce(renames);
+
+    for (std::vector<TacBasicBlockPtr>::iterator i = m_function->blocks.begin(); i != m_function->blocks.end(); ++i) {
+        for (TacInstructions::iterator j = (*i)->code.begin(); j != (*i)->code.end(); ++j) {
+            for (int k = 0; k < 3; ++k) {
+                if (!isValueOperand(*j, k)) {
+                    continue;
+                }
+
+                boost::unordered_map<int, int>::iterator rename = renames.find(j->operands[k]);
+                if (rename != renames.end()) {
+                    j->operands[k] = rename->second;
+                }
+            }
+
+            if (j->opcode == TacOpcode::Assign && j->operands[0] == j->operands[1]) {
+                j->opcode = TacOpcode::Invalid;
+            }
+        }
+
+        compactBasicBlock(**i);
+    }
+
+    // versions are temporaries, so they are not in the symbol index
+    std::vector<TacValue *> symbols;
+    for (std::vector<TacValue *>::iterator i = m_function->symbols.begin(); i != m_function->symbols.end(); ++i) {
+        if (renames.count((*i)->index)) {
+            continue;
+        }
+
+        if (!(*i)->symbol && m_originals.count((*i)->index)) {
+            m_function->module->nameTemporary(*i);
+        }
+        symbols.push_back(*i);
+    }
+    m_function->symbols.swap(symbols);
+
+    bool kept = renames.size() < m_originals.size();
+    m_originals.clear();
+
+    return kept;
+}
+
+// Folds each version into its original value unless it is live where
+// another member of the same family is defined, copies between the two
+// aside. Members are tried in the order they were made.
+void TacSsa::coalesce(boost::unordered_map<int, int> &renames)
+{
+    TacCfg cfg(*m_function);
+    TacLiveness liveness(cfg);
+
+    typedef boost::unordered_map<int, std::vector<int> > Interference;
+    Interference interference;
+
+    for (std::vector<int>::const_iterator i = cfg.reversePostorder().begin(); i != cfg.reversePostorder().end(); ++i) {
+        const TacCfg::Node &node = cfg.node(*i);
+        TacLiveness::Set live = liveness.liveOut(*i);
+
+        for (size_t j = node.end; j > node.begin; --j) {
+            const TacInstruction &instruction = node.block->code[j - 1];
+            int definition = instruction.definition();
+            int slot = liveness.slot(definition);
+
+            if (slot >= 0) {
+                int family = original(definition);
+                int source = instruction.opcode == TacOpcode::Assign ? instruction.operands[0] : kNoOperand;
+
+                for (TacLiveness::Set::size_type k = live.find_first(); k != TacLiveness::Set::npos; k = live.find_next(k)) {
+                    int other = liveness.value(k);
+
+                    if (other != definition && other != source && original(other) == family) {
+                        interference[definition].push_back(other);
+                        interference[other].push_back(definition);
+                    }
+                }
+            }
+
+            liveness.transfer(instruction, live);
+        }
+    }
+
+    // versions in creation order, so each family meets its oldest first
+    std::vector<TacValue *> versions;
+    for (std::vector<TacValue *>::iterator i = m_function->symbols.begin(); i != m_function->symbols.end(); ++i) {
+        if (m_originals.count((*i)->index)) {
+            versions.push_back(*i);
+        }
+    }
+
+    for (std::vector<TacValue *>::iterator i = versions.begin(); i != versions.end(); ++i) {
+        int version = (*i)->index;
+        int family = original(version);
+        bool interferes = false;
+
+        Interference::iterator others = interference.find(version);
+        if (others != interference.end()) {
+            for (std::vector<int>::iterator j = others->second.begin(); j != others->second.end(); ++j) {
+                int merged = renames.count(*j) ? renames[*j] : *j;
+                if (merged == family) {
+                    interferes = true;
+                    break;
+                }
+            }
+        }
+
+        if (!interferes) {
+            renames[version] = family;
+        }
+    }
+}
+
+void TacSsa::output(std::ostream &stream) const
+{
+    TacModule &module = *m_function->module;
+
+    for (size_t i = 0; i < m_phis.size(); ++i) {
+        for (std::vector<Phi>::const_iterator j = m_phis[i].begin(); j != m_phis[i].end(); ++j) {
+            stream << i << "\t" << versionName(module.value(j->result)) << " = phi";
+
+            for (std::vector<int>::const_iterator k = j->arguments.begin(); k != j->arguments.end(); ++k) {
+                stream << " " << versionName(module.value(*k));
+            }
+            stream << "\n";
+        }
+    }
+}
+
+bool SsaRoundTripPass::runOnFunction(TacFunction &function)
+{
+    TacSsa ssa(function);
+
+    ssa.construct();
+
+    return ssa.destroy();
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "TacCfg.h"
+#include "TacPass.h"
+
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <ostream>
+#include <vector>
+
+// Static single assignment form for one function.
+//
+// construct() gives every definition of a renamable value its own
+// temporary, a version, and rewrites the uses to match. Phis are kept here,
+// by CFG node, rather than in the instruction stream, so nothing outside
+// the SSA passes ever sees them. Variables that nested subprograms can
+// reach are left alone, and phis are only placed where the value is live.
+//
+// destroy() turns every phi into copies through a fresh temporary, one at
+// the end of each predecessor and one at the phi, then folds each version
+// back into its original value wherever their live ranges do not overlap.
+// Straight after construct() that undoes the renaming completely.
+class TacSsa : private boost::noncopyable
+{
+public:
+    struct Phi
+    {
+        int variable;
+        int result;
+        // one per CFG predecessor, in the same order
+        std::vector<int> arguments;
+    };
+
+    explicit TacSsa(TacFunction &function);
+    ~TacSsa();
+
+    void construct();
+    // Returns true if any copies or versions had to stay.
+    bool destroy();
+
+    // only valid between construct() and destroy()
+    const TacCfg &cfg() const { return *m_cfg; }
+    const std::vector<Phi> &phis(int node) const { return m_phis[node]; }
+
+    // the value a version was made from, or the value itself
+    int original(int value) const;
+
+    void output(std::ostream &stream) const;
+
+private:
+    int createVersion(int value);
+    void coalesce(boost::unordered_map<int, int> &renames);
+
+    TacFunction *m_function;
+    boost::scoped_ptr<TacCfg> m_cfg;
+    std::vector<std::vector<Phi> > m_phis;
+    boost::unordered_map<int, int> m_originals;
+};
+
+// Puts each function into SSA form and straight back out. No pass works on
+// SSA yet; this checks the round trip and shows its cost in --stats.
+class SsaRoundTripPass : public TacPass
+{
+public:
+    virtual const char *name() const { return "ssa-round-trip"; }
+    virtual bool runOnFunction(TacFunction &function);
+};
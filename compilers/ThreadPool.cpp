@@ -0,0 +1,77 @@
+#include "ThreadPool.h"
+
+#include <boost/bind/bind.hpp>
+
+ThreadPool::ThreadPool(int threads)
+    : m_size(threads > 0 ? threads : boost::thread::hardware_concurrency())
+    , m_pending(0)
+    , m_stopping(false)
+{
+    if (m_size < 1) {
+        m_size = 1;
+    }
+
+    for (int i = 0; i < m_size; ++i) {
+        m_threads.create_thread(boost::bind(&ThreadPool::work, this));
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        m_stopping = true;
+    }
+
+    m_taskReady.notify_all();
+    m_threads.join_all();
+}
+
+void ThreadPool::submit(const boost::function<void ()> &task)
+{
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        m_tasks.push_back(task);
+        ++m_pending;
+    }
+
+    m_taskReady.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+
+    while (m_pending > 0) {
+        m_idle.wait(lock);
+    }
+}
+
+void ThreadPool::work()
+{
+    for (;;) {
+        boost::function<void ()> task;
+
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+
+            while (m_tasks.empty() && !m_stopping) {
+                m_taskReady.wait(lock);
+            }
+
+            if (m_tasks.empty()) {
+                return;
+            }
+
+            task = m_tasks.front();
+            m_tasks.pop_front();
+        }
+
+        task();
+
+        boost::mutex::scoped_lock lock(m_mutex);
+        if (--m_pending == 0) {
+            m_idle.notify_all();
+        }
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <deque>
+
+// Fixed set of worker threads running queued tasks in submission order.
+// Tasks must not throw.
+class ThreadPool : private boost::noncopyable
+{
+public:
+    // 0 starts one thread per hardware thread
+    explicit ThreadPool(int threads = 0);
+    ~ThreadPool();
+
+    void submit(const boost::function<void ()> &task);
+
+    // blocks until every task submitted so far has finished
+    void wait();
+
+    int size() const { return m_size; }
+
+private:
+    void work();
+
+    boost::thread_group m_threads;
+    std::deque<boost::function<void ()> > m_tasks;
+    boost::mutex m_mutex;
+    boost::condition_variable m_taskReady;
+    boost::condition_variable m_idle;
+    int m_size;
+    int m_pending;
+    bool m_stopping;
+};
@@ -1,61 +1,89 @@
 #include "Token.h"
+#include "SymbolTable.h"
 
 #include <algorithm>
-#include <sstream>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <ostream>
 
 Token::Token()
     : m_symbolTableEntry(0)
-    , m_value("")
+    , m_source("")
+    , m_offset(0)
+    , m_length(0)
     , m_line(-1)
     , m_column(-1)
     , m_tokenType(TokenType::Invalid)
     , m_operatorType(OperatorType::Invalid)
     , m_numberType(NumberType::Invalid)
+    , m_intValue(0)
+    , m_realValue(0)
 {
 }
 
 Token::Token(const std::string &value, int line, int column)
-    : m_symbolTableEntry(0)
-    , m_value(value)
+    : m_symbolTableEntry(SymbolTable::instance().intern(value.data(), value.size()))
+    , m_source(m_symbolTableEntry->name().c_str())
+    , m_offset(0)
+    , m_length(m_symbolTableEntry->name().size())
     , m_line(line)
     , m_column(column)
     , m_tokenType(TokenType::Identifier)
     , m_operatorType(OperatorType::Invalid)
     , m_numberType(NumberType::Invalid)
+    , m_intValue(0)
+    , m_realValue(0)
 {
 }
 
-Token::Token(const std::string &value, int line, int column, NumberType::Enum num)
+Token::Token(const char *source, int offset, int length, int line, int column, TokenType::Enum type, OperatorType::Enum oper)
     : m_symbolTableEntry(0)
-    , m_value(value)
+    , m_source(source)
+    , m_offset(offset)
+    , m_length(length)
     , m_line(line)
     , m_column(column)
-    , m_tokenType(TokenType::Number)
-    , m_operatorType(OperatorType::Invalid)
-    , m_numberType(num)
+    , m_tokenType(type)
+    , m_operatorType(oper)
+    , m_numberType(NumberType::Invalid)
+    , m_intValue(0)
+    , m_realValue(0)
 {
 }
 
-Token::Token(const std::string &value, int line, int column, TokenType::Enum type)
-    : m_symbolTableEntry(0)
-    , m_value(value)
-    , m_line(line)
-    , m_column(column)
-    , m_tokenType(type)
-    , m_operatorType(OperatorType::Invalid)
-    , m_numberType(NumberType::Invalid)
+Token Token::identifier(const char *source, int offset, int length, int line, int column, SymbolTableEntry *entry)
 {
+    Token token(source, offset, length, line, column, TokenType::Identifier);
+    token.m_symbolTableEntry = entry;
+
+    return token;
 }
 
-Token::Token(const std::string &value, int line, int column, TokenType::Enum type, OperatorType::Enum oper)
-    : m_symbolTableEntry(0)
-    , m_value(value)
-    , m_line(line)
-    , m_column(column)
-    , m_tokenType(type)
-    , m_operatorType(oper)
-    , m_numberType(NumberType::Invalid)
+Token Token::number(const char *source, int offset, int length, int line, int column, NumberType::Enum num)
 {
+    Token token(source, offset, length, line, column, TokenType::Number);
+    token.m_numberType = num;
+
+    // the text is not NUL terminated in the source, so convert from a copy;
+    // both values are kept, as the old stream conversions allowed either
+    char buffer[64];
+    std::string longNumber;
+    const char *text = buffer;
+
+    if (length < (int)sizeof(buffer)) {
+        std::memcpy(buffer, source + offset, length);
+        buffer[length] = '\0';
+    } else {
+        longNumber.assign(source + offset, length);
+        text = longNumber.c_str();
+    }
+
+    long intValue = std::strtol(text, 0, 10);
+    token.m_intValue = (int)std::max<long>(std::min<long>(intValue, INT_MAX), INT_MIN);
+    token.m_realValue = std::strtof(text, 0);
+
+    return token;
 }
 
 TokenType::Enum Token::tokenType() const
@@ -85,34 +113,16 @@ void Token::setSymbolTableEntry(SymbolTableEntry *entry)
 
 std::string Token::value() const
 {
-    std::string result = m_value;
+    if (m_symbolTableEntry) {
+        return m_symbolTableEntry->name();
+    }
+
+    std::string result(text(), m_length);
     std::transform(result.begin(), result.end(), result.begin(), ::tolower);
 
     return result;
 }
 
-int Token::valueAsInt() const
-{
-    std::stringstream ss;
-
-    int value = 0;
-    ss << m_value;
-    ss >> value;
-
-    return value;
-}
-
-float Token::valueAsReal() const
-{
-    std::stringstream ss;
-
-    float value = 0;
-    ss << m_value;
-    ss >> value;
-
-    return value;
-}
-
 static std::string operToString(OperatorType::Enum oper)
 {
     switch (oper) {
@@ -90,14 +90,19 @@ struct NumberType
 
 class SymbolTableEntry;
 
+// A token refers to its text by (offset, length) into the lexer's source
+// buffer instead of owning a copy. Identifiers are interned and numbers are
+// converted when the token is made, so neither needs the text afterwards.
 class Token
 {
 public:
     Token();
+    // a token made up by the compiler, with an interned identifier as text
     Token(const std::string &value, int line, int column);
-    Token(const std::string &value, int line, int column, NumberType::Enum num);
-    Token(const std::string &value, int line, int column, TokenType::Enum type);
-    Token(const std::string &value, int line, int column, TokenType::Enum type, OperatorType::Enum oper);
+    Token(const char *source, int offset, int length, int line, int column, TokenType::Enum type, OperatorType::Enum oper = OperatorType::Invalid);
+
+    static Token identifier(const char *source, int offset, int length, int line, int column, SymbolTableEntry *entry);
+    static Token number(const char *source, int offset, int length, int line, int column, NumberType::Enum num);
 
     TokenType::Enum tokenType() const;
     OperatorType::Enum operatorType() const;
@@ -112,21 +117,29 @@ public:
     bool isKeyword() const;
     bool isOperator() const;
 
+    const char *text() const { return m_source + m_offset; }
+    int offset() const { return m_offset; }
+    int length() const { return m_length; }
+
     std::string value() const;
-    int valueAsInt() const;
-    float valueAsReal() const;
+    int valueAsInt() const { return m_intValue; }
+    float valueAsReal() const { return m_realValue; }
 
     int line() const { return m_line; }
     int column() const { return m_column; }
 
 private:
     SymbolTableEntry *m_symbolTableEntry;
-    std::string m_value;
+    const char *m_source;
+    int m_offset;
+    int m_length;
     int m_line;
     int m_column;
     TokenType::Enum m_tokenType;
     OperatorType::Enum m_operatorType;
     NumberType::Enum m_numberType;
+    int m_intValue;
+    float m_realValue;
 };
 
 std::ostream &operator<<(std::ostream &stream, const Token &token);
@@ -0,0 +1,926 @@
+#include "X86Builder.h"
+
+#include <boost/dynamic_bitset.hpp>
+#include <boost/unordered_map.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+static const int kNumRegisters = 5;
+static const char *const kRegisters[kNumRegisters] = { "ebx", "r12d", "r13d", "r14d", "r15d" };
+static const char *const kRegisters64[kNumRegisters] = { "rbx", "r12", "r13", "r14", "r15" };
+static const int kMaxUnrolledClear = 8;
+
+struct LiveInterval
+{
+    int value;
+    int start;
+    int end;
+};
+
+static bool startsBefore(const LiveInterval &a, const LiveInterval &b)
+{
+    return a.start < b.start || (a.start == b.start && a.value < b.value);
+}
+
+static bool endsBefore(const LiveInterval &a, const LiveInterval &b)
+{
+    return a.end < b.end;
+}
+
+// Signed conditions for integer compares, unsigned ones for ucomiss.
+static const char *jumpMnemonic(TacOpcode::Enum opcode, bool real)
+{
+    switch (opcode) {
+    case TacOpcode::BranchEq:
+        return "je";
+    case TacOpcode::BranchGe:
+        return real ? "jae" : "jge";
+    case TacOpcode::BranchGt:
+        return real ? "ja" : "jg";
+    case TacOpcode::BranchLe:
+        return real ? "jbe" : "jle";
+    case TacOpcode::BranchLt:
+        return real ? "jb" : "jl";
+    case TacOpcode::BranchNe:
+        return "jne";
+    default:
+        return 0;
+    }
+}
+
+// Lowers a TacModule to assembly. Each function gets a frame pointer and an
+// 8 byte slot per symbol; the program's symbols are globals. Like the
+// interpreter, a display indexed by lexical level gives nested functions
+// the frame of their parents, and the function value (the return slot)
+// lives with the parent.
+class X86Emitter
+{
+public:
+    X86Emitter(const TacModule &module, std::ostream &stream);
+
+    bool emit();
+    const std::string &error() const { return m_error; }
+
+private:
+    struct FunctionInfo
+    {
+        TacFunction *function;
+        int level;
+        int frameSlots;
+        std::string symbol;
+        std::vector<int> savedRegisters;
+    };
+
+    void assignStorage();
+    void inferTypes();
+    void allocateRegisters(FunctionInfo &info);
+    bool emitFunction(FunctionInfo &info);
+    bool emitInstruction(const TacInstruction &instruction);
+    bool emitCall(const TacInstruction &instruction);
+    void emitWriteln();
+    void emitMain();
+    void emitBoundsError();
+    void emitData();
+
+    bool isDirect(int value) const;
+    std::string location(int value);
+    std::string labelName(int label) const;
+    std::string parameterSlot(int index) const;
+    void loadInt(const char *reg, int value);
+    void loadReal(const char *reg, int value);
+    void loadBool(const char *reg, const char *reg8, int value);
+    void storeInt(int value, const char *reg);
+    void storeReal(int value, const char *reg);
+    void moveInt(int dest, int src);
+
+    const TacModule &m_module;
+    std::ostream &m_out;
+    std::string m_error;
+
+    std::vector<FunctionInfo> m_functions;
+    boost::unordered_map<TacFunction *, int> m_indices;
+    std::vector<int> m_owners;
+    std::vector<int> m_slots;
+    std::vector<char> m_isReal;
+    std::vector<char> m_isShared;
+    std::vector<int> m_registers;
+    int m_globalSlots;
+
+    int m_current;
+    std::vector<char> m_pendingParameters;
+    int m_maxParameters;
+    bool m_checksBounds;
+};
+
+X86Emitter::X86Emitter(const TacModule &module, std::ostream &stream)
+    : m_module(module)
+    , m_out(stream)
+    , m_globalSlots(0)
+    , m_current(-1)
+    , m_maxParameters(0)
+    , m_checksBounds(false)
+{
+}
+
+void X86Emitter::assignStorage()
+{
+    std::vector<TacFunction *> functions;
+    m_module.collectFunctions(functions);
+
+    size_t numValues = m_module.values.size();
+    m_owners.assign(numValues, -1);
+    m_slots.assign(numValues, -1);
+    m_isShared.assign(numValues, false);
+    m_registers.assign(numValues, -1);
+
+    for (size_t i = 0; i < functions.size(); ++i) {
+        TacFunction *function = functions[i];
+
+        FunctionInfo info;
+        info.function = function;
+        info.level = function->parent ? m_functions[m_indices[function->parent]].level + 1 : 0;
+        info.frameSlots = 0;
+
+        std::stringstream symbol;
+        if (info.level == 0) {
+            symbol << "__impasse_program";
+        } else {
+            symbol << "__impasse_" << function->name << "_" << i;
+        }
+        info.symbol = symbol.str();
+
+        int &slots = info.level == 0 ? m_globalSlots : info.frameSlots;
+        for (std::vector<TacValue *>::iterator j = function->symbols.begin(); j != function->symbols.end(); ++j) {
+            if ((*j)->isConstant) {
+                continue;
+            }
+
+            m_owners[(*j)->index] = i;
+            m_slots[(*j)->index] = slots++;
+        }
+
+        m_indices[function] = m_functions.size();
+        m_functions.push_back(info);
+    }
+
+    // anything a nested function reads or writes has to stay in memory
+    for (size_t i = 0; i < m_functions.size(); ++i) {
+        TacFunction *function = m_functions[i].function;
+
+        for (std::vector<TacBasicBlockPtr>::iterator j = function->blocks.begin(); j != function->blocks.end(); ++j) {
+            for (TacInstructions::iterator k = (*j)->code.begin(); k != (*j)->code.end(); ++k) {
+                for (int operand = 0; operand < k->numUses(); ++operand) {
+                    int value = k->operands[operand];
+                    if (m_owners[value] >= 0 && m_owners[value] != (int)i) {
+                        m_isShared[value] = true;
+                    }
+                }
+
+                int definition = k->definition();
+                if (definition != kNoOperand && m_owners[definition] >= 0 && m_owners[definition] != (int)i) {
+                    m_isShared[definition] = true;
+                }
+            }
+        }
+    }
+}
+
+void X86Emitter::inferTypes()
+{
+    std::vector<TacFunction *> functions;
+    for (std::vector<FunctionInfo>::iterator i = m_functions.begin(); i != m_functions.end(); ++i) {
+        functions.push_back(i->function);
+    }
+
+    inferRealValues(m_module, functions, m_isReal);
+}
+
+// Linear scan over the function laid out in block order. A value's interval
+// is the hull of its occurrences and of every instruction it is live into
+// or out of, so the register is not reused while a later instruction, or
+// the next trip round a loop, may still read it.
+void X86Emitter::allocateRegisters(FunctionInfo &info)
+{
+    TacFunction *function = info.function;
+    int index = m_indices[function];
+
+    std::vector<const TacInstruction *> code;
+    boost::unordered_map<int, int> labelPositions;
+    boost::unordered_map<int, LiveInterval> intervals;
+
+    for (std::vector<TacBasicBlockPtr>::iterator i = function->blocks.begin(); i != function->blocks.end(); ++i) {
+        labelPositions[(*i)->label] = code.size();
+
+        for (TacInstructions::iterator j = (*i)->code.begin(); j != (*i)->code.end(); ++j) {
+            if (j->opcode == TacOpcode::Label) {
+                labelPositions[j->operands[0]] = code.size();
+                continue;
+            }
+
+            if (j->opcode == TacOpcode::Invalid) {
+                continue;
+            }
+
+            int position = code.size();
+            code.push_back(&*j);
+
+            int operands[4];
+            int numOperands = 0;
+            for (int k = 0; k < j->numUses(); ++k) {
+                operands[numOperands++] = j->operands[k];
+            }
+            if (j->definition() != kNoOperand) {
+                operands[numOperands++] = j->definition();
+            }
+
+            for (int k = 0; k < numOperands; ++k) {
+                int value = operands[k];
+                TacValue *tacValue = m_module.value(value);
+
+                if (m_owners[value] != index || m_isReal[value] || m_isShared[value] || tacValue->isFunction) {
+                    continue;
+                }
+
+                boost::unordered_map<int, LiveInterval>::iterator interval = intervals.find(value);
+                if (interval == intervals.end()) {
+                    // parameters arrive at entry, and a variable read before it
+                    // is written holds the zero the frame was cleared with, so
+                    // both are live from before the first instruction
+                    bool definedHere = k == numOperands - 1 && value == j->definition();
+                    LiveInterval live = { value, tacValue->isParameter || !definedHere ? -1 : position, position };
+                    intervals[value] = live;
+                } else {
+                    interval->second.end = position;
+                }
+            }
+        }
+    }
+
+    // Liveness per instruction, over the values that get an interval
+    boost::unordered_map<int, int> slots;
+    std::vector<int> values;
+    for (boost::unordered_map<int, LiveInterval>::iterator i = intervals.begin(); i != intervals.end(); ++i) {
+        slots[i->first] = values.size();
+        values.push_back(i->first);
+    }
+
+    typedef boost::dynamic_bitset<> Set;
+    int count = code.size();
+    std::vector<Set> uses(count, Set(values.size()));
+    std::vector<Set> definitions(count, Set(values.size()));
+    std::vector<Set> liveIn(count, Set(values.size()));
+    std::vector<Set> liveOut(count, Set(values.size()));
+    std::vector<int> targets(count, -1);
+
+    for (int position = 0; position < count; ++position) {
+        const TacInstruction &instruction = *code[position];
+
+        for (int k = 0; k < instruction.numUses(); ++k) {
+            boost::unordered_map<int, int>::iterator slot = slots.find(instruction.operands[k]);
+            if (slot != slots.end()) {
+                uses[position].set(slot->second);
+            }
+        }
+
+        boost::unordered_map<int, int>::iterator slot = slots.find(instruction.definition());
+        if (slot != slots.end()) {
+            definitions[position].set(slot->second);
+        }
+
+        if (instruction.isJump()) {
+            boost::unordered_map<int, int>::iterator target = labelPositions.find(instruction.label());
+            if (target != labelPositions.end() && target->second < count) {
+                targets[position] = target->second;
+            }
+        }
+    }
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+
+        for (int position = count - 1; position >= 0; --position) {
+            Set out(values.size());
+            if (!code[position]->isTerminator() && position + 1 < count) {
+                out |= liveIn[position + 1];
+            }
+            if (targets[position] >= 0) {
+                out |= liveIn[targets[position]];
+            }
+
+            Set in = uses[position] | (out - definitions[position]);
+            if (in != liveIn[position] || out != liveOut[position]) {
+                liveIn[position].swap(in);
+                liveOut[position].swap(out);
+                changed = true;
+            }
+        }
+    }
+
+    // A value live into an instruction is held from before it, and one live
+    // out of it until after it, so neither shares a register with what the
+    // instruction reads or writes.
+    for (int position = 0; position < count; ++position) {
+        for (size_t slot = liveIn[position].find_first(); slot != Set::npos; slot = liveIn[position].find_next(slot)) {
+            LiveInterval &live = intervals[values[slot]];
+            live.start = std::min(live.start, position - 1);
+            live.end = std::max(live.end, position);
+        }
+
+        for (size_t slot = liveOut[position].find_first(); slot != Set::npos; slot = liveOut[position].find_next(slot)) {
+            LiveInterval &live = intervals[values[slot]];
+            live.start = std::min(live.start, position);
+            live.end = std::max(live.end, position + 1);
+        }
+    }
+
+    std::vector<LiveInterval> sorted;
+    for (boost::unordered_map<int, LiveInterval>::iterator i = intervals.begin(); i != intervals.end(); ++i) {
+        sorted.push_back(i->second);
+    }
+    std::sort(sorted.begin(), sorted.end(), startsBefore);
+
+    std::vector<LiveInterval> active;
+    std::vector<int> freeRegisters;
+    for (int i = kNumRegisters - 1; i >= 0; --i) {
+        freeRegisters.push_back(i);
+    }
+
+    bool used[kNumRegisters] = { false };
+
+    for (std::vector<LiveInterval>::iterator i = sorted.begin(); i != sorted.end(); ++i) {
+        // an operand may share a register with the result of its last use
+        while (!active.empty() && active.front().end <= i->start) {
+            freeRegisters.push_back(m_registers[active.front().value]);
+            active.erase(active.begin());
+        }
+
+        if (!freeRegisters.empty()) {
+            m_registers[i->value] = freeRegisters.back();
+            freeRegisters.pop_back();
+        } else if (active.back().end > i->end) {
+            // spill whichever interval reaches furthest
+            m_registers[i->value] = m_registers[active.back().value];
+            m_registers[active.back().value] = -1;
+            active.pop_back();
+        } else {
+            continue;
+        }
+
+        used[m_registers[i->value]] = true;
+        active.insert(std::upper_bound(active.begin(), active.end(), *i, endsBefore), *i);
+    }
+
+    for (int i = 0; i < kNumRegisters; ++i) {
+        if (used[i]) {
+            info.savedRegisters.push_back(i);
+        }
+    }
+}
+
+bool X86Emitter::isDirect(int value) const
+{
+    return dynamic_cast<ConstIntTacValue *>(m_module.value(value)) || m_registers[value] >= 0;
+}
+
+std::string X86Emitter::location(int value)
+{
+    TacValue *tacValue = m_module.value(value);
+    std::stringstream ss;
+
+    if (ConstIntTacValue *intValue = dynamic_cast<ConstIntTacValue *>(tacValue)) {
+        ss << intValue->intValue;
+        return ss.str();
+    }
+
+    if (dynamic_cast<ConstRealTacValue *>(tacValue)) {
+        ss << "DWORD PTR [rip + .Lreal" << value << "]";
+        return ss.str();
+    }
+
+    if (m_registers[value] >= 0) {
+        return kRegisters[m_registers[value]];
+    }
+
+    const FunctionInfo &owner = m_functions[m_owners[value]];
+    int offset = 8 * (m_slots[value] + 1);
+
+    if (owner.level == 0) {
+        ss << "DWORD PTR [rip + __impasse_globals + " << 8 * m_slots[value] << "]";
+    } else if (m_owners[value] == m_current) {
+        ss << "DWORD PTR [rbp - " << offset << "]";
+    } else {
+        m_out << "    mov r11, QWORD PTR [rip + __impasse_display + " << 8 * owner.level << "]\n";
+        ss << "DWORD PTR [r11 - " << offset << "]";
+    }
+
+    return ss.str();
+}
+
+std::string X86Emitter::labelName(int label) const
+{
+    std::stringstream ss;
+    ss << ".L" << label;
+
+    return ss.str();
+}
+
+std::string X86Emitter::parameterSlot(int index) const
+{
+    std::stringstream ss;
+    ss << "DWORD PTR [rip + __impasse_parameters + " << 8 * index << "]";
+
+    return ss.str();
+}
+
+void X86Emitter::loadInt(const char *reg, int value)
+{
+    if (m_isReal[value]) {
+        m_out << "    movss xmm2, " << location(value) << "\n";
+        m_out << "    cvttss2si " << reg << ", xmm2\n";
+    } else {
+        m_out << "    mov " << reg << ", " << location(value) << "\n";
+    }
+}
+
+void X86Emitter::loadReal(const char *reg, int value)
+{
+    if (m_isReal[value]) {
+        m_out << "    movss " << reg << ", " << location(value) << "\n";
+    } else if (dynamic_cast<ConstIntTacValue *>(m_module.value(value))) {
+        m_out << "    mov eax, " << location(value) << "\n";
+        m_out << "    cvtsi2ss " << reg << ", eax\n";
+    } else {
+        m_out << "    cvtsi2ss " << reg << ", " << location(value) << "\n";
+    }
+}
+
+void X86Emitter::loadBool(const char *reg, const char *reg8, int value)
+{
+    if (m_isReal[value]) {
+        m_out << "    movss xmm2, " << location(value) << "\n";
+        m_out << "    xorps xmm3, xmm3\n";
+        m_out << "    ucomiss xmm2, xmm3\n";
+    } else {
+        m_out << "    mov " << reg << ", " << location(value) << "\n";
+        m_out << "    test " << reg << ", " << reg << "\n";
+    }
+
+    m_out << "    setne " << reg8 << "\n";
+    m_out << "    movzx " << reg << ", " << reg8 << "\n";
+}
+
+void X86Emitter::storeInt(int value, const char *reg)
+{
+    if (m_isReal[value]) {
+        m_out << "    cvtsi2ss xmm0, " << reg << "\n";
+        m_out << "    movss " << location(value) << ", xmm0\n";
+    } else {
+        m_out << "    mov " << location(value) << ", " << reg << "\n";
+    }
+}
+
+void X86Emitter::storeReal(int value, const char *reg)
+{
+    if (m_isReal[value]) {
+        m_out << "    movss " << location(value) << ", " << reg << "\n";
+    } else {
+        m_out << "    cvttss2si eax, " << reg << "\n";
+        m_out << "    mov " << location(value) << ", eax\n";
+    }
+}
+
+void X86Emitter::moveInt(int dest, int src)
+{
+    if (isDirect(dest) || isDirect(src)) {
+        std::string source = location(src);
+        std::string destination = location(dest);
+
+        if (destination == source) {
+            return;
+        }
+
+        m_out << "    mov " << destination << ", " << source << "\n";
+    } else {
+        loadInt("eax", src);
+        storeInt(dest, "eax");
+    }
+}
+
+bool X86Emitter::emitInstruction(const TacInstruction &instruction)
+{
+    const int *operands = instruction.operands;
+    bool real = instruction.numUses() > 0 && m_isReal[operands[0]];
+    if (instruction.numUses() > 1) {
+        real = real || m_isReal[operands[1]];
+    }
+
+    switch (instruction.opcode) {
+    case TacOpcode::Add:
+    case TacOpcode::Multiply:
+    case TacOpcode::Subtract: {
+        if (real) {
+            const char *mnemonic = instruction.opcode == TacOpcode::Add ? "addss" : instruction.opcode == TacOpcode::Multiply ? "mulss" : "subss";
+            loadReal("xmm0", operands[0]);
+            loadReal("xmm1", operands[1]);
+            m_out << "    " << mnemonic << " xmm0, xmm1\n";
+            storeReal(operands[2], "xmm0");
+        } else {
+            const char *mnemonic = instruction.opcode == TacOpcode::Add ? "add" : instruction.opcode == TacOpcode::Multiply ? "imul" : "sub";
+            loadInt("eax", operands[0]);
+            m_out << "    " << mnemonic << " eax, " << location(operands[1]) << "\n";
+            storeInt(operands[2], "eax");
+        }
+        break;
+    }
+
+    case TacOpcode::Divide:
+        loadReal("xmm0", operands[0]);
+        loadReal("xmm1", operands[1]);
+        m_out << "    divss xmm0, xmm1\n";
+        storeReal(operands[2], "xmm0");
+        break;
+
+    case TacOpcode::IntegerDivide:
+    case TacOpcode::Modulus:
+        loadInt("eax", operands[0]);
+        loadInt("ecx", operands[1]);
+        m_out << "    cdq\n";
+        m_out << "    idiv ecx\n";
+        storeInt(operands[2], instruction.opcode == TacOpcode::Modulus ? "edx" : "eax");
+        break;
+
+    case TacOpcode::And:
+    case TacOpcode::Or:
+        loadBool("ecx", "cl", operands[1]);
+        loadBool("eax", "al", operands[0]);
+        m_out << "    " << (instruction.opcode == TacOpcode::And ? "and" : "or") << " eax, ecx\n";
+        storeInt(operands[2], "eax");
+        break;
+
+    case TacOpcode::Assign:
+        if (real || m_isReal[operands[1]]) {
+            loadReal("xmm0", operands[0]);
+            storeReal(operands[1], "xmm0");
+        } else {
+            moveInt(operands[1], operands[0]);
+        }
+        break;
+
+    case TacOpcode::Negate:
+        if (real) {
+            loadReal("xmm0", operands[0]);
+            m_out << "    movd eax, xmm0\n";
+            m_out << "    xor eax, 0x80000000\n";
+            m_out << "    movd xmm0, eax\n";
+            storeReal(operands[1], "xmm0");
+        } else {
+            loadInt("eax", operands[0]);
+            m_out << "    neg eax\n";
+            storeInt(operands[1], "eax");
+        }
+        break;
+
+    case TacOpcode::Not:
+        loadBool("eax", "al", operands[0]);
+        m_out << "    xor eax, 1\n";
+        storeInt(operands[1], "eax");
+        break;
+
+    case TacOpcode::BranchEq:
+    case TacOpcode::BranchGe:
+    case TacOpcode::BranchGt:
+    case TacOpcode::BranchLe:
+    case TacOpcode::BranchLt:
+    case TacOpcode::BranchNe:
+        if (real) {
+            loadReal("xmm0", operands[0]);
+            loadReal("xmm1", operands[1]);
+            m_out << "    ucomiss xmm0, xmm1\n";
+        } else {
+            loadInt("eax", operands[0]);
+            m_out << "    cmp eax, " << location(operands[1]) << "\n";
+        }
+        m_out << "    " << jumpMnemonic(instruction.opcode, real) << " " << labelName(operands[2]) << "\n";
+        break;
+
+    case TacOpcode::Goto:
+        m_out << "    jmp " << labelName(operands[0]) << "\n";
+        break;
+
+    case TacOpcode::Label:
+        m_out << labelName(operands[0]) << ":\n";
+        break;
+
+    case TacOpcode::Param: {
+        int index = m_pendingParameters.size();
+        if (m_isReal[operands[0]]) {
+            loadReal("xmm0", operands[0]);
+            m_out << "    movss " << parameterSlot(index) << ", xmm0\n";
+        } else {
+            loadInt("eax", operands[0]);
+            m_out << "    mov " << parameterSlot(index) << ", eax\n";
+        }
+        m_pendingParameters.push_back(m_isReal[operands[0]]);
+        m_maxParameters = std::max(m_maxParameters, (int)m_pendingParameters.size());
+        break;
+    }
+
+    case TacOpcode::Call:
+        return emitCall(instruction);
+
+    case TacOpcode::Return:
+        m_out << "    jmp .Lreturn" << m_current << "\n";
+        break;
+
+    case TacOpcode::Check:
+        loadInt("eax", operands[0]);
+        m_out << "    cmp eax, " << location(operands[1]) << "\n";
+        m_out << "    jl __impasse_bounds_error\n";
+        m_out << "    cmp eax, " << location(operands[2]) << "\n";
+        m_out << "    jg __impasse_bounds_error\n";
+        m_checksBounds = true;
+        break;
+
+    case TacOpcode::Invalid:
+        break;
+    }
+
+    return true;
+}
+
+bool X86Emitter::emitCall(const TacInstruction &instruction)
+{
+    TacValue *target = m_module.value(instruction.operands[0]);
+    FunctionTacValue *callee = dynamic_cast<FunctionTacValue *>(target);
+
+    if (!callee) {
+        if (target->value() != "writeln") {
+            m_error = "call to unknown function '" + target->value() + "'";
+            return false;
+        }
+
+        emitWriteln();
+        m_pendingParameters.clear();
+        return true;
+    }
+
+    // convert the arguments to the declared parameter types; missing
+    // arguments read as zero, as they do in the interpreter
+    const std::vector<TacValue *> &parameters = callee->function->parameters;
+    for (size_t i = 0; i < parameters.size(); ++i) {
+        bool real = m_isReal[parameters[i]->index];
+
+        if (i >= m_pendingParameters.size()) {
+            m_out << "    mov " << parameterSlot(i) << ", 0\n";
+        } else if (real && !m_pendingParameters[i]) {
+            m_out << "    cvtsi2ss xmm0, " << parameterSlot(i) << "\n";
+            m_out << "    movss " << parameterSlot(i) << ", xmm0\n";
+        } else if (!real && m_pendingParameters[i]) {
+            m_out << "    cvttss2si eax, " << parameterSlot(i) << "\n";
+            m_out << "    mov " << parameterSlot(i) << ", eax\n";
+        }
+    }
+    m_maxParameters = std::max(m_maxParameters, (int)parameters.size());
+
+    m_out << "    call " << m_functions[m_indices[callee->function.get()]].symbol << "\n";
+    m_pendingParameters.clear();
+
+    return true;
+}
+
+void X86Emitter::emitWriteln()
+{
+    for (size_t i = 0; i < m_pendingParameters.size(); ++i) {
+        if (i > 0) {
+            m_out << "    mov edi, 32\n";
+            m_out << "    call putchar@PLT\n";
+        }
+
+        if (m_pendingParameters[i]) {
+            m_out << "    cvtss2sd xmm0, " << parameterSlot(i) << "\n";
+            m_out << "    lea rdi, [rip + .Lformat_real]\n";
+            m_out << "    mov eax, 1\n";
+        } else {
+            m_out << "    mov esi, " << parameterSlot(i) << "\n";
+            m_out << "    lea rdi, [rip + .Lformat_int]\n";
+            m_out << "    xor eax, eax\n";
+        }
+        m_out << "    call printf@PLT\n";
+    }
+
+    m_out << "    mov edi, 10\n";
+    m_out << "    call putchar@PLT\n";
+}
+
+bool X86Emitter::emitFunction(FunctionInfo &info)
+{
+    m_current = m_indices[info.function];
+    allocateRegisters(info);
+
+    int displaySlot = info.frameSlots + 1;
+    int frameSize = 8 * (info.frameSlots + 1 + info.savedRegisters.size());
+    frameSize = (frameSize + 15) & ~15;
+
+    m_out << "\n";
+    m_out << "    .type " << info.symbol << ", @function\n";
+    m_out << info.symbol << ":\n";
+    m_out << "    push rbp\n";
+    m_out << "    mov rbp, rsp\n";
+    m_out << "    sub rsp, " << frameSize << "\n";
+
+    for (size_t i = 0; i < info.savedRegisters.size(); ++i) {
+        m_out << "    mov QWORD PTR [rbp - " << 8 * (displaySlot + 1 + i) << "], " << kRegisters64[info.savedRegisters[i]] << "\n";
+        m_out << "    xor " << kRegisters[info.savedRegisters[i]] << ", " << kRegisters[info.savedRegisters[i]] << "\n";
+    }
+
+    // every run starts from zeroed globals, every call from a zeroed frame
+    if (info.level == 0 && m_globalSlots > 0) {
+        m_out << "    lea rdi, [rip + __impasse_globals]\n";
+        m_out << "    mov ecx, " << m_globalSlots << "\n";
+        m_out << "    xor eax, eax\n";
+        m_out << "    rep stosq\n";
+    } else if (info.level > 0 && info.frameSlots > kMaxUnrolledClear) {
+        m_out << "    lea rdi, [rbp - " << 8 * info.frameSlots << "]\n";
+        m_out << "    mov ecx, " << info.frameSlots << "\n";
+        m_out << "    xor eax, eax\n";
+        m_out << "    rep stosq\n";
+    } else if (info.level > 0) {
+        // rep stos has a start-up cost that dominates small frames
+        for (int i = 1; i <= info.frameSlots; ++i) {
+            m_out << "    mov QWORD PTR [rbp - " << 8 * i << "], 0\n";
+        }
+    }
+
+    if (info.level > 0) {
+        m_out << "    mov rax, QWORD PTR [rip + __impasse_display + " << 8 * info.level << "]\n";
+        m_out << "    mov QWORD PTR [rbp - " << 8 * displaySlot << "], rax\n";
+        m_out << "    mov QWORD PTR [rip + __impasse_display + " << 8 * info.level << "], rbp\n";
+    }
+
+    for (size_t i = 0; i < info.function->parameters.size(); ++i) {
+        int parameter = info.function->parameters[i]->index;
+
+        if (m_registers[parameter] >= 0) {
+            m_out << "    mov " << location(parameter) << ", " << parameterSlot(i) << "\n";
+        } else {
+            m_out << "    mov eax, " << parameterSlot(i) << "\n";
+            m_out << "    mov " << location(parameter) << ", eax\n";
+        }
+    }
+
+    for (std::vector<TacBasicBlockPtr>::iterator i = info.function->blocks.begin(); i != info.function->blocks.end(); ++i) {
+        m_out << labelName((*i)->label) << ":\n";
+
+        for (TacInstructions::iterator j = (*i)->code.begin(); j != (*i)->code.end(); ++j) {
+            if (!emitInstruction(*j)) {
+                return false;
+            }
+        }
+    }
+
+    m_out << ".Lreturn" << m_current << ":\n";
+
+    if (info.level > 0) {
+        m_out << "    mov rax, QWORD PTR [rbp - " << 8 * displaySlot << "]\n";
+        m_out << "    mov QWORD PTR [rip + __impasse_display + " << 8 * info.level << "], rax\n";
+    }
+
+    for (size_t i = 0; i < info.savedRegisters.size(); ++i) {
+        m_out << "    mov " << kRegisters64[info.savedRegisters[i]] << ", QWORD PTR [rbp - " << 8 * (displaySlot + 1 + i) << "]\n";
+    }
+
+    m_out << "    leave\n";
+    m_out << "    ret\n";
+    m_out << "    .size " << info.symbol << ", .-" << info.symbol << "\n";
+
+    return true;
+}
+
+// main([runs]) runs the program the given number of times, once by default.
+void X86Emitter::emitMain()
+{
+    m_out << "\n";
+    m_out << "    .globl main\n";
+    m_out << "    .type main, @function\n";
+    m_out << "main:\n";
+    m_out << "    push rbp\n";
+    m_out << "    mov rbp, rsp\n";
+    m_out << "    push rbx\n";
+    m_out << "    sub rsp, 8\n";
+    m_out << "    mov ebx, 1\n";
+    m_out << "    cmp edi, 2\n";
+    m_out << "    jl .Lmain_loop\n";
+    m_out << "    mov rdi, QWORD PTR [rsi + 8]\n";
+    m_out << "    call atoi@PLT\n";
+    m_out << "    mov ebx, eax\n";
+    m_out << ".Lmain_loop:\n";
+    m_out << "    test ebx, ebx\n";
+    m_out << "    jle .Lmain_done\n";
+    m_out << "    call __impasse_program\n";
+    m_out << "    dec ebx\n";
+    m_out << "    jmp .Lmain_loop\n";
+    m_out << ".Lmain_done:\n";
+    m_out << "    xor eax, eax\n";
+    m_out << "    mov rbx, QWORD PTR [rbp - 8]\n";
+    m_out << "    leave\n";
+    m_out << "    ret\n";
+    m_out << "    .size main, .-main\n";
+}
+
+// Where a failed CHECK jumps to. The stack is aligned as it is anywhere in
+// a function body; exit() flushes what the program wrote so far.
+void X86Emitter::emitBoundsError()
+{
+    m_out << "\n";
+    m_out << "    .type __impasse_bounds_error, @function\n";
+    m_out << "__impasse_bounds_error:\n";
+    m_out << "    mov edi, 2\n";
+    m_out << "    lea rsi, [rip + .Lbounds_message]\n";
+    m_out << "    mov edx, .Lbounds_message_end - .Lbounds_message\n";
+    m_out << "    call write@PLT\n";
+    m_out << "    mov edi, 1\n";
+    m_out << "    call exit@PLT\n";
+    m_out << "    .size __impasse_bounds_error, .-__impasse_bounds_error\n";
+}
+
+void X86Emitter::emitData()
+{
+    int maxLevel = 0;
+    for (std::vector<FunctionInfo>::iterator i = m_functions.begin(); i != m_functions.end(); ++i) {
+        maxLevel = std::max(maxLevel, i->level);
+    }
+
+    m_out << "\n";
+    m_out << "    .section .rodata\n";
+    m_out << ".Lformat_int:\n";
+    m_out << "    .string \"%d\"\n";
+    m_out << ".Lformat_real:\n";
+    m_out << "    .string \"%g\"\n";
+    if (m_checksBounds) {
+        m_out << ".Lbounds_message:\n";
+        m_out << "    .ascii \"Runtime error: index out of range\\n\"\n";
+        m_out << ".Lbounds_message_end:\n";
+    }
+    m_out << "    .align 4\n";
+
+    for (std::vector<TacValuePtr>::const_iterator i = m_module.values.begin(); i != m_module.values.end(); ++i) {
+        if (ConstRealTacValue *realValue = dynamic_cast<ConstRealTacValue *>(i->get())) {
+            unsigned int bits;
+            std::memcpy(&bits, &realValue->realValue, sizeof(bits));
+            m_out << ".Lreal" << (*i)->index << ":\n";
+            m_out << "    .long " << bits << "\n";
+        }
+    }
+
+    m_out << "\n";
+    m_out << "    .bss\n";
+    m_out << "    .align 8\n";
+    m_out << "__impasse_globals:\n";
+    m_out << "    .zero " << 8 * std::max(m_globalSlots, 1) << "\n";
+    m_out << "__impasse_display:\n";
+    m_out << "    .zero " << 8 * (maxLevel + 1) << "\n";
+    m_out << "__impasse_parameters:\n";
+    m_out << "    .zero " << 8 * std::max(m_maxParameters, 1) << "\n";
+    m_out << "\n";
+    m_out << "    .section .note.GNU-stack,\"\",@progbits\n";
+}
+
+bool X86Emitter::emit()
+{
+    assignStorage();
+    inferTypes();
+
+    m_out << "    .intel_syntax noprefix\n";
+    m_out << "    .text\n";
+
+    for (std::vector<FunctionInfo>::iterator i = m_functions.begin(); i != m_functions.end(); ++i) {
+        if (!emitFunction(*i)) {
+            return false;
+        }
+    }
+
+    emitMain();
+    if (m_checksBounds) {
+        emitBoundsError();
+    }
+    emitData();
+
+    return true;
+}
+
+std::string X86Builder::output()
+{
+    std::stringstream ss;
+    X86Emitter emitter(*module(), ss);
+
+    if (!emitter.emit()) {
+        std::cerr << "x86 backend: " << emitter.error() << std::endl;
+        return std::string();
+    }
+
+    return ss.str();
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "TacBuilder.h"
+
+#include <string>
+
+// Builds the same TAC IR as TacBuilder, so the pass pipeline still applies,
+// but renders it as x86-64 assembly (GNU as, Intel syntax, System V ABI).
+// Integers that are only touched by their own function are kept in
+// callee-saved registers chosen by a linear scan over live intervals;
+// reals and values shared with nested functions live in memory.
+//
+// The generated main() takes an optional repeat count, which is what
+// --bench is to the interpreter:
+//
+//     impasse --x86 < fact.pas > fact.s && cc fact.s -o fact && ./fact 1000
+class X86Builder : public TacBuilder
+{
+public:
+    virtual std::string output();
+};
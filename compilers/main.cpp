@@ -1,27 +1,379 @@
+#include "BatchCompiler.h"
+#include "CompileReport.h"
+#include "CompileServer.h"
 #include "Lexer.h"
 #include "Parser.h"
+#include "SymbolTable.h"
 #include "TacBuilder.h"
+#include "TacInterpreter.h"
+#include "TacOptimizations.h"
+#include "TacLiveness.h"
+#include "TacObject.h"
+#include "TacPass.h"
+#include "TacSsa.h"
+#include "ThreadPool.h"
 #include "Token.h"
+#include "X86Builder.h"
 
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/shared_ptr.hpp>
 
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static void printStatistics(boost::shared_ptr<TacBuilder> builder)
+{
+    const TacModule::Statistics &statistics = builder->module()->statistics;
+
+    std::cerr << "symbol lookups:       " << statistics.symbolLookups << std::endl;
+    std::cerr << "symbol scope probes:  " << statistics.symbolProbes << std::endl;
+    std::cerr << "interned identifiers: " << SymbolTable::instance().size() << std::endl;
+}
+
+// For each function: the CFG with its dominators, live sets and the phis
+// SSA construction would place. Builds and tears down SSA on the way.
+static void dumpCfg(TacModule &module)
+{
+    std::vector<TacFunction *> functions;
+    module.collectFunctions(functions);
+
+    for (std::vector<TacFunction *>::iterator i = functions.begin(); i != functions.end(); ++i) {
+        std::cerr << "function " << ((*i)->name.empty() ? "<program>" : (*i)->name) << std::endl;
+
+        TacCfg cfg(**i);
+        cfg.output(std::cerr);
+        TacLiveness(cfg).output(std::cerr);
+
+        TacSsa ssa(**i);
+        ssa.construct();
+        ssa.output(std::cerr);
+        ssa.destroy();
+    }
+}
+
+static bool runProgram(boost::shared_ptr<TacBuilder> builder, int benchmarkRuns)
+{
+    TacInterpreter interpreter(builder->module());
+
+    if (benchmarkRuns <= 0) {
+        if (!interpreter.run(std::cout)) {
+            std::cerr << "Runtime error: " << interpreter.error() << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    // program output is discarded while benchmarking
+    std::ostream discard(0);
+
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+    unsigned long long instructions = 0;
+
+    for (int i = 0; i < benchmarkRuns; ++i) {
+        if (!interpreter.run(discard)) {
+            std::cerr << "Runtime error: " << interpreter.error() << std::endl;
+            return false;
+        }
+
+        instructions += interpreter.instructionsExecuted();
+    }
+
+    boost::posix_time::time_duration elapsed = boost::posix_time::microsec_clock::universal_time() - start;
+    double nanoseconds = elapsed.total_microseconds() * 1000.0;
+
+    std::cerr << "runs:                 " << benchmarkRuns << std::endl;
+    std::cerr << "instructions per run: " << interpreter.instructionsExecuted() << std::endl;
+    std::cerr << "instructions total:   " << instructions << std::endl;
+    std::cerr << "time:                 " << nanoseconds / 1e6 << " ms" << std::endl;
+    std::cerr << "ns per instruction:   " << (instructions ? nanoseconds / instructions : 0.0) << std::endl;
+
+    return true;
+}
+
+// "@list" names a file listing one input per line
+static bool addInputs(const std::string &arg, std::vector<std::string> &files)
+{
+    if (arg.empty() || arg[0] != '@') {
+        files.push_back(arg);
+        return true;
+    }
+
+    std::ifstream list(arg.c_str() + 1);
+    if (!list) {
+        std::cerr << "cannot open " << arg.substr(1) << std::endl;
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(list, line)) {
+        if (!line.empty()) {
+            files.push_back(line);
+        }
+    }
+
+    return true;
+}
+
+static bool runBatch(const BatchCompiler::Options &options, const std::vector<std::string> &files)
+{
+    boost::posix_time::ptime start = boost::posix_time::microsec_clock::universal_time();
+
+    BatchCompiler compiler(options);
+    bool succeeded = compiler.compile(files, std::cerr);
+
+    boost::posix_time::time_duration elapsed = boost::posix_time::microsec_clock::universal_time() - start;
+
+    std::cerr << files.size() << " files: " << compiler.compiledCount() << " compiled, "
+              << compiler.cachedCount() << " cached, " << compiler.failedCount() << " failed in "
+              << elapsed.total_milliseconds() << " ms" << std::endl;
+
+    return succeeded;
+}
+
+// Scans the whole input once on its own, since the parser pulls tokens as
+// it goes, and counts the tokens.
+static unsigned long long scanTokens(Lexer &lexer)
+{
+    unsigned long long tokens = 0;
+
+    while (lexer.nextToken().tokenType() != TokenType::Eof) {
+        ++tokens;
+    }
+
+    return tokens;
+}
 
 int main(int argc, char const *argv[])
 {
-    boost::shared_ptr<Lexer> lexer(new Lexer);
+    bool showStatistics = false;
+    bool ssa = false;
+    bool showCfg = false;
+    bool run = false;
+    bool emitX86 = false;
+    bool emitObject = false;
+    bool boundsCheck = false;
+    // "", "text" or "json"
+    std::string timeReport;
+    int benchmarkRuns = 0;
+    int optimizationLevel = 0;
+    // -1 until -j is given
+    int jobs = -1;
+    // syntax errors written out; the rest are only counted
+    int maxErrors = 100;
+    std::string lexerKind = "dfa";
+    bool batch = false;
+    bool server = false;
+    std::string cacheDirectory = ".impasse-cache";
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+
+        if (arg == "--stats") {
+            showStatistics = true;
+        } else if (arg == "--ssa") {
+            ssa = true;
+        } else if (arg == "--dump-cfg") {
+            showCfg = true;
+        } else if (arg == "-O0") {
+            optimizationLevel = 0;
+        } else if (arg == "-O1") {
+            optimizationLevel = 1;
+        } else if (arg == "--x86") {
+            emitX86 = true;
+        } else if (arg == "--time-report" || arg == "--time-report=text" || arg == "--time-report=json") {
+            timeReport = arg == "--time-report=json" ? "json" : "text";
+        } else if (arg == "--object") {
+            emitObject = true;
+        } else if (arg == "--bounds-check") {
+            boundsCheck = true;
+        } else if (arg == "-j" && i + 1 < argc) {
+            jobs = std::atoi(argv[++i]);
+        } else if (arg == "--max-errors" && i + 1 < argc) {
+            maxErrors = std::atoi(argv[++i]);
+        } else if (arg == "--lexer" && i + 1 < argc) {
+            lexerKind = argv[++i];
+        } else if (arg == "--batch") {
+            batch = true;
+        } else if (arg == "--server") {
+            server = true;
+        } else if (arg == "--cache" && i + 1 < argc) {
+            cacheDirectory = argv[++i];
+        } else if (arg == "--no-cache") {
+            cacheDirectory.clear();
+        } else if (batch && arg[0] != '-') {
+            if (!addInputs(arg, files)) {
+                return 1;
+            }
+        } else if (arg == "--run") {
+            run = true;
+        } else if (arg == "--bench" && i + 1 < argc) {
+            run = true;
+            benchmarkRuns = std::atoi(argv[++i]);
+        } else {
+            std::cerr << "usage: " << argv[0] << " [-O0|-O1] [--ssa] [--stats] [--dump-cfg] [--x86|--object] [--bounds-check] [--lexer dfa|flex] [--max-errors N] [-j N] [--run [--bench N]] [--time-report[=json]] < program.pas" << std::endl;
+            std::cerr << "       " << argv[0] << " --batch [-O0|-O1] [--x86] [--bounds-check] [--lexer dfa|flex] [-j N] [--cache DIR|--no-cache] file.pas|@list..." << std::endl;
+            std::cerr << "       " << argv[0] << " --server [-O0|-O1] [--x86] [--bounds-check] [--lexer dfa|flex] [--max-errors N]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<std::string> kinds = Lexer::kinds();
+    if (std::find(kinds.begin(), kinds.end(), lexerKind) == kinds.end()) {
+        std::cerr << "unknown or unavailable lexer: " << lexerKind << std::endl;
+        return 1;
+    }
+
+    if (batch) {
+        // files are the unit of parallelism here, so -j defaults to every core
+        BatchCompiler::Options options;
+        options.optimizationLevel = optimizationLevel;
+        options.emitX86 = emitX86;
+        options.boundsCheck = boundsCheck;
+        options.lexerKind = lexerKind;
+        options.cacheDirectory = cacheDirectory;
+        options.jobs = jobs < 0 ? 0 : jobs;
+
+        return runBatch(options, files) ? 0 : 1;
+    }
+
+    if (server) {
+        // requests on stdin, answers on stdout; see CompileServer.h
+        CompileServer::Options options;
+        options.optimizationLevel = optimizationLevel;
+        options.emitX86 = emitX86;
+        options.boundsCheck = boundsCheck;
+        options.lexerKind = lexerKind;
+        options.maxErrors = maxErrors;
+
+        CompileServer compileServer(options);
+        return compileServer.serve(std::cin, std::cout) ? 0 : 1;
+    }
+
+    boost::scoped_ptr<CompileReport> report(timeReport.empty() ? 0 : new CompileReport);
+    if (report) {
+        enableHeapCounting();
+    }
+
+    // with a report the input is read up front, so that reading, scanning
+    // and parsing are timed apart
+    std::string source;
+    std::istringstream input;
+    if (report) {
+        ScopedPhase phase(report.get(), "read");
+        source.assign(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+        input.str(source);
+    }
+
+    boost::shared_ptr<Lexer> lexer(Lexer::create(lexerKind, report ? &input : 0));
     boost::shared_ptr<Parser> parser(new Parser);
-    boost::shared_ptr<TacBuilder> builder(new TacBuilder);
+    parser->setMaxReportedErrors(maxErrors);
+    boost::shared_ptr<TacBuilder> builder(emitX86 ? new X86Builder : new TacBuilder);
+    builder->setBoundsChecking(boundsCheck);
+
+    // -j 0 uses every hardware thread
+    if (jobs != -1 && jobs != 1) {
+        builder->setThreadPool(boost::shared_ptr<ThreadPool>(new ThreadPool(jobs)));
+    }
+
+    if (report) {
+        unsigned long long tokens;
+        {
+            ScopedPhase phase(report.get(), "lex");
+            tokens = scanTokens(*lexer);
+        }
+
+        double seconds = report->milliseconds("lex") / 1000.0;
+
+        report->setCount("source_bytes", source.size());
+        report->setCount("tokens", tokens);
+        report->setCount("tokens_per_second", seconds > 0 ? (unsigned long long)(tokens / seconds) : 0);
+
+        input.clear();
+        input.str(source);
+        lexer->reset(&input);
+    }
+
+    int result = 0;
+    ProgramPtr program;
+    {
+        ScopedPhase phase(report.get(), "parse");
+        program = parser->parse(lexer);
+    }
 
-    ProgramPtr program = parser->parse(lexer);
+    if (report) {
+        report->setCount("ast_nodes", parser->arena().objectCount());
+        report->setCount("ast_bytes", parser->arena().bytesAllocated());
+    }
+
+    if (parser->errorCount() == 0) {
+        ScopedPhase phase(report.get(), "codegen");
+        program->codegen(builder);
+    }
 
     if (parser->errorCount() > 0) {
         std::cout << "Number of errors: " << parser->errorCount() << std::endl;
+    } else if (builder->errorCount() > 0) {
+        std::cout << builder->diagnostics();
+        std::cout << "Number of errors: " << builder->errorCount() << std::endl;
     } else {
-        program->codegen(builder);
+        TacPassManager passes;
+        passes.setReport(report.get());
+        if (optimizationLevel >= 1) {
+            addO1Passes(passes);
+        }
+        if (ssa) {
+            passes.add(TacPassPtr(new SsaRoundTripPass));
+        }
+        passes.run(*builder->module());
+
+        if (report) {
+            report->setCount("tac_instructions", TacPassManager::countInstructions(*builder->module()));
+            report->setCount("tac_values", builder->module()->values.size());
+        }
+
+        if (showCfg) {
+            dumpCfg(*builder->module());
+        }
+
+        if (run) {
+            ScopedPhase phase(report.get(), "run");
+            if (!runProgram(builder, benchmarkRuns)) {
+                result = 1;
+            }
+        } else if (emitObject) {
+            ScopedPhase phase(report.get(), "output");
+            // the text form reads back with impasse_tac --to-object
+            if (!writeTacObject(*builder->module(), std::cout)) {
+                std::cerr << "cannot write the TAC object" << std::endl;
+                result = 1;
+            }
+        } else {
+            ScopedPhase phase(report.get(), "output");
+            std::cout << builder->output() << std::endl;
+        }
+
+        if (showStatistics) {
+            printStatistics(builder);
+            passes.report(std::cerr);
+        }
+    }
 
-        std::cout << builder->output() << std::endl;
+    if (report) {
+        if (timeReport == "json") {
+            report->outputJson(std::cerr);
+        } else {
+            report->output(std::cerr);
+        }
     }
 
-	return 0;
+	return result;
 }
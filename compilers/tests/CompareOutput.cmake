@@ -0,0 +1,17 @@
+# Runs PROGRAM with ARGS on INPUT and compares what it writes to EXPECTED.
+# Timings differ from run to run, so the us= of the server's answers is
+# left out of both.
+separate_arguments(arguments UNIX_COMMAND "${ARGS}")
+
+execute_process(COMMAND ${PROGRAM} ${arguments}
+    INPUT_FILE ${INPUT}
+    OUTPUT_VARIABLE output
+    ERROR_VARIABLE output)
+
+file(READ ${EXPECTED} expected)
+string(REGEX REPLACE " us=[0-9]+" "" output "${output}")
+string(REGEX REPLACE " us=[0-9]+" "" expected "${expected}")
+
+if(NOT output STREQUAL expected)
+    message(FATAL_ERROR "${INPUT} gave\n${output}\ninstead of\n${expected}")
+endif()
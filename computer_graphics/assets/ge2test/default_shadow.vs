@@ -3,6 +3,10 @@
 in vec4 ge_position;
 in vec3 ge_normal;
 in vec2 ge_textureCoordinates;
+// the identity unless the mesh is drawn instanced; the renderer instances
+// only rigid or uniformly scaled nodes, so its upper 3x3 also transforms
+// normals
+in mat4 ge_instanceModel;
 
 uniform mat4 ge_modelViewProjection;
 uniform mat4 ge_modelView;
@@ -17,10 +21,12 @@ out vec4 positionLight1;
 
 void main()
 {
-	gl_Position = ge_modelViewProjection * ge_position;
+	vec4 modelPosition = ge_instanceModel * ge_position;
+
+	gl_Position = ge_modelViewProjection * modelPosition;
 
 	textureCoordinates = ge_textureCoordinates;
-	normal = normalize(ge_normalMatrix * ge_normal);
-	position = (ge_modelView * ge_position).xyz;
-	positionLight1 = ge_modelViewProjectionLight1 * ge_position;
+	normal = normalize(ge_normalMatrix * mat3(ge_instanceModel) * ge_normal);
+	position = (ge_modelView * modelPosition).xyz;
+	positionLight1 = ge_modelViewProjectionLight1 * modelPosition;
 }
@@ -0,0 +1,6 @@
+// Set by the renderer once for each pass, see ge2::FrameProperties.
+layout(std140) uniform ge_Frame {
+	mat3 ge_viewMatrixLinear;
+	mat3 ge_viewMatrixLinearInverse;
+	float ge_totalSeconds;
+};
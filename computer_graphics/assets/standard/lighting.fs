@@ -30,15 +30,12 @@ in vec3 position;
 in vec4 positionLight1;
 in vec4 positionLight2;
 
-uniform float ge_oneOverShadowMapResolution;
 uniform sampler2D ge_shadowMap1;
 uniform samplerCube ge_shadowCubeMap1;
-uniform float ge_shadowBias1;
-uniform float ge_shadowFarPlane1;
 uniform sampler2D ge_shadowMap2;
 uniform samplerCube ge_shadowCubeMap2;
-uniform float ge_shadowBias2;
-uniform float ge_shadowFarPlane2;
+
+#ge_include "standard/shadows.glsl"
 
 uniform MaterialProperties ge_materialProperties;
 uniform float ge_specularStrength;
@@ -0,0 +1,8 @@
+// Set by the renderer once a frame, see ge2::ShadowProperties.
+layout(std140) uniform ge_Shadows {
+	float ge_shadowBias1;
+	float ge_shadowFarPlane1;
+	float ge_shadowBias2;
+	float ge_shadowFarPlane2;
+	float ge_oneOverShadowMapResolution;
+};
@@ -11,11 +11,13 @@
 #include "ge2fsquad.h"
 #include "ge2gamestate.h"
 #include "ge2geometry.h"
+#include "ge2glstate.h"
 #include "ge2material.h"
 #include "ge2mesh.h"
 #include "ge2node.h"
 #include "ge2posteffects.h"
 #include "ge2renderer.h"
+#include "ge2renderqueue.h"
 #include "ge2resourcemgr.h"
 #include "ge2shader.h"
 #include "ge2texture2d.h"
@@ -28,7 +28,9 @@ enum class ShaderAttribute : GLint
 {
 	VertexPosition,
 	VertexTextureCoordinates,
-	VertexNormals
+	VertexNormals,
+	// a mat4, which takes this location and the three after it
+	InstanceModel
 };
 
 enum class FragmentBuffer : GLint
@@ -43,10 +45,35 @@ enum class FragmentBuffer : GLint
 enum class StandardUniformBlocks : GLint
 {
 	Lights,
+	Frame,
+	Shadows,
 
 	User
 };
 
+// The ge_* uniforms every shader is queried for, in the order of their
+// names in ge2shader.cpp. Each one's value is also its uniform handle.
+enum class StandardUniform : GLint
+{
+	MaterialAmbient,
+	MaterialDiffuse,
+	MaterialEmission,
+	MaterialShininess,
+	MaterialSpecular,
+	ModelView,
+	ModelViewProjection,
+	ModelViewProjectionLight1,
+	ModelViewProjectionLight2,
+	NormalMatrix,
+	ShadowCubeMap1,
+	ShadowCubeMap2,
+	ShadowMap1,
+	ShadowMap2,
+	SpecularStrength,
+
+	NumUniforms
+};
+
 enum class CubeDirection : GLint
 {
 	PositiveX,
@@ -59,6 +86,17 @@ enum class CubeDirection : GLint
 	NumDirections
 };
 
+// What the renderer changed in GL state over one frame, see
+// Renderer::frameStats().
+struct RenderStats
+{
+	int drawCalls = 0;
+	int programChanges = 0;
+	int textureBinds = 0;
+	int stateChanges = 0;
+	int filteredCalls = 0;
+};
+
 enum {
 	kTextureColor         = (1 << 0),
 	kTextureDepth         = (1 << 1),
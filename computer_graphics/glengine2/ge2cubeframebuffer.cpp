@@ -1,6 +1,7 @@
 #include "ge2cubeframebuffer.h"
 #include "ge2camera.h"
 #include "ge2cubemap.h"
+#include "ge2glstate.h"
 
 using namespace ge2;
 
@@ -49,7 +50,7 @@ void CubeFramebuffer::construct(int size, bool depthBufferEnabled, const std::ve
 	m_camera = new PerspectiveCamera{fov, 1.0f, 0.001f, 1000.0f};
 
 	glGenFramebuffers(1, &m_frameBuffer);
-	glBindFramebuffer(GL_FRAMEBUFFER, m_frameBuffer);
+	GLState::bindFramebuffer(m_frameBuffer);
 
 	if (depthBufferEnabled) {
 		m_depthBuffer = new Cubemap;
@@ -74,7 +75,7 @@ void CubeFramebuffer::construct(int size, bool depthBufferEnabled, const std::ve
 		glDrawBuffer(GL_NONE);
 	}
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	GLState::bindFramebuffer(0);
 }
 
 void CubeFramebuffer::destruct()
@@ -90,7 +91,7 @@ void CubeFramebuffer::destruct()
 		m_colorBuffers[i] = nullptr;
 	}
 
-	glDeleteFramebuffers(1, &m_frameBuffer);
+	GLState::deleteFramebuffer(m_frameBuffer);
 
 	m_size = -1;
 
@@ -180,9 +181,9 @@ void CubeFramebuffer::setPosition(const glm::vec3 &position)
 
 void CubeFramebuffer::bind(CubeDirection direction)
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, m_frameBuffer);
-	glGetIntegerv(GL_VIEWPORT, m_storedViewport);
-	glViewport(0, 0, m_size, m_size);
+	GLState::bindFramebuffer(m_frameBuffer);
+	GLState::getViewport(m_storedViewport);
+	GLState::viewport(0, 0, m_size, m_size);
 
 	if (m_depthBuffer) {
 		glFramebufferTexture2D(
@@ -209,8 +210,8 @@ void CubeFramebuffer::bind(CubeDirection direction)
 
 void CubeFramebuffer::unbind()
 {
-	glViewport(m_storedViewport[0], m_storedViewport[1], m_storedViewport[2], m_storedViewport[3]);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	GLState::viewport(m_storedViewport[0], m_storedViewport[1], m_storedViewport[2], m_storedViewport[3]);
+	GLState::bindFramebuffer(0);
 }
 
 void CubeFramebuffer::update(CubeFramebufferRenderFunction renderFunction)
@@ -1,4 +1,5 @@
 #include "ge2cubemap.h"
+#include "ge2glstate.h"
 
 using namespace ge2;
 
@@ -27,7 +28,7 @@ void Cubemap::construct(int size, int flags)
 	m_size = size;
 
 	glGenTextures(1, &m_cubemap);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, m_cubemap);
+	GLState::bindTexture(GL_TEXTURE_CUBE_MAP, m_cubemap);
 
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -48,21 +49,26 @@ void Cubemap::construct(int size, int flags)
 		}
 	}
 
-	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+	GLState::bindTexture(GL_TEXTURE_CUBE_MAP, 0);
 }
 
 void Cubemap::destruct()
 {
-	glDeleteTextures(1, &m_cubemap);
+	GLState::deleteTexture(m_cubemap);
 	m_size = 0;
 }
 
 void Cubemap::bind()
 {
-	glBindTexture(GL_TEXTURE_CUBE_MAP, m_cubemap);
+	GLState::bindTexture(GL_TEXTURE_CUBE_MAP, m_cubemap);
+}
+
+void Cubemap::bind(int unit)
+{
+	GLState::bindTexture(unit, GL_TEXTURE_CUBE_MAP, m_cubemap);
 }
 
 void Cubemap::unbind()
 {
-	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+	GLState::bindTexture(GL_TEXTURE_CUBE_MAP, 0);
 }
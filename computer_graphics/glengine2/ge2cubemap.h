@@ -18,6 +18,7 @@ public:
 	int size() const { return m_size; }
 
 	void bind();
+	void bind(int unit);
 	void unbind();
 
 private:
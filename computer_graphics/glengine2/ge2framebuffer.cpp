@@ -1,4 +1,5 @@
 #include "ge2framebuffer.h"
+#include "ge2glstate.h"
 #include "ge2texture2d.h"
 
 using namespace ge2;
@@ -31,7 +32,7 @@ void Framebuffer::construct(int width, int height, bool depthBufferEnabled, cons
 	m_height = height;
 
 	glGenFramebuffers(1, &m_frameBuffer);
-	glBindFramebuffer(GL_FRAMEBUFFER, m_frameBuffer);
+	GLState::bindFramebuffer(m_frameBuffer);
 
 	if (depthBufferEnabled) {
 		m_depthBuffer = new Texture2D;
@@ -59,7 +60,7 @@ void Framebuffer::construct(int width, int height, bool depthBufferEnabled, cons
 		glDrawBuffer(GL_NONE);
 	}
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	GLState::bindFramebuffer(0);
 }
 
 void Framebuffer::destruct()
@@ -72,7 +73,7 @@ void Framebuffer::destruct()
 		m_colorBuffers[i] = nullptr;
 	}
 
-	glDeleteFramebuffers(1, &m_frameBuffer);
+	GLState::deleteFramebuffer(m_frameBuffer);
 
 	m_width = -1;
 	m_height = -1;
@@ -82,15 +83,15 @@ void Framebuffer::destruct()
 
 void Framebuffer::bind()
 {
-	glBindFramebuffer(GL_FRAMEBUFFER, m_frameBuffer);
-	glGetIntegerv(GL_VIEWPORT, m_storedViewport);
-	glViewport(0, 0, m_width, m_height);
+	GLState::bindFramebuffer(m_frameBuffer);
+	GLState::getViewport(m_storedViewport);
+	GLState::viewport(0, 0, m_width, m_height);
 }
 
 void Framebuffer::unbind()
 {
-	glViewport(m_storedViewport[0], m_storedViewport[1], m_storedViewport[2], m_storedViewport[3]);
-	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	GLState::viewport(m_storedViewport[0], m_storedViewport[1], m_storedViewport[2], m_storedViewport[3]);
+	GLState::bindFramebuffer(0);
 }
 
 void Framebuffer::swap(Framebuffer &other)
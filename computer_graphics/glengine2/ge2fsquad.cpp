@@ -1,5 +1,6 @@
 #include "ge2fsquad.h"
 #include "ge2geometry.h"
+#include "ge2glstate.h"
 #include "ge2material.h"
 #include "ge2resourcemgr.h"
 #include "ge2shader.h"
@@ -54,7 +55,7 @@ FullscreenQuad::FullscreenQuad(FullscreenQuad &&rhs)
 FullscreenQuad::~FullscreenQuad()
 {
 	glDeleteBuffers(1, &m_indexBuffer);
-	glDeleteVertexArrays(1, &m_vertexArray);
+	GLState::deleteVertexArray(m_vertexArray);
 	glDeleteBuffers(1, &m_vertexBuffer);
 }
 
@@ -81,17 +82,15 @@ void FullscreenQuad::setMaterial(Material *material)
 
 void FullscreenQuad::draw()
 {
-	glBindVertexArray(m_vertexArray);
+	GLState::bindVertexArray(m_vertexArray);
 
 	glDrawElements(GL_TRIANGLES, kFullscreenQuadIndices.size(), GL_UNSIGNED_SHORT, 0);
-
-	glBindVertexArray(0);
 }
 
 void FullscreenQuad::construct()
 {
 	glGenVertexArrays(1, &m_vertexArray);
-	glBindVertexArray(m_vertexArray);
+	GLState::bindVertexArray(m_vertexArray);
 
 	// Fill vertex position data
 	glGenBuffers(1, &m_vertexBuffer);
@@ -108,7 +107,7 @@ void FullscreenQuad::construct()
 
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, kFullscreenQuadIndices.size() * sizeof(uint32_t), kFullscreenQuadIndices.data(), GL_STATIC_DRAW);
 
-	glBindVertexArray(0);
+	GLState::bindVertexArray(0);
 }
 
 void FullscreenQuad::swap(FullscreenQuad &other)
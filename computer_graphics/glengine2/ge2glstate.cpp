@@ -0,0 +1,299 @@
+#include "ge2glstate.h"
+
+#include <algorithm>
+
+using namespace ge2;
+
+namespace {
+
+const GLuint kUnknown = ~0u;
+const int kUnknownUnit = -1;
+// GL 3.2 guarantees 48 combined units
+const int kMaxTextureUnits = 48;
+
+enum Capability
+{
+	kCapabilityBlend,
+	kCapabilityCullFace,
+	kCapabilityDepthTest,
+	kCapabilityScissorTest,
+	kCapabilityStencilTest,
+	kCapabilityTextureCubeMapSeamless,
+
+	kNumCapabilities
+};
+
+enum TextureTarget
+{
+	kTextureTarget2D,
+	kTextureTargetCubeMap,
+
+	kNumTextureTargets
+};
+
+struct State
+{
+	GLuint capabilities[kNumCapabilities];
+	GLuint depthFunc;
+	GLuint cullFace;
+	GLuint program;
+	GLuint vertexArray;
+	GLuint framebuffer;
+	int    activeUnit;
+	GLuint textures[kMaxTextureUnits][kNumTextureTargets];
+	GLint  viewport[4];
+	bool   viewportKnown;
+
+	RenderStats stats;
+};
+
+State state;
+bool stateInitialized = false;
+
+State &current()
+{
+	if (!stateInitialized) {
+		GLState::invalidate();
+	}
+	return state;
+}
+
+int capabilityIndex(GLenum capability)
+{
+	switch (capability) {
+	case GL_BLEND:                      return kCapabilityBlend;
+	case GL_CULL_FACE:                  return kCapabilityCullFace;
+	case GL_DEPTH_TEST:                 return kCapabilityDepthTest;
+	case GL_SCISSOR_TEST:               return kCapabilityScissorTest;
+	case GL_STENCIL_TEST:               return kCapabilityStencilTest;
+	case GL_TEXTURE_CUBE_MAP_SEAMLESS:  return kCapabilityTextureCubeMapSeamless;
+	default:                            return -1;
+	}
+}
+
+int textureTargetIndex(GLenum target)
+{
+	switch (target) {
+	case GL_TEXTURE_2D:       return kTextureTarget2D;
+	case GL_TEXTURE_CUBE_MAP: return kTextureTargetCubeMap;
+	default:                  return -1;
+	}
+}
+
+// Returns whether the call has to be made, and counts it either way
+bool changes(GLuint &cached, GLuint value, int &counter)
+{
+	if (cached == value) {
+		++state.stats.filteredCalls;
+		return false;
+	}
+
+	cached = value;
+	++counter;
+	return true;
+}
+
+void forget(GLuint &cached, GLuint name)
+{
+	if (cached == name) {
+		cached = kUnknown;
+	}
+}
+
+}
+
+void GLState::setEnabled(GLenum capability, bool enabled)
+{
+	State &s = current();
+
+	int index = capabilityIndex(capability);
+	if (index >= 0 && !changes(s.capabilities[index], enabled, s.stats.stateChanges)) {
+		return;
+	}
+
+	if (enabled) {
+		glEnable(capability);
+	} else {
+		glDisable(capability);
+	}
+}
+
+void GLState::depthFunc(GLenum func)
+{
+	State &s = current();
+	if (changes(s.depthFunc, func, s.stats.stateChanges)) {
+		glDepthFunc(func);
+	}
+}
+
+void GLState::cullFace(GLenum mode)
+{
+	State &s = current();
+	if (changes(s.cullFace, mode, s.stats.stateChanges)) {
+		glCullFace(mode);
+	}
+}
+
+void GLState::useProgram(GLuint program)
+{
+	State &s = current();
+	if (changes(s.program, program, s.stats.programChanges)) {
+		glUseProgram(program);
+	}
+}
+
+void GLState::bindVertexArray(GLuint vertexArray)
+{
+	State &s = current();
+	if (changes(s.vertexArray, vertexArray, s.stats.stateChanges)) {
+		glBindVertexArray(vertexArray);
+	}
+}
+
+void GLState::bindFramebuffer(GLuint framebuffer)
+{
+	State &s = current();
+	if (changes(s.framebuffer, framebuffer, s.stats.stateChanges)) {
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	}
+}
+
+void GLState::activeTexture(int unit)
+{
+	State &s = current();
+	if (s.activeUnit == unit) {
+		++s.stats.filteredCalls;
+		return;
+	}
+
+	s.activeUnit = unit;
+	++s.stats.stateChanges;
+	glActiveTexture(GL_TEXTURE0 + unit);
+}
+
+void GLState::bindTexture(GLenum target, GLuint texture)
+{
+	State &s = current();
+
+	int index = textureTargetIndex(target);
+	if (index >= 0 && s.activeUnit >= 0 && s.activeUnit < kMaxTextureUnits) {
+		if (!changes(s.textures[s.activeUnit][index], texture, s.stats.textureBinds)) {
+			return;
+		}
+	} else {
+		++s.stats.textureBinds;
+	}
+
+	glBindTexture(target, texture);
+}
+
+void GLState::bindTexture(int unit, GLenum target, GLuint texture)
+{
+	State &s = current();
+
+	int index = textureTargetIndex(target);
+	if (index >= 0 && unit >= 0 && unit < kMaxTextureUnits && s.textures[unit][index] == texture) {
+		++s.stats.filteredCalls;
+		return;
+	}
+
+	activeTexture(unit);
+	bindTexture(target, texture);
+}
+
+void GLState::viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	State &s = current();
+	if (s.viewportKnown && s.viewport[0] == x && s.viewport[1] == y && s.viewport[2] == width && s.viewport[3] == height) {
+		++s.stats.filteredCalls;
+		return;
+	}
+
+	s.viewport[0] = x;
+	s.viewport[1] = y;
+	s.viewport[2] = width;
+	s.viewport[3] = height;
+	s.viewportKnown = true;
+	++s.stats.stateChanges;
+	glViewport(x, y, width, height);
+}
+
+void GLState::getViewport(GLint *viewport)
+{
+	State &s = current();
+	if (!s.viewportKnown) {
+		glGetIntegerv(GL_VIEWPORT, s.viewport);
+		s.viewportKnown = true;
+	}
+
+	std::copy(s.viewport, s.viewport + 4, viewport);
+}
+
+void GLState::deleteFramebuffer(GLuint framebuffer)
+{
+	if (!framebuffer) {
+		return;
+	}
+
+	forget(current().framebuffer, framebuffer);
+	glDeleteFramebuffers(1, &framebuffer);
+}
+
+void GLState::deleteProgram(GLuint program)
+{
+	if (!program) {
+		return;
+	}
+
+	forget(current().program, program);
+	glDeleteProgram(program);
+}
+
+void GLState::deleteTexture(GLuint texture)
+{
+	if (!texture) {
+		return;
+	}
+
+	State &s = current();
+	for (auto &unit : s.textures) {
+		for (auto &bound : unit) {
+			forget(bound, texture);
+		}
+	}
+	glDeleteTextures(1, &texture);
+}
+
+void GLState::deleteVertexArray(GLuint vertexArray)
+{
+	if (!vertexArray) {
+		return;
+	}
+
+	forget(current().vertexArray, vertexArray);
+	glDeleteVertexArrays(1, &vertexArray);
+}
+
+void GLState::invalidate()
+{
+	std::fill(std::begin(state.capabilities), std::end(state.capabilities), kUnknown);
+	state.depthFunc = kUnknown;
+	state.cullFace = kUnknown;
+	state.program = kUnknown;
+	state.vertexArray = kUnknown;
+	state.framebuffer = kUnknown;
+	state.activeUnit = kUnknownUnit;
+	for (auto &unit : state.textures) {
+		std::fill(std::begin(unit), std::end(unit), kUnknown);
+	}
+	state.viewportKnown = false;
+
+	stateInitialized = true;
+}
+
+RenderStats GLState::takeStats()
+{
+	RenderStats stats = current().stats;
+	state.stats = RenderStats{};
+	return stats;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "ge2common.h"
+
+#include "gl_core_3_2.h"
+
+namespace ge2 {
+
+// A shadow of the GL state the engine changes, so that setting what is
+// already set never reaches the driver. Everything in ge2 goes through
+// here for these calls; code that makes any of them on GL directly must
+// call invalidate() afterwards.
+class GLState
+{
+public:
+	static void enable(GLenum capability) { setEnabled(capability, true); }
+	static void disable(GLenum capability) { setEnabled(capability, false); }
+	static void setEnabled(GLenum capability, bool enabled);
+	static void depthFunc(GLenum func);
+	static void cullFace(GLenum mode);
+
+	static void useProgram(GLuint program);
+	static void bindVertexArray(GLuint vertexArray);
+	static void bindFramebuffer(GLuint framebuffer);
+
+	// The unit-less bindTexture() binds to the active unit, for setting up
+	// a texture; the other only switches units if the binding changes.
+	static void activeTexture(int unit);
+	static void bindTexture(GLenum target, GLuint texture);
+	static void bindTexture(int unit, GLenum target, GLuint texture);
+
+	static void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+	static void getViewport(GLint *viewport);
+
+	// GL hands out the names of deleted objects again, so these also
+	// forget every binding of them.
+	static void deleteFramebuffer(GLuint framebuffer);
+	static void deleteProgram(GLuint program);
+	static void deleteTexture(GLuint texture);
+	static void deleteVertexArray(GLuint vertexArray);
+
+	static void invalidate();
+
+	// The calls made and filtered out since the last time; drawCalls is
+	// left to the renderer.
+	static RenderStats takeStats();
+};
+
+} // namespace ge2
@@ -69,6 +69,7 @@ int main(int argc, char *argv[])
 		}
 
 		ge2::Time::update();
+		ge2::geRenderer->beginFrame();
 
 		app->update();
 
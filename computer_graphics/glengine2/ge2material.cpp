@@ -1,5 +1,6 @@
 #include "ge2material.h"
 #include "ge2cubemap.h"
+#include "ge2glstate.h"
 #include "ge2shader.h"
 #include "ge2texture2d.h"
 
@@ -13,49 +14,40 @@ int Material::bind()
 		return 0;
 	}
 
-	if (m_faceCulling) {
-		glEnable(GL_CULL_FACE);
-	} else {
-		glDisable(GL_CULL_FACE);
-	}
-
-	if (m_depthTest) {
-		glEnable(GL_DEPTH_TEST);
-	} else {
-		glDisable(GL_DEPTH_TEST);
-	}
+	GLState::setEnabled(GL_CULL_FACE, m_faceCulling);
+	GLState::setEnabled(GL_DEPTH_TEST, m_depthTest);
 
 	switch (m_depthFunc) {
 	case kDepthFuncLess:
-		glDepthFunc(GL_LESS);
+		GLState::depthFunc(GL_LESS);
 		break;
 
 	case kDepthFuncLEqual:
-		glDepthFunc(GL_LEQUAL);
+		GLState::depthFunc(GL_LEQUAL);
 		break;
 
 	case kDepthFuncEqual:
-		glDepthFunc(GL_EQUAL);
+		GLState::depthFunc(GL_EQUAL);
 		break;
 
 	case kDepthFuncGEqual:
-		glDepthFunc(GL_GEQUAL);
+		GLState::depthFunc(GL_GEQUAL);
 		break;
 
 	case kDepthFuncGreater:
-		glDepthFunc(GL_GREATER);
+		GLState::depthFunc(GL_GREATER);
 		break;
 
 	case kDepthFuncNotEqual:
-		glDepthFunc(GL_NOTEQUAL);
+		GLState::depthFunc(GL_NOTEQUAL);
 		break;
 
 	case kDepthFuncNever:
-		glDepthFunc(GL_NEVER);
+		GLState::depthFunc(GL_NEVER);
 		break;
 
 	case kDepthFuncAlways:
-		glDepthFunc(GL_ALWAYS);
+		GLState::depthFunc(GL_ALWAYS);
 		break;
 
 	default:
@@ -64,15 +56,15 @@ int Material::bind()
 
 	switch (m_cullFace) {
 	case kCullFaceFront:
-		glCullFace(GL_FRONT);
+		GLState::cullFace(GL_FRONT);
 		break;
 
 	case kCullFaceBack:
-		glCullFace(GL_BACK);
+		GLState::cullFace(GL_BACK);
 		break;
 
 	case kCullFaceFrontAndBack:
-		glCullFace(GL_FRONT_AND_BACK);
+		GLState::cullFace(GL_FRONT_AND_BACK);
 		break;
 
 	default:
@@ -85,26 +77,20 @@ int Material::bind()
 	for (auto it : m_tex2DUniforms) {
 		if (it.second) {
 			int textureUnit = nextTextureUnit++;
-			glActiveTexture(GL_TEXTURE0 + textureUnit);
-
-			it.second->bind();
+			it.second->bind(textureUnit);
 
 			m_shader->setUniform(it.first, textureUnit);
 		}
 	}
-	glActiveTexture(GL_TEXTURE0);
 
 	for (auto it : m_cubemapUniforms) {
 		if (it.second) {
 			int textureUnit = nextTextureUnit++;
-			glActiveTexture(GL_TEXTURE0 + textureUnit);
-
-			it.second->bind();
+			it.second->bind(textureUnit);
 
 			m_shader->setUniform(it.first, textureUnit);
 		}
 	}
-	glActiveTexture(GL_TEXTURE0);
 
 	for (auto it : m_floatUniforms) {
 		m_shader->setUniform(it.first, it.second);
@@ -125,11 +111,11 @@ int Material::bind()
 		m_shader->setUniform(it.first, it.second);
 	}
 
-	m_shader->setUniform("ge_materialProperties.ambient", m_ambient);
-	m_shader->setUniform("ge_materialProperties.diffuse", m_diffuse);
-	m_shader->setUniform("ge_materialProperties.emission", m_emission);
-	m_shader->setUniform("ge_materialProperties.shininess", m_shininess);
-	m_shader->setUniform("ge_materialProperties.specular", m_specular);
+	m_shader->setUniform(StandardUniform::MaterialAmbient, m_ambient);
+	m_shader->setUniform(StandardUniform::MaterialDiffuse, m_diffuse);
+	m_shader->setUniform(StandardUniform::MaterialEmission, m_emission);
+	m_shader->setUniform(StandardUniform::MaterialShininess, m_shininess);
+	m_shader->setUniform(StandardUniform::MaterialSpecular, m_specular);
 
 	return nextTextureUnit;
 }
@@ -141,15 +127,14 @@ void Material::unbind()
 	}
 
 	for (size_t i = 0; i < m_tex2DUniforms.size(); ++i) {
-		glActiveTexture(GL_TEXTURE0 + i);
-		glBindTexture(GL_TEXTURE_2D, 0);
+		GLState::bindTexture(i, GL_TEXTURE_2D, 0);
 	}
 
-	glDisable(GL_CULL_FACE);
-	glDisable(GL_DEPTH_TEST);
+	GLState::disable(GL_CULL_FACE);
+	GLState::disable(GL_DEPTH_TEST);
 
-	glDepthFunc(GL_LESS);
-	glCullFace(GL_BACK);
+	GLState::depthFunc(GL_LESS);
+	GLState::cullFace(GL_BACK);
 
 	m_shader->unbind();
 }
@@ -68,6 +68,7 @@ public:
 	void setUniform(const std::string &name, glm::vec3 vec3) { m_vec3Uniforms[name] = vec3; }
 	void setUniform(const std::string &name, glm::vec4 vec4) { m_vec4Uniforms[name] = vec4; }
 
+	// Returns the first free texture unit
 	int bind();
 	void unbind();
 
@@ -1,11 +1,27 @@
 #include "ge2mesh.h"
 #include "ge2common.h"
 #include "ge2geometry.h"
+#include "ge2glstate.h"
 #include "ge2material.h"
 #include "ge2shader.h"
 
 using namespace ge2;
 
+namespace {
+
+GLenum primitiveMode(Geometry::PrimitiveType type)
+{
+	switch (type) {
+	case Geometry::kGeometryTriangles:
+		return GL_TRIANGLES;
+
+	default:
+		return GL_TRIANGLES;
+	}
+}
+
+}
+
 Mesh::Mesh(Geometry *geometry, Material *material)
 	: m_geometry(geometry)
 	, m_material(material)
@@ -58,7 +74,7 @@ void Mesh::construct()
 	destruct();
 
 	glGenVertexArrays(1, &m_vertexArray);
-	glBindVertexArray(m_vertexArray);
+	GLState::bindVertexArray(m_vertexArray);
 
 	// Fill vertex position data
 	glGenBuffers(1, &m_vertexBuffer);
@@ -101,7 +117,7 @@ void Mesh::construct()
 	IndexList indices = m_geometry->indices();
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
 
-	glBindVertexArray(0);
+	GLState::bindVertexArray(0);
 
 	m_dirty = false;
 }
@@ -109,7 +125,7 @@ void Mesh::construct()
 void Mesh::destruct()
 {
 	glDeleteBuffers(1, &m_indexBuffer);
-	glDeleteVertexArrays(1, &m_vertexArray);
+	GLState::deleteVertexArray(m_vertexArray);
 	glDeleteBuffers(1, &m_vertexBuffer);
 
 	m_indexBuffer = 0;
@@ -117,6 +133,7 @@ void Mesh::destruct()
 	m_vertexBuffer = 0;
 
 	m_dirty = true;
+	m_instanceArraysEnabled = false;
 }
 
 void Mesh::draw()
@@ -125,32 +142,55 @@ void Mesh::draw()
 		return;
 	}
 
-	glBindVertexArray(m_vertexArray);
+	// The vertex array stays bound; only the next draw replaces it
+	GLState::bindVertexArray(m_vertexArray);
 
-	GLenum primitiveType;
-	switch (m_geometry->primitiveType()) {
-	case Geometry::kGeometryTriangles:
-		primitiveType = GL_TRIANGLES;
-		break;
+	// ge_instanceModel goes back to its generic value, the identity
+	if (m_instanceArraysEnabled) {
+		for (GLint column = 0; column < 4; ++column) {
+			glDisableVertexAttribArray((GLint)ShaderAttribute::InstanceModel + column);
+		}
+		m_instanceArraysEnabled = false;
+		resetInstanceModel();
+	}
 
-	default:
-		primitiveType = GL_TRIANGLES;
-		break;
+	glDrawElements(primitiveMode(m_geometry->primitiveType()), m_geometry->indexCount(), GL_UNSIGNED_SHORT, 0);
+}
+
+void Mesh::drawInstanced(GLuint instanceBuffer, size_t offset, int count)
+{
+	if (m_dirty || !m_vertexArray || !m_geometry) {
+		return;
 	}
 
-	glDrawElements(primitiveType, m_geometry->indexCount(), GL_UNSIGNED_SHORT, 0);
+	GLState::bindVertexArray(m_vertexArray);
 
-	glBindVertexArray(0);
+	// The matrices move around in the buffer from one draw to the next, so
+	// only the divisors and enabled arrays are set up once.
+	glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+	for (GLint column = 0; column < 4; ++column) {
+		GLint location = (GLint)ShaderAttribute::InstanceModel + column;
+		glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), bufferOffset(offset + column * sizeof(glm::vec4)));
+
+		if (!m_instanceArraysEnabled) {
+			glVertexAttribDivisorARB(location, 1);
+			glEnableVertexAttribArray(location);
+		}
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	m_instanceArraysEnabled = true;
+
+	glDrawElementsInstanced(primitiveMode(m_geometry->primitiveType()), m_geometry->indexCount(), GL_UNSIGNED_SHORT, 0, count);
+
+	// Other meshes drawn after this one read the generic value
+	resetInstanceModel();
 }
 
-void Mesh::swap(Mesh &other)
+void Mesh::resetInstanceModel()
 {
-	std::swap(m_geometry, other.m_geometry);
-	std::swap(m_material, other.m_material);
-	std::swap(m_dirty, other.m_dirty);
-	std::swap(m_indexBuffer, other.m_indexBuffer);
-	std::swap(m_textureCoordinatesBuffer, other.m_textureCoordinatesBuffer);
-	std::swap(m_vertexArray, other.m_vertexArray);
-	std::swap(m_vertexBuffer, other.m_vertexBuffer);
-	std::swap(m_vertexNormalsBuffer, other.m_vertexNormalsBuffer);
+	for (GLint column = 0; column < 4; ++column) {
+		glm::vec4 identityColumn{0.0f};
+		identityColumn[column] = 1.0f;
+		glVertexAttrib4fv((GLint)ShaderAttribute::InstanceModel + column, &identityColumn[0]);
+	}
 }
@@ -28,6 +28,14 @@ public:
 	void destruct();
 
 	void draw();
+	// draws count instances, whose model matrices are consecutive mat4s
+	// from offset bytes into instanceBuffer
+	void drawInstanced(GLuint instanceBuffer, size_t offset, int count);
+
+	// Sets the generic value ge_instanceModel reads outside of instanced
+	// draws back to the identity. GL leaves it undefined after a draw that
+	// sourced it from an array.
+	static void resetInstanceModel();
 
 private:
 	Mesh() = default;
@@ -37,6 +45,7 @@ private:
 	Geometry *m_geometry = nullptr;
 	Material *m_material = nullptr;
 	bool m_dirty = true;
+	bool m_instanceArraysEnabled = false;
 
 	GLuint m_indexBuffer = 0;
 	GLuint m_textureCoordinatesBuffer = 0;
@@ -3,6 +3,7 @@
 #include "ge2cubeframebuffer.h"
 #include "ge2cubemap.h"
 #include "ge2framebuffer.h"
+#include "ge2glstate.h"
 #include "ge2material.h"
 #include "ge2mesh.h"
 #include "ge2node.h"
@@ -13,6 +14,8 @@
 
 #include "gl_core_3_2.h"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
 #ifndef __APPLE__
@@ -39,12 +42,13 @@ const std::string kShadowMapVertexShader = R"(
 	#version 150
 
 	in vec4 ge_position;
+	in mat4 ge_instanceModel;
 
 	uniform mat4 ge_modelViewProjection;
 
 	void main()
 	{
-		gl_Position = ge_modelViewProjection * ge_position;
+		gl_Position = ge_modelViewProjection * ge_instanceModel * ge_position;
 	}
 )";
 
@@ -72,6 +76,25 @@ const std::string kShadowMapFragmentShader = R"(
 )";
 #endif
 
+// Whether the upper 3x3 of model scales all axes alike and keeps them at
+// right angles, so that it transforms normals as well as its inverse
+// transpose does, up to their length
+bool hasUniformScale(const glm::mat4 &model)
+{
+	glm::vec3 x{model[0]};
+	glm::vec3 y{model[1]};
+	glm::vec3 z{model[2]};
+
+	float scale = glm::dot(x, x);
+	float tolerance = 1e-4f * scale;
+
+	return std::abs(glm::dot(y, y) - scale) <= tolerance &&
+		std::abs(glm::dot(z, z) - scale) <= tolerance &&
+		std::abs(glm::dot(x, y)) <= tolerance &&
+		std::abs(glm::dot(x, z)) <= tolerance &&
+		std::abs(glm::dot(y, z)) <= tolerance;
+}
+
 } // namespace
 
 void DirectionalLight::populateLightProperties(LightProperties &properties)
@@ -138,7 +161,30 @@ Renderer::Renderer(SDL_Window *window)
 
 	glBindBufferRange(GL_UNIFORM_BUFFER, (GLint)StandardUniformBlocks::Lights, m_lightsBufferObject, 0, kRendererLightsBufferSize);
 
-	glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+	FrameProperties frame;
+	glGenBuffers(1, &m_frameBufferObject);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_frameBufferObject);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameProperties), &frame, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	glBindBufferRange(GL_UNIFORM_BUFFER, (GLint)StandardUniformBlocks::Frame, m_frameBufferObject, 0, sizeof(FrameProperties));
+
+	ShadowProperties shadows;
+	glGenBuffers(1, &m_shadowsBufferObject);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_shadowsBufferObject);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(ShadowProperties), &shadows, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	glBindBufferRange(GL_UNIFORM_BUFFER, (GLint)StandardUniformBlocks::Shadows, m_shadowsBufferObject, 0, sizeof(ShadowProperties));
+
+	GLState::enable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+
+	glGenBuffers(1, &m_instanceBufferObject);
+	m_instancingSupported = ogl_ext_ARB_instanced_arrays == ogl_LOAD_SUCCEEDED;
+
+	// Outside of instanced draws ge_instanceModel reads its generic value,
+	// which starts out as the identity and is reset after each instanced run
+	Mesh::resetInstanceModel();
 
 	Shader *shadowMapShader = geResourceMgr->loadShaderFromStrings(
 		kShadowMapShaderAndMaterialName,
@@ -169,6 +215,11 @@ Renderer::~Renderer()
 		delete m_shadowData[i].shadowMap;
 		delete m_shadowData[i].cubeShadowMap;
 	}
+
+	glDeleteBuffers(1, &m_lightsBufferObject);
+	glDeleteBuffers(1, &m_frameBufferObject);
+	glDeleteBuffers(1, &m_shadowsBufferObject);
+	glDeleteBuffers(1, &m_instanceBufferObject);
 }
 
 Camera *Renderer::activeCamera()
@@ -176,6 +227,13 @@ Camera *Renderer::activeCamera()
 	return m_camera;
 }
 
+void Renderer::beginFrame()
+{
+	m_lastFrameStats = GLState::takeStats();
+	m_lastFrameStats.drawCalls = m_drawCalls;
+	m_drawCalls = 0;
+}
+
 void Renderer::setActiveCameraAndLights(Camera *camera, LightInfoList &lights)
 {
 	m_camera = camera;
@@ -236,6 +294,11 @@ void Renderer::setClearStencilValue(int value)
 	glClearStencil(m_clearStencil);
 }
 
+void Renderer::setInstancingEnabled(bool enabled)
+{
+	m_instancingEnabled = enabled;
+}
+
 void Renderer::setTitle(const char *title)
 {
 	SDL_SetWindowTitle(m_window, title);
@@ -270,25 +333,43 @@ void Renderer::render(RenderableList &renderables, bool isShadowPass, Material *
 		return;
 	}
 
-	int firstShadowMapTextureUnit = 0;
-	if (overrideMaterial) {
-		firstShadowMapTextureUnit = overrideMaterial->bind();
-	}
-
 	glm::mat4 viewMatrix = m_camera->viewMatrix();
 	glm::mat4 projectionMatrix = m_camera->projectionMatrix();
 
 	glm::mat3 viewMatrixLinear = glm::transpose(glm::inverse(glm::mat3(viewMatrix)));
 	glm::mat3 viewMatrixLinearInverse = glm::inverse(viewMatrixLinear);
 
+	// Everything that does not depend on the mesh is set once per pass
+	FrameProperties frame;
+	frame.viewMatrixLinear = glm::mat3x4{viewMatrixLinear};
+	frame.viewMatrixLinearInverse = glm::mat3x4{viewMatrixLinearInverse};
+	frame.totalSeconds = Time::totalSeconds();
+
+	glBindBuffer(GL_UNIFORM_BUFFER, m_frameBufferObject);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameProperties), &frame, GL_DYNAMIC_DRAW);
+
 	if (!isShadowPass) {
 		glBindBuffer(GL_UNIFORM_BUFFER, m_lightsBufferObject);
 		glBufferData(GL_UNIFORM_BUFFER, kRendererLightsBufferSize, m_lightProperties.data(), GL_DYNAMIC_DRAW);
-		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+		ShadowProperties shadows;
+		shadows.shadowBias1 = m_shadowData[0].shadowBias;
+		shadows.shadowFarPlane1 = m_shadowData[0].shadowFarPlane;
+		shadows.shadowBias2 = m_shadowData[1].shadowBias;
+		shadows.shadowFarPlane2 = m_shadowData[1].shadowFarPlane;
+		shadows.oneOverShadowMapResolution = 1.0f / (float)kShadowMapResolution;
+
+		glBindBuffer(GL_UNIFORM_BUFFER, m_shadowsBufferObject);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(ShadowProperties), &shadows, GL_DYNAMIC_DRAW);
 	}
 
-	// Draw renderables
-	for (auto renderable : renderables) {
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	// Queue and sort the draws, so that state is only changed where it has to
+	RenderQueue::Pass pass = isShadowPass ? RenderQueue::Pass::Shadow : RenderQueue::Pass::Opaque;
+	m_renderQueue.clear();
+
+	for (const auto &renderable : renderables) {
 		if (isShadowPass && !renderable.castsShadows) {
 			continue;
 		}
@@ -297,98 +378,147 @@ void Renderer::render(RenderableList &renderables, bool isShadowPass, Material *
 			continue;
 		}
 
+		float depth = -(viewMatrix * renderable.modelMatrix[3]).z;
+
 		for (auto mesh : renderable.node->meshList()) {
-			Material *material = overrideMaterial ? nullptr : mesh->material();
-			Shader *shader = nullptr;
+			Material *material = overrideMaterial ? overrideMaterial : mesh->material();
+			if (!material || !material->shader()) {
+				continue;
+			}
 
-			if (material) {
-				shader = material->shader();
-				firstShadowMapTextureUnit = material->bind();
-			} else {
-				shader = overrideMaterial->shader();
+			m_renderQueue.push(pass, mesh, material, renderable.modelMatrix, depth);
+		}
+	}
+
+	m_renderQueue.sort();
+
+	const DrawPacketList &packets = m_renderQueue.packets();
+	bool instancing = m_instancingEnabled && m_instancingSupported;
+
+	// Packets that share a mesh and a material with an instanced shader are
+	// next to each other after sorting, and their model matrices go into
+	// one buffer for the whole pass. Instanced shaders transform normals by
+	// the upper 3x3 of the model matrix, so nodes scaled unevenly are left
+	// out and drawn one at a time with a proper normal matrix.
+	if (instancing) {
+		m_instanceMatrices.clear();
+		m_drawInstanced.assign(packets.size(), false);
+
+		for (size_t i = 0; i < packets.size(); ++i) {
+			const DrawPacket &packet = packets[i];
+			if (packet.material->shader()->isInstanced() && hasUniformScale(*packet.modelMatrix)) {
+				m_instanceMatrices.push_back(*packet.modelMatrix);
+				m_drawInstanced[i] = true;
 			}
+		}
 
-			glm::mat4 modelView = viewMatrix * renderable.modelMatrix;
-			glm::mat4 modelViewProjection = projectionMatrix * modelView;
-			shader->setUniform("ge_modelViewProjection", modelViewProjection);
-			shader->setUniform("ge_modelView", modelView);
-			shader->setUniform("ge_normalMatrix", glm::transpose(glm::inverse(glm::mat3(modelView))));
-			shader->setUniform("ge_specularStrength", m_specularStrength);
-			shader->setUniform("ge_viewMatrixLinear", viewMatrixLinear);
-			shader->setUniform("ge_viewMatrixLinearInverse", viewMatrixLinearInverse);
-			shader->setUniform("ge_totalSeconds", Time::totalSeconds());
+		if (!m_instanceMatrices.empty()) {
+			glBindBuffer(GL_ARRAY_BUFFER, m_instanceBufferObject);
+			glBufferData(GL_ARRAY_BUFFER, m_instanceMatrices.size() * sizeof(glm::mat4), m_instanceMatrices.data(), GL_STREAM_DRAW);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+		}
+	}
+
+	// Draw renderables
+	Material *material = nullptr;
+	Shader *shader = nullptr;
+	int firstShadowMapTextureUnit = 0;
+	int lastTextureUnit = 0;
+	size_t firstInstance = 0;
+
+	for (size_t i = 0; i < packets.size(); ) {
+		const DrawPacket &packet = packets[i];
+
+		if (packet.material != material) {
+			firstShadowMapTextureUnit = packet.material->bind();
+			material = packet.material;
+			shader = material->shader();
+
+			shader->setUniform(StandardUniform::SpecularStrength, m_specularStrength);
 
 			if (!isShadowPass) {
-				shader->setUniform("ge_oneOverShadowMapResolution", 1.0f / (float)kShadowMapResolution);
 				int textureUnit = firstShadowMapTextureUnit;
 
 #ifdef DEPTH_TEXTURE_SAMPLERS_WORK
-				glActiveTexture(GL_TEXTURE0 + textureUnit);
-				m_shadowData[0].shadowMap->depthBuffer()->bind();
-				shader->setUniform("ge_shadowMap1", textureUnit++);
-				glActiveTexture(GL_TEXTURE0 + textureUnit);
-				m_shadowData[0].cubeShadowMap->depthBuffer()->bind();
-				shader->setUniform("ge_shadowCubeMap1", textureUnit++);
-				shader->setUniform("ge_shadowBias1", m_shadowData[0].shadowBias);
-				shader->setUniform("ge_shadowFarPlane1", m_shadowData[0].shadowFarPlane);
-				shader->setUniform("ge_modelViewProjectionLight1", m_shadowData[0].lightViewProjectionMatrix * renderable.modelMatrix);
-
-				glActiveTexture(GL_TEXTURE0 + textureUnit);
-				m_shadowData[1].shadowMap->depthBuffer()->bind();
-				shader->setUniform("ge_shadowMap2", textureUnit++);
-				glActiveTexture(GL_TEXTURE0 + textureUnit);
-				m_shadowData[1].cubeShadowMap->depthBuffer()->bind();
-				shader->setUniform("ge_shadowCubeMap2", textureUnit++);
-				shader->setUniform("ge_shadowBias2", m_shadowData[1].shadowBias);
-				shader->setUniform("ge_shadowFarPlane2", m_shadowData[1].shadowFarPlane);
-				shader->setUniform("ge_modelViewProjectionLight2", m_shadowData[1].lightViewProjectionMatrix * renderable.modelMatrix);
+				m_shadowData[0].shadowMap->depthBuffer()->bind(textureUnit);
+				shader->setUniform(StandardUniform::ShadowMap1, textureUnit++);
+				m_shadowData[0].cubeShadowMap->depthBuffer()->bind(textureUnit);
+				shader->setUniform(StandardUniform::ShadowCubeMap1, textureUnit++);
+
+				m_shadowData[1].shadowMap->depthBuffer()->bind(textureUnit);
+				shader->setUniform(StandardUniform::ShadowMap2, textureUnit++);
+				m_shadowData[1].cubeShadowMap->depthBuffer()->bind(textureUnit);
+				shader->setUniform(StandardUniform::ShadowCubeMap2, textureUnit++);
 #else
-				glActiveTexture(GL_TEXTURE0 + textureUnit);
-				m_shadowData[0].shadowMap->colorBuffer(FragmentBuffer::Color)->bind();
-				shader->setUniform("ge_shadowMap1", textureUnit++);
-				glActiveTexture(GL_TEXTURE0 + textureUnit);
-				m_shadowData[0].cubeShadowMap->colorBuffer(FragmentBuffer::Color)->bind();
-				shader->setUniform("ge_shadowCubeMap1", textureUnit++);
-				shader->setUniform("ge_shadowBias1", m_shadowData[0].shadowBias);
-				shader->setUniform("ge_shadowFarPlane1", m_shadowData[0].shadowFarPlane);
-				shader->setUniform("ge_modelViewProjectionLight1", m_shadowData[0].lightViewProjectionMatrix * renderable.modelMatrix);
-
-				glActiveTexture(GL_TEXTURE0 + textureUnit);
-				m_shadowData[1].shadowMap->colorBuffer(FragmentBuffer::Color)->bind();
-				shader->setUniform("ge_shadowMap2", textureUnit++);
-				glActiveTexture(GL_TEXTURE0 + textureUnit);
-				m_shadowData[1].cubeShadowMap->colorBuffer(FragmentBuffer::Color)->bind();
-				shader->setUniform("ge_shadowCubeMap2", textureUnit++);
-				shader->setUniform("ge_shadowBias2", m_shadowData[1].shadowBias);
-				shader->setUniform("ge_shadowFarPlane2", m_shadowData[1].shadowFarPlane);
-				shader->setUniform("ge_modelViewProjectionLight2", m_shadowData[1].lightViewProjectionMatrix * renderable.modelMatrix);
+				m_shadowData[0].shadowMap->colorBuffer(FragmentBuffer::Color)->bind(textureUnit);
+				shader->setUniform(StandardUniform::ShadowMap1, textureUnit++);
+				m_shadowData[0].cubeShadowMap->colorBuffer(FragmentBuffer::Color)->bind(textureUnit);
+				shader->setUniform(StandardUniform::ShadowCubeMap1, textureUnit++);
+
+				m_shadowData[1].shadowMap->colorBuffer(FragmentBuffer::Color)->bind(textureUnit);
+				shader->setUniform(StandardUniform::ShadowMap2, textureUnit++);
+				m_shadowData[1].cubeShadowMap->colorBuffer(FragmentBuffer::Color)->bind(textureUnit);
+				shader->setUniform(StandardUniform::ShadowCubeMap2, textureUnit++);
 #endif
+				lastTextureUnit = std::max(lastTextureUnit, textureUnit);
+			} else {
+				lastTextureUnit = std::max(lastTextureUnit, firstShadowMapTextureUnit);
 			}
+		}
 
-			mesh->draw();
+		if (instancing && m_drawInstanced[i]) {
+			size_t end = i + 1;
+			while (end < packets.size() && m_drawInstanced[end] &&
+				packets[end].mesh == packet.mesh && packets[end].material == packet.material) {
+				++end;
+			}
 
-			if (!isShadowPass) {
-				int textureUnit = firstShadowMapTextureUnit;
+			// The model matrix comes from ge_instanceModel, so the uniforms
+			// carry only the view
+			shader->setUniform(StandardUniform::ModelViewProjection, projectionMatrix * viewMatrix);
+			shader->setUniform(StandardUniform::ModelView, viewMatrix);
+			shader->setUniform(StandardUniform::NormalMatrix, viewMatrixLinear);
 
-				glActiveTexture(GL_TEXTURE0 + (textureUnit++));  // flat
-				glBindTexture(GL_TEXTURE_2D, 0);
-				glActiveTexture(GL_TEXTURE0 + (textureUnit++));  // cube
-				glBindTexture(GL_TEXTURE_2D, 0);
-				glActiveTexture(GL_TEXTURE0 + (textureUnit++));  // flat
-				glBindTexture(GL_TEXTURE_2D, 0);
-				glActiveTexture(GL_TEXTURE0 + (textureUnit++));  // cube
-				glBindTexture(GL_TEXTURE_2D, 0);
+			if (!isShadowPass) {
+				shader->setUniform(StandardUniform::ModelViewProjectionLight1, m_shadowData[0].lightViewProjectionMatrix);
+				shader->setUniform(StandardUniform::ModelViewProjectionLight2, m_shadowData[1].lightViewProjectionMatrix);
 			}
 
-			if (material) {
-				material->unbind();
+			packet.mesh->drawInstanced(m_instanceBufferObject, firstInstance * sizeof(glm::mat4), end - i);
+
+			firstInstance += end - i;
+			i = end;
+		} else {
+			const glm::mat4 &modelMatrix = *packet.modelMatrix;
+			glm::mat4 modelView = viewMatrix * modelMatrix;
+			glm::mat4 modelViewProjection = projectionMatrix * modelView;
+			shader->setUniform(StandardUniform::ModelViewProjection, modelViewProjection);
+			shader->setUniform(StandardUniform::ModelView, modelView);
+			shader->setUniform(StandardUniform::NormalMatrix, glm::transpose(glm::inverse(glm::mat3(modelView))));
+
+			if (!isShadowPass) {
+				shader->setUniform(StandardUniform::ModelViewProjectionLight1, m_shadowData[0].lightViewProjectionMatrix * modelMatrix);
+				shader->setUniform(StandardUniform::ModelViewProjectionLight2, m_shadowData[1].lightViewProjectionMatrix * modelMatrix);
 			}
+
+			packet.mesh->draw();
+			++i;
 		}
+
+		++m_drawCalls;
 	}
 
-	if (overrideMaterial) {
-		overrideMaterial->unbind();
+	if (!material) {
+		return;
 	}
+
+	// Earlier materials may have left textures on units the last one did not use
+	for (int textureUnit = 0; textureUnit < lastTextureUnit; ++textureUnit) {
+		GLState::bindTexture(textureUnit, GL_TEXTURE_2D, 0);
+		GLState::bindTexture(textureUnit, GL_TEXTURE_CUBE_MAP, 0);
+	}
+
+	material->unbind();
 }
 
 // http://www.opengl-tutorial.org/intermediate-tutorials/tutorial-16-shadow-mapping/
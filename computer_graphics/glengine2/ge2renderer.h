@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ge2common.h"
+#include "ge2renderqueue.h"
 
 #include <glm/glm.hpp>
 #include <SDL_video.h>
@@ -52,6 +53,41 @@ static_assert(offsetof(LightProperties, spotExponent)  ==  96, "spotExponent is
 static_assert(offsetof(LightProperties, radius)        == 100, "radius is at an incorrect offset");
 static_assert(offsetof(LightProperties, cutoff)        == 104, "cutoff is at an incorrect offset");
 
+// The ge_Frame block, see assets/standard/frame.glsl. A std140 mat3 takes
+// three vec4 columns.
+struct FrameProperties
+{
+	glm::mat3x4 viewMatrixLinear{1.0f};
+	glm::mat3x4 viewMatrixLinearInverse{1.0f};
+	float       totalSeconds{0.0f};
+	uint32_t    _padding1{0};
+	uint32_t    _padding2{0};
+	uint32_t    _padding3{0};
+};
+static_assert(sizeof(FrameProperties) == 112, "FrameProperties is not packed");
+static_assert(offsetof(FrameProperties, viewMatrixLinear)        ==  0, "viewMatrixLinear is at an incorrect offset");
+static_assert(offsetof(FrameProperties, viewMatrixLinearInverse) == 48, "viewMatrixLinearInverse is at an incorrect offset");
+static_assert(offsetof(FrameProperties, totalSeconds)            == 96, "totalSeconds is at an incorrect offset");
+
+// The ge_Shadows block, see assets/standard/shadows.glsl.
+struct ShadowProperties
+{
+	float    shadowBias1{0.0f};
+	float    shadowFarPlane1{0.0f};
+	float    shadowBias2{0.0f};
+	float    shadowFarPlane2{0.0f};
+	float    oneOverShadowMapResolution{0.0f};
+	uint32_t _padding1{0};
+	uint32_t _padding2{0};
+	uint32_t _padding3{0};
+};
+static_assert(sizeof(ShadowProperties) == 32, "ShadowProperties is not packed");
+static_assert(offsetof(ShadowProperties, shadowBias1)                ==  0, "shadowBias1 is at an incorrect offset");
+static_assert(offsetof(ShadowProperties, shadowFarPlane1)            ==  4, "shadowFarPlane1 is at an incorrect offset");
+static_assert(offsetof(ShadowProperties, shadowBias2)                ==  8, "shadowBias2 is at an incorrect offset");
+static_assert(offsetof(ShadowProperties, shadowFarPlane2)            == 12, "shadowFarPlane2 is at an incorrect offset");
+static_assert(offsetof(ShadowProperties, oneOverShadowMapResolution) == 16, "oneOverShadowMapResolution is at an incorrect offset");
+
 class Light
 {
 public:
@@ -202,16 +238,24 @@ public:
 	float clearDepthValue() { return m_clearDepth; }
 	int clearStencilValue() { return m_clearStencil; }
 	float specularStrength() { return m_specularStrength; }
+	// Instanced shaders are drawn one call per run of meshes sharing a
+	// material, where GL_ARB_instanced_arrays is available; nodes that are
+	// not uniformly scaled are drawn one by one
+	bool instancingEnabled() { return m_instancingEnabled; }
+	// the counts for the last whole frame
+	const RenderStats &frameStats() const { return m_lastFrameStats; }
 
 	void setActiveCameraAndLights(Camera *camera, LightInfoList &lights);
 	void setClearColorValue(const glm::vec4 &color);
 	void setClearDepthValue(float value);
 	void setClearStencilValue(int value);
+	void setInstancingEnabled(bool enabled);
 	void setSpecularStrength(float strength);
 	void setTitle(const char *title);
 
 	void resize(int width, int height);
 
+	void beginFrame();
 	void clear(int clearFlags = kClearFlagAll);
 	void render(RenderableList &renderables, bool isShadowPass = false, Material *overrideMaterial = nullptr);
 	void updateShadowMaps(RenderableList &renderables);
@@ -230,11 +274,15 @@ private:
 
 	typedef std::array<LightProperties, kRendererMaxLights> LightArray;
 	typedef std::array<ShadowData, kNumShadowMaps> ShadowDataArray;
+	typedef std::vector<glm::mat4> MatrixList;
 
 	SDL_Window           *m_window = nullptr;
 	int                   m_windowHeight = 0;
 	int                   m_windowWidth = 0;
 	unsigned int          m_lightsBufferObject = 0;
+	unsigned int          m_frameBufferObject = 0;
+	unsigned int          m_shadowsBufferObject = 0;
+	unsigned int          m_instanceBufferObject = 0;
 
 	Camera               *m_camera = nullptr;
 	LightInfoList         m_activeLights;
@@ -243,9 +291,18 @@ private:
 	float                 m_clearDepth{1.0f};
 	int                   m_clearStencil{0};
 	float                 m_specularStrength{1.0f};
+	bool                  m_instancingEnabled = true;
+	bool                  m_instancingSupported = false;
+	MatrixList            m_instanceMatrices;
+	// per packet of the pass, whether its matrix is in m_instanceMatrices
+	std::vector<bool>     m_drawInstanced;
 
 	Material             *m_shadowMapMaterial = nullptr;
 	ShadowDataArray       m_shadowData;
+
+	RenderQueue           m_renderQueue;
+	int                   m_drawCalls = 0;
+	RenderStats           m_lastFrameStats;
 };
 
 } // namespace ge2
@@ -0,0 +1,102 @@
+#include "ge2renderqueue.h"
+#include "ge2material.h"
+
+#include <cstring>
+
+using namespace ge2;
+
+namespace {
+
+const int kPassShift     = 62;
+const int kShaderShift   = 48;
+const int kMaterialShift = 32;
+const int kMeshShift     = 16;
+
+const uint32_t kMaxShaderId   = (1 << 14) - 1;
+const uint32_t kMaxMaterialId = (1 << 16) - 1;
+const uint32_t kMaxMeshId     = (1 << 16) - 1;
+
+// The bits of a non-negative float sort the same way as its value, so
+// the top half of them is a coarse depth that keeps its order.
+uint64_t quantizeDepth(float depth)
+{
+	if (!(depth > 0.0f)) {
+		return 0;
+	}
+
+	uint32_t bits;
+	std::memcpy(&bits, &depth, sizeof(bits));
+	return bits >> 16;
+}
+
+}
+
+void RenderQueue::clear()
+{
+	m_packets.clear();
+
+	// Freed objects' addresses may be reused by new ones
+	m_shaderIds.clear();
+	m_materialIds.clear();
+	m_meshIds.clear();
+}
+
+void RenderQueue::push(Pass pass, Mesh *mesh, Material *material, const glm::mat4 &modelMatrix, float depth)
+{
+	uint64_t key = (uint64_t)pass << kPassShift;
+	key |= (uint64_t)idFor(m_shaderIds, material->shader(), kMaxShaderId) << kShaderShift;
+	key |= (uint64_t)idFor(m_materialIds, material, kMaxMaterialId) << kMaterialShift;
+	key |= (uint64_t)idFor(m_meshIds, mesh, kMaxMeshId) << kMeshShift;
+	key |= quantizeDepth(depth);
+
+	m_packets.push_back(DrawPacket{key, mesh, material, &modelMatrix});
+}
+
+// A least significant byte first radix sort. It is stable, so packets with
+// equal keys stay in scene order, and it skips the bytes all keys share,
+// which in practice are most of the high ones.
+void RenderQueue::sort()
+{
+	const size_t count = m_packets.size();
+	if (count < 2) {
+		return;
+	}
+
+	m_scratch.resize(count);
+
+	for (int shift = 0; shift < 64; shift += 8) {
+		size_t offsets[256] = {};
+		for (const auto &packet : m_packets) {
+			++offsets[(packet.key >> shift) & 0xff];
+		}
+
+		if (offsets[(m_packets[0].key >> shift) & 0xff] == count) {
+			continue;
+		}
+
+		size_t total = 0;
+		for (auto &offset : offsets) {
+			size_t bucket = offset;
+			offset = total;
+			total += bucket;
+		}
+
+		for (const auto &packet : m_packets) {
+			m_scratch[offsets[(packet.key >> shift) & 0xff]++] = packet;
+		}
+		m_packets.swap(m_scratch);
+	}
+}
+
+uint32_t RenderQueue::idFor(IdMap &ids, const void *object, uint32_t maxId)
+{
+	auto it = ids.find(object);
+	if (it != ids.end()) {
+		return it->second;
+	}
+
+	// Past the last id everything shares it and is merely not grouped.
+	uint32_t id = ids.size() < maxId ? (uint32_t)ids.size() + 1 : maxId;
+	ids.emplace(object, id);
+	return id;
+}
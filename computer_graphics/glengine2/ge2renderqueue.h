@@ -0,0 +1,65 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+namespace ge2 {
+
+class Material;
+class Mesh;
+
+// One draw call. The key orders packets so that draws sharing a program,
+// a material and geometry end up next to each other, and opaque geometry
+// within each of those is drawn front to back:
+//
+//   63..62  pass
+//   61..48  shader
+//   47..32  material
+//   31..16  mesh
+//   15..0   view depth
+struct DrawPacket
+{
+	uint64_t         key;
+	Mesh            *mesh;
+	Material        *material;
+	const glm::mat4 *modelMatrix;
+};
+
+typedef std::vector<DrawPacket> DrawPacketList;
+
+class RenderQueue
+{
+public:
+	enum class Pass : uint8_t
+	{
+		Shadow,
+		Opaque
+	};
+
+	void clear();
+	// modelMatrix must outlive the queue's next clear()
+	void push(Pass pass, Mesh *mesh, Material *material, const glm::mat4 &modelMatrix, float depth);
+	void sort();
+
+	const DrawPacketList &packets() const { return m_packets; }
+
+private:
+	typedef std::unordered_map<const void *, uint32_t> IdMap;
+
+	static uint32_t idFor(IdMap &ids, const void *object, uint32_t maxId);
+
+	DrawPacketList m_packets;
+	DrawPacketList m_scratch;
+
+	// Ids are handed out as objects are first seen and only have to hold
+	// for one sort, so they are dropped with the packets. Scene order is
+	// stable, so the ids and the draw order are too.
+	IdMap          m_shaderIds;
+	IdMap          m_materialIds;
+	IdMap          m_meshIds;
+};
+
+} // namespace ge2
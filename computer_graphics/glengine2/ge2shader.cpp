@@ -1,4 +1,5 @@
 #include "ge2shader.h"
+#include "ge2glstate.h"
 
 #include <glm/gtc/type_ptr.hpp>
 
@@ -11,7 +12,8 @@ namespace {
 const char * const kAttributeNames[] = {
 	"ge_position",
 	"ge_textureCoordinates",
-	"ge_normal"
+	"ge_normal",
+	"ge_instanceModel"
 };
 
 const char * const kFragmentBufferNames[] = {
@@ -31,24 +33,22 @@ const char * const kStandardUniforms[] = {
 	"ge_modelViewProjectionLight1",
 	"ge_modelViewProjectionLight2",
 	"ge_normalMatrix",
-	"ge_oneOverShadowMapResolution",
-	"ge_shadowBias1",
-	"ge_shadowBias2",
 	"ge_shadowCubeMap1",
 	"ge_shadowCubeMap2",
-	"ge_shadowFarPlane1",
-	"ge_shadowFarPlane2",
 	"ge_shadowMap1",
 	"ge_shadowMap2",
-	"ge_specularStrength",
-	"ge_totalSeconds",
-	"ge_viewMatrixLinear",
-	"ge_viewMatrixLinearInverse"
+	"ge_specularStrength"
 };
+static_assert(sizeof(kStandardUniforms) / sizeof(kStandardUniforms[0]) == (size_t)StandardUniform::NumUniforms,
+	"kStandardUniforms does not match StandardUniform");
 
 const char * const kStandardUniformBlockNames[] = {
-	"ge_Lights"
+	"ge_Lights",
+	"ge_Frame",
+	"ge_Shadows"
 };
+static_assert(sizeof(kStandardUniformBlockNames) / sizeof(kStandardUniformBlockNames[0]) == (size_t)StandardUniformBlocks::User,
+	"kStandardUniformBlockNames does not match StandardUniformBlocks");
 
 }
 
@@ -59,7 +59,7 @@ Shader::Shader(Shader &&rvalue)
 
 Shader::~Shader()
 {
-	glDeleteProgram(m_programId);
+	GLState::deleteProgram(m_programId);
 }
 
 Shader &Shader::operator=(Shader rvalue)
@@ -84,7 +84,7 @@ Shader *Shader::loadFromString(
 
 	GLuint vertexShaderId = shader->compileShader(GL_VERTEX_SHADER, vertexShader);
 	if (!vertexShaderId) {
-		glDeleteProgram(shader->m_programId);
+		GLState::deleteProgram(shader->m_programId);
 		shader->m_programId = 0;
 		return shader;
 	}
@@ -93,7 +93,7 @@ Shader *Shader::loadFromString(
 
 	GLuint fragmentShaderId = shader->compileShader(GL_FRAGMENT_SHADER, fragmentShader);
 	if (!fragmentShaderId) {
-		glDeleteProgram(shader->m_programId);
+		GLState::deleteProgram(shader->m_programId);
 		shader->m_programId = 0;
 		return shader;
 	}
@@ -106,7 +106,7 @@ Shader *Shader::loadFromString(
 	glGetProgramiv(shader->m_programId, GL_LINK_STATUS, &status);
 	if (status != GL_TRUE) {
 		shader->m_errorString = shader->getProgramInfoLog();
-		glDeleteProgram(shader->m_programId);
+		GLState::deleteProgram(shader->m_programId);
 		shader->m_programId = 0;
 		return shader;
 	}
@@ -144,63 +144,68 @@ bool Shader::hasUniform(const std::string &name) const
 
 GLint Shader::uniform(const std::string &name) const
 {
-	auto it = m_uniforms.find(name);
-	return (it != m_uniforms.end()) ? it->second : -1;
+	return uniformLocation(uniformHandle(name));
 }
 
-void Shader::setUniform(const std::string &name, float f)
+UniformHandle Shader::uniformHandle(const std::string &name) const
 {
 	auto it = m_uniforms.find(name);
-	if (it != m_uniforms.end()) {
-		glUniform1f(it->second, f);
+	return (it != m_uniforms.end()) ? UniformHandle(it->second) : kInvalidUniformHandle;
+}
+
+void Shader::setUniform(UniformHandle handle, float f)
+{
+	GLint location = uniformLocation(handle);
+	if (location != -1) {
+		glUniform1f(location, f);
 	}
 }
 
-void Shader::setUniform(const std::string &name, int i)
+void Shader::setUniform(UniformHandle handle, int i)
 {
-	auto it = m_uniforms.find(name);
-	if (it != m_uniforms.end()) {
-		glUniform1i(it->second, i);
+	GLint location = uniformLocation(handle);
+	if (location != -1) {
+		glUniform1i(location, i);
 	}
 }
 
-void Shader::setUniform(const std::string &name, const glm::mat3 &mat3)
+void Shader::setUniform(UniformHandle handle, const glm::mat3 &mat3)
 {
-	auto it = m_uniforms.find(name);
-	if (it != m_uniforms.end()) {
-		glUniformMatrix3fv(it->second, 1, GL_FALSE, glm::value_ptr(mat3));
+	GLint location = uniformLocation(handle);
+	if (location != -1) {
+		glUniformMatrix3fv(location, 1, GL_FALSE, glm::value_ptr(mat3));
 	}
 }
 
-void Shader::setUniform(const std::string &name, const glm::mat4 &mat4)
+void Shader::setUniform(UniformHandle handle, const glm::mat4 &mat4)
 {
-	auto it = m_uniforms.find(name);
-	if (it != m_uniforms.end()) {
-		glUniformMatrix4fv(it->second, 1, GL_FALSE, glm::value_ptr(mat4));
+	GLint location = uniformLocation(handle);
+	if (location != -1) {
+		glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(mat4));
 	}
 }
 
-void Shader::setUniform(const std::string &name, const glm::vec2 &vec2)
+void Shader::setUniform(UniformHandle handle, const glm::vec2 &vec2)
 {
-	auto it = m_uniforms.find(name);
-	if (it != m_uniforms.end()) {
-		glUniform2f(it->second, vec2[0], vec2[1]);
+	GLint location = uniformLocation(handle);
+	if (location != -1) {
+		glUniform2f(location, vec2[0], vec2[1]);
 	}
 }
 
-void Shader::setUniform(const std::string &name, const glm::vec3 &vec3)
+void Shader::setUniform(UniformHandle handle, const glm::vec3 &vec3)
 {
-	auto it = m_uniforms.find(name);
-	if (it != m_uniforms.end()) {
-		glUniform3f(it->second, vec3[0], vec3[1], vec3[2]);
+	GLint location = uniformLocation(handle);
+	if (location != -1) {
+		glUniform3f(location, vec3[0], vec3[1], vec3[2]);
 	}
 }
 
-void Shader::setUniform(const std::string &name, const glm::vec4 &vec4)
+void Shader::setUniform(UniformHandle handle, const glm::vec4 &vec4)
 {
-	auto it = m_uniforms.find(name);
-	if (it != m_uniforms.end()) {
-		glUniform4f(it->second, vec4[0], vec4[1], vec4[2], vec4[3]);
+	GLint location = uniformLocation(handle);
+	if (location != -1) {
+		glUniform4f(location, vec4[0], vec4[1], vec4[2], vec4[3]);
 	}
 }
 
@@ -214,12 +219,12 @@ void Shader::setUniformBlock(const std::string &name, int bindingPoint)
 
 void Shader::bind()
 {
-	glUseProgram(m_programId);
+	GLState::useProgram(m_programId);
 }
 
 void Shader::unbind()
 {
-	glUseProgram(0);
+	GLState::useProgram(0);
 }
 
 void Shader::swap(Shader &other)
@@ -227,6 +232,9 @@ void Shader::swap(Shader &other)
 	std::swap(m_programId, other.m_programId);
 	std::swap(m_errorString, other.m_errorString);
 	std::swap(m_uniforms, other.m_uniforms);
+	std::swap(m_uniformLocations, other.m_uniformLocations);
+	std::swap(m_uniformBlocks, other.m_uniformBlocks);
+	std::swap(m_instanced, other.m_instanced);
 }
 
 void Shader::bindStandardLocations()
@@ -234,6 +242,7 @@ void Shader::bindStandardLocations()
 	glBindAttribLocation(m_programId, (GLint)ShaderAttribute::VertexPosition, kAttributeNames[(GLint)ShaderAttribute::VertexPosition]);
 	glBindAttribLocation(m_programId, (GLint)ShaderAttribute::VertexTextureCoordinates, kAttributeNames[(GLint)ShaderAttribute::VertexTextureCoordinates]);
 	glBindAttribLocation(m_programId, (GLint)ShaderAttribute::VertexNormals, kAttributeNames[(GLint)ShaderAttribute::VertexNormals]);
+	glBindAttribLocation(m_programId, (GLint)ShaderAttribute::InstanceModel, kAttributeNames[(GLint)ShaderAttribute::InstanceModel]);
 
 	glBindFragDataLocation(m_programId, (GLint)FragmentBuffer::Color, kFragmentBufferNames[(GLint)FragmentBuffer::Color]);
 	glBindFragDataLocation(m_programId, (GLint)FragmentBuffer::Glow, kFragmentBufferNames[(GLint)FragmentBuffer::Glow]);
@@ -244,24 +253,36 @@ void Shader::populateIndices(const StringList &uniforms)
 {
 	bind();
 
-	for (auto uniform : uniforms) {
-		m_uniforms[uniform] = glGetUniformLocation(m_programId, uniform.c_str());
+	// the standard uniforms come first, so that their handles are fixed
+	for (auto uniform : kStandardUniforms) {
+		m_uniforms[uniform] = m_uniformLocations.size();
+		m_uniformLocations.push_back(glGetUniformLocation(m_programId, uniform));
 	}
 
-	for (auto uniform : kStandardUniforms) {
-		m_uniforms[uniform] = glGetUniformLocation(m_programId, uniform);
+	for (auto uniform : uniforms) {
+		if (m_uniforms.find(uniform) == m_uniforms.end()) {
+			m_uniforms[uniform] = m_uniformLocations.size();
+			m_uniformLocations.push_back(glGetUniformLocation(m_programId, uniform.c_str()));
+		}
 	}
 
 	for (auto uniformBlock : kStandardUniformBlockNames) {
-		m_uniformBlocks[uniformBlock] = glGetUniformBlockIndex(m_programId, uniformBlock);
+		GLuint index = glGetUniformBlockIndex(m_programId, uniformBlock);
+		if (index != GL_INVALID_INDEX) {
+			m_uniformBlocks[uniformBlock] = index;
+		}
 	}
 
+	m_instanced = hasAttribute(ShaderAttribute::InstanceModel);
+
 	unbind();
 }
 
 void Shader::setStandardUniformBlocks()
 {
-	setUniformBlock(kStandardUniformBlockNames[(GLint)StandardUniformBlocks::Lights], (GLint)StandardUniformBlocks::Lights);
+	for (GLint i = 0; i < (GLint)StandardUniformBlocks::User; ++i) {
+		setUniformBlock(kStandardUniformBlockNames[i], i);
+	}
 }
 
 std::string Shader::getShaderInfoLog(GLint shader)
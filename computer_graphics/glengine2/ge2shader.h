@@ -14,6 +14,22 @@
 namespace ge2 {
 
 typedef std::map<std::string, GLint> IndexMap;
+typedef std::vector<GLint> LocationList;
+
+// An index into a shader's table of uniform locations, resolved once with
+// Shader::uniformHandle() so that setting a uniform needs no name lookup.
+// The standard uniforms have fixed handles, see StandardUniform. It is not
+// a plain GLint, so that setUniform(handle, 1) never reads as
+// setUniform(1, handle).
+struct UniformHandle
+{
+	explicit UniformHandle(GLint index = -1) : index(index) {}
+	explicit UniformHandle(StandardUniform uniform) : index((GLint)uniform) {}
+
+	GLint index;
+};
+
+const UniformHandle kInvalidUniformHandle;
 
 class Shader
 {
@@ -36,16 +52,36 @@ public:
 	bool hasAttribute(ShaderAttribute attribute) const;
 	bool hasFragmentOutput(FragmentBuffer buffer) const;
 	bool hasUniform(const std::string &name) const;
+	// whether the shader reads ge_instanceModel, and so can be drawn instanced
+	bool isInstanced() const { return m_instanced; }
 
 	GLint uniform(const std::string &name) const;
-
-	void setUniform(const std::string &name, float f);
-	void setUniform(const std::string &name, int i);
-	void setUniform(const std::string &name, const glm::mat3 &mat3);
-	void setUniform(const std::string &name, const glm::mat4 &mat4);
-	void setUniform(const std::string &name, const glm::vec2 &vec2);
-	void setUniform(const std::string &name, const glm::vec3 &vec3);
-	void setUniform(const std::string &name, const glm::vec4 &vec4);
+	UniformHandle uniformHandle(const std::string &name) const;
+
+	void setUniform(UniformHandle handle, float f);
+	void setUniform(UniformHandle handle, int i);
+	void setUniform(UniformHandle handle, const glm::mat3 &mat3);
+	void setUniform(UniformHandle handle, const glm::mat4 &mat4);
+	void setUniform(UniformHandle handle, const glm::vec2 &vec2);
+	void setUniform(UniformHandle handle, const glm::vec3 &vec3);
+	void setUniform(UniformHandle handle, const glm::vec4 &vec4);
+
+	void setUniform(StandardUniform uniform, float f) { setUniform(UniformHandle(uniform), f); }
+	void setUniform(StandardUniform uniform, int i) { setUniform(UniformHandle(uniform), i); }
+	void setUniform(StandardUniform uniform, const glm::mat3 &mat3) { setUniform(UniformHandle(uniform), mat3); }
+	void setUniform(StandardUniform uniform, const glm::mat4 &mat4) { setUniform(UniformHandle(uniform), mat4); }
+	void setUniform(StandardUniform uniform, const glm::vec2 &vec2) { setUniform(UniformHandle(uniform), vec2); }
+	void setUniform(StandardUniform uniform, const glm::vec3 &vec3) { setUniform(UniformHandle(uniform), vec3); }
+	void setUniform(StandardUniform uniform, const glm::vec4 &vec4) { setUniform(UniformHandle(uniform), vec4); }
+
+	// slower, since the name is looked up on every call
+	void setUniform(const std::string &name, float f) { setUniform(uniformHandle(name), f); }
+	void setUniform(const std::string &name, int i) { setUniform(uniformHandle(name), i); }
+	void setUniform(const std::string &name, const glm::mat3 &mat3) { setUniform(uniformHandle(name), mat3); }
+	void setUniform(const std::string &name, const glm::mat4 &mat4) { setUniform(uniformHandle(name), mat4); }
+	void setUniform(const std::string &name, const glm::vec2 &vec2) { setUniform(uniformHandle(name), vec2); }
+	void setUniform(const std::string &name, const glm::vec3 &vec3) { setUniform(uniformHandle(name), vec3); }
+	void setUniform(const std::string &name, const glm::vec4 &vec4) { setUniform(uniformHandle(name), vec4); }
 
 	void setUniformBlock(const std::string &name, int bindingPoint);
 
@@ -53,6 +89,11 @@ public:
 	void unbind();
 
 private:
+	GLint uniformLocation(UniformHandle handle) const
+	{
+		return (handle.index >= 0 && (size_t)handle.index < m_uniformLocations.size()) ? m_uniformLocations[handle.index] : -1;
+	}
+
 	void swap(Shader &other);
 	void bindStandardLocations();
 	void populateIndices(const StringList &uniforms);
@@ -61,10 +102,13 @@ private:
 	std::string getProgramInfoLog();
 	GLint compileShader(GLenum shaderType, const std::string &source);
 
-	GLuint      m_programId = 0;
-	std::string m_errorString;
-	IndexMap    m_uniforms;
-	IndexMap    m_uniformBlocks;
+	GLuint       m_programId = 0;
+	std::string  m_errorString;
+	// uniform names to handles, and handles to locations
+	IndexMap     m_uniforms;
+	LocationList m_uniformLocations;
+	IndexMap     m_uniformBlocks;
+	bool         m_instanced = false;
 };
 
 } // namespace ge2
@@ -1,4 +1,5 @@
 #include "ge2texture2d.h"
+#include "ge2glstate.h"
 
 #include <png.h>
 
@@ -150,7 +151,7 @@ GLuint png_texture_load(const char * file_name, int * width, int * height)
 	// Generate the OpenGL texture object
 	GLuint texture;
 	glGenTextures(1, &texture);
-	glBindTexture(GL_TEXTURE_2D, texture);
+	GLState::bindTexture(GL_TEXTURE_2D, texture);
 	glTexImage2D(GL_TEXTURE_2D, 0, format, temp_width, temp_height, 0, format, GL_UNSIGNED_BYTE, image_data);
 	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 	glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -191,7 +192,7 @@ void Texture2D::construct(int width, int height, int flags)
 	m_height = height;
 
 	glGenTextures(1, &m_texture);
-	glBindTexture(GL_TEXTURE_2D, m_texture);
+	GLState::bindTexture(GL_TEXTURE_2D, m_texture);
 
 	if (flags & kTextureColor) {
 		GLint internalFormat = (flags & kTextureFloatingPoint) ? GL_RGB32F : GL_RGBA;
@@ -221,7 +222,7 @@ void Texture2D::construct(int width, int height, int flags)
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	}
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLState::bindTexture(GL_TEXTURE_2D, 0);
 }
 
 void Texture2D::construct(const std::string &fileName)
@@ -230,7 +231,7 @@ void Texture2D::construct(const std::string &fileName)
 
 	m_width = m_height = 0;
 	m_texture = png_texture_load(fileName.c_str(), &m_width, &m_height);
-	glBindTexture(GL_TEXTURE_2D, m_texture);
+	GLState::bindTexture(GL_TEXTURE_2D, m_texture);
 
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -238,21 +239,26 @@ void Texture2D::construct(const std::string &fileName)
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 	glGenerateMipmap(GL_TEXTURE_2D);
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLState::bindTexture(GL_TEXTURE_2D, 0);
 }
 
 void Texture2D::destruct()
 {
-	glDeleteTextures(1, &m_texture);
+	GLState::deleteTexture(m_texture);
 	m_width = m_height = 0;
 }
 
 void Texture2D::bind()
 {
-	glBindTexture(GL_TEXTURE_2D, m_texture);
+	GLState::bindTexture(GL_TEXTURE_2D, m_texture);
+}
+
+void Texture2D::bind(int unit)
+{
+	GLState::bindTexture(unit, GL_TEXTURE_2D, m_texture);
 }
 
 void Texture2D::unbind()
 {
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLState::bindTexture(GL_TEXTURE_2D, 0);
 }
@@ -24,6 +24,7 @@ public:
 	int height() const { return m_height; }
 
 	void bind();
+	void bind(int unit);
 	void unbind();
 
 private:
@@ -30,7 +30,7 @@ const std::string kLightSourceFragmentShader = R"(
 	in vec3 normal;
 
 	uniform vec3 lightColor;
-	uniform float ge_totalSeconds;
+	#ge_include "standard/frame.glsl"
 
 	out vec4 ge_fragmentColor;
 	out vec4 ge_fragmentCrepuscularRays;
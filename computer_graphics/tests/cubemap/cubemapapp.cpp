@@ -27,7 +27,7 @@ const std::string kReflectiveFragmentShader = R"(
 	//in vec3 normal;
 
 	uniform samplerCube envMap;
-	uniform mat3 ge_viewMatrixLinearInverse;
+	#ge_include "standard/frame.glsl"
 
 	out vec4 ge_fragmentColor;
 
@@ -47,7 +47,7 @@ const std::string kRefractiveFragmentShader = R"(
 	uniform float outsideRefractiveIndex = 1.0;
 	uniform float objectRefractiveIndex = 1.5;
 	uniform samplerCube envMap;
-	uniform mat3 ge_viewMatrixLinearInverse;
+	#ge_include "standard/frame.glsl"
 
 	out vec4 ge_fragmentColor;
 
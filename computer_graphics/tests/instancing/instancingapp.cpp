@@ -0,0 +1,149 @@
+#include "instancingapp.h"
+
+#include <iostream>
+
+using namespace ge2;
+
+namespace {
+
+// 100 x 100 cubes
+const int kGridSize = 100;
+const float kGridSpacing = 1.5f;
+
+// Frames measured in each mode before switching to the other, the first
+// of which is dropped since it still reports the previous mode
+const int kFramesPerMode = 300;
+
+}
+
+InstancingApplication::InstancingApplication(int argc, char *argv[])
+{
+	geRenderer->setTitle("GL Engine 2 - Instancing Benchmark");
+
+	geResourceMgr->setAssetDirectory("../assets");
+
+	if (argc >= 2) {
+		geResourceMgr->setAssetDirectory(argv[1]);
+	}
+
+	Shader *shader = geResourceMgr->loadShaderFromFiles(
+		"default_shader",
+		"standard/default.vs",
+		"ge2test/colored_fragment_light.fs",
+		{ });
+	if (shader->hasError()) {
+		std::cerr << "Shader compilation error" << std::endl;
+		std::cerr << shader->errorString() << std::endl;
+	}
+	Material *material = geResourceMgr->createMaterial("default_material", shader);
+	material->setDiffuseColor(glm::vec3{0.8f});
+
+	m_camera = new DebugCamera;
+	m_camera->setPosition(glm::vec3{0.0f, 40.0f, 90.0f});
+	m_camera->setAltitude(degToRad(-30));
+
+	m_scene = new Node;
+
+	Mesh *cubeMesh = geResourceMgr->createCube("cube", 1.0f);
+	cubeMesh->setMaterial(material);
+	cubeMesh->construct();
+
+	float offset = -0.5f * kGridSpacing * (kGridSize - 1);
+	for (int z = 0; z < kGridSize; ++z) {
+		for (int x = 0; x < kGridSize; ++x) {
+			Node *cubeNode = new Node;
+			cubeNode->setPosition(glm::vec3{offset + kGridSpacing * x, 0.0f, offset + kGridSpacing * z});
+			cubeNode->setMeshList({ cubeMesh });
+			m_scene->addChild(cubeNode);
+		}
+	}
+
+	Node *directionalNode = new Node;
+	m_directionalLight = new DirectionalLight;
+	m_directionalLight->setAmbientColor(glm::vec3{0.15f});
+	m_directionalLight->setColor(glm::vec3{1.0f});
+	m_directionalLight->setDirection(glm::vec3{-0.5f, -1.0f, -0.8f});
+	directionalNode->setLight(m_directionalLight);
+	m_scene->addChild(directionalNode);
+}
+
+InstancingApplication::~InstancingApplication()
+{
+	delete m_scene;
+	delete m_camera;
+}
+
+void InstancingApplication::handleEvent(const SDL_Event &event)
+{
+	m_camera->handleEvent(event);
+
+	if (event.type == SDL_KEYUP) {
+		const SDL_KeyboardEvent *evt = (const SDL_KeyboardEvent *)(&event);
+		if (evt->keysym.scancode == SDL_SCANCODE_ESCAPE) {
+			SDL_Event quitEvent = { SDL_QUIT };
+			SDL_PushEvent(&quitEvent);
+		}
+	}
+}
+
+void InstancingApplication::record()
+{
+	// frameStats() is the frame before this one, still in the last mode
+	if (m_current.frames++ > 0) {
+		const RenderStats &stats = geRenderer->frameStats();
+		m_current.drawCalls += stats.drawCalls;
+		m_current.programChanges += stats.programChanges;
+		m_current.filteredCalls += stats.filteredCalls;
+		m_current.seconds += Time::deltaTime();
+	}
+
+	if (m_current.frames < kFramesPerMode) {
+		return;
+	}
+
+	bool instanced = geRenderer->instancingEnabled();
+	int frames = m_current.frames - 1;
+	std::cout << "instancing " << (instanced ? "on: " : "off:")
+		<< " draw calls/frame " << m_current.drawCalls / frames
+		<< ", program changes/frame " << m_current.programChanges / frames
+		<< ", filtered GL calls/frame " << m_current.filteredCalls / frames
+		<< ", ms/frame " << 1000.0 * m_current.seconds / frames << std::endl;
+
+	m_results[instanced ? 1 : 0] = m_current;
+	m_current = Measurement{};
+
+	const Measurement &off = m_results[0];
+	const Measurement &on = m_results[1];
+	if (off.drawCalls && on.drawCalls && on.seconds > 0.0) {
+		std::cout << "draw calls reduced " << (double)off.drawCalls / on.drawCalls << "x, frame time "
+			<< off.seconds / on.seconds << "x" << std::endl;
+	}
+
+	geRenderer->setInstancingEnabled(!instanced);
+}
+
+void InstancingApplication::update()
+{
+	m_camera->update();
+
+	LightInfoList lights;
+	RenderableList renderables;
+	NodeTreeVisitor treeVisitor;
+	treeVisitor.visitNodeTree(m_scene, {
+		[&renderables, &lights] (Node *node, const glm::mat4 &modelMatrix) {
+			if (node->meshCount()) {
+				renderables.push_back({ modelMatrix, node });
+			}
+			if (node->light()) {
+				lights.push_back({ modelMatrix, node->light() });
+			}
+		}
+	});
+
+	geRenderer->setActiveCameraAndLights(m_camera->camera(), lights);
+
+	geRenderer->clear();
+	geRenderer->render(renderables);
+
+	record();
+}
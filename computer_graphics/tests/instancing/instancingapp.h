@@ -0,0 +1,37 @@
+#pragma once
+
+#include "ge2.h"
+
+// Draws a grid of cubes that share one mesh and material, switching
+// instancing on and off every few hundred frames and printing the draw
+// calls and frame time of each mode.
+class InstancingApplication : public ge2::Application
+{
+public:
+	InstancingApplication(int argc, char *argv[]);
+	~InstancingApplication();
+
+	virtual void handleEvent(const SDL_Event &event) override;
+	virtual void update() override;
+
+private:
+	struct Measurement
+	{
+		int    frames = 0;
+		long   drawCalls = 0;
+		long   programChanges = 0;
+		long   filteredCalls = 0;
+		double seconds = 0.0;
+	};
+
+	void record();
+
+	ge2::DebugCamera *m_camera = nullptr;
+	ge2::Node        *m_scene = nullptr;
+
+	ge2::DirectionalLight *m_directionalLight = nullptr;
+
+	Measurement m_current;
+	// the last complete measurement without and with instancing
+	Measurement m_results[2];
+};
@@ -0,0 +1,6 @@
+#include "instancingapp.h"
+
+ge2::Application *geConstructApplication(int argc, char *argv[])
+{
+	return (new InstancingApplication(argc, argv));
+}